@@ -4,6 +4,7 @@
 #include <curl/curl.h>
 #include <sstream>
 #include <cctype>
+#include <algorithm>
 #include <functional>
 #include <GLFW/glfw3.h>
 
@@ -33,82 +34,6 @@ static std::string parseEndpointHost(const std::string& endpoint_url) {
     return url;
 }
 
-static size_t writeCallback(void* contents, size_t size, size_t nmemb, std::string* userp) {
-    size_t total = size * nmemb;
-    userp->append(static_cast<char*>(contents), total);
-    return total;
-}
-
-// CURL share lock/unlock callbacks for thread-safe connection pooling
-// Uses separate mutexes per data type to avoid deadlock when CURL locks multiple types
-void curlShareLock(CURL*, curl_lock_data data, curl_lock_access, void* userptr) {
-    auto* backend = static_cast<S3Backend*>(userptr);
-    switch (data) {
-        case CURL_LOCK_DATA_CONNECT:
-            backend->m_curlShareMutexConnect.lock();
-            break;
-        case CURL_LOCK_DATA_DNS:
-            backend->m_curlShareMutexDns.lock();
-            break;
-        case CURL_LOCK_DATA_SSL_SESSION:
-            backend->m_curlShareMutexSsl.lock();
-            break;
-        default:
-            break;
-    }
-}
-
-void curlShareUnlock(CURL*, curl_lock_data data, void* userptr) {
-    auto* backend = static_cast<S3Backend*>(userptr);
-    switch (data) {
-        case CURL_LOCK_DATA_CONNECT:
-            backend->m_curlShareMutexConnect.unlock();
-            break;
-        case CURL_LOCK_DATA_DNS:
-            backend->m_curlShareMutexDns.unlock();
-            break;
-        case CURL_LOCK_DATA_SSL_SESSION:
-            backend->m_curlShareMutexSsl.unlock();
-            break;
-        default:
-            break;
-    }
-}
-
-// Thread-local CURL handle for connection reuse
-// Each worker thread gets its own handle, automatically cleaned up on thread exit
-struct ThreadCurlHandle {
-    CURL* handle = nullptr;
-
-    ThreadCurlHandle() {
-        handle = curl_easy_init();
-        if (handle) {
-            LOG_F(INFO, "ThreadCurlHandle: created CURL handle for thread");
-        } else {
-            LOG_F(ERROR, "ThreadCurlHandle: failed to create CURL handle");
-        }
-    }
-
-    ~ThreadCurlHandle() {
-        if (handle) {
-            curl_easy_cleanup(handle);
-            LOG_F(INFO, "ThreadCurlHandle: cleaned up CURL handle for thread");
-        }
-    }
-
-    // Non-copyable
-    ThreadCurlHandle(const ThreadCurlHandle&) = delete;
-    ThreadCurlHandle& operator=(const ThreadCurlHandle&) = delete;
-};
-
-// Get the thread-local CURL handle (lazily initialized)
-static CURL* getThreadCurl() {
-    thread_local ThreadCurlHandle tlsCurl;
-    return tlsCurl.handle;
-}
-
-// Member function resetThreadCurl is defined below S3Backend class methods
-
 // Header callback for capturing Content-Range header
 struct HttpResponseContext {
     std::string body;
@@ -146,48 +71,6 @@ static size_t writeCallbackCtx(void* contents, size_t size, size_t nmemb, void*
     return total;
 }
 
-// Context for streaming downloads - emits events as chunks arrive
-struct StreamingDownloadContext {
-    S3Backend* backend = nullptr;
-    std::string bucket;
-    std::string key;
-    size_t bytesReceived = 0;  // Bytes received in this request (offset from startByte)
-    size_t startByte = 0;      // Starting byte offset in file
-    size_t totalSize = 0;      // Total file size
-    std::shared_ptr<std::atomic<bool>> cancel_flag;
-    std::string buffer;        // Buffer for chunking
-    std::function<void(StateEvent)> pushEvent;  // Callback to push events
-
-    static constexpr size_t CHUNK_SIZE = 256 * 1024;  // Emit events every 256KB
-};
-
-static size_t streamingWriteCallback(void* contents, size_t size, size_t nmemb, void* userdata) {
-    size_t total = size * nmemb;
-    auto* ctx = static_cast<StreamingDownloadContext*>(userdata);
-
-    // Check cancellation
-    if (ctx->cancel_flag && ctx->cancel_flag->load()) {
-        return 0;  // Abort transfer
-    }
-
-    // Add to buffer
-    ctx->buffer.append(static_cast<char*>(contents), total);
-
-    // Emit events for complete chunks
-    while (ctx->buffer.size() >= StreamingDownloadContext::CHUNK_SIZE) {
-        std::string chunk(ctx->buffer.begin(), ctx->buffer.begin() + StreamingDownloadContext::CHUNK_SIZE);
-        ctx->buffer.erase(0, StreamingDownloadContext::CHUNK_SIZE);
-
-        size_t chunkOffset = ctx->startByte + ctx->bytesReceived;
-        ctx->bytesReceived += chunk.size();
-
-        ctx->pushEvent(StateEvent::objectRangeLoaded(
-            ctx->bucket, ctx->key, chunkOffset, ctx->totalSize, std::move(chunk)));
-    }
-
-    return total;
-}
-
 static std::string extractTag(const std::string& xml, const std::string& tag) {
     std::string open = "<" + tag + ">";
     std::string close = "</" + tag + ">";
@@ -290,46 +173,22 @@ void S3Backend::cacheRegion(const std::string& bucket, const std::string& region
     LOG_F(1, "S3Backend: cached region for bucket=%s region=%s", bucket.c_str(), region.c_str());
 }
 
-// Progress callback for cancellable requests
-static int cancelCheckProgressCallback(void* clientp, curl_off_t /*dltotal*/, curl_off_t /*dlnow*/,
-                                       curl_off_t /*ultotal*/, curl_off_t /*ulnow*/) {
-    auto* cancel_flag = static_cast<std::atomic<bool>*>(clientp);
-    // If cancelled, abort the transfer
-    if (cancel_flag && cancel_flag->load()) {
-        return 1;  // Non-zero aborts the transfer
-    }
-    return 0;
-}
-
-S3Backend::S3Backend(const AWSProfile& profile, size_t numWorkers)
-    : m_profile(profile), m_numWorkers(numWorkers)
+S3Backend::S3Backend(const AWSProfile& profile, size_t maxConcurrent)
+    : m_profile(profile),
+      m_maxConcurrent(std::max<size_t>(maxConcurrent, 2)),
+      m_maxLowPriorityConcurrent(std::max<size_t>(maxConcurrent, 2) / 2)
 {
-    LOG_F(INFO, "S3Backend: initializing with profile=%s region=%s numWorkers=%zu",
-          profile.name.c_str(), profile.region.c_str(), numWorkers);
+    LOG_F(INFO, "S3Backend: initializing with profile=%s region=%s maxConcurrent=%zu",
+          profile.name.c_str(), profile.region.c_str(), m_maxConcurrent);
     curl_global_init(CURL_GLOBAL_DEFAULT);
 
-    // Initialize shared CURL handle for connection pooling across all workers
-    m_curlShare = curl_share_init();
-    if (m_curlShare) {
-        curl_share_setopt(m_curlShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
-        curl_share_setopt(m_curlShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
-        curl_share_setopt(m_curlShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
-        curl_share_setopt(m_curlShare, CURLSHOPT_LOCKFUNC, curlShareLock);
-        curl_share_setopt(m_curlShare, CURLSHOPT_UNLOCKFUNC, curlShareUnlock);
-        curl_share_setopt(m_curlShare, CURLSHOPT_USERDATA, this);
-        LOG_F(INFO, "S3Backend: initialized CURL share handle for connection pooling");
+    m_multi = curl_multi_init();
+    if (m_multi) {
+        // Keep enough idle connections around that a burst of requests can reuse them
+        curl_multi_setopt(m_multi, CURLMOPT_MAXCONNECTS, static_cast<long>(m_maxConcurrent));
+        m_ioThread = std::thread(&S3Backend::ioThread, this);
     } else {
-        LOG_F(WARNING, "S3Backend: failed to initialize CURL share handle");
-    }
-
-    // Spawn high-priority workers
-    for (size_t i = 0; i < m_numWorkers; ++i) {
-        m_highPriorityWorkers.emplace_back(&S3Backend::workerThread, this, WorkItem::Priority::High, i);
-    }
-
-    // Spawn low-priority workers
-    for (size_t i = 0; i < m_numWorkers; ++i) {
-        m_lowPriorityWorkers.emplace_back(&S3Backend::workerThread, this, WorkItem::Priority::Low, i);
+        LOG_F(ERROR, "S3Backend: failed to initialize CURL multi handle");
     }
 }
 
@@ -337,69 +196,26 @@ S3Backend::~S3Backend() {
     LOG_F(INFO, "S3Backend: shutting down");
     cancelAll();
 
-    // Signal shutdown
+    // Signal shutdown and wake the I/O thread out of curl_multi_poll
     m_shutdown = true;
-
-    // Wake up all high-priority workers with shutdown items
-    {
-        std::lock_guard<std::mutex> lock(m_highPriorityMutex);
-        for (size_t i = 0; i < m_numWorkers; ++i) {
-            WorkItem item;
-            item.type = WorkItem::Type::Shutdown;
-            item.priority = WorkItem::Priority::High;
-            m_highPriorityQueue.push_back(std::move(item));
-        }
-    }
-    m_highPriorityCv.notify_all();
-
-    // Wake up all low-priority workers with shutdown items
-    {
-        std::lock_guard<std::mutex> lock(m_lowPriorityMutex);
-        for (size_t i = 0; i < m_numWorkers; ++i) {
-            WorkItem item;
-            item.type = WorkItem::Type::Shutdown;
-            item.priority = WorkItem::Priority::Low;
-            m_lowPriorityQueue.push_back(std::move(item));
-        }
-    }
-    m_lowPriorityCv.notify_all();
-
-    // Join all high-priority workers
-    for (auto& worker : m_highPriorityWorkers) {
-        if (worker.joinable()) {
-            worker.join();
-        }
+    wakeIoThread();
+    if (m_ioThread.joinable()) {
+        m_ioThread.join();
     }
 
-    // Join all low-priority workers
-    for (auto& worker : m_lowPriorityWorkers) {
-        if (worker.joinable()) {
-            worker.join();
-        }
+    for (CURL* easy : m_idleHandles) {
+        curl_easy_cleanup(easy);
     }
+    m_idleHandles.clear();
 
-    // Cleanup shared CURL handle
-    if (m_curlShare) {
-        curl_share_cleanup(m_curlShare);
-        m_curlShare = nullptr;
-        LOG_F(INFO, "S3Backend: cleaned up CURL share handle");
+    if (m_multi) {
+        curl_multi_cleanup(m_multi);
+        m_multi = nullptr;
     }
 
     curl_global_cleanup();
 }
 
-// Reset the thread-local CURL handle for reuse (preserves connection cache via share)
-void S3Backend::resetThreadCurl() {
-    CURL* curl = getThreadCurl();
-    if (curl) {
-        curl_easy_reset(curl);
-        // Re-apply shared connection cache after reset
-        if (m_curlShare) {
-            curl_easy_setopt(curl, CURLOPT_SHARE, m_curlShare);
-        }
-    }
-}
-
 std::vector<StateEvent> S3Backend::takeEvents() {
     std::lock_guard<std::mutex> lock(m_eventMutex);
     std::vector<StateEvent> events = std::move(m_events);
@@ -457,15 +273,16 @@ void S3Backend::listObjects(
     const std::string& bucket,
     const std::string& prefix,
     const std::string& continuation_token,
-    std::shared_ptr<std::atomic<bool>> cancel_flag
+    std::shared_ptr<std::atomic<bool>> cancel_flag,
+    bool lowPriority
 ) {
-    LOG_F(INFO, "S3Backend: queuing listObjects bucket=%s prefix=%s token=%s cancellable=%d",
+    LOG_F(INFO, "S3Backend: queuing listObjects bucket=%s prefix=%s token=%s cancellable=%d priority=%s",
           bucket.c_str(), prefix.c_str(),
           continuation_token.empty() ? "(none)" : continuation_token.substr(0, 20).c_str(),
-          cancel_flag != nullptr);
+          cancel_flag != nullptr, lowPriority ? "low" : "high");
     WorkItem item;
     item.type = WorkItem::Type::ListObjects;
-    item.priority = WorkItem::Priority::High;
+    item.priority = lowPriority ? WorkItem::Priority::Low : WorkItem::Priority::High;
     item.bucket = bucket;
     item.prefix = prefix;
     item.continuation_token = continuation_token;
@@ -511,18 +328,21 @@ void S3Backend::getObjectRange(
     const std::string& key,
     size_t startByte,
     size_t endByte,
-    std::shared_ptr<std::atomic<bool>> cancel_flag
+    std::shared_ptr<std::atomic<bool>> cancel_flag,
+    bool lowPriority,
+    uint64_t tag
 ) {
-    LOG_F(INFO, "S3Backend: queuing getObjectRange bucket=%s key=%s range=%zu-%zu",
-          bucket.c_str(), key.c_str(), startByte, endByte);
+    LOG_F(INFO, "S3Backend: queuing getObjectRange bucket=%s key=%s range=%zu-%zu priority=%s",
+          bucket.c_str(), key.c_str(), startByte, endByte, lowPriority ? "low" : "high");
 
     WorkItem item;
     item.type = WorkItem::Type::GetObjectRange;
-    item.priority = WorkItem::Priority::High;
+    item.priority = lowPriority ? WorkItem::Priority::Low : WorkItem::Priority::High;
     item.bucket = bucket;
     item.key = key;
     item.start_byte = startByte;
     item.end_byte = endByte;
+    item.tag = tag;
     item.queued_at = std::chrono::steady_clock::now();
     item.cancel_flag = cancel_flag;
 
@@ -534,7 +354,8 @@ void S3Backend::getObjectStreaming(
     const std::string& key,
     size_t startByte,
     size_t totalSize,
-    std::shared_ptr<std::atomic<bool>> cancel_flag
+    std::shared_ptr<std::atomic<bool>> cancel_flag,
+    std::shared_ptr<IStreamSink> sink
 ) {
     LOG_F(INFO, "S3Backend: queuing getObjectStreaming bucket=%s key=%s startByte=%zu totalSize=%zu",
           bucket.c_str(), key.c_str(), startByte, totalSize);
@@ -548,6 +369,7 @@ void S3Backend::getObjectStreaming(
     item.total_size = totalSize;
     item.queued_at = std::chrono::steady_clock::now();
     item.cancel_flag = cancel_flag;
+    item.sink = std::move(sink);
 
     enqueue(std::move(item));
 }
@@ -636,7 +458,7 @@ bool S3Backend::boostFromLowToHigh(Predicate pred) {
             std::lock_guard<std::mutex> lock(m_highPriorityMutex);
             m_highPriorityQueue.push_front(std::move(foundItem));
         }
-        m_highPriorityCv.notify_one();
+        wakeIoThread();
         return true;
     }
 
@@ -685,836 +507,774 @@ bool S3Backend::prioritizeObjectRequest(const std::string& bucket, const std::st
 
 void S3Backend::enqueue(WorkItem item) {
     if (item.priority == WorkItem::Priority::High) {
-        {
-            std::lock_guard<std::mutex> lock(m_highPriorityMutex);
-            m_highPriorityQueue.push_back(std::move(item));
-        }
-        m_highPriorityCv.notify_one();
+        std::lock_guard<std::mutex> lock(m_highPriorityMutex);
+        m_highPriorityQueue.push_back(std::move(item));
     } else {
-        {
-            std::lock_guard<std::mutex> lock(m_lowPriorityMutex);
-            // Push to front so most recent prefetch request is fetched first
-            m_lowPriorityQueue.push_front(std::move(item));
-        }
-        m_lowPriorityCv.notify_one();
+        std::lock_guard<std::mutex> lock(m_lowPriorityMutex);
+        // Push to front so most recent prefetch request is fetched first
+        m_lowPriorityQueue.push_front(std::move(item));
+    }
+    wakeIoThread();
+}
+
+void S3Backend::wakeIoThread() {
+    if (m_multi) {
+        curl_multi_wakeup(m_multi);
     }
 }
 
-void S3Backend::workerThread(WorkItem::Priority priority, size_t workerIndex) {
-    const char* priorityStr = (priority == WorkItem::Priority::High) ? "High" : "Low";
-    char threadName[32];
-    snprintf(threadName, sizeof(threadName), "S3%s%zu", priorityStr, workerIndex);
-    loguru::set_thread_name(threadName);
-    LOG_F(INFO, "S3Backend: %s priority worker %zu started", priorityStr, workerIndex);
+// ============================================================================
+// I/O thread
+// ============================================================================
 
-    // Warm up the connection pool by establishing a TCP connection to the S3 endpoint
-    // Configure shared connection cache so warmup connections are available to all workers
-    {
-        CURL* curl = getThreadCurl();
-        if (curl) {
-            // Set shared connection cache before warmup so the connection is pooled
-            if (m_curlShare) {
-                curl_easy_setopt(curl, CURLOPT_SHARE, m_curlShare);
-            }
-            std::string host;
-            if (!m_profile.endpoint_url.empty()) {
-                host = m_profile.endpoint_url;
-            } else {
-                host = "https://s3." + m_profile.region + ".amazonaws.com/";
+// One HTTP request attached to the multi handle. Owned by the I/O thread.
+struct S3Backend::Transfer {
+    WorkItem item;
+    CURL* easy = nullptr;
+    struct curl_slist* headerList = nullptr;
+    std::string region;
+    int attempt = 0;  // 1 once retried after a PermanentRedirect
+    HttpResponseContext response;
+    std::shared_ptr<StreamingJob> job;  // GetObjectPart only
+    bool paused = false;                // Write callback paused for backpressure
+    std::chrono::steady_clock::time_point http_start;
+};
+
+// A GetObjectStreaming request. Large ones fetch the remaining range as
+// concurrent Range: requests; small ones use a single part. Parts can finish
+// in any order, but bytes are handed out strictly in order: the lowest
+// outstanding part streams straight through as it arrives, later parts are
+// buffered until everything before them is out. Parts assigned at once span
+// at most window bytes, the sink's queue limit, so a slow consumer holds back
+// about as much as it would queue itself.
+struct S3Backend::StreamingJob {
+    static constexpr size_t CHUNK_SIZE = 256 * 1024;  // Emit every 256KB
+    static constexpr size_t PART_SIZE = 8 * 1024 * 1024;
+    static constexpr size_t MIN_PART_SIZE = 1024 * 1024;
+    static constexpr size_t DEFAULT_WINDOW = 32 * 1024 * 1024;  // Without a sink
+    static constexpr size_t INITIAL_PARALLELISM = 4;
+    static constexpr size_t MAX_PARALLELISM = 16;
+    // In-order bytes a sink may leave unaccepted before the head part is paused
+    static constexpr size_t MAX_PENDING = 16 * 1024 * 1024;
+
+    struct Part {
+        size_t end = 0;        // Inclusive
+        size_t received = 0;
+        std::string data;      // Received but not yet handed out
+        bool done = false;
+    };
+
+    WorkItem item;
+    std::map<size_t, Part> parts;  // Keyed by start offset; begin() is the part being handed out
+    size_t partSize = PART_SIZE;
+    size_t window = DEFAULT_WINDOW;  // Bytes of parts assigned but not yet handed out
+    bool adaptive = true;          // Tune parallelism from throughput
+    size_t nextPartStart = 0;      // First byte not yet assigned to a part
+    size_t emitOffset = 0;         // Source offset of pending[0]
+    std::string pending;           // In-order bytes not yet emitted as a chunk
+    size_t inFlight = 0;
+    size_t parallelism = INITIAL_PARALLELISM;
+    size_t peakParallelism = INITIAL_PARALLELISM;
+    bool failed = false;
+
+    // Throughput sampling for adapting parallelism
+    std::chrono::steady_clock::time_point started;
+    std::chrono::steady_clock::time_point windowStart;
+    size_t windowBytes = 0;
+    double lastThroughput = 0.0;
+
+    std::function<void(StateEvent)> pushEvent;
+
+    bool finished() const { return parts.empty() && nextPartStart >= item.total_size && pending.empty(); }
+
+    // Move whatever the head part has received into pending and emit full chunks
+    void drain() {
+        while (!parts.empty()) {
+            Part& head = parts.begin()->second;
+            if (!head.data.empty()) {
+                pending.append(head.data);
+                head.data.clear();
+                head.data.shrink_to_fit();
             }
-            curl_easy_setopt(curl, CURLOPT_URL, host.c_str());
-            curl_easy_setopt(curl, CURLOPT_CONNECT_ONLY, 1L);
-            curl_easy_setopt(curl, CURLOPT_TIMEOUT, 5L);
-            CURLcode res = curl_easy_perform(curl);
-            if (res == CURLE_OK) {
-                LOG_F(INFO, "S3Backend: %s priority worker %zu warmed up connection to %s",
-                      priorityStr, workerIndex, host.c_str());
+            if (!head.done) break;
+            parts.erase(parts.begin());
+        }
+
+        // Full chunks, plus the final partial chunk once every part has been handed out
+        bool lastBytes = parts.empty() && nextPartStart >= item.total_size;
+        size_t pos = 0;
+        while (pending.size() - pos >= CHUNK_SIZE || (lastBytes && pos < pending.size())) {
+            size_t len = std::min(CHUNK_SIZE, pending.size() - pos);
+            std::string chunk = pending.substr(pos, len);
+            if (item.sink) {
+                if (!item.sink->offerChunk(chunk, emitOffset)) break;  // Full, retry later
             } else {
-                LOG_F(WARNING, "S3Backend: %s priority worker %zu warmup failed: %s",
-                      priorityStr, workerIndex, curl_easy_strerror(res));
+                pushEvent(StateEvent::objectRangeLoaded(item.bucket, item.key, emitOffset,
+                    item.total_size, std::move(chunk)));
             }
-            resetThreadCurl();
+            emitOffset += len;
+            pos += len;
         }
+        pending.erase(0, pos);
     }
+};
 
-    // Select the appropriate queue, mutex, and cv based on priority
-    auto& queue = (priority == WorkItem::Priority::High) ? m_highPriorityQueue : m_lowPriorityQueue;
-    auto& mutex = (priority == WorkItem::Priority::High) ? m_highPriorityMutex : m_lowPriorityMutex;
-    auto& cv = (priority == WorkItem::Priority::High) ? m_highPriorityCv : m_lowPriorityCv;
+static const char* requestName(int type) {
+    static const char* names[] = {
+        "listBuckets", "listObjects", "getObject", "getObjectRange", "getObjectStreaming", "getObjectPart"
+    };
+    return names[type];
+}
 
-    while (true) {
-        WorkItem item;
-        {
-            std::unique_lock<std::mutex> lock(mutex);
-            cv.wait(lock, [this, &queue] {
-                return !queue.empty() || m_shutdown;
-            });
+// Work out which region a bucket lives in from a PermanentRedirect error body
+static std::string regionFromRedirect(const std::string& body, const std::string& bucket) {
+    std::string correctEndpoint = extractTag(body, "Endpoint");
+    LOG_F(INFO, "S3Backend: PermanentRedirect error, endpoint in response: '%s'",
+          correctEndpoint.c_str());
 
-            if (m_shutdown && queue.empty()) {
-                break;
-            }
+    std::string correctRegion;
 
-            item = std::move(queue.front());
-            queue.pop_front();
-        }
+    // Try to extract region from the endpoint
+    if (!correctEndpoint.empty()) {
+        correctRegion = extractRegionFromEndpoint(correctEndpoint);
+    }
 
-        if (item.type == WorkItem::Type::Shutdown) {
-            break;
+    // If that failed, try to extract region from bucket name
+    // Many buckets have region in their name, e.g., "my-bucket-us-east-1"
+    if (correctRegion.empty()) {
+        LOG_F(INFO, "S3Backend: trying to extract region from bucket name: '%s'", bucket.c_str());
+        std::string bucketLower = bucket;
+        for (auto& c : bucketLower) c = std::tolower(c);
+
+        // List of common AWS regions to search for
+        const char* regions[] = {
+            "us-east-1", "us-east-2", "us-west-1", "us-west-2",
+            "eu-west-1", "eu-west-2", "eu-west-3", "eu-central-1", "eu-north-1",
+            "ap-southeast-1", "ap-southeast-2", "ap-northeast-1", "ap-northeast-2", "ap-south-1",
+            "ca-central-1", "sa-east-1"
+        };
+
+        for (const char* regionName : regions) {
+            if (bucketLower.find(regionName) != std::string::npos) {
+                correctRegion = regionName;
+                LOG_F(INFO, "S3Backend: extracted region from bucket name: %s", correctRegion.c_str());
+                break;
+            }
         }
+    }
 
-        processWorkItem(item);
-
-        // Reset curl options for next request, but keep connection cache
-        resetThreadCurl();
+    // Last resort: use us-east-1 as default (most common region)
+    if (correctRegion.empty()) {
+        correctRegion = "us-east-1";
+        LOG_F(INFO, "S3Backend: falling back to default region: %s", correctRegion.c_str());
     }
 
-    // Thread-local CURL handle is automatically cleaned up when thread exits
-    LOG_F(INFO, "S3Backend: %s priority worker %zu exiting", priorityStr, workerIndex);
+    return correctRegion;
 }
 
-void S3Backend::processWorkItem(WorkItem& item) {
-    // Apply artificial lag for testing if configured
-    if (m_requestLagSeconds > 0.0f) {
-        auto lagMs = static_cast<int>(m_requestLagSeconds * 1000);
-        LOG_F(INFO, "S3Backend: applying %dms lag to request", lagMs);
-        std::this_thread::sleep_for(std::chrono::milliseconds(lagMs));
-    }
-
-    if (item.type == WorkItem::Type::ListBuckets) {
-        std::string host;
-        if (!m_profile.endpoint_url.empty()) {
-            host = parseEndpointHost(m_profile.endpoint_url);
-        } else {
-            host = "s3." + m_profile.region + ".amazonaws.com";
+void S3Backend::ioThread() {
+    loguru::set_thread_name("S3IO");
+    LOG_F(INFO, "S3Backend: I/O thread started (max %zu concurrent requests, %zu for prefetch)",
+          m_maxConcurrent, m_maxLowPriorityConcurrent);
+
+    while (!m_shutdown) {
+        reapCancelledTransfers();
+        updateStreamingJobs();
+        startQueuedTransfers();
+        scheduleStreamingParts();
+
+        int running = 0;
+        curl_multi_perform(m_multi, &running);
+
+        int msgsLeft = 0;
+        while (CURLMsg* msg = curl_multi_info_read(m_multi, &msgsLeft)) {
+            if (msg->msg != CURLMSG_DONE) continue;
+            // msg is invalidated by curl_multi_remove_handle, so copy what we need first
+            CURL* easy = msg->easy_handle;
+            CURLcode result = msg->data.result;
+            completeTransfer(detachTransfer(easy), result);
         }
-        LOG_F(1, "S3Backend: fetching bucket list from %s", host.c_str());
 
-        auto signedReq = aws_sign_request(
-            "GET", host, "/", "", m_profile.region, "s3",
-            m_profile.access_key_id, m_profile.secret_access_key, "",
-            m_profile.session_token
-        );
-
-        auto http_start = std::chrono::steady_clock::now();
-        std::string response = httpGet(signedReq.url, signedReq.headers);
-        auto http_end = std::chrono::steady_clock::now();
-
-        if (response.find("ERROR:") == 0) {
-            auto now = std::chrono::steady_clock::now();
-            auto total_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - item.queued_at).count();
-            auto http_ms = std::chrono::duration_cast<std::chrono::milliseconds>(http_end - http_start).count();
-            LOG_F(WARNING, "S3Backend: listBuckets HTTP error: %s (total=%lldms http=%lldms)",
-                  response.c_str(), static_cast<long long>(total_ms), static_cast<long long>(http_ms));
-            pushEvent(StateEvent::bucketsError(response));
-        } else {
-            std::string error = extractError(response);
-            if (!error.empty()) {
-                auto now = std::chrono::steady_clock::now();
-                auto total_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - item.queued_at).count();
-                auto http_ms = std::chrono::duration_cast<std::chrono::milliseconds>(http_end - http_start).count();
-                LOG_F(WARNING, "S3Backend: listBuckets S3 error: %s (total=%lldms http=%lldms)",
-                      error.c_str(), static_cast<long long>(total_ms), static_cast<long long>(http_ms));
-                pushEvent(StateEvent::bucketsError(error));
-            } else {
-                auto parse_start = std::chrono::steady_clock::now();
-                auto buckets = parseListBucketsXml(response);
-                auto now = std::chrono::steady_clock::now();
-                auto total_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - item.queued_at).count();
-                auto http_ms = std::chrono::duration_cast<std::chrono::milliseconds>(http_end - http_start).count();
-                auto parse_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - parse_start).count();
-                LOG_F(INFO, "S3Backend: listBuckets success, got %zu buckets (total=%lldms http=%lldms parse=%lldms)",
-                      buckets.size(), static_cast<long long>(total_ms), static_cast<long long>(http_ms), static_cast<long long>(parse_ms));
-                pushEvent(StateEvent::bucketsLoaded(std::move(buckets)));
-            }
+        // Sleep until there is socket activity, a curl timeout, or a new request
+        // (enqueue calls curl_multi_wakeup). Cancel flags and sinks are polled,
+        // so wake up at a modest rate while anything is in flight.
+        int timeoutMs = 1000;
+        if (!m_transfers.empty() || !m_streamingJobs.empty()) timeoutMs = 100;
+        for (const auto& job : m_streamingJobs) {
+            // A sink that refused bytes is usually busy for a few milliseconds only
+            if (job->item.sink && !job->pending.empty()) timeoutMs = 10;
         }
+        if (m_requestLagSeconds > 0.0f) timeoutMs = 10;
+        curl_multi_poll(m_multi, nullptr, 0, timeoutMs, nullptr);
     }
-    else if (item.type == WorkItem::Type::ListObjects) {
-        // Check cache first, fall back to profile region
-        std::string cachedRegion = getCachedRegion(item.bucket);
-        std::string region = cachedRegion.empty() ? m_profile.region : cachedRegion;
 
-        // Validate region is not empty
-        if (region.empty()) {
-            LOG_F(ERROR, "S3Backend: region is empty for bucket=%s, profile.region=%s, cached=%s",
-                  item.bucket.c_str(), m_profile.region.c_str(), cachedRegion.c_str());
-            pushEvent(StateEvent::objectsError(item.bucket, item.prefix,
-                "ERROR: Region not configured. Please ensure your AWS profile has a valid region."));
-            return;
-        }
+    // Abort anything still in flight
+    for (auto& [easy, transfer] : m_transfers) {
+        curl_multi_remove_handle(m_multi, easy);
+        releaseTransfer(*transfer);
+    }
+    m_transfers.clear();
+    m_streamingJobs.clear();
 
-        bool retried = false;
+    LOG_F(INFO, "S3Backend: I/O thread exiting");
+}
 
-        // Retry loop for handling PermanentRedirect
-        for (int attempt = 0; attempt < 2; ++attempt) {
-            std::string host;
-            std::string path;
-            if (!m_profile.endpoint_url.empty()) {
-                // Path-style: endpoint/bucket
-                host = parseEndpointHost(m_profile.endpoint_url);
-                path = "/" + item.bucket;
-            } else {
-                // Virtual-host style: bucket.s3.region.amazonaws.com
-                host = item.bucket + ".s3." + region + ".amazonaws.com";
-                path = "/";
+void S3Backend::startQueuedTransfers() {
+    auto now = std::chrono::steady_clock::now();
+    auto lag = std::chrono::duration<float>(m_requestLagSeconds);
+
+    // Artificial lag for testing holds each request back until it has been queued long enough
+    auto takeReady = [&](std::deque<WorkItem>& queue, std::mutex& mutex, WorkItem& out) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = queue.begin(); it != queue.end(); ++it) {
+            if (now - it->queued_at >= lag) {
+                out = std::move(*it);
+                queue.erase(it);
+                return true;
             }
-            LOG_F(1, "S3Backend: fetching objects bucket=%s prefix=%s host=%s path=%s region=%s%s",
-                  item.bucket.c_str(), item.prefix.c_str(), host.c_str(), path.c_str(), region.c_str(),
-                  retried ? " (retry)" : "");
+        }
+        return false;
+    };
 
-            // Build query string
-            std::ostringstream query;
-            query << "list-type=2";
-            query << "&delimiter=" << urlEncode("/");
-            query << "&max-keys=1000";
-            if (!item.prefix.empty()) {
-                query << "&prefix=" << urlEncode(item.prefix);
-            }
-            if (!item.continuation_token.empty()) {
-                query << "&continuation-token=" << urlEncode(item.continuation_token);
+    while (m_transfers.size() < m_maxConcurrent) {
+        WorkItem item;
+        if (!takeReady(m_highPriorityQueue, m_highPriorityMutex, item)) {
+            if (m_activeLowPriority >= m_maxLowPriorityConcurrent ||
+                !takeReady(m_lowPriorityQueue, m_lowPriorityMutex, item)) {
+                break;
             }
+        }
 
-            auto signedReq = aws_sign_request(
-                "GET", host, path, query.str(), region, "s3",
-                m_profile.access_key_id, m_profile.secret_access_key, "",
-                m_profile.session_token
-            );
-
-            auto http_start = std::chrono::steady_clock::now();
-            std::string response = httpGet(signedReq.url, signedReq.headers, item.cancel_flag);
-            auto http_end = std::chrono::steady_clock::now();
+        // Superseded before it ever reached the network
+        if (item.cancel_flag && item.cancel_flag->load()) {
+            LOG_F(1, "S3Backend: dropping cancelled %s bucket=%s %s before start",
+                  requestName(static_cast<int>(item.type)), item.bucket.c_str(),
+                  item.key.empty() ? item.prefix.c_str() : item.key.c_str());
+            continue;
+        }
 
-            // If cancelled, just return without pushing any event
-            if (response == "CANCELLED") {
-                LOG_F(INFO, "S3Backend: listObjects cancelled bucket=%s prefix=%s (superseded by newer request)",
-                      item.bucket.c_str(), item.prefix.c_str());
-                return;
-            }
+        if (item.type == WorkItem::Type::GetObjectStreaming) {
+            startStreamingJob(std::move(item));
+            continue;
+        }
 
-            if (response.find("ERROR:") == 0) {
-                auto now = std::chrono::steady_clock::now();
-                auto total_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - item.queued_at).count();
-                auto http_ms = std::chrono::duration_cast<std::chrono::milliseconds>(http_end - http_start).count();
-                LOG_F(WARNING, "S3Backend: listObjects HTTP error: %s (total=%lldms http=%lldms)",
-                      response.c_str(), static_cast<long long>(total_ms), static_cast<long long>(http_ms));
-                pushEvent(StateEvent::objectsError(item.bucket, item.prefix, response));
-                return;
-            }
+        auto transfer = std::make_unique<Transfer>();
+        transfer->item = std::move(item);
+        submitTransfer(std::move(transfer));
+    }
+}
 
-            auto parse_start = std::chrono::steady_clock::now();
-            auto result = parseListObjectsXml(response);
-            auto now = std::chrono::steady_clock::now();
-            auto total_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - item.queued_at).count();
-            auto http_ms = std::chrono::duration_cast<std::chrono::milliseconds>(http_end - http_start).count();
-            auto parse_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - parse_start).count();
-
-            if (!result.error.empty()) {
-                // Check for PermanentRedirect error
-                std::string errorCode = extractTag(response, "Code");
-                if (errorCode == "PermanentRedirect" && attempt == 0) {
-                    // Extract the correct endpoint and retry
-                    std::string correctEndpoint = extractTag(response, "Endpoint");
-                    LOG_F(INFO, "S3Backend: PermanentRedirect error, endpoint in response: '%s'",
-                          correctEndpoint.c_str());
-
-                    std::string correctRegion;
-
-                    // Try to extract region from the endpoint
-                    if (!correctEndpoint.empty()) {
-                        correctRegion = extractRegionFromEndpoint(correctEndpoint);
-                    }
-
-                    // If that failed, try to extract region from bucket name
-                    // Many buckets have region in their name, e.g., "my-bucket-us-east-1"
-                    if (correctRegion.empty()) {
-                        LOG_F(INFO, "S3Backend: trying to extract region from bucket name: '%s'",
-                              item.bucket.c_str());
-                        // Look for region pattern in bucket name (e.g., us-east-1, eu-west-2)
-                        // Common patterns: us-east-1, us-west-2, eu-west-1, ap-southeast-1, etc.
-                        std::string bucketLower = item.bucket;
-                        for (auto& c : bucketLower) c = std::tolower(c);
-
-                        // List of common AWS regions to search for
-                        const char* regions[] = {
-                            "us-east-1", "us-east-2", "us-west-1", "us-west-2",
-                            "eu-west-1", "eu-west-2", "eu-west-3", "eu-central-1", "eu-north-1",
-                            "ap-southeast-1", "ap-southeast-2", "ap-northeast-1", "ap-northeast-2", "ap-south-1",
-                            "ca-central-1", "sa-east-1"
-                        };
-
-                        for (const char* regionName : regions) {
-                            if (bucketLower.find(regionName) != std::string::npos) {
-                                correctRegion = regionName;
-                                LOG_F(INFO, "S3Backend: extracted region from bucket name: %s", correctRegion.c_str());
-                                break;
-                            }
-                        }
-                    }
-
-                    // Last resort: use us-east-1 as default (most common region)
-                    if (correctRegion.empty()) {
-                        correctRegion = "us-east-1";
-                        LOG_F(INFO, "S3Backend: falling back to default region: %s", correctRegion.c_str());
-                    }
-
-                    if (!correctRegion.empty() && correctRegion != region) {
-                        LOG_F(INFO, "S3Backend: detected PermanentRedirect, retrying with region=%s (was %s)",
-                              correctRegion.c_str(), region.c_str());
-                        region = correctRegion;
-                        cacheRegion(item.bucket, correctRegion);  // Cache for future requests
-                        retried = true;
-                        continue;  // Retry with corrected region
-                    } else {
-                        LOG_F(WARNING, "S3Backend: PermanentRedirect but could not determine correct region (endpoint: '%s', bucket: '%s')",
-                              correctEndpoint.c_str(), item.bucket.c_str());
-                    }
-                }
+void S3Backend::reapCancelledTransfers() {
+    for (auto it = m_transfers.begin(); it != m_transfers.end();) {
+        Transfer& transfer = *it->second;
+        if (transfer.job && transfer.job->failed) {
+            // Another part of the same download failed; the rest is useless
+            curl_multi_remove_handle(m_multi, it->first);
+            releaseTransfer(transfer);
+            it = m_transfers.erase(it);
+        } else if (transfer.item.cancel_flag && transfer.item.cancel_flag->load()) {
+            LOG_F(INFO, "S3Backend: %s cancelled bucket=%s %s (superseded by newer request)",
+                  requestName(static_cast<int>(transfer.item.type)), transfer.item.bucket.c_str(),
+                  transfer.item.key.empty() ? transfer.item.prefix.c_str() : transfer.item.key.c_str());
+            curl_multi_remove_handle(m_multi, it->first);
+            if (transfer.item.priority == WorkItem::Priority::Low) --m_activeLowPriority;
+            releaseTransfer(transfer);
+            it = m_transfers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
 
-                LOG_F(WARNING, "S3Backend: listObjects S3 error: %s (total=%lldms http=%lldms parse=%lldms)",
-                      result.error.c_str(), static_cast<long long>(total_ms), static_cast<long long>(http_ms), static_cast<long long>(parse_ms));
-                pushEvent(StateEvent::objectsError(item.bucket, item.prefix, result.error));
-                return;
-            }
+bool S3Backend::submitTransfer(std::unique_ptr<Transfer> transfer) {
+    const WorkItem& item = transfer->item;
+    const bool pathStyle = !m_profile.endpoint_url.empty();
 
-            // Cache the region on success (either profile region or corrected region)
-            cacheRegion(item.bucket, region);
+    std::string region;
+    std::string host;
+    std::string path;
+    std::string query;
+    long timeoutSeconds = 30;
 
-            LOG_F(INFO, "S3Backend: listObjects success bucket=%s prefix=%s count=%zu truncated=%d (total=%lldms http=%lldms parse=%lldms)",
-                  item.bucket.c_str(), item.prefix.c_str(),
-                  result.objects.size(), result.is_truncated, static_cast<long long>(total_ms), static_cast<long long>(http_ms), static_cast<long long>(parse_ms));
-            pushEvent(StateEvent::objectsLoaded(
-                item.bucket,
-                item.prefix,
-                item.continuation_token,
-                std::move(result.objects),
-                result.next_continuation_token,
-                result.is_truncated
-            ));
-            return;  // Success
-        }
-    }
-    else if (item.type == WorkItem::Type::GetObject) {
-        // Check cache first, fall back to profile region
+    if (item.type == WorkItem::Type::ListBuckets) {
+        region = m_profile.region;
+        host = pathStyle ? parseEndpointHost(m_profile.endpoint_url) : "s3." + region + ".amazonaws.com";
+        path = "/";
+        LOG_F(1, "S3Backend: fetching bucket list from %s", host.c_str());
+    } else {
+        // Use the region we were told to retry with, then the cache, then the profile
         std::string cachedRegion = getCachedRegion(item.bucket);
-        std::string region = cachedRegion.empty() ? m_profile.region : cachedRegion;
+        region = !transfer->region.empty() ? transfer->region
+               : !cachedRegion.empty() ? cachedRegion : m_profile.region;
 
-        // Validate region is not empty
         if (region.empty()) {
             LOG_F(ERROR, "S3Backend: region is empty for bucket=%s, profile.region=%s, cached=%s",
                   item.bucket.c_str(), m_profile.region.c_str(), cachedRegion.c_str());
-            pushEvent(StateEvent::objectContentError(item.bucket, item.key,
-                "ERROR: Region not configured. Please ensure your AWS profile has a valid region."));
-            return;
+            pushRequestError(item, "ERROR: Region not configured. Please ensure your AWS profile has a valid region.");
+            return false;
         }
 
-        bool retried = false;
+        // Path-style: endpoint/bucket[/key], virtual-host style: bucket.s3.region.amazonaws.com[/key]
+        host = pathStyle ? parseEndpointHost(m_profile.endpoint_url) : item.bucket + ".s3." + region + ".amazonaws.com";
 
-        // Retry loop for handling PermanentRedirect
-        for (int attempt = 0; attempt < 2; ++attempt) {
-            std::string host;
-            std::string path;
-            if (!m_profile.endpoint_url.empty()) {
-                // Path-style: endpoint/bucket/key
-                host = parseEndpointHost(m_profile.endpoint_url);
-                path = "/" + item.bucket + "/" + item.key;
-            } else {
-                // Virtual-host style: bucket.s3.region.amazonaws.com/key
-                host = item.bucket + ".s3." + region + ".amazonaws.com";
-                path = "/" + item.key;
-            }
-            LOG_F(1, "S3Backend: fetching object bucket=%s key=%s max_bytes=%zu host=%s path=%s region=%s%s",
-                  item.bucket.c_str(), item.key.c_str(), item.max_bytes, host.c_str(), path.c_str(), region.c_str(),
-                  retried ? " (retry)" : "");
-
-            auto signedReq = aws_sign_request(
-                "GET", host, path, "", region, "s3",
-                m_profile.access_key_id, m_profile.secret_access_key, "",
-                m_profile.session_token
-            );
-
-            // Add Range header if max_bytes is set (doesn't need to be signed)
-            if (item.max_bytes > 0) {
-                signedReq.headers["Range"] = "bytes=0-" + std::to_string(item.max_bytes - 1);
-            }
-
-            auto http_start = std::chrono::steady_clock::now();
-            std::string response = httpGet(signedReq.url, signedReq.headers, item.cancel_flag);
-            auto http_end = std::chrono::steady_clock::now();
-
-            // If cancelled, just return without pushing any event
-            if (response == "CANCELLED") {
-                LOG_F(INFO, "S3Backend: getObject cancelled bucket=%s key=%s (superseded by newer request)",
-                      item.bucket.c_str(), item.key.c_str());
-                return;
-            }
-
-            auto now = std::chrono::steady_clock::now();
-            auto total_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - item.queued_at).count();
-            auto http_ms = std::chrono::duration_cast<std::chrono::milliseconds>(http_end - http_start).count();
+        if (item.type == WorkItem::Type::ListObjects) {
+            path = pathStyle ? "/" + item.bucket : "/";
 
-            if (response.find("ERROR:") == 0) {
-                LOG_F(WARNING, "S3Backend: getObject HTTP error: %s (total=%lldms http=%lldms)",
-                      response.c_str(), static_cast<long long>(total_ms), static_cast<long long>(http_ms));
-                pushEvent(StateEvent::objectContentError(item.bucket, item.key, response));
-                return;
+            std::ostringstream queryStream;
+            queryStream << "list-type=2";
+            queryStream << "&delimiter=" << urlEncode("/");
+            queryStream << "&max-keys=1000";
+            if (!item.prefix.empty()) {
+                queryStream << "&prefix=" << urlEncode(item.prefix);
             }
-
-            // Check for S3 error in XML response
-            std::string error = extractError(response);
-            if (!error.empty()) {
-                // Check for PermanentRedirect error
-                std::string errorCode = extractTag(response, "Code");
-                if (errorCode == "PermanentRedirect" && attempt == 0) {
-                    // Extract the correct endpoint and retry
-                    std::string correctEndpoint = extractTag(response, "Endpoint");
-                    LOG_F(INFO, "S3Backend: PermanentRedirect error, endpoint in response: '%s'",
-                          correctEndpoint.c_str());
-
-                    std::string correctRegion;
-
-                    // Try to extract region from the endpoint
-                    if (!correctEndpoint.empty()) {
-                        correctRegion = extractRegionFromEndpoint(correctEndpoint);
-                    }
-
-                    // If that failed, try to extract region from bucket name
-                    if (correctRegion.empty()) {
-                        LOG_F(INFO, "S3Backend: trying to extract region from bucket name: '%s'",
-                              item.bucket.c_str());
-                        std::string bucketLower = item.bucket;
-                        for (auto& c : bucketLower) c = std::tolower(c);
-
-                        const char* regions[] = {
-                            "us-east-1", "us-east-2", "us-west-1", "us-west-2",
-                            "eu-west-1", "eu-west-2", "eu-west-3", "eu-central-1", "eu-north-1",
-                            "ap-southeast-1", "ap-southeast-2", "ap-northeast-1", "ap-northeast-2", "ap-south-1",
-                            "ca-central-1", "sa-east-1"
-                        };
-
-                        for (const char* regionName : regions) {
-                            if (bucketLower.find(regionName) != std::string::npos) {
-                                correctRegion = regionName;
-                                LOG_F(INFO, "S3Backend: extracted region from bucket name: %s", correctRegion.c_str());
-                                break;
-                            }
-                        }
-                    }
-
-                    // Last resort: use us-east-1 as default
-                    if (correctRegion.empty()) {
-                        correctRegion = "us-east-1";
-                        LOG_F(INFO, "S3Backend: falling back to default region: %s", correctRegion.c_str());
-                    }
-
-                    if (!correctRegion.empty() && correctRegion != region) {
-                        LOG_F(INFO, "S3Backend: detected PermanentRedirect, retrying with region=%s (was %s)",
-                              correctRegion.c_str(), region.c_str());
-                        region = correctRegion;
-                        cacheRegion(item.bucket, correctRegion);  // Cache for future requests
-                        retried = true;
-                        continue;  // Retry with corrected region
-                    } else {
-                        LOG_F(WARNING, "S3Backend: PermanentRedirect but could not determine correct region (endpoint: '%s', bucket: '%s')",
-                              correctEndpoint.c_str(), item.bucket.c_str());
-                    }
-                }
-
-                // InvalidRange means the file is 0 bytes - return empty content
-                if (errorCode == "InvalidRange") {
-                    LOG_F(INFO, "S3Backend: getObject empty file (InvalidRange) bucket=%s key=%s (total=%lldms http=%lldms)",
-                          item.bucket.c_str(), item.key.c_str(), static_cast<long long>(total_ms), static_cast<long long>(http_ms));
-                    pushEvent(StateEvent::objectContentLoaded(item.bucket, item.key, ""));
-                    return;
-                }
-
-                LOG_F(WARNING, "S3Backend: getObject S3 error: %s (total=%lldms http=%lldms)",
-                      error.c_str(), static_cast<long long>(total_ms), static_cast<long long>(http_ms));
-                pushEvent(StateEvent::objectContentError(item.bucket, item.key, error));
-                return;
+            if (!item.continuation_token.empty()) {
+                queryStream << "&continuation-token=" << urlEncode(item.continuation_token);
             }
+            query = queryStream.str();
 
-            // Cache the region on success (either profile region or corrected region)
-            cacheRegion(item.bucket, region);
-
-            LOG_F(INFO, "S3Backend: getObject success bucket=%s key=%s size=%zu (total=%lldms http=%lldms)",
-                  item.bucket.c_str(), item.key.c_str(), response.size(), static_cast<long long>(total_ms), static_cast<long long>(http_ms));
-            pushEvent(StateEvent::objectContentLoaded(item.bucket, item.key, std::move(response)));
-            return;  // Success
+            LOG_F(1, "S3Backend: fetching objects bucket=%s prefix=%s host=%s path=%s region=%s%s",
+                  item.bucket.c_str(), item.prefix.c_str(), host.c_str(), path.c_str(), region.c_str(),
+                  transfer->attempt > 0 ? " (retry)" : "");
+        } else {
+            path = (pathStyle ? "/" + item.bucket + "/" : "/") + item.key;
+            LOG_F(1, "S3Backend: fetching object bucket=%s key=%s type=%s host=%s path=%s region=%s%s",
+                  item.bucket.c_str(), item.key.c_str(), requestName(static_cast<int>(item.type)),
+                  host.c_str(), path.c_str(), region.c_str(), transfer->attempt > 0 ? " (retry)" : "");
         }
     }
-    else if (item.type == WorkItem::Type::GetObjectRange) {
-        // Check cache first, fall back to profile region
-        std::string cachedRegion = getCachedRegion(item.bucket);
-        std::string region = cachedRegion.empty() ? m_profile.region : cachedRegion;
+    transfer->region = region;
+
+    auto signedReq = aws_sign_request(
+        "GET", host, path, query, region, "s3",
+        m_profile.access_key_id, m_profile.secret_access_key, "",
+        m_profile.session_token
+    );
+
+    // Range headers don't need to be signed
+    if (item.type == WorkItem::Type::GetObject && item.max_bytes > 0) {
+        signedReq.headers["Range"] = "bytes=0-" + std::to_string(item.max_bytes - 1);
+    } else if (item.type == WorkItem::Type::GetObjectRange) {
+        signedReq.headers["Range"] = "bytes=" + std::to_string(item.start_byte) + "-" + std::to_string(item.end_byte);
+        timeoutSeconds = 60;  // Longer timeout for larger chunks
+    } else if (item.type == WorkItem::Type::GetObjectPart) {
+        signedReq.headers["Range"] = "bytes=" + std::to_string(item.start_byte) + "-" + std::to_string(item.end_byte);
+        timeoutSeconds = 0;  // Parts may wait paused on the consumer; see below
+    }
 
-        // Validate region is not empty
-        if (region.empty()) {
-            LOG_F(ERROR, "S3Backend: region is empty for bucket=%s, profile.region=%s, cached=%s",
-                  item.bucket.c_str(), m_profile.region.c_str(), cachedRegion.c_str());
-            pushEvent(StateEvent::objectRangeError(item.bucket, item.key, item.start_byte,
-                "ERROR: Region not configured. Please ensure your AWS profile has a valid region."));
-            return;
-        }
+    CURL* easy = nullptr;
+    if (!m_idleHandles.empty()) {
+        easy = m_idleHandles.back();
+        m_idleHandles.pop_back();
+    } else {
+        easy = curl_easy_init();
+    }
+    if (!easy) {
+        pushRequestError(item, "ERROR: Failed to create curl handle");
+        return false;
+    }
+    transfer->easy = easy;
+
+    curl_easy_setopt(easy, CURLOPT_URL, signedReq.url.c_str());
+    curl_easy_setopt(easy, CURLOPT_PRIVATE, transfer.get());
+    curl_easy_setopt(easy, CURLOPT_TIMEOUT, timeoutSeconds);
+    curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+    if (item.type == WorkItem::Type::GetObjectPart) {
+        // A total timeout would fail parts paused for backpressure; give up on
+        // a stalled connection instead (curl skips the check while paused)
+        curl_easy_setopt(easy, CURLOPT_LOW_SPEED_LIMIT, 1024L);
+        curl_easy_setopt(easy, CURLOPT_LOW_SPEED_TIME, 60L);
+    }
 
-        bool retried = false;
+    if (item.type == WorkItem::Type::GetObjectPart) {
+        transfer->response = HttpResponseContext{};
+        curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, streamingPartWriteCallback);
+        curl_easy_setopt(easy, CURLOPT_WRITEDATA, transfer.get());
+    } else {
+        transfer->response = HttpResponseContext{};
+        curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, writeCallbackCtx);
+        curl_easy_setopt(easy, CURLOPT_WRITEDATA, &transfer->response);
+        curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, headerCallback);
+        curl_easy_setopt(easy, CURLOPT_HEADERDATA, &transfer->response);
+    }
 
-        // Retry loop for handling PermanentRedirect
-        for (int attempt = 0; attempt < 2; ++attempt) {
-            std::string host;
-            std::string path;
-            if (!m_profile.endpoint_url.empty()) {
-                host = parseEndpointHost(m_profile.endpoint_url);
-                path = "/" + item.bucket + "/" + item.key;
-            } else {
-                host = item.bucket + ".s3." + region + ".amazonaws.com";
-                path = "/" + item.key;
-            }
-            LOG_F(1, "S3Backend: fetching object range bucket=%s key=%s range=%zu-%zu host=%s path=%s region=%s%s",
-                  item.bucket.c_str(), item.key.c_str(), item.start_byte, item.end_byte, host.c_str(), path.c_str(), region.c_str(),
-                  retried ? " (retry)" : "");
+    for (const auto& [key, value] : signedReq.headers) {
+        std::string header = key + ": " + value;
+        transfer->headerList = curl_slist_append(transfer->headerList, header.c_str());
+    }
+    if (transfer->headerList) {
+        curl_easy_setopt(easy, CURLOPT_HTTPHEADER, transfer->headerList);
+    }
 
-            auto signedReq = aws_sign_request(
-                "GET", host, path, "", region, "s3",
-                m_profile.access_key_id, m_profile.secret_access_key, "",
-                m_profile.session_token
-            );
+    CURLMcode mres = curl_multi_add_handle(m_multi, easy);
+    if (mres != CURLM_OK) {
+        LOG_F(WARNING, "S3Backend: curl_multi_add_handle failed: %s", curl_multi_strerror(mres));
+        pushRequestError(item, "ERROR: " + std::string(curl_multi_strerror(mres)));
+        releaseTransfer(*transfer);
+        return false;
+    }
 
-            // Add Range header
-            signedReq.headers["Range"] = "bytes=" + std::to_string(item.start_byte) + "-" + std::to_string(item.end_byte);
+    transfer->http_start = std::chrono::steady_clock::now();
+    if (item.priority == WorkItem::Priority::Low) ++m_activeLowPriority;
+    m_transfers[easy] = std::move(transfer);
+    return true;
+}
 
-            // Use thread-local CURL handle with header callback to capture Content-Range
-            auto http_start = std::chrono::steady_clock::now();
+std::unique_ptr<S3Backend::Transfer> S3Backend::detachTransfer(CURL* easy) {
+    curl_multi_remove_handle(m_multi, easy);
+    auto it = m_transfers.find(easy);
+    if (it == m_transfers.end()) return nullptr;
+    std::unique_ptr<Transfer> transfer = std::move(it->second);
+    m_transfers.erase(it);
+    if (transfer->item.priority == WorkItem::Priority::Low) --m_activeLowPriority;
+    return transfer;
+}
 
-            CURL* curl = getThreadCurl();
-            if (!curl) {
-                pushEvent(StateEvent::objectRangeError(item.bucket, item.key, item.start_byte, "ERROR: Failed to get thread-local curl handle"));
-                return;
-            }
+void S3Backend::releaseTransfer(Transfer& transfer) {
+    if (transfer.job) {
+        --transfer.job->inFlight;
+    }
+    if (transfer.headerList) {
+        curl_slist_free_all(transfer.headerList);
+        transfer.headerList = nullptr;
+    }
+    if (transfer.easy) {
+        // Reset options but keep the handle; connections live in the multi handle's pool
+        curl_easy_reset(transfer.easy);
+        if (m_idleHandles.size() < m_maxConcurrent) {
+            m_idleHandles.push_back(transfer.easy);
+        } else {
+            curl_easy_cleanup(transfer.easy);
+        }
+        transfer.easy = nullptr;
+    }
+}
 
-            HttpResponseContext ctx;
-            curl_easy_setopt(curl, CURLOPT_URL, signedReq.url.c_str());
-            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallbackCtx);
-            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &ctx);
-            curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, headerCallback);
-            curl_easy_setopt(curl, CURLOPT_HEADERDATA, &ctx);
-            curl_easy_setopt(curl, CURLOPT_TIMEOUT, 60L);  // Longer timeout for larger chunks
-
-            if (item.cancel_flag) {
-                curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
-                curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, cancelCheckProgressCallback);
-                curl_easy_setopt(curl, CURLOPT_XFERINFODATA, item.cancel_flag.get());
-            }
+void S3Backend::pushRequestError(const WorkItem& item, const std::string& error) {
+    switch (item.type) {
+        case WorkItem::Type::ListBuckets:
+            pushEvent(StateEvent::bucketsError(error));
+            break;
+        case WorkItem::Type::ListObjects:
+            pushEvent(StateEvent::objectsError(item.bucket, item.prefix, error));
+            break;
+        case WorkItem::Type::GetObject:
+            pushEvent(StateEvent::objectContentError(item.bucket, item.key, error));
+            break;
+        case WorkItem::Type::GetObjectRange:
+        case WorkItem::Type::GetObjectStreaming:
+        case WorkItem::Type::GetObjectPart:
+            pushEvent(StateEvent::objectRangeError(item.bucket, item.key, item.start_byte, error, item.tag));
+            break;
+    }
+}
 
-            struct curl_slist* headerList = nullptr;
-            for (const auto& [key, value] : signedReq.headers) {
-                std::string header = key + ": " + value;
-                headerList = curl_slist_append(headerList, header.c_str());
-            }
-            if (headerList) {
-                curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headerList);
-            }
+void S3Backend::completeTransfer(std::unique_ptr<Transfer> transfer, CURLcode result) {
+    if (!transfer) return;
+    releaseTransfer(*transfer);
 
-            CURLcode res = curl_easy_perform(curl);
+    // Parts of a download that already failed have nothing left to report
+    if (transfer->job && transfer->job->failed) return;
 
-            if (headerList) curl_slist_free_all(headerList);
-            // Don't cleanup curl - it's reused via thread-local storage
+    WorkItem& item = transfer->item;
+    const char* name = requestName(static_cast<int>(item.type));
 
-            auto http_end = std::chrono::steady_clock::now();
+    auto now = std::chrono::steady_clock::now();
+    auto total_ms = static_cast<long long>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(now - item.queued_at).count());
+    auto http_ms = static_cast<long long>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(now - transfer->http_start).count());
 
-            if (res == CURLE_ABORTED_BY_CALLBACK) {
-                LOG_F(INFO, "S3Backend: getObjectRange cancelled bucket=%s key=%s",
-                      item.bucket.c_str(), item.key.c_str());
-                return;
-            }
+    if (result == CURLE_ABORTED_BY_CALLBACK || (item.cancel_flag && item.cancel_flag->load())) {
+        LOG_F(INFO, "S3Backend: %s cancelled bucket=%s %s (superseded by newer request)",
+              name, item.bucket.c_str(), item.key.empty() ? item.prefix.c_str() : item.key.c_str());
+        return;
+    }
 
-            auto now = std::chrono::steady_clock::now();
-            auto total_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - item.queued_at).count();
-            auto http_ms = std::chrono::duration_cast<std::chrono::milliseconds>(http_end - http_start).count();
+    if (result != CURLE_OK) {
+        LOG_F(WARNING, "S3Backend: %s HTTP error: %s (total=%lldms http=%lldms)",
+              name, curl_easy_strerror(result), total_ms, http_ms);
+        pushRequestError(item, "ERROR: " + std::string(curl_easy_strerror(result)));
+        if (transfer->job) transfer->job->failed = true;
+        return;
+    }
 
-            if (res != CURLE_OK) {
-                LOG_F(WARNING, "S3Backend: getObjectRange HTTP error: %s (total=%lldms http=%lldms)",
-                      curl_easy_strerror(res), static_cast<long long>(total_ms), static_cast<long long>(http_ms));
-                pushEvent(StateEvent::objectRangeError(item.bucket, item.key, item.start_byte,
-                    "ERROR: " + std::string(curl_easy_strerror(res))));
+    // For GetObjectPart this only holds a non-206 (error) response
+    std::string& body = transfer->response.body;
+
+    // Check for S3 error in XML response
+    std::string error = extractError(body);
+    if (!error.empty()) {
+        std::string errorCode = extractTag(body, "Code");
+
+        if (errorCode == "PermanentRedirect" && item.type != WorkItem::Type::ListBuckets &&
+            transfer->attempt == 0) {
+            std::string correctRegion = regionFromRedirect(body, item.bucket);
+            if (correctRegion != transfer->region) {
+                LOG_F(INFO, "S3Backend: detected PermanentRedirect, retrying with region=%s (was %s)",
+                      correctRegion.c_str(), transfer->region.c_str());
+                cacheRegion(item.bucket, correctRegion);  // Cache for future requests
+
+                auto retry = std::make_unique<Transfer>();
+                retry->item = std::move(item);
+                retry->region = correctRegion;
+                retry->attempt = 1;
+                retry->job = transfer->job;
+                if (retry->job) ++retry->job->inFlight;
+                if (!submitTransfer(std::move(retry)) && transfer->job) {
+                    transfer->job->failed = true;
+                }
                 return;
             }
+            LOG_F(WARNING, "S3Backend: PermanentRedirect but could not determine correct region (bucket: '%s')",
+                  item.bucket.c_str());
+        }
 
-            // Check for S3 error in XML response
-            std::string error = extractError(ctx.body);
-            if (!error.empty()) {
-                // Check for PermanentRedirect error
-                std::string errorCode = extractTag(ctx.body, "Code");
-                if (errorCode == "PermanentRedirect" && attempt == 0) {
-                    // Extract the correct endpoint and retry
-                    std::string correctEndpoint = extractTag(ctx.body, "Endpoint");
-                    LOG_F(INFO, "S3Backend: PermanentRedirect error, endpoint in response: '%s'",
-                          correctEndpoint.c_str());
-
-                    std::string correctRegion;
-
-                    // Try to extract region from the endpoint
-                    if (!correctEndpoint.empty()) {
-                        correctRegion = extractRegionFromEndpoint(correctEndpoint);
-                    }
-
-                    // If that failed, try to extract region from bucket name
-                    if (correctRegion.empty()) {
-                        LOG_F(INFO, "S3Backend: trying to extract region from bucket name: '%s'",
-                              item.bucket.c_str());
-                        std::string bucketLower = item.bucket;
-                        for (auto& c : bucketLower) c = std::tolower(c);
-
-                        const char* regions[] = {
-                            "us-east-1", "us-east-2", "us-west-1", "us-west-2",
-                            "eu-west-1", "eu-west-2", "eu-west-3", "eu-central-1", "eu-north-1",
-                            "ap-southeast-1", "ap-southeast-2", "ap-northeast-1", "ap-northeast-2", "ap-south-1",
-                            "ca-central-1", "sa-east-1"
-                        };
-
-                        for (const char* regionName : regions) {
-                            if (bucketLower.find(regionName) != std::string::npos) {
-                                correctRegion = regionName;
-                                LOG_F(INFO, "S3Backend: extracted region from bucket name: %s", correctRegion.c_str());
-                                break;
-                            }
-                        }
-                    }
-
-                    // Last resort: use us-east-1 as default
-                    if (correctRegion.empty()) {
-                        correctRegion = "us-east-1";
-                        LOG_F(INFO, "S3Backend: falling back to default region: %s", correctRegion.c_str());
-                    }
-
-                    if (!correctRegion.empty() && correctRegion != region) {
-                        LOG_F(INFO, "S3Backend: detected PermanentRedirect, retrying with region=%s (was %s)",
-                              correctRegion.c_str(), region.c_str());
-                        region = correctRegion;
-                        cacheRegion(item.bucket, correctRegion);  // Cache for future requests
-                        retried = true;
-                        continue;  // Retry with corrected region
-                    } else {
-                        LOG_F(WARNING, "S3Backend: PermanentRedirect but could not determine correct region (endpoint: '%s', bucket: '%s')",
-                              correctEndpoint.c_str(), item.bucket.c_str());
-                    }
-                }
+        // InvalidRange means the file is 0 bytes - return empty content
+        if (errorCode == "InvalidRange" && item.type == WorkItem::Type::GetObject) {
+            LOG_F(INFO, "S3Backend: getObject empty file (InvalidRange) bucket=%s key=%s (total=%lldms http=%lldms)",
+                  item.bucket.c_str(), item.key.c_str(), total_ms, http_ms);
+            pushEvent(StateEvent::objectContentLoaded(item.bucket, item.key, ""));
+            return;
+        }
 
-                LOG_F(WARNING, "S3Backend: getObjectRange S3 error: %s (total=%lldms http=%lldms)",
-                      error.c_str(), static_cast<long long>(total_ms), static_cast<long long>(http_ms));
-                pushEvent(StateEvent::objectRangeError(item.bucket, item.key, item.start_byte, error));
-                return;
-            }
+        LOG_F(WARNING, "S3Backend: %s S3 error: %s (total=%lldms http=%lldms)",
+              name, error.c_str(), total_ms, http_ms);
+        pushRequestError(item, error);
+        if (transfer->job) transfer->job->failed = true;
+        return;
+    }
 
-            // Cache the region on success (either profile region or corrected region)
-            cacheRegion(item.bucket, region);
+    // Cache the region on success (either profile region or corrected region)
+    if (item.type != WorkItem::Type::ListBuckets) {
+        cacheRegion(item.bucket, transfer->region);
+    }
 
+    switch (item.type) {
+        case WorkItem::Type::ListBuckets: {
+            auto buckets = parseListBucketsXml(body);
+            LOG_F(INFO, "S3Backend: listBuckets success, got %zu buckets (total=%lldms http=%lldms)",
+                  buckets.size(), total_ms, http_ms);
+            pushEvent(StateEvent::bucketsLoaded(std::move(buckets)));
+            break;
+        }
+        case WorkItem::Type::ListObjects: {
+            auto parse_start = std::chrono::steady_clock::now();
+            auto listing = parseListObjectsXml(body);
+            auto parse_ms = static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - parse_start).count());
+            LOG_F(INFO, "S3Backend: listObjects success bucket=%s prefix=%s count=%zu truncated=%d (total=%lldms http=%lldms parse=%lldms)",
+                  item.bucket.c_str(), item.prefix.c_str(),
+                  listing.objects.size(), listing.is_truncated, total_ms, http_ms, parse_ms);
+            pushEvent(StateEvent::objectsLoaded(
+                item.bucket,
+                item.prefix,
+                item.continuation_token,
+                std::move(listing.objects),
+                listing.next_continuation_token,
+                listing.is_truncated
+            ));
+            break;
+        }
+        case WorkItem::Type::GetObject:
+            LOG_F(INFO, "S3Backend: getObject success bucket=%s key=%s size=%zu (total=%lldms http=%lldms)",
+                  item.bucket.c_str(), item.key.c_str(), body.size(), total_ms, http_ms);
+            pushEvent(StateEvent::objectContentLoaded(item.bucket, item.key, std::move(body)));
+            break;
+        case WorkItem::Type::GetObjectRange:
             LOG_F(INFO, "S3Backend: getObjectRange success bucket=%s key=%s range=%zu-%zu got=%zu total=%zu (total=%lldms http=%lldms)",
                   item.bucket.c_str(), item.key.c_str(), item.start_byte, item.end_byte,
-                  ctx.body.size(), ctx.contentRangeTotal, static_cast<long long>(total_ms), static_cast<long long>(http_ms));
+                  body.size(), transfer->response.contentRangeTotal, total_ms, http_ms);
             pushEvent(StateEvent::objectRangeLoaded(item.bucket, item.key, item.start_byte,
-                ctx.contentRangeTotal, std::move(ctx.body)));
-            return;  // Success
+                transfer->response.contentRangeTotal, std::move(body), item.tag));
+            break;
+        case WorkItem::Type::GetObjectStreaming:
+            break;  // Runs as a StreamingJob of GetObjectPart transfers
+        case WorkItem::Type::GetObjectPart: {
+            StreamingJob& job = *transfer->job;
+            auto it = job.parts.find(item.start_byte);
+            size_t expected = item.end_byte - item.start_byte + 1;
+            if (it == job.parts.end() || it->second.received != expected) {
+                LOG_F(WARNING, "S3Backend: getObjectPart short read bucket=%s key=%s range=%zu-%zu got=%zu",
+                      item.bucket.c_str(), item.key.c_str(), item.start_byte, item.end_byte,
+                      it == job.parts.end() ? 0 : it->second.received);
+                pushRequestError(item, "ERROR: Incomplete response for byte range " +
+                    std::to_string(item.start_byte) + "-" + std::to_string(item.end_byte));
+                job.failed = true;
+                break;
+            }
+            LOG_F(1, "S3Backend: getObjectPart complete bucket=%s key=%s range=%zu-%zu (http=%lldms)",
+                  item.bucket.c_str(), item.key.c_str(), item.start_byte, item.end_byte, http_ms);
+            it->second.done = true;
+            job.drain();
+            break;
         }
     }
-    else if (item.type == WorkItem::Type::GetObjectStreaming) {
-        // Check cache first, fall back to profile region
-        std::string cachedRegion = getCachedRegion(item.bucket);
-        std::string region = cachedRegion.empty() ? m_profile.region : cachedRegion;
-
-        // Validate region is not empty
-        if (region.empty()) {
-            LOG_F(ERROR, "S3Backend: region is empty for bucket=%s, profile.region=%s, cached=%s",
-                  item.bucket.c_str(), m_profile.region.c_str(), cachedRegion.c_str());
-            pushEvent(StateEvent::objectRangeError(item.bucket, item.key, item.start_byte,
-                "ERROR: Region not configured. Please ensure your AWS profile has a valid region."));
-            return;
-        }
+}
 
-        bool retried = false;
+// ============================================================================
+// Parallel streaming downloads
+// ============================================================================
 
-        // Retry loop for handling PermanentRedirect
-        for (int attempt = 0; attempt < 2; ++attempt) {
-            std::string host;
-            std::string path;
-            if (!m_profile.endpoint_url.empty()) {
-                host = parseEndpointHost(m_profile.endpoint_url);
-                path = "/" + item.bucket + "/" + item.key;
-            } else {
-                host = item.bucket + ".s3." + region + ".amazonaws.com";
-                path = "/" + item.key;
-            }
-            LOG_F(INFO, "S3Backend: streaming object bucket=%s key=%s startByte=%zu totalSize=%zu host=%s region=%s%s",
-                  item.bucket.c_str(), item.key.c_str(), item.start_byte, item.total_size,
-                  host.c_str(), region.c_str(), retried ? " (retry)" : "");
-
-            auto signedReq = aws_sign_request(
-                "GET", host, path, "", region, "s3",
-                m_profile.access_key_id, m_profile.secret_access_key, "",
-                m_profile.session_token
-            );
-
-            // Add Range header if starting from non-zero offset
-            if (item.start_byte > 0) {
-                signedReq.headers["Range"] = "bytes=" + std::to_string(item.start_byte) + "-";
-            }
-
-            auto http_start = std::chrono::steady_clock::now();
+void S3Backend::startStreamingJob(WorkItem item) {
+    auto job = std::make_shared<StreamingJob>();
 
-            CURL* curl = getThreadCurl();
-            if (!curl) {
-                pushEvent(StateEvent::objectRangeError(item.bucket, item.key, item.start_byte,
-                    "ERROR: Failed to get thread-local curl handle"));
-                return;
-            }
+    // Only worth splitting when there are at least a couple of parts' worth left
+    size_t remaining = item.total_size > item.start_byte ? item.total_size - item.start_byte : 0;
+    if (item.sink) {
+        job->window = std::max(item.sink->queueLimit(), StreamingJob::MIN_PART_SIZE);
+    }
+    if (remaining <= 2 * StreamingJob::PART_SIZE) {
+        job->partSize = std::max<size_t>(remaining, 1);
+        job->parallelism = 1;
+        job->adaptive = false;
+    } else {
+        // Small enough parts that the most parallelism still fits the window
+        job->partSize = std::clamp(job->window / StreamingJob::MAX_PARALLELISM,
+                                   StreamingJob::MIN_PART_SIZE, StreamingJob::PART_SIZE);
+    }
 
-            // Set up streaming context
-            StreamingDownloadContext streamCtx;
-            streamCtx.backend = this;
-            streamCtx.bucket = item.bucket;
-            streamCtx.key = item.key;
-            streamCtx.startByte = item.start_byte;
-            streamCtx.totalSize = item.total_size;
-            streamCtx.cancel_flag = item.cancel_flag;
-            streamCtx.pushEvent = [this](StateEvent event) { this->pushEvent(std::move(event)); };
-
-            curl_easy_setopt(curl, CURLOPT_URL, signedReq.url.c_str());
-            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, streamingWriteCallback);
-            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &streamCtx);
-            curl_easy_setopt(curl, CURLOPT_TIMEOUT, 300L);  // 5 minute timeout for large files
-
-            if (item.cancel_flag) {
-                curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
-                curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, cancelCheckProgressCallback);
-                curl_easy_setopt(curl, CURLOPT_XFERINFODATA, item.cancel_flag.get());
-            }
+    job->nextPartStart = item.start_byte;
+    job->emitOffset = item.start_byte;
+    job->started = std::chrono::steady_clock::now();
+    job->windowStart = job->started;
+    job->pushEvent = [this](StateEvent event) { this->pushEvent(std::move(event)); };
+    job->item = std::move(item);
+
+    LOG_F(INFO, "S3Backend: streaming object bucket=%s key=%s startByte=%zu totalSize=%zu in %zuKB parts%s",
+          job->item.bucket.c_str(), job->item.key.c_str(), job->item.start_byte, job->item.total_size,
+          job->partSize / 1024, job->item.sink ? " (direct to sink)" : "");
+    m_streamingJobs.push_back(std::move(job));
+}
 
-            struct curl_slist* headerList = nullptr;
-            for (const auto& [key, value] : signedReq.headers) {
-                std::string header = key + ": " + value;
-                headerList = curl_slist_append(headerList, header.c_str());
-            }
-            if (headerList) {
-                curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headerList);
+void S3Backend::scheduleStreamingParts() {
+    for (auto& job : m_streamingJobs) {
+        if (job->failed || (job->item.cancel_flag && job->item.cancel_flag->load())) continue;
+
+        // Completed parts wait in memory for the head part, so also cap how far
+        // ahead of it we are allowed to run
+        while (job->inFlight < job->parallelism &&
+               (job->parts.empty() || (job->parts.size() + 1) * job->partSize <= job->window) &&
+               job->nextPartStart < job->item.total_size &&
+               m_transfers.size() < m_maxConcurrent) {
+            size_t start = job->nextPartStart;
+            size_t end = std::min(start + job->partSize, job->item.total_size) - 1;
+            job->parts[start].end = end;
+            job->nextPartStart = end + 1;
+
+            auto transfer = std::make_unique<Transfer>();
+            transfer->item = job->item;
+            transfer->item.type = WorkItem::Type::GetObjectPart;
+            transfer->item.start_byte = start;
+            transfer->item.end_byte = end;
+            transfer->job = job;
+            ++job->inFlight;
+            if (!submitTransfer(std::move(transfer))) {
+                job->failed = true;
+                break;
             }
+        }
+    }
+}
 
-            CURLcode res = curl_easy_perform(curl);
-
-            if (headerList) curl_slist_free_all(headerList);
-            // Don't cleanup curl - it's reused via thread-local storage
-
-            auto http_end = std::chrono::steady_clock::now();
-
-            if (res == CURLE_ABORTED_BY_CALLBACK || (item.cancel_flag && item.cancel_flag->load())) {
-                LOG_F(INFO, "S3Backend: getObjectStreaming cancelled bucket=%s key=%s",
-                      item.bucket.c_str(), item.key.c_str());
-                return;
-            }
+void S3Backend::updateStreamingJobs() {
+    auto now = std::chrono::steady_clock::now();
 
-            auto now = std::chrono::steady_clock::now();
-            auto total_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - item.queued_at).count();
-            auto http_ms = std::chrono::duration_cast<std::chrono::milliseconds>(http_end - http_start).count();
+    for (auto it = m_streamingJobs.begin(); it != m_streamingJobs.end();) {
+        StreamingJob& job = **it;
+        bool cancelled = job.item.cancel_flag && job.item.cancel_flag->load();
 
-            if (res != CURLE_OK) {
-                LOG_F(WARNING, "S3Backend: getObjectStreaming HTTP error: %s (total=%lldms http=%lldms)",
-                      curl_easy_strerror(res), static_cast<long long>(total_ms), static_cast<long long>(http_ms));
-                pushEvent(StateEvent::objectRangeError(item.bucket, item.key, item.start_byte,
-                    "ERROR: " + std::string(curl_easy_strerror(res))));
-                return;
+        if (job.finished() || ((job.failed || cancelled) && job.inFlight == 0)) {
+            if (job.finished()) {
+                double seconds = std::chrono::duration<double>(now - job.started).count();
+                double mb = static_cast<double>(job.item.total_size - job.item.start_byte) / (1024.0 * 1024.0);
+                LOG_F(INFO, "S3Backend: getObjectStreaming complete bucket=%s key=%s downloaded=%zu bytes in %.1fs (%.1f MB/s, up to %zu parts in flight)",
+                      job.item.bucket.c_str(), job.item.key.c_str(), job.item.total_size,
+                      seconds, seconds > 0 ? mb / seconds : 0.0, job.peakParallelism);
             }
+            it = m_streamingJobs.erase(it);
+            continue;
+        }
 
-            // Check for S3 error in any buffered response (errors come as XML)
-            std::string error = extractError(streamCtx.buffer);
-            if (!error.empty()) {
-                // Check for PermanentRedirect error
-                std::string errorCode = extractTag(streamCtx.buffer, "Code");
-                if (errorCode == "PermanentRedirect" && attempt == 0) {
-                    std::string correctEndpoint = extractTag(streamCtx.buffer, "Endpoint");
-                    LOG_F(INFO, "S3Backend: PermanentRedirect error, endpoint: '%s'", correctEndpoint.c_str());
-
-                    std::string correctRegion;
-                    if (!correctEndpoint.empty()) {
-                        correctRegion = extractRegionFromEndpoint(correctEndpoint);
-                    }
-                    if (correctRegion.empty()) {
-                        correctRegion = "us-east-1";
-                    }
-
-                    if (!correctRegion.empty() && correctRegion != region) {
-                        LOG_F(INFO, "S3Backend: retrying with region=%s (was %s)",
-                              correctRegion.c_str(), region.c_str());
-                        region = correctRegion;
-                        cacheRegion(item.bucket, correctRegion);
-                        retried = true;
-                        continue;
-                    }
+        // Offer bytes a sink refused earlier, and resume the head part once the
+        // backlog has cleared
+        if (job.item.sink && !job.pending.empty()) {
+            job.drain();
+        }
+        if (job.pending.size() < StreamingJob::MAX_PENDING) {
+            for (auto& [easy, transfer] : m_transfers) {
+                if (transfer->paused && transfer->job.get() == &job) {
+                    transfer->paused = false;
+                    curl_easy_pause(easy, CURLPAUSE_CONT);
                 }
-
-                LOG_F(WARNING, "S3Backend: getObjectStreaming S3 error: %s", error.c_str());
-                pushEvent(StateEvent::objectRangeError(item.bucket, item.key, item.start_byte, error));
-                return;
             }
+        }
 
-            // Cache region on success
-            cacheRegion(item.bucket, region);
-
-            // Emit any remaining buffered data as final chunk
-            if (!streamCtx.buffer.empty()) {
-                size_t chunkOffset = item.start_byte + streamCtx.bytesReceived;
-                LOG_F(1, "S3Backend: emitting final chunk of %zu bytes at offset %zu",
-                      streamCtx.buffer.size(), chunkOffset);
-                pushEvent(StateEvent::objectRangeLoaded(item.bucket, item.key, chunkOffset,
-                    item.total_size, std::move(streamCtx.buffer)));
+        // Hill-climb the number of parts in flight: keep adding connections while
+        // each one buys at least 10% more throughput, back off when it drops
+        double elapsed = std::chrono::duration<double>(now - job.windowStart).count();
+        if (job.adaptive && elapsed >= 1.0 && job.nextPartStart < job.item.total_size) {
+            double throughput = static_cast<double>(job.windowBytes) / elapsed;
+            size_t previous = job.parallelism;
+            if (job.lastThroughput == 0.0 || throughput > job.lastThroughput * 1.1) {
+                job.parallelism = std::min(job.parallelism + 1, StreamingJob::MAX_PARALLELISM);
+            } else if (throughput < job.lastThroughput * 0.9 && job.parallelism > 1) {
+                --job.parallelism;
             }
-
-            LOG_F(INFO, "S3Backend: getObjectStreaming complete bucket=%s key=%s downloaded=%zu bytes (total=%lldms http=%lldms)",
-                  item.bucket.c_str(), item.key.c_str(),
-                  item.start_byte + streamCtx.bytesReceived + streamCtx.buffer.size(),
-                  static_cast<long long>(total_ms), static_cast<long long>(http_ms));
-            return;  // Success
+            job.peakParallelism = std::max(job.peakParallelism, job.parallelism);
+            if (job.parallelism != previous) {
+                LOG_F(1, "S3Backend: streaming key=%s throughput=%.1f MB/s, parallelism %zu -> %zu",
+                      job.item.key.c_str(), throughput / (1024.0 * 1024.0), previous, job.parallelism);
+            }
+            job.lastThroughput = throughput;
+            job.windowBytes = 0;
+            job.windowStart = now;
         }
+        ++it;
     }
 }
 
-std::string S3Backend::httpGet(const std::string& url,
-                               const std::map<std::string, std::string>& headers,
-                               std::shared_ptr<std::atomic<bool>> cancel_flag) {
-    CURL* curl = getThreadCurl();
-    if (!curl) return "ERROR: Failed to get thread-local curl handle";
-
-    std::string response;
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
+size_t S3Backend::streamingPartWriteCallback(char* contents, size_t size, size_t nmemb, void* userdata) {
+    size_t total = size * nmemb;
+    auto* transfer = static_cast<Transfer*>(userdata);
+    StreamingJob& job = *transfer->job;
 
-    // For cancellable requests, enable progress callback to check cancellation
-    if (cancel_flag) {
-        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
-        curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, cancelCheckProgressCallback);
-        curl_easy_setopt(curl, CURLOPT_XFERINFODATA, cancel_flag.get());
+    if (job.failed || (transfer->item.cancel_flag && transfer->item.cancel_flag->load())) {
+        return 0;  // Abort transfer
     }
 
-    struct curl_slist* headerList = nullptr;
-    for (const auto& [key, value] : headers) {
-        std::string header = key + ": " + value;
-        headerList = curl_slist_append(headerList, header.c_str());
+    // Anything but 206 is an S3 error document (or a server ignoring Range);
+    // keep it aside for error handling instead of mixing it into the file
+    long status = 0;
+    curl_easy_getinfo(transfer->easy, CURLINFO_RESPONSE_CODE, &status);
+    if (status != 206) {
+        if (transfer->response.body.size() + total > 1024 * 1024) {
+            return 0;
+        }
+        transfer->response.body.append(contents, total);
+        return total;
     }
-    if (headerList) {
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headerList);
+
+    auto it = job.parts.find(transfer->item.start_byte);
+    if (it == job.parts.end()) {
+        return 0;
     }
 
-    CURLcode res = curl_easy_perform(curl);
+    // The consumer is behind: stop reading the head part until it catches up
+    // (updateStreamingJobs resumes it). Later parts are bounded by the window.
+    if (it == job.parts.begin() && job.pending.size() >= StreamingJob::MAX_PENDING) {
+        transfer->paused = true;
+        return CURL_WRITEFUNC_PAUSE;
+    }
 
-    if (headerList) curl_slist_free_all(headerList);
-    // Don't cleanup curl - it's reused via thread-local storage
+    it->second.data.append(contents, total);
+    it->second.received += total;
+    job.windowBytes += total;
 
-    if (res == CURLE_ABORTED_BY_CALLBACK) {
-        return "CANCELLED";  // Special marker for cancelled request
+    // The head part is handed out as it arrives
+    if (it == job.parts.begin()) {
+        job.drain();
     }
-    if (res != CURLE_OK) {
-        return "ERROR: " + std::string(curl_easy_strerror(res));
-    }
-
-    return response;
+    return total;
 }
 
 std::string S3Backend::urlEncode(const std::string& value) {
@@ -1629,6 +1389,16 @@ S3Backend::ListObjectsResult S3Backend::parseListObjectsXml(const std::string& x
 
         obj.last_modified = extractTag(contentsXml, "LastModified");
 
+        // ETags come quoted, sometimes XML-escaped: "abc" or &quot;abc&quot;
+        obj.etag = extractTag(contentsXml, "ETag");
+        for (const std::string quote : {"&quot;", "\""}) {
+            size_t n = quote.size();
+            if (obj.etag.size() >= 2 * n && obj.etag.compare(0, n, quote) == 0 &&
+                obj.etag.compare(obj.etag.size() - n, n, quote) == 0) {
+                obj.etag = obj.etag.substr(n, obj.etag.size() - 2 * n);
+            }
+        }
+
         // Get display name
         size_t lastSlash = obj.key.rfind('/');
         obj.display_name = (lastSlash != std::string::npos) ?
@@ -9,7 +9,7 @@
 #include <thread>
 #include <atomic>
 #include <deque>
-#include <condition_variable>
+#include <memory>
 #include <chrono>
 #include <curl/curl.h>
 
@@ -24,13 +24,16 @@ struct S3Object {
     std::string display_name;
     int64_t size = 0;
     std::string last_modified;
+    std::string etag;  // Identifies the object version (quotes stripped)
     bool is_folder = false;
 };
 
 // S3 backend implementation
 class S3Backend : public IBackend {
 public:
-    explicit S3Backend(const AWSProfile& profile, size_t numWorkers = 5);
+    // maxConcurrent bounds the number of requests in flight at once; prefetches
+    // may use at most half of them so user actions always find a free slot
+    explicit S3Backend(const AWSProfile& profile, size_t maxConcurrent = 64);
     ~S3Backend() override;
 
     std::vector<StateEvent> takeEvents() override;
@@ -39,7 +42,8 @@ public:
         const std::string& bucket,
         const std::string& prefix,
         const std::string& continuation_token = "",
-        std::shared_ptr<std::atomic<bool>> cancel_flag = nullptr
+        std::shared_ptr<std::atomic<bool>> cancel_flag = nullptr,
+        bool lowPriority = false
     ) override;
     void getObject(
         const std::string& bucket,
@@ -53,14 +57,17 @@ public:
         const std::string& key,
         size_t startByte,
         size_t endByte,
-        std::shared_ptr<std::atomic<bool>> cancel_flag = nullptr
+        std::shared_ptr<std::atomic<bool>> cancel_flag = nullptr,
+        bool lowPriority = false,
+        uint64_t tag = 0
     ) override;
     void getObjectStreaming(
         const std::string& bucket,
         const std::string& key,
         size_t startByte,
         size_t totalSize,
-        std::shared_ptr<std::atomic<bool>> cancel_flag = nullptr
+        std::shared_ptr<std::atomic<bool>> cancel_flag = nullptr,
+        std::shared_ptr<IStreamSink> sink = nullptr
     ) override;
     void cancelAll() override;
 
@@ -102,9 +109,10 @@ public:
     void setRequestLag(float seconds) { m_requestLagSeconds = seconds; }
 
 private:
-    // Work item for the background thread
+    // Work item queued for the I/O thread
     struct WorkItem {
-        enum class Type { ListBuckets, ListObjects, GetObject, GetObjectRange, GetObjectStreaming, Shutdown };
+        // GetObjectPart is internal: one ranged piece of a parallel GetObjectStreaming
+        enum class Type { ListBuckets, ListObjects, GetObject, GetObjectRange, GetObjectStreaming, GetObjectPart };
         enum class Priority { High, Low };  // High = user action, Low = prefetch
         Type type;
         Priority priority = Priority::High;
@@ -114,15 +122,38 @@ private:
         std::string key;  // For GetObject / GetObjectRange / GetObjectStreaming
         size_t max_bytes = 0;  // For GetObject
         size_t start_byte = 0;  // For GetObjectRange / GetObjectStreaming
-        size_t end_byte = 0;    // For GetObjectRange
+        size_t end_byte = 0;    // For GetObjectRange / GetObjectPart (inclusive)
         size_t total_size = 0;  // For GetObjectStreaming (total file size)
+        uint64_t tag = 0;       // For GetObjectRange, echoed in its events
         std::chrono::steady_clock::time_point queued_at;
         std::shared_ptr<std::atomic<bool>> cancel_flag;  // Shared flag to cancel this request
+        std::shared_ptr<IStreamSink> sink;  // For GetObjectStreaming (optional)
     };
 
-    void workerThread(WorkItem::Priority priority, size_t workerIndex);
-    void processWorkItem(WorkItem& item);
+    // An HTTP request attached to the multi handle (defined in s3_backend.cpp)
+    struct Transfer;
+
+    // A streaming download split into concurrent ranged parts (defined in s3_backend.cpp)
+    struct StreamingJob;
+
     void enqueue(WorkItem item);
+    void wakeIoThread();
+
+    // I/O thread: drives every request through a single curl_multi handle
+    void ioThread();
+    void startQueuedTransfers();
+    void reapCancelledTransfers();
+    bool submitTransfer(std::unique_ptr<Transfer> transfer);
+    std::unique_ptr<Transfer> detachTransfer(CURL* easy);
+    void releaseTransfer(Transfer& transfer);
+    void completeTransfer(std::unique_ptr<Transfer> transfer, CURLcode result);
+    void pushRequestError(const WorkItem& item, const std::string& error);
+
+    // Parallel streaming downloads
+    void startStreamingJob(WorkItem item);
+    void scheduleStreamingParts();
+    void updateStreamingJobs();
+    static size_t streamingPartWriteCallback(char* contents, size_t size, size_t nmemb, void* userdata);
 
     // Helper methods for queue operations with predicates
     template<typename Predicate>
@@ -131,10 +162,6 @@ private:
     template<typename Predicate>
     bool boostFromLowToHigh(Predicate pred);
 
-    // HTTP and signing
-    std::string httpGet(const std::string& url,
-                        const std::map<std::string, std::string>& headers,
-                        std::shared_ptr<std::atomic<bool>> cancel_flag = nullptr);
     std::string urlEncode(const std::string& value);
 
     // XML parsing
@@ -148,21 +175,29 @@ private:
     ListObjectsResult parseListObjectsXml(const std::string& xml);
 
     AWSProfile m_profile;
-    size_t m_numWorkers;
+    size_t m_maxConcurrent;
+    size_t m_maxLowPriorityConcurrent;
     float m_requestLagSeconds = 0.0f;  // Artificial lag for testing
 
-    // High-priority worker threads and queue (user actions)
-    std::vector<std::thread> m_highPriorityWorkers;
+    // Pending user actions, started before anything in the low-priority queue
     mutable std::mutex m_highPriorityMutex;
-    std::condition_variable m_highPriorityCv;
     std::deque<WorkItem> m_highPriorityQueue;
 
-    // Low-priority worker threads and queue (prefetch)
-    std::vector<std::thread> m_lowPriorityWorkers;
+    // Pending prefetches
     mutable std::mutex m_lowPriorityMutex;
-    std::condition_variable m_lowPriorityCv;
     std::deque<WorkItem> m_lowPriorityQueue;
 
+    // curl_multi handle and the thread that drives it. The multi handle owns the
+    // connection, DNS and TLS session caches shared by all requests.
+    CURLM* m_multi = nullptr;
+    std::thread m_ioThread;
+
+    // Only touched by the I/O thread
+    std::map<CURL*, std::unique_ptr<Transfer>> m_transfers;
+    std::vector<CURL*> m_idleHandles;  // Easy handles kept for reuse
+    size_t m_activeLowPriority = 0;
+    std::vector<std::shared_ptr<StreamingJob>> m_streamingJobs;
+
     std::atomic<bool> m_shutdown{false};
 
     // Hover prefetch cancellation - when a new cancellable prefetch is queued,
@@ -170,7 +205,7 @@ private:
     std::shared_ptr<std::atomic<bool>> m_currentHoverCancelFlag;
     std::mutex m_hoverCancelMutex;
 
-    // Event queue (results from worker thread)
+    // Event queue (results from the I/O thread)
     std::mutex m_eventMutex;
     std::vector<StateEvent> m_events;
 
@@ -183,18 +218,4 @@ private:
     // Helper methods for region cache
     std::string getCachedRegion(const std::string& bucket) const;
     void cacheRegion(const std::string& bucket, const std::string& region);
-
-    // Shared CURL handle for connection pooling across all workers
-    CURLSH* m_curlShare = nullptr;
-    // Separate mutexes for each CURL lock data type to avoid deadlock
-    std::mutex m_curlShareMutexConnect;
-    std::mutex m_curlShareMutexDns;
-    std::mutex m_curlShareMutexSsl;
-
-    // Reset thread-local CURL handle (preserves connection cache via share)
-    void resetThreadCurl();
-
-    // Lock callbacks need access to the mutexes
-    friend void curlShareLock(CURL*, curl_lock_data, curl_lock_access, void*);
-    friend void curlShareUnlock(CURL*, curl_lock_data, void*);
 };
@@ -1,10 +1,12 @@
 #pragma once
 
 #include "events.h"
+#include "stream_sink.h"
 #include <string>
 #include <vector>
 #include <memory>
 #include <atomic>
+#include <cstdint>
 
 // Abstract backend interface
 // Implementations handle async execution and queue events for the model to poll
@@ -22,11 +24,13 @@ public:
     // Request objects in a bucket/prefix
     // continuation_token is empty for first request, or the token from previous response
     // cancel_flag can be used to cancel in-flight requests (for pagination)
+    // lowPriority = true for background requests (e.g. revalidating a cached listing)
     virtual void listObjects(
         const std::string& bucket,
         const std::string& prefix,
         const std::string& continuation_token = "",
-        std::shared_ptr<std::atomic<bool>> cancel_flag = nullptr
+        std::shared_ptr<std::atomic<bool>> cancel_flag = nullptr,
+        bool lowPriority = false
     ) = 0;
 
     // Request object content (for preview)
@@ -44,24 +48,33 @@ public:
     // Request a specific byte range of an object (for streaming large files)
     // startByte is inclusive, endByte is inclusive
     // cancel_flag can be used to cancel the request
+    // lowPriority = true for background fetches (e.g. thumbnails)
+    // tag is copied into the response event so requesters can tell their
+    // responses apart from streaming chunks of the same object (0 = untagged)
     virtual void getObjectRange(
         const std::string& bucket,
         const std::string& key,
         size_t startByte,
         size_t endByte,
-        std::shared_ptr<std::atomic<bool>> cancel_flag = nullptr
+        std::shared_ptr<std::atomic<bool>> cancel_flag = nullptr,
+        bool lowPriority = false,
+        uint64_t tag = 0
     ) = 0;
 
     // Stream an object from a starting byte offset
-    // Emits ObjectRangeLoaded events as chunks arrive from network
-    // More efficient than multiple getObjectRange calls - single HTTP request
+    // Emits ObjectRangeLoaded events as chunks arrive from network, or hands
+    // them to sink if one is given (errors are still reported as events)
+    // More efficient than multiple getObjectRange calls
+    // Stops before totalSize, which is usually the object's size but may be
+    // less to fetch only part of it
     // cancel_flag can be used to cancel the request
     virtual void getObjectStreaming(
         const std::string& bucket,
         const std::string& key,
         size_t startByte,
         size_t totalSize,
-        std::shared_ptr<std::atomic<bool>> cancel_flag = nullptr
+        std::shared_ptr<std::atomic<bool>> cancel_flag = nullptr,
+        std::shared_ptr<IStreamSink> sink = nullptr
     ) = 0;
 
     // Cancel all pending requests (optional, for cleanup)
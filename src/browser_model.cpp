@@ -1,11 +1,15 @@
 #include "browser_model.h"
+#include "listing_cache.h"
 #include "loguru.hpp"
 #include <unordered_set>
 #include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <ctime>
 
-BrowserModel::BrowserModel() = default;
+BrowserModel::BrowserModel() {
+    pruneListingCache();
+}
 
 BrowserModel::~BrowserModel() {
     // Cancel any streaming downloads so worker threads can exit
@@ -17,10 +21,15 @@ BrowserModel::~BrowserModel() {
     if (m_paginationCancelFlag) {
         m_paginationCancelFlag->store(true);
     }
+
+    releaseSeekIndex();
 }
 
 void BrowserModel::setSettings(AppSettings settings) {
     m_settings = std::move(settings);
+    int64_t budgetMB = std::max<int64_t>(m_settings.cache_budget_mb, 16);
+    m_cacheBudget.setBudget(static_cast<size_t>(budgetMB) * 1024 * 1024);
+    enforceCacheBudget();
 }
 
 void BrowserModel::recordRecentPath(const std::string& path) {
@@ -151,9 +160,11 @@ void BrowserModel::selectProfile(int index) {
     m_selectedProfileIdx = index;
 
     // Clear state
+    cancelThumbnailFetches();
     m_buckets.clear();
     m_bucketsError.clear();
     m_nodes.clear();
+    m_cacheBudget.clear(CacheBudget::Folder);
     m_currentBucket.clear();
     m_currentPrefix.clear();
 
@@ -175,6 +186,8 @@ void BrowserModel::refresh() {
     m_bucketsLoading = true;
     m_nodes.clear();
     m_previewCache.clear();
+    m_cacheBudget.clear(CacheBudget::Folder);
+    m_cacheBudget.clear(CacheBudget::Preview);
     m_pendingObjectRequests.clear();
     m_lastHoveredFile.clear();
     m_lastHoveredFolder.clear();
@@ -192,9 +205,25 @@ void BrowserModel::refresh() {
 
 void BrowserModel::loadFolder(const std::string& bucket, const std::string& prefix) {
     auto& node = getOrCreateNode(bucket, prefix);
+    m_cacheBudget.countLookup(CacheBudget::Folder, node.loaded);
+
+    // If already loaded, don't reload. A listing from the cache that was
+    // never revalidated (prefetched, or given up on when we navigated away)
+    // is revalidated now.
+    if (node.loaded) {
+        if (node.fromCache && !node.revalidating) {
+            revalidateFolder(node);
+        }
+        return;
+    }
 
-    // If already loaded, don't reload
-    if (node.loaded) return;
+    // Seen in an earlier session: show the saved listing now and fetch the
+    // current one in the background. Checked before boosting, since a prefetch
+    // of this folder may already be queued.
+    if (loadCachedListing(node)) {
+        revalidateFolder(node);
+        return;
+    }
 
     // Try to boost any pending prefetch request to high priority.
     // This makes it non-cancellable (cancel_flag is cleared on boost).
@@ -213,6 +242,7 @@ void BrowserModel::loadFolder(const std::string& bucket, const std::string& pref
     // - Previous prefetch is in-flight (will get duplicate event, which is OK)
     LOG_F(INFO, "Loading folder: bucket=%s prefix=%s", bucket.c_str(), prefix.c_str());
     node.objects.clear();
+    node.resetView();
     node.error.clear();
     node.loading = true;
 
@@ -315,6 +345,11 @@ void BrowserModel::navigateInto(const std::string& bucket, const std::string& pr
                   bucket.c_str(), prefix.c_str());
             loadMore(bucket, prefix);
         }
+
+        // Likewise restart a revalidation cut short by navigating away
+        if (node->fromCache && !node->revalidating) {
+            revalidateFolder(*getNode(bucket, prefix));
+        }
     }
 }
 
@@ -328,13 +363,16 @@ void BrowserModel::addManualBucket(const std::string& bucket_name) {
     m_buckets.push_back(std::move(newBucket));
 }
 
-std::string BrowserModel::previewContent() const {
+std::shared_ptr<const ContentView> BrowserModel::previewContent() const {
     // If we have a streaming preview, return its decompressed content
     if (m_streamingPreview) {
-        return m_streamingPreview->getAllContent();
+        return m_streamingPreview->content();
     }
     // Otherwise return the raw preview content
-    return m_previewContent;
+    if (!m_previewContentView) {
+        m_previewContentView = std::make_shared<ContentView>(m_previewContent);
+    }
+    return m_previewContentView;
 }
 
 void BrowserModel::selectFile(const std::string& bucket, const std::string& key) {
@@ -345,21 +383,25 @@ void BrowserModel::selectFile(const std::string& bucket, const std::string& key)
 
     // Cancel any existing streaming download
     cancelStreamingDownload();
+    releaseSeekIndex();
 
     LOG_F(INFO, "Selecting file: bucket=%s key=%s", bucket.c_str(), key.c_str());
     m_selectedBucket = bucket;
     m_selectedKey = key;
     m_previewContent.clear();
+    m_previewContentView.reset();
     m_previewError.clear();
     m_previewSupported = isPreviewSupported(key);
 
     // Find the file size from the folder node
     m_selectedFileSize = 0;
+    m_selectedETag.clear();
     const auto* node = getNode(m_currentBucket, m_currentPrefix);
     if (node) {
         for (const auto& obj : node->objects) {
-            if (!obj.is_folder && obj.key == key) {
-                m_selectedFileSize = obj.size;
+            if (!obj.isFolder() && obj.key() == key) {
+                m_selectedFileSize = obj.size();
+                m_selectedETag = obj.etag();
                 break;
             }
         }
@@ -369,9 +411,12 @@ void BrowserModel::selectFile(const std::string& bucket, const std::string& key)
         // Check if we have cached content from prefetch
         std::string cacheKey = makePreviewCacheKey(bucket, key);
         auto it = m_previewCache.find(cacheKey);
+        m_cacheBudget.countLookup(CacheBudget::Preview, it != m_previewCache.end());
         if (it != m_previewCache.end()) {
+            m_cacheBudget.touch(CacheBudget::Preview, cacheKey);
             LOG_F(INFO, "Using cached preview for bucket=%s key=%s", bucket.c_str(), key.c_str());
             m_previewContent = it->second;
+            m_previewContentView.reset();
             m_previewLoading = false;
 
             // Always create StreamingFilePreview for unified data access
@@ -419,6 +464,44 @@ void BrowserModel::prefetchFilePreview(const std::string& bucket, const std::str
     m_backend->getObject(bucket, key, PREVIEW_MAX_BYTES, true /* lowPriority */, true /* cancellable */);
 }
 
+void BrowserModel::fetchThumbnailBytes(const std::string& bucket, const std::string& key, size_t maxBytes) {
+    if (!m_backend || maxBytes == 0) return;
+
+    std::string cacheKey = makePreviewCacheKey(bucket, key);
+    if (m_thumbnailFetches.count(cacheKey)) return;
+
+    ThumbnailFetch fetch;
+    fetch.cancelFlag = std::make_shared<std::atomic<bool>>(false);
+    fetch.tag = m_nextThumbnailTag++;
+    m_thumbnailFetches[cacheKey] = fetch;
+    m_backend->getObjectRange(bucket, key, 0, maxBytes - 1, fetch.cancelFlag, true /* lowPriority */, fetch.tag);
+}
+
+void BrowserModel::cancelThumbnailFetch(const std::string& bucket, const std::string& key) {
+    auto it = m_thumbnailFetches.find(makePreviewCacheKey(bucket, key));
+    if (it == m_thumbnailFetches.end()) return;
+    *it->second.cancelFlag = true;
+    m_thumbnailFetches.erase(it);
+}
+
+void BrowserModel::cancelThumbnailFetches() {
+    // The backend drops cancelled requests silently; tell the requester instead
+    for (auto& [cacheKey, fetch] : m_thumbnailFetches) {
+        *fetch.cancelFlag = true;
+        size_t slashPos = cacheKey.find('/');
+        ThumbnailBytes result;
+        result.bucket = cacheKey.substr(0, slashPos);
+        result.key = cacheKey.substr(slashPos + 1);
+        result.cancelled = true;
+        m_thumbnailBytes.push_back(std::move(result));
+    }
+    m_thumbnailFetches.clear();
+}
+
+std::vector<ThumbnailBytes> BrowserModel::takeThumbnailBytes() {
+    return std::move(m_thumbnailBytes);
+}
+
 std::string BrowserModel::makePreviewCacheKey(const std::string& bucket, const std::string& key) {
     return bucket + "/" + key;
 }
@@ -459,22 +542,28 @@ void BrowserModel::prefetchFolder(const std::string& bucket, const std::string&
         }
     }
 
-    // Create node and mark as loading to prevent loadFolder() from making a duplicate request
-    // if user clicks before the prefetch completes.
+    // A listing from the cache needs no prefetch; it's revalidated when opened
     auto& newNode = getOrCreateNode(bucket, prefix);
+    m_lastHoveredFolder = folderKey;
+    if (loadCachedListing(newNode)) return;
+
+    // Mark as loading to prevent loadFolder() from making a duplicate request
+    // if user clicks before the prefetch completes.
     newNode.loading = true;
 
-    m_lastHoveredFolder = folderKey;
     LOG_F(INFO, "Prefetching folder on hover: bucket=%s prefix=%s", bucket.c_str(), prefix.c_str());
     m_backend->listObjectsPrefetch(bucket, prefix, true /* cancellable */);
 }
 
 void BrowserModel::clearSelection() {
     cancelStreamingDownload();
+    releaseSeekIndex();
     m_selectedBucket.clear();
     m_selectedKey.clear();
     m_selectedFileSize = 0;
+    m_selectedETag.clear();
     m_previewContent.clear();
+    m_previewContentView.reset();
     m_previewError.clear();
     m_previewLoading = false;
     m_previewSupported = false;
@@ -605,8 +694,31 @@ bool BrowserModel::isPreviewSupported(const std::string& key) {
 bool BrowserModel::processEvents() {
     if (!m_backend) return false;
 
+    // Streamed chunks reach the preview directly on its decode worker, so
+    // progress there counts as activity even without backend events
+    bool streamingProgressed = false;
+    if (m_streamingPreview) {
+        size_t downloaded = m_streamingPreview->bytesDownloaded();
+        if (downloaded != m_lastStreamingBytesDownloaded) {
+            m_lastStreamingBytesDownloaded = downloaded;
+            streamingProgressed = true;
+        }
+
+        // A full pass has recorded every checkpoint; persist them right away
+        if (m_seekIndex && m_streamingPreview->isComplete()) {
+            m_seekIndex->saveIfDirty();
+        }
+
+        // Corrupt data stops the decoding; stop the download too, keeping
+        // what was decoded on screen with the error
+        if (m_streamingCancelFlag && !m_streamingPreview->error().empty()) {
+            m_streamingCancelFlag->store(true);
+            m_streamingCancelFlag.reset();
+        }
+    }
+
     auto events = m_backend->takeEvents();
-    if (events.empty()) return false;
+    if (events.empty()) return streamingProgressed;
 
     for (auto& event : events) {
         switch (event.type) {
@@ -634,30 +746,52 @@ bool BrowserModel::processEvents() {
                           getNode(payload.bucket, payload.prefix)->objects.size() + payload.objects.size() : payload.objects.size());
                 auto& node = getOrCreateNode(payload.bucket, payload.prefix);
 
+                // Background listing of a folder shown from the listing cache:
+                // collect every page, then apply it in one go
+                if (node.revalidating) {
+                    if (payload.continuation_token.empty()) {
+                        node.freshObjects.clear();
+                    }
+                    appendListingPage(node.freshObjects, payload.objects, !payload.continuation_token.empty());
+                    recordNodeMemory(makeNodeKey(payload.bucket, payload.prefix), node);
+                    if (!payload.is_truncated) {
+                        applyRevalidatedListing(node);
+                    } else if (m_backend && payload.bucket == m_currentBucket && payload.prefix == m_currentPrefix) {
+                        m_backend->listObjects(payload.bucket, payload.prefix, payload.next_continuation_token,
+                                               m_paginationCancelFlag, true /* lowPriority */);
+                    } else {
+                        node.revalidating = false;
+                        node.freshObjects.clear();
+                    }
+                    break;
+                }
+                if (node.fromCache) {
+                    // A page of a revalidation given up on when we navigated
+                    // away; the cached listing stays until the next visit
+                    break;
+                }
+
                 // If this is a continuation, append; otherwise replace
                 if (payload.continuation_token.empty()) {
-                    node.objects = std::move(payload.objects);
+                    node.objects.clear();
+                    node.resetView();
+                    appendListingPage(node.objects, payload.objects, false);
                 } else {
-                    // Build a set of existing keys to avoid duplicates
-                    // (can happen if multiple requests were in flight for the same folder)
-                    std::unordered_set<std::string> existingKeys;
-                    existingKeys.reserve(node.objects.size());
-                    for (const auto& obj : node.objects) {
-                        existingKeys.insert(obj.key);
-                    }
-
-                    for (auto& obj : payload.objects) {
-                        if (existingKeys.find(obj.key) == existingKeys.end()) {
-                            node.objects.push_back(std::move(obj));
-                        }
-                    }
+                    appendListingPage(node.objects, payload.objects, true);
                 }
 
                 node.next_continuation_token = payload.next_continuation_token;
                 node.is_truncated = payload.is_truncated;
                 node.loading = false;
                 node.loaded = true;
+                node.fromCache = false;
                 node.error.clear();
+                recordNodeMemory(makeNodeKey(payload.bucket, payload.prefix), node);
+
+                // Save complete listings for the next session
+                if (!node.is_truncated) {
+                    saveListing(listingPath(payload.bucket, payload.prefix), payload.prefix, node.objects);
+                }
 
                 // If this is the currently viewed folder, handle auto-pagination and prefetch
                 if (payload.bucket == m_currentBucket && payload.prefix == m_currentPrefix) {
@@ -681,6 +815,12 @@ bool BrowserModel::processEvents() {
                 LOG_F(WARNING, "Event: ObjectsLoadError bucket=%s prefix=%s error=%s",
                       payload.bucket.c_str(), payload.prefix.c_str(), payload.error_message.c_str());
                 auto& node = getOrCreateNode(payload.bucket, payload.prefix);
+                if (node.revalidating) {
+                    // Keep showing the cached listing
+                    node.revalidating = false;
+                    node.freshObjects.clear();
+                    break;
+                }
                 node.loading = false;
                 node.error = payload.error_message;
                 break;
@@ -693,11 +833,13 @@ bool BrowserModel::processEvents() {
                 // Cache the raw content for future use
                 std::string cacheKey = makePreviewCacheKey(payload.bucket, payload.key);
                 m_previewCache[cacheKey] = payload.content;
+                m_cacheBudget.record(CacheBudget::Preview, cacheKey, payload.content.size() + cacheKey.size() * 2);
                 m_pendingObjectRequests.erase(cacheKey);
 
                 // Update preview if this is the selected file
                 if (payload.bucket == m_selectedBucket && payload.key == m_selectedKey) {
                     m_previewContent = payload.content;
+                    m_previewContentView.reset();
                     m_previewLoading = false;
                     m_previewError.clear();
 
@@ -736,14 +878,36 @@ bool BrowserModel::processEvents() {
                       payload.bucket.c_str(), payload.key.c_str(),
                       payload.startByte, payload.data.size(), payload.totalSize);
 
+                // Only thumbnail fetches are tagged; responses to cancelled
+                // ones are dropped
+                if (payload.tag != 0) {
+                    auto thumbnail = m_thumbnailFetches.find(makePreviewCacheKey(payload.bucket, payload.key));
+                    if (thumbnail != m_thumbnailFetches.end() && thumbnail->second.tag == payload.tag) {
+                        m_thumbnailFetches.erase(thumbnail);
+                        ThumbnailBytes result;
+                        result.bucket = payload.bucket;
+                        result.key = payload.key;
+                        result.data = std::move(payload.data);
+                        m_thumbnailBytes.push_back(std::move(result));
+                    }
+                    break;
+                }
+
+                if (payload.startByte == m_seekTableRequestStart &&
+                    payload.bucket == m_selectedBucket && payload.key == m_selectedKey) {
+                    m_seekTableRequestStart = SIZE_MAX;
+                    handleZstdSeekTable(payload.data);
+                    break;
+                }
+
                 // Only process if this is for the current streaming preview
                 if (m_streamingPreview &&
                     payload.bucket == m_streamingPreview->bucket() &&
                     payload.key == m_streamingPreview->key()) {
 
+                    // Only reached for downloads started without a sink; queued
+                    // for the preview's decode worker like sink-delivered chunks
                     m_streamingPreview->appendChunk(payload.data, payload.startByte);
-                    // Chunks arrive automatically from the single streaming request
-                    // No need to request next chunk - CURL streams them as they arrive
                 }
                 break;
             }
@@ -753,6 +917,25 @@ bool BrowserModel::processEvents() {
                       payload.bucket.c_str(), payload.key.c_str(),
                       payload.startByte, payload.error_message.c_str());
 
+                if (payload.tag != 0) {
+                    auto thumbnail = m_thumbnailFetches.find(makePreviewCacheKey(payload.bucket, payload.key));
+                    if (thumbnail != m_thumbnailFetches.end() && thumbnail->second.tag == payload.tag) {
+                        m_thumbnailFetches.erase(thumbnail);
+                        ThumbnailBytes result;
+                        result.bucket = payload.bucket;
+                        result.key = payload.key;
+                        result.error = payload.error_message;
+                        m_thumbnailBytes.push_back(std::move(result));
+                    }
+                    break;
+                }
+
+                if (payload.startByte == m_seekTableRequestStart &&
+                    payload.bucket == m_selectedBucket && payload.key == m_selectedKey) {
+                    m_seekTableRequestStart = SIZE_MAX;
+                    break;
+                }
+
                 // Only process if this is for the current streaming preview
                 if (m_streamingPreview &&
                     payload.bucket == m_streamingPreview->bucket() &&
@@ -765,6 +948,8 @@ bool BrowserModel::processEvents() {
             }
         }
     }
+
+    enforceCacheBudget();
     return true;
 }
 
@@ -786,10 +971,105 @@ FolderNode& BrowserModel::getOrCreateNode(const std::string& bucket, const std::
     if (node.bucket.empty()) {
         node.bucket = bucket;
         node.prefix = prefix;
+        recordNodeMemory(key, node);
+    } else {
+        m_cacheBudget.touch(CacheBudget::Folder, key);
     }
     return node;
 }
 
+void BrowserModel::recordNodeMemory(const std::string& nodeKey, FolderNode& node) {
+    // One view slot per object, which the UI builds once it's shown
+    node.memoryBytes = sizeof(FolderNode) + nodeKey.size() * 2 + node.next_continuation_token.capacity() +
+                       node.objects.memoryBytes() + node.freshObjects.memoryBytes() +
+                       node.objects.size() * sizeof(size_t) +
+                       node.folderSorter.memoryBytes() + node.fileSorter.memoryBytes();
+    m_cacheBudget.record(CacheBudget::Folder, nodeKey, node.memoryBytes);
+}
+
+void BrowserModel::enforceCacheBudget() {
+    if (m_cacheBudget.usedBytes() <= m_cacheBudget.budget()) return;
+
+    std::string currentNode = makeNodeKey(m_currentBucket, m_currentPrefix);
+    std::string selectedPreview = makePreviewCacheKey(m_selectedBucket, m_selectedKey);
+    auto evicted = m_cacheBudget.evict([&](CacheBudget::Kind kind, const std::string& key) {
+        if (kind == CacheBudget::Preview) {
+            return key == selectedPreview;
+        }
+        if (key == currentNode) return true;
+        auto it = m_nodes.find(key);
+        return it != m_nodes.end() && (it->second.loading || it->second.revalidating);
+    });
+    if (evicted.empty()) return;  // Everything left is pinned
+
+    for (const auto& [kind, key] : evicted) {
+        if (kind == CacheBudget::Folder) {
+            m_nodes.erase(key);
+        } else {
+            m_previewCache.erase(key);
+        }
+    }
+    LOG_F(INFO, "Listing and preview cache over budget: dropped %zu entries, %zu MB of %zu MB in use",
+          evicted.size(), m_cacheBudget.usedBytes() / (1024 * 1024), m_cacheBudget.budget() / (1024 * 1024));
+}
+
+void BrowserModel::appendListingPage(ObjectStore& objects, const std::vector<S3Object>& page, bool continuation) {
+    size_t skipped = objects.appendPage(page, continuation);
+    if (skipped > 0) {
+        LOG_F(INFO, "Skipped %zu already listed objects", skipped);
+    }
+}
+
+std::string BrowserModel::listingPath(const std::string& bucket, const std::string& prefix) const {
+    if (m_selectedProfileIdx < 0 || m_selectedProfileIdx >= static_cast<int>(m_profiles.size())) {
+        return "";
+    }
+    return listingCachePath(m_profiles[m_selectedProfileIdx].name, bucket, prefix);
+}
+
+bool BrowserModel::loadCachedListing(FolderNode& node) {
+    ObjectStore cached;
+    if (!loadListing(listingPath(node.bucket, node.prefix), node.prefix, cached)) {
+        return false;
+    }
+    node.objects = std::move(cached);
+    node.resetView();
+    node.next_continuation_token.clear();
+    node.is_truncated = false;
+    node.loading = false;
+    node.loaded = true;
+    node.fromCache = true;
+    node.error.clear();
+    recordNodeMemory(makeNodeKey(node.bucket, node.prefix), node);
+    return true;
+}
+
+void BrowserModel::revalidateFolder(FolderNode& node) {
+    LOG_F(INFO, "Revalidating cached folder: bucket=%s prefix=%s objects=%zu",
+          node.bucket.c_str(), node.prefix.c_str(), node.objects.size());
+    node.revalidating = true;
+    node.freshObjects.clear();
+    if (m_backend) {
+        m_backend->listObjects(node.bucket, node.prefix, "", m_paginationCancelFlag, true /* lowPriority */);
+    }
+}
+
+void BrowserModel::applyRevalidatedListing(FolderNode& node) {
+    // Spliced in rather than replaced, so the view keeps its rows
+    ListingDiff diff = updateListing(node.objects, node.freshObjects);
+    LOG_F(INFO, "Revalidated folder: bucket=%s prefix=%s added=%zu removed=%zu changed=%zu",
+          node.bucket.c_str(), node.prefix.c_str(), diff.added, diff.removed, diff.changed);
+
+    if (!diff.empty()) {
+        node.spliceView(diff);
+        saveListing(listingPath(node.bucket, node.prefix), node.prefix, node.objects);
+    }
+    node.freshObjects.clear();
+    node.fromCache = false;
+    node.revalidating = false;
+    recordNodeMemory(makeNodeKey(node.bucket, node.prefix), node);
+}
+
 std::string BrowserModel::makeNodeKey(const std::string& bucket, const std::string& prefix) {
     return bucket + "/" + prefix;
 }
@@ -806,6 +1086,8 @@ void BrowserModel::setCurrentPath(const std::string& bucket, const std::string&
             auto* oldNode = getNode(m_currentBucket, m_currentPrefix);
             if (oldNode) {
                 oldNode->loading = false;
+                oldNode->revalidating = false;
+                oldNode->freshObjects.clear();
             }
         }
         // Create a new cancel flag for the new folder's pagination
@@ -850,7 +1132,7 @@ bool BrowserModel::parseS3Path(const std::string& path, std::string& bucket, std
     return true;
 }
 
-void BrowserModel::triggerPrefetch(const std::string& bucket, const std::vector<S3Object>& objects) {
+void BrowserModel::triggerPrefetch(const std::string& bucket, const ObjectStore& objects) {
     if (!m_backend) return;
 
     // Only prefetch subfolders, limit to first 20 to avoid overwhelming
@@ -858,19 +1140,23 @@ void BrowserModel::triggerPrefetch(const std::string& bucket, const std::vector<
     size_t prefetch_count = 0;
 
     for (const auto& obj : objects) {
-        if (!obj.is_folder) continue;
+        if (!obj.isFolder()) continue;
         if (prefetch_count >= MAX_PREFETCH) break;
+        std::string prefix(obj.key());
 
         // Skip if already loaded or loading
-        const auto* node = getNode(bucket, obj.key);
+        const auto* node = getNode(bucket, prefix);
         if (node && (node->loaded || node->loading)) continue;
 
         // Skip if already queued
-        if (m_backend->hasPendingRequest(bucket, obj.key)) continue;
+        if (m_backend->hasPendingRequest(bucket, prefix)) continue;
+
+        // A listing from the cache needs no request; it's revalidated when opened
+        if (loadCachedListing(getOrCreateNode(bucket, prefix))) continue;
 
         // Queue low-priority prefetch request
-        LOG_F(INFO, "Prefetching: bucket=%s prefix=%s", bucket.c_str(), obj.key.c_str());
-        m_backend->listObjectsPrefetch(bucket, obj.key);
+        LOG_F(INFO, "Prefetching: bucket=%s prefix=%s", bucket.c_str(), prefix.c_str());
+        m_backend->listObjectsPrefetch(bucket, prefix);
         prefetch_count++;
     }
 
@@ -891,26 +1177,15 @@ void BrowserModel::startStreamingDownload(size_t totalFileSize) {
           m_selectedBucket.c_str(), m_selectedKey.c_str(), totalFileSize);
 
     // Check if the file is compressed and needs decompression
-    std::unique_ptr<IStreamTransform> transform;
-    size_t dotPos = m_selectedKey.rfind('.');
-    if (dotPos != std::string::npos) {
-        std::string ext = m_selectedKey.substr(dotPos);
-        for (char& c : ext) c = std::tolower(static_cast<unsigned char>(c));
-
-        if (ext == ".gz") {
-            LOG_F(INFO, "Using GzipTransform for gzipped file: %s", m_selectedKey.c_str());
-            transform = std::make_unique<GzipTransform>();
-        } else if (ext == ".zst" || ext == ".zstd") {
-            LOG_F(INFO, "Using ZstdTransform for zstd file: %s", m_selectedKey.c_str());
-            transform = std::make_unique<ZstdTransform>();
-        }
-    }
+    std::unique_ptr<IStreamTransform> transform = createTransform(nullptr);
 
     // Create streaming preview with the initial preview content
     m_streamingPreview = std::make_shared<StreamingFilePreview>(
         m_selectedBucket, m_selectedKey, m_previewContent, totalFileSize, std::move(transform));
 
     m_streamingEnabled = true;
+    m_lastStreamingBytesDownloaded = 0;
+    m_streamingRangeEnd = totalFileSize;
     m_streamingCancelFlag = std::make_shared<std::atomic<bool>>(false);
 
     // Start streaming from where the initial preview left off
@@ -923,8 +1198,254 @@ void BrowserModel::startStreamingDownload(size_t totalFileSize) {
             m_selectedKey,
             startByte,
             totalFileSize,
-            m_streamingCancelFlag);
+            m_streamingCancelFlag,
+            m_streamingPreview->sink());
+    }
+}
+
+bool BrowserModel::seekStreamingPreview(uint64_t uncompressedOffset) {
+    if (!m_streamingPreview || !m_seekIndex) return false;
+
+    uint64_t start = m_streamingPreview->firstByteOffset();
+    uint64_t end = start + m_streamingPreview->bytesWritten();
+    if (uncompressedOffset >= start && uncompressedOffset < end) return true;
+
+    SeekCheckpoint checkpoint;
+    bool found = m_seekIndex->findByOffset(uncompressedOffset, checkpoint);
+    if (uncompressedOffset >= start && (!found || checkpoint.uncompressedOffset < end + SEEK_MIN_SKIP)) {
+        return false;
+    }
+    return seekToCheckpoint(found ? &checkpoint : nullptr);
+}
+
+bool BrowserModel::seekStreamingPreviewToLine(uint64_t lineNumber) {
+    if (!m_streamingPreview || !m_seekIndex) return false;
+
+    // After a seek without a known line number, first is UNKNOWN_LINE and
+    // every target counts as behind the preview
+    uint64_t first = m_streamingPreview->firstLineNumber();
+    if (lineNumber >= first && lineNumber < first + m_streamingPreview->lineCount()) return true;
+
+    SeekCheckpoint checkpoint;
+    bool found = m_seekIndex->findByLine(lineNumber, checkpoint);
+
+    // Checkpoints without line numbers (every frame of a seekable zstd object)
+    // still get close: guess the line's offset from the average line length
+    // and start there if that skips a lot more. The preview then starts on an
+    // unknown line a little before the target rather than on it.
+    uint64_t estimate = 0;
+    SeekCheckpoint nearby;
+    uint64_t exactOffset = found ? checkpoint.uncompressedOffset : 0;
+    if (estimateLineOffset(lineNumber, found ? &checkpoint : nullptr, estimate) &&
+        m_seekIndex->findByOffset(estimate, nearby) &&
+        nearby.uncompressedOffset >= exactOffset + SEEK_MIN_SKIP) {
+        if (first == SeekCheckpoint::UNKNOWN_LINE &&
+            nearby.uncompressedOffset == m_streamingPreview->firstByteOffset()) {
+            return true;  // Already started there
+        }
+        checkpoint = nearby;
+        found = true;
+    }
+
+    uint64_t end = m_streamingPreview->firstByteOffset() + m_streamingPreview->bytesWritten();
+    if (lineNumber >= first && (!found || checkpoint.uncompressedOffset < end + SEEK_MIN_SKIP)) {
+        return false;
+    }
+    return seekToCheckpoint(found ? &checkpoint : nullptr);
+}
+
+bool BrowserModel::estimateLineOffset(uint64_t lineNumber, const SeekCheckpoint* from,
+                                      uint64_t& offset) const {
+    size_t lines = m_streamingPreview->lineCount();
+    size_t bytes = m_streamingPreview->bytesWritten();
+    if (lines < MIN_LINES_FOR_ESTIMATE || bytes == 0) return false;
+    double bytesPerLine = static_cast<double>(bytes) / static_cast<double>(lines);
+
+    // Count from the closest known line before the target
+    uint64_t baseLine = 0;
+    uint64_t baseOffset = 0;
+    if (from) {
+        baseLine = from->lineNumber;
+        baseOffset = from->uncompressedOffset;
+    }
+    uint64_t first = m_streamingPreview->firstLineNumber();
+    if (first != SeekCheckpoint::UNKNOWN_LINE && first <= lineNumber && first >= baseLine) {
+        baseLine = first;
+        baseOffset = m_streamingPreview->firstByteOffset();
+    }
+    if (lineNumber < baseLine) return false;
+
+    offset = baseOffset + static_cast<uint64_t>(static_cast<double>(lineNumber - baseLine) * bytesPerLine);
+    uint64_t size = m_seekIndex->uncompressedSize();
+    if (size > 0 && offset >= size) offset = size - 1;
+    return true;
+}
+
+bool BrowserModel::seekStreamingPreviewToEnd() {
+    if (!m_streamingPreview || !m_seekIndex) return false;
+    if (m_streamingPreview->isComplete()) return true;
+
+    // Known from a zstd seek table or an earlier full pass
+    uint64_t size = m_seekIndex->uncompressedSize();
+    if (size == 0) return false;
+    return seekStreamingPreview(size - 1);
+}
+
+bool BrowserModel::seekToCheckpoint(const SeekCheckpoint* checkpoint) {
+    if (checkpoint) {
+        restartStreamingAt(*checkpoint);
+    } else {
+        // Behind the preview with nothing recorded before it: start over
+        startStreamingDownload(static_cast<size_t>(m_selectedFileSize));
+    }
+    return true;
+}
+
+void BrowserModel::restartStreamingAt(const SeekCheckpoint& checkpoint) {
+    cancelStreamingDownload();
+
+    // Gzip checkpoints between bytes resume one byte early; zstd ones never do
+    size_t startByte = static_cast<size_t>(GzipTransform::resumeOffset(checkpoint));
+    size_t totalFileSize = static_cast<size_t>(m_selectedFileSize);
+    size_t endByte = std::max(streamingWindowEnd(checkpoint.uncompressedOffset), startByte);
+    LOG_F(INFO, "Seeking streaming download: bucket=%s key=%s bytes %zu-%zu (uncompressed %llu)",
+          m_selectedBucket.c_str(), m_selectedKey.c_str(), startByte, endByte,
+          static_cast<unsigned long long>(checkpoint.uncompressedOffset));
+
+    m_streamingPreview = std::make_shared<StreamingFilePreview>(
+        m_selectedBucket, m_selectedKey, "", totalFileSize, createTransform(&checkpoint));
+    m_streamingPreview->seekTo(startByte, checkpoint.uncompressedOffset, checkpoint.lineNumber,
+                               checkpoint.lineStart);
+
+    m_streamingEnabled = true;
+    m_lastStreamingBytesDownloaded = 0;
+    m_streamingRangeEnd = endByte;
+    m_streamingCancelFlag = std::make_shared<std::atomic<bool>>(false);
+
+    // Only the frames up to a window past the target; keepStreamingPreviewAhead
+    // fetches more. The preview completes when it reaches totalFileSize.
+    m_backend->getObjectStreaming(
+        m_selectedBucket,
+        m_selectedKey,
+        startByte,
+        endByte,
+        m_streamingCancelFlag,
+        m_streamingPreview->sink());
+}
+
+size_t BrowserModel::streamingWindowEnd(uint64_t uncompressedOffset) const {
+    // End on a checkpoint, so the window holds whole zstd frames
+    size_t fileSize = static_cast<size_t>(m_selectedFileSize);
+    SeekCheckpoint next;
+    if (!m_seekIndex || !m_seekIndex->findAfter(uncompressedOffset + SEEK_WINDOW, next)) {
+        return fileSize;
+    }
+    return std::min(static_cast<size_t>(next.compressedOffset), fileSize);
+}
+
+void BrowserModel::keepStreamingPreviewAhead(size_t lineIndex) {
+    if (!m_backend || !m_streamingPreview || !m_streamingCancelFlag) return;
+    size_t fileSize = static_cast<size_t>(m_selectedFileSize);
+    if (m_streamingRangeEnd >= fileSize) return;
+
+    // Still working through the current window
+    size_t start = m_streamingPreview->nextByteNeeded();
+    if (start < m_streamingRangeEnd || start >= fileSize) return;
+
+    // Far enough from the end of what's decoded
+    size_t lines = m_streamingPreview->lineCount();
+    uint64_t written = m_streamingPreview->bytesWritten();
+    if (lineIndex < lines && m_streamingPreview->lineIndex()->lineStart(lineIndex) + SEEK_WINDOW / 2 < written) {
+        return;
+    }
+
+    uint64_t decodedEnd = m_streamingPreview->firstByteOffset() + written;
+    m_streamingRangeEnd = std::max(streamingWindowEnd(decodedEnd), start + 1);
+    LOG_F(INFO, "Continuing streaming download: bucket=%s key=%s bytes %zu-%zu",
+          m_selectedBucket.c_str(), m_selectedKey.c_str(), start, m_streamingRangeEnd);
+    m_backend->getObjectStreaming(
+        m_selectedBucket,
+        m_selectedKey,
+        start,
+        m_streamingRangeEnd,
+        m_streamingCancelFlag,
+        m_streamingPreview->sink());
+}
+
+void BrowserModel::releaseSeekIndex() {
+    if (m_seekIndex) {
+        m_seekIndex->saveIfDirty();
+        m_seekIndex.reset();
+    }
+    m_seekTableRequestStart = SIZE_MAX;
+}
+
+std::unique_ptr<IStreamTransform> BrowserModel::createTransform(const SeekCheckpoint* from) {
+    size_t dotPos = m_selectedKey.rfind('.');
+    if (dotPos == std::string::npos) return nullptr;
+
+    std::string ext = m_selectedKey.substr(dotPos);
+    for (char& c : ext) c = std::tolower(static_cast<unsigned char>(c));
+
+    bool gzip = ext == ".gz";
+    bool zstd = ext == ".zst" || ext == ".zstd";
+    if (!gzip && !zstd) return nullptr;
+
+    if (!m_seekIndex) {
+        m_seekIndex = std::make_shared<SeekIndex>(
+            SeekIndex::cachePath(m_selectedBucket, m_selectedKey, m_selectedETag),
+            static_cast<uint64_t>(m_selectedFileSize));
+        m_seekIndex->load();
+
+        // A seekable zstd object lists all its frames up front
+        if (zstd && m_seekIndex->size() == 0) {
+            requestZstdSeekTable(ZSTD_SEEK_TABLE_TAIL);
+        }
+    }
+
+    if (gzip) {
+        LOG_F(INFO, "Using GzipTransform for gzipped file: %s", m_selectedKey.c_str());
+        return from ? std::make_unique<GzipTransform>(*from, m_seekIndex)
+                    : std::make_unique<GzipTransform>(m_seekIndex);
+    }
+    LOG_F(INFO, "Using ZstdTransform for zstd file: %s", m_selectedKey.c_str());
+    return from ? std::make_unique<ZstdTransform>(*from, m_seekIndex)
+                : std::make_unique<ZstdTransform>(m_seekIndex);
+}
+
+void BrowserModel::requestZstdSeekTable(size_t tailBytes) {
+    size_t fileSize = static_cast<size_t>(m_selectedFileSize);
+    if (fileSize == 0) return;
+
+    m_seekTableRequestStart = fileSize > tailBytes ? fileSize - tailBytes : 0;
+    LOG_F(INFO, "Requesting zstd seek table: bucket=%s key=%s range=%zu-%zu",
+          m_selectedBucket.c_str(), m_selectedKey.c_str(), m_seekTableRequestStart, fileSize - 1);
+    m_backend->getObjectRange(m_selectedBucket, m_selectedKey, m_seekTableRequestStart, fileSize - 1);
+}
+
+void BrowserModel::handleZstdSeekTable(const std::string& tail) {
+    if (!m_seekIndex) return;
+
+    std::vector<SeekCheckpoint> frames;
+    uint64_t uncompressedSize = 0;
+    size_t tableSize = parseZstdSeekTable(tail, static_cast<uint64_t>(m_selectedFileSize),
+                                          frames, uncompressedSize);
+    if (tableSize == 0) {
+        LOG_F(INFO, "No zstd seek table in %s, frames will be found while decoding", m_selectedKey.c_str());
+        return;
+    }
+    if (tableSize > tail.size()) {
+        // Bigger than the first guess; fetch exactly the table
+        requestZstdSeekTable(tableSize);
+        return;
+    }
+
+    LOG_F(INFO, "Read zstd seek table of %s: %zu frames, %llu bytes uncompressed",
+          m_selectedKey.c_str(), frames.size(), static_cast<unsigned long long>(uncompressedSize));
+    for (auto& frame : frames) {
+        m_seekIndex->add(std::move(frame));
     }
+    m_seekIndex->setUncompressedSize(uncompressedSize);
 }
 
 void BrowserModel::cancelStreamingDownload() {
@@ -4,51 +4,122 @@
 #include "aws/s3_backend.h"
 #include "aws/aws_credentials.h"
 #include "streaming_preview.h"
+#include "seek_index.h"
 #include "settings.h"
+#include "cache_budget.h"
+#include "object_store.h"
+#include "listing_sort.h"
+#include "listing_cache.h"
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <map>
 #include <set>
 #include <memory>
 #include <atomic>
+#include <cstdint>
 
 // Node representing a folder's contents
 struct FolderNode {
     std::string bucket;
     std::string prefix;
-    std::vector<S3Object> objects;
+    ObjectStore objects;
     std::string next_continuation_token;
     bool is_truncated = false;
     bool loading = false;
     bool loaded = false;  // True if we've fetched this folder at least once
     std::string error;
 
-    // Cached view for virtual scrolling: indices into objects[]
-    // First folderCount indices are folders, rest are files
-    std::vector<size_t> sortedView;
-    size_t folderCount = 0;
-    size_t cachedObjectsSize = 0;  // Invalidation check
+    // Stale-while-revalidate: objects came from the on-disk listing cache and
+    // a low-priority listing is fetching the current contents into freshObjects
+    bool fromCache = false;
+    bool revalidating = false;
+    ObjectStore freshObjects;
 
-    void rebuildSortedViewIfNeeded() {
-        if (cachedObjectsSize == objects.size()) return;
+    // View for virtual scrolling: indices into objects[], folders then files.
+    // Extended as pages arrive; rebuilt only after resetView()
+    std::vector<size_t> folderView;
+    std::vector<size_t> fileView;
+    size_t viewedObjects = 0;  // objects[0, viewedObjects) are in the view
 
-        sortedView.clear();
-        sortedView.reserve(objects.size());
+    // Order of each section when not sorted by key, computed in the background
+    ListingSorter folderSorter;
+    ListingSorter fileSorter;
 
-        // Folders first
-        for (size_t i = 0; i < objects.size(); ++i) {
-            if (objects[i].is_folder) sortedView.push_back(i);
+    // Approximate memory use, updated as objects arrive (see CacheBudget)
+    size_t memoryBytes = 0;
+
+    // Counts, sizes and times over all objects, kept as pages arrive
+    const ListingStats& stats() const { return objects.stats(); }
+
+    size_t viewSize() const { return folderView.size() + fileView.size(); }
+    size_t viewAt(size_t row) const {
+        if (row < folderView.size()) return folderView[folderSorter.positionAt(row)];
+        return fileView[fileSorter.positionAt(row - folderView.size())];
+    }
+    // A sort is running; rows not sorted yet are shown after the sorted ones
+    bool sorting() const { return folderSorter.busy() || fileSorter.busy(); }
+
+    // Call whenever objects is replaced rather than appended to
+    void resetView() {
+        folderView.clear();
+        fileView.clear();
+        viewedObjects = 0;
+        folderSorter.reset();
+        fileSorter.reset();
+    }
+
+    // Call after updateListing spliced a revalidated listing into objects:
+    // drops removed rows and merges added ones in at their key's place, so
+    // the view never starts over. The sorters do, as positions have moved.
+    void spliceView(const ListingDiff& diff) {
+        if (diff.empty()) return;
+        if (viewedObjects != diff.previousCount) {
+            resetView();
+            return;
         }
-        folderCount = sortedView.size();
+        auto byKey = [this](size_t a, size_t b) { return objects[a].key() < objects[b].key(); };
+        for (std::vector<size_t>* view : {&folderView, &fileView}) {
+            if (!diff.moved.empty()) {
+                size_t kept = 0;
+                for (size_t index : *view) {
+                    if (diff.moved[index] != SIZE_MAX) (*view)[kept++] = diff.moved[index];
+                }
+                view->resize(kept);
+            }
+            size_t middle = view->size();
+            bool folders = view == &folderView;
+            for (size_t i = diff.firstAdded; i < objects.size(); ++i) {
+                if (objects[i].isFolder() == folders) view->push_back(i);
+            }
+            std::inplace_merge(view->begin(), view->begin() + static_cast<ptrdiff_t>(middle), view->end(), byKey);
+        }
+        viewedObjects = objects.size();
+        folderSorter.reset();
+        fileSorter.reset();
+    }
 
-        // Files second
-        for (size_t i = 0; i < objects.size(); ++i) {
-            if (!objects[i].is_folder) sortedView.push_back(i);
+    // Call once per frame while shown; never waits for a sort
+    void updateView(const ListingSort& sort) {
+        if (viewedObjects > objects.size()) resetView();
+        for (size_t i = viewedObjects; i < objects.size(); ++i) {
+            (objects[i].isFolder() ? folderView : fileView).push_back(i);
         }
-        cachedObjectsSize = objects.size();
+        viewedObjects = objects.size();
+        folderSorter.update(objects, folderView, sort);
+        fileSorter.update(objects, fileView, sort);
     }
 };
 
+// The start of an object fetched for a thumbnail (see fetchThumbnailBytes)
+struct ThumbnailBytes {
+    std::string bucket;
+    std::string key;
+    std::string data;
+    std::string error;       // Set if the fetch failed
+    bool cancelled = false;  // Dropped before it finished (e.g. on profile switch)
+};
+
 // The browser model - owns state and processes commands
 class BrowserModel {
 public:
@@ -90,6 +161,13 @@ public:
     // Prefetch folder contents on hover (low priority)
     void prefetchFolder(const std::string& bucket, const std::string& prefix);
 
+    // Thumbnails: low-priority ranged GET of the first maxBytes of an object
+    // (the whole object if smaller). Results are collected with
+    // takeThumbnailBytes; a cancelled fetch produces no result.
+    void fetchThumbnailBytes(const std::string& bucket, const std::string& key, size_t maxBytes);
+    void cancelThumbnailFetch(const std::string& bucket, const std::string& key);
+    std::vector<ThumbnailBytes> takeThumbnailBytes();
+
     // Check if at root (bucket list view)
     bool isAtRoot() const { return m_currentBucket.empty(); }
 
@@ -98,7 +176,8 @@ public:
     const std::string& selectedBucket() const { return m_selectedBucket; }
     const std::string& selectedKey() const { return m_selectedKey; }
     bool previewLoading() const { return m_previewLoading; }
-    std::string previewContent() const;  // Returns from StreamingFilePreview if available
+    // Returns from StreamingFilePreview if available; shared, not copied
+    std::shared_ptr<const ContentView> previewContent() const;
     const std::string& previewError() const { return m_previewError; }
     bool previewSupported() const { return m_previewSupported; }
 
@@ -109,6 +188,26 @@ public:
     bool isStreamingEnabled() const { return m_streamingEnabled; }
     int64_t selectedFileSize() const { return m_selectedFileSize; }
 
+    // Seek the streaming preview of a .gz or .zst object. A target before the preview's
+    // start, or far beyond what's decoded, restarts the download with a ranged
+    // GET from the nearest recorded checkpoint. Returns false if the target can
+    // only be reached by decoding on from the current position.
+    bool seekStreamingPreview(uint64_t uncompressedOffset);
+    bool seekStreamingPreviewToLine(uint64_t lineNumber);
+
+    // Seek to the end of a compressed object whose size is known (from a zstd
+    // seek table or an earlier full pass). Returns false if it isn't known.
+    bool seekStreamingPreviewToEnd();
+
+    // A seek only downloads about SEEK_WINDOW bytes past its target, up to a
+    // checkpoint. Viewers pass the furthest preview line they show (or
+    // lineCount() while waiting for more) so the download continues as they
+    // get near the end of what's decoded.
+    void keepStreamingPreviewAhead(size_t lineIndex);
+
+    // Memory used by cached folder listings and previews, with hit counts
+    const CacheBudget& cacheBudget() const { return m_cacheBudget; }
+
     // Call once per frame to process pending events from backend
     // Returns true if any events were processed (UI should redraw)
     bool processEvents();
@@ -131,9 +230,11 @@ private:
     static std::string makeNodeKey(const std::string& bucket, const std::string& prefix);
     static bool parseS3Path(const std::string& path, std::string& bucket, std::string& prefix);
     static bool isPreviewSupported(const std::string& key);
+    // Add a page of a listing to objects, skipping any repeated from an earlier page
+    static void appendListingPage(ObjectStore& objects, const std::vector<S3Object>& page, bool continuation);
 
     // Prefetch support - queue low-priority requests for subfolders
-    void triggerPrefetch(const std::string& bucket, const std::vector<S3Object>& objects);
+    void triggerPrefetch(const std::string& bucket, const ObjectStore& objects);
 
     std::unique_ptr<IBackend> m_backend;
     AppSettings m_settings;
@@ -150,6 +251,20 @@ private:
     // Folder nodes
     std::map<std::string, FolderNode> m_nodes;
 
+    // Accounting for m_nodes and m_previewCache; least recently used entries
+    // are dropped once over budget, except the current folder, folders still
+    // loading or revalidating and the selected file
+    CacheBudget m_cacheBudget{static_cast<size_t>(512) * 1024 * 1024};
+    void recordNodeMemory(const std::string& nodeKey, FolderNode& node);
+    void enforceCacheBudget();
+
+    // On-disk listing cache (see listing_cache.h)
+    std::string listingPath(const std::string& bucket, const std::string& prefix) const;
+    // Show a folder's saved listing, if any, without fetching anything
+    bool loadCachedListing(FolderNode& node);
+    void revalidateFolder(FolderNode& node);
+    void applyRevalidatedListing(FolderNode& node);
+
     // Current navigation path
     std::string m_currentBucket;
     std::string m_currentPrefix;
@@ -158,25 +273,58 @@ private:
     std::string m_selectedBucket;
     std::string m_selectedKey;
     int64_t m_selectedFileSize = 0;
+    std::string m_selectedETag;
     bool m_previewLoading = false;
     bool m_previewSupported = false;
     std::string m_previewContent;
+    mutable std::shared_ptr<const ContentView> m_previewContentView;  // Of m_previewContent, made on demand
     std::string m_previewError;
 
     // Streaming preview for large files
     std::shared_ptr<StreamingFilePreview> m_streamingPreview;
     std::shared_ptr<std::atomic<bool>> m_streamingCancelFlag;
     bool m_streamingEnabled = false;  // Whether we're in streaming mode
+    size_t m_lastStreamingBytesDownloaded = 0;  // Last progress seen by processEvents
+    size_t m_streamingRangeEnd = 0;             // Source byte the download stops at
     void startStreamingDownload(size_t totalFileSize);
     void cancelStreamingDownload();
     static constexpr size_t STREAMING_THRESHOLD = 64 * 1024;     // Stream files > 64KB
 
+    // Seek checkpoints for the selected compressed object (kept across restarts,
+    // saved when the selection changes or the download completes)
+    std::shared_ptr<SeekIndex> m_seekIndex;
+    size_t m_seekTableRequestStart = SIZE_MAX;  // Pending zstd seek table range
+    std::unique_ptr<IStreamTransform> createTransform(const SeekCheckpoint* from);
+    void requestZstdSeekTable(size_t tailBytes);
+    void handleZstdSeekTable(const std::string& tail);
+    bool seekToCheckpoint(const SeekCheckpoint* checkpoint);
+    void restartStreamingAt(const SeekCheckpoint& checkpoint);
+    bool estimateLineOffset(uint64_t lineNumber, const SeekCheckpoint* from, uint64_t& offset) const;
+    size_t streamingWindowEnd(uint64_t uncompressedOffset) const;
+    void releaseSeekIndex();
+    static constexpr size_t ZSTD_SEEK_TABLE_TAIL = 64 * 1024;    // First guess at the table size
+    static constexpr uint64_t SEEK_MIN_SKIP = 64 * 1024 * 1024;  // Restart only to skip more than this
+    static constexpr uint64_t SEEK_WINDOW = 64 * 1024 * 1024;    // Decoded bytes a seek downloads at a time
+    static constexpr size_t MIN_LINES_FOR_ESTIMATE = 100;        // Lines seen before trusting their average length
+
     // Cache for prefetched file previews (bucket/key -> content)
     std::map<std::string, std::string> m_previewCache;
     std::set<std::string> m_pendingObjectRequests;  // Track requests until event processed
     static std::string makePreviewCacheKey(const std::string& bucket, const std::string& key);
     static constexpr size_t PREVIEW_MAX_BYTES = 64 * 1024;  // 64KB
 
+    // Thumbnail fetches in flight (by bucket/key) and their results. Each
+    // fetch's range request carries a tag of its own, so a late response to
+    // a cancelled fetch is neither taken for a newer one nor for streaming data.
+    struct ThumbnailFetch {
+        std::shared_ptr<std::atomic<bool>> cancelFlag;
+        uint64_t tag = 0;
+    };
+    std::map<std::string, ThumbnailFetch> m_thumbnailFetches;
+    std::vector<ThumbnailBytes> m_thumbnailBytes;
+    uint64_t m_nextThumbnailTag = 1;
+    void cancelThumbnailFetches();
+
     // Compression helper - detects .gz, .zst, .zstd extensions
     static bool isCompressed(const std::string& key);
 
@@ -4,10 +4,13 @@
 #include "preview/text_preview.h"
 #include "aws/aws_signer.h"
 #include "imgui/imgui.h"
+#include <algorithm>
 #include <cstring>
+#include <ctime>
 
 BrowserUI::BrowserUI(BrowserModel& model)
     : m_model(model)
+    , m_thumbnails(model)
 {
     std::strcpy(m_pathInput, "s3://");
 
@@ -18,6 +21,8 @@ BrowserUI::BrowserUI(BrowserModel& model)
 }
 
 void BrowserUI::render(int windowWidth, int windowHeight) {
+    m_thumbnails.update();
+
     ImGui::SetNextWindowPos(ImVec2(0, 0));
     ImGui::SetNextWindowSize(ImVec2(static_cast<float>(windowWidth),
                                      static_cast<float>(windowHeight)));
@@ -121,6 +126,7 @@ void BrowserUI::renderTopBar() {
         if (ImGui::Combo("##profile", &selectedIdx,
                          profileNames.data(), static_cast<int>(profileNames.size()))) {
             m_model.selectProfile(selectedIdx);
+            m_thumbnails.clear();
             std::strcpy(m_pathInput, "s3://");
         }
 
@@ -254,97 +260,218 @@ void BrowserUI::renderFolderContents() {
         return;
     }
 
-    // Rebuild sorted view if objects changed (e.g., pagination added more)
-    node->rebuildSortedViewIfNeeded();
+    // Add any objects that arrived since last frame (e.g., pagination added more)
+    node->updateView(m_sort);
+
+    if (m_gridView) {
+        renderFolderGrid(*node);
+    } else {
+        renderFolderList(*node);
+    }
+
+    // Show inline loading indicator if loading more (outside clipper)
+    if (node->loading) {
+        ImGui::TextColored(ImVec4(0.5f, 0.5f, 1.0f, 1.0f), "Loading more...");
+    }
+
+    // Show "Load more" button if truncated (outside clipper)
+    if (node->is_truncated && !node->loading && !node->next_continuation_token.empty()) {
+        ImGui::Spacing();
+        if (ImGui::Button("Load more")) {
+            m_model.loadMore(bucket, prefix);
+        }
+        ImGui::SameLine();
+        ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f),
+            "(%s items loaded)", formatNumber(node->objects.size()).c_str());
+    }
+}
+
+void BrowserUI::renderFolderList(FolderNode& node) {
+    const std::string& bucket = node.bucket;
 
     // Use ImGuiListClipper for virtual scrolling - only render visible rows
     ImGuiListClipper clipper;
-    clipper.Begin(static_cast<int>(node->sortedView.size()));
+    clipper.Begin(static_cast<int>(node.viewSize()));
 
     while (clipper.Step()) {
         for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
-            size_t objIndex = node->sortedView[i];
-            const auto& obj = node->objects[objIndex];
-            bool isFolder = (static_cast<size_t>(i) < node->folderCount);
+            size_t objIndex = node.viewAt(i);
+            const auto& obj = node.objects[objIndex];
+            std::string key(obj.key());
+            bool isFolder = (static_cast<size_t>(i) < node.folderView.size());
 
             ImGui::PushID(static_cast<int>(objIndex));
 
             if (isFolder) {
                 // Render folder
-                std::string label = "[D] " + obj.display_name;
+                std::string label = "[D] " + std::string(obj.displayName());
                 if (ImGui::Selectable(label.c_str())) {
-                    m_model.navigateInto(bucket, obj.key);
+                    m_model.navigateInto(bucket, key);
                     ImGui::SetScrollY(0);
                 }
-                // Right-click context menu
-                if (ImGui::BeginPopupContextItem()) {
-                    if (ImGui::MenuItem("Copy path")) {
-                        std::string path = "s3://" + bucket + "/" + obj.key;
-                        ImGui::SetClipboardText(path.c_str());
-                    }
-                    ImGui::EndPopup();
-                }
+                renderFolderContextMenu(bucket, key);
                 // Prefetch folder contents on hover for instant navigation
                 if (ImGui::IsItemHovered()) {
-                    m_model.prefetchFolder(bucket, obj.key);
+                    m_model.prefetchFolder(bucket, key);
                 }
             } else {
                 // Render file
-                std::string label = "    " + obj.display_name + "  (" + formatSize(obj.size) + ")";
+                std::string label = "    " + std::string(obj.displayName()) + "  (" + formatSize(obj.size()) + ")";
+                if (m_sort.column == ListingSort::Modified && obj.lastModified() != 0) {
+                    label += "  " + formatTime(obj.lastModified());
+                }
                 // Check if this file is selected
-                bool isSelected = (m_model.selectedBucket() == bucket && m_model.selectedKey() == obj.key);
+                bool isSelected = (m_model.selectedBucket() == bucket && m_model.selectedKey() == key);
                 if (ImGui::Selectable(label.c_str(), isSelected)) {
-                    m_model.selectFile(bucket, obj.key);
+                    m_model.selectFile(bucket, key);
                 }
                 // Right-click context menu
-                if (ImGui::BeginPopupContextItem()) {
-                    if (ImGui::MenuItem("Copy path")) {
-                        std::string path = "s3://" + bucket + "/" + obj.key;
-                        ImGui::SetClipboardText(path.c_str());
-                    }
-                    if (ImGui::MenuItem("Copy pre-signed URL (7 days)")) {
-                        const auto& profiles = m_model.profiles();
-                        int idx = m_model.selectedProfileIndex();
-                        if (idx >= 0 && idx < static_cast<int>(profiles.size())) {
-                            const auto& profile = profiles[idx];
-                            std::string url = aws_generate_presigned_url(
-                                bucket,
-                                obj.key,
-                                profile.region,
-                                profile.access_key_id,
-                                profile.secret_access_key,
-                                profile.session_token,
-                                604800  // 7 days in seconds
-                            );
-                            ImGui::SetClipboardText(url.c_str());
-                        }
-                    }
-                    ImGui::EndPopup();
-                }
+                renderFileContextMenu(bucket, key);
                 // Prefetch preview content on hover for instant preview when clicked
                 if (ImGui::IsItemHovered()) {
-                    m_model.prefetchFilePreview(bucket, obj.key);
+                    m_model.prefetchFilePreview(bucket, key);
                 }
             }
 
             ImGui::PopID();
         }
     }
+}
 
-    // Show inline loading indicator if loading more (outside clipper)
-    if (node->loading) {
-        ImGui::TextColored(ImVec4(0.5f, 0.5f, 1.0f, 1.0f), "Loading more...");
+void BrowserUI::renderFolderGrid(FolderNode& node) {
+    const std::string& bucket = node.bucket;
+    const ImGuiStyle& style = ImGui::GetStyle();
+    float labelHeight = ImGui::GetTextLineHeightWithSpacing();
+    ImVec2 cellSize(GRID_CELL_SIZE, GRID_CELL_SIZE + labelHeight);
+    int columns = std::max(1, static_cast<int>((ImGui::GetContentRegionAvail().x + style.ItemSpacing.x) /
+                                                (cellSize.x + style.ItemSpacing.x)));
+    int itemCount = static_cast<int>(node.viewSize());
+    int rowCount = (itemCount + columns - 1) / columns;
+
+    // Virtual scrolling by grid row; only visible cells ask for thumbnails
+    ImGuiListClipper clipper;
+    clipper.Begin(rowCount, cellSize.y + style.ItemSpacing.y);
+
+    while (clipper.Step()) {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+            for (int column = 0; column < columns; ++column) {
+                int i = row * columns + column;
+                if (i >= itemCount) break;
+                size_t objIndex = node.viewAt(i);
+                const auto& obj = node.objects[objIndex];
+                std::string key(obj.key());
+                std::string_view name = obj.displayName();
+                bool isFolder = (static_cast<size_t>(i) < node.folderView.size());
+
+                if (column > 0) ImGui::SameLine();
+                ImGui::PushID(static_cast<int>(objIndex));
+
+                bool isSelected = !isFolder &&
+                    m_model.selectedBucket() == bucket && m_model.selectedKey() == key;
+                bool clicked = ImGui::Selectable("##cell", isSelected, 0, cellSize);
+                bool hovered = ImGui::IsItemHovered();
+                ImVec2 cellMin = ImGui::GetItemRectMin();
+                ImDrawList* drawList = ImGui::GetWindowDrawList();
+
+                // Picture: thumbnail, or a placeholder naming what it is
+                ImVec2 boxCenter(cellMin.x + GRID_CELL_SIZE * 0.5f, cellMin.y + GRID_CELL_SIZE * 0.5f);
+                std::string placeholder;
+                if (isFolder) {
+                    placeholder = "[D]";
+                } else {
+                    size_t dotPos = key.rfind('.');
+                    std::string ext = dotPos != std::string::npos ? key.substr(dotPos) : "";
+                    if (ImagePreviewRenderer::isImageExtension(ext)) {
+                        ThumbnailCache::Thumbnail thumbnail = m_thumbnails.get(bucket, key, obj.size());
+                        if (thumbnail.texture != nullptr) {
+                            ImVec2 half(thumbnail.width * 0.5f, thumbnail.height * 0.5f);
+                            drawList->AddImage(reinterpret_cast<ImTextureID>(thumbnail.texture),
+                                               ImVec2(boxCenter.x - half.x, boxCenter.y - half.y),
+                                               ImVec2(boxCenter.x + half.x, boxCenter.y + half.y),
+                                               ImVec2(thumbnail.u0, thumbnail.v0), ImVec2(thumbnail.u1, thumbnail.v1));
+                        } else {
+                            placeholder = thumbnail.failed ? ext : "...";
+                        }
+                    } else {
+                        placeholder = ext.empty() ? "file" : ext;
+                    }
+                }
+                if (!placeholder.empty()) {
+                    ImVec2 textSize = ImGui::CalcTextSize(placeholder.c_str());
+                    drawList->AddText(ImVec2(boxCenter.x - textSize.x * 0.5f, boxCenter.y - textSize.y * 0.5f),
+                                      ImGui::GetColorU32(ImGuiCol_TextDisabled), placeholder.c_str());
+                }
+
+                // Name below, cut at the cell's edge
+                ImVec2 labelMin(cellMin.x, cellMin.y + GRID_CELL_SIZE);
+                drawList->PushClipRect(labelMin, ImVec2(labelMin.x + GRID_CELL_SIZE, labelMin.y + labelHeight), true);
+                float labelWidth = ImGui::CalcTextSize(name.data(), name.data() + name.size()).x;
+                float labelX = labelMin.x + std::max(0.0f, (GRID_CELL_SIZE - labelWidth) * 0.5f);
+                drawList->AddText(ImVec2(labelX, labelMin.y), ImGui::GetColorU32(ImGuiCol_Text),
+                                  name.data(), name.data() + name.size());
+                drawList->PopClipRect();
+
+                if (isFolder) {
+                    if (clicked) {
+                        m_model.navigateInto(bucket, key);
+                        ImGui::SetScrollY(0);
+                    }
+                    renderFolderContextMenu(bucket, key);
+                    if (hovered) {
+                        m_model.prefetchFolder(bucket, key);
+                    }
+                } else {
+                    if (clicked) {
+                        m_model.selectFile(bucket, key);
+                    }
+                    renderFileContextMenu(bucket, key);
+                    if (hovered) {
+                        ImGui::SetTooltip("%.*s  (%s)", static_cast<int>(name.size()), name.data(),
+                                          formatSize(obj.size()).c_str());
+                        m_model.prefetchFilePreview(bucket, key);
+                    }
+                }
+
+                ImGui::PopID();
+            }
+        }
     }
+}
 
-    // Show "Load more" button if truncated (outside clipper)
-    if (node->is_truncated && !node->loading && !node->next_continuation_token.empty()) {
-        ImGui::Spacing();
-        if (ImGui::Button("Load more")) {
-            m_model.loadMore(bucket, prefix);
+void BrowserUI::renderFolderContextMenu(const std::string& bucket, const std::string& prefix) {
+    if (ImGui::BeginPopupContextItem()) {
+        if (ImGui::MenuItem("Copy path")) {
+            std::string path = "s3://" + bucket + "/" + prefix;
+            ImGui::SetClipboardText(path.c_str());
         }
-        ImGui::SameLine();
-        ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f),
-            "(%s items loaded)", formatNumber(node->objects.size()).c_str());
+        ImGui::EndPopup();
+    }
+}
+
+void BrowserUI::renderFileContextMenu(const std::string& bucket, const std::string& key) {
+    if (ImGui::BeginPopupContextItem()) {
+        if (ImGui::MenuItem("Copy path")) {
+            std::string path = "s3://" + bucket + "/" + key;
+            ImGui::SetClipboardText(path.c_str());
+        }
+        if (ImGui::MenuItem("Copy pre-signed URL (7 days)")) {
+            const auto& profiles = m_model.profiles();
+            int idx = m_model.selectedProfileIndex();
+            if (idx >= 0 && idx < static_cast<int>(profiles.size())) {
+                const auto& profile = profiles[idx];
+                std::string url = aws_generate_presigned_url(
+                    bucket,
+                    key,
+                    profile.region,
+                    profile.access_key_id,
+                    profile.secret_access_key,
+                    profile.session_token,
+                    604800  // 7 days in seconds
+                );
+                ImGui::SetClipboardText(url.c_str());
+            }
+        }
+        ImGui::EndPopup();
     }
 }
 
@@ -372,19 +499,11 @@ void BrowserUI::renderStatusBar() {
         } else if (!node->error.empty()) {
             ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "Error");
         } else {
-            // Count folders and files, sum sizes
-            size_t folderCount = 0;
-            size_t fileCount = 0;
-            int64_t totalSize = 0;
-
-            for (const auto& obj : node->objects) {
-                if (obj.is_folder) {
-                    folderCount++;
-                } else {
-                    fileCount++;
-                    totalSize += obj.size;
-                }
-            }
+            // Running totals, kept as pages arrive
+            const ListingStats& stats = node->stats();
+            size_t folderCount = stats.folders;
+            size_t fileCount = stats.files;
+            int64_t totalSize = stats.totalBytes;
 
             // Build status string
             std::string status;
@@ -403,15 +522,104 @@ void BrowserUI::renderStatusBar() {
             // Add loading/truncation indicator
             if (node->loading) {
                 status += "  Loading...";
+            } else if (node->revalidating) {
+                status += "  Refreshing...";
             } else if (node->is_truncated) {
                 status += "  [more available]";
             }
+            if (node->sorting()) {
+                status += "  Sorting...";
+            }
+            if (m_gridView && m_thumbnails.pendingCount() > 0) {
+                status += "  (" + formatNumber(m_thumbnails.pendingCount()) + " thumbnails loading)";
+            }
 
             ImGui::Text("%s", status.c_str());
         }
+        if (ImGui::IsItemHovered()) {
+            renderStatusTooltip(node && node->error.empty() ? node : nullptr);
+        }
+
+        // Sort order and list/grid toggle, right-aligned
+        const ImGuiStyle& style = ImGui::GetStyle();
+        const char* toggleLabel = "Thumbnails";
+        float comboWidth = 130;
+        float toggleWidth = ImGui::GetFrameHeight() + style.ItemInnerSpacing.x + ImGui::CalcTextSize(toggleLabel).x;
+        float controlsWidth = comboWidth + style.ItemInnerSpacing.x + ImGui::GetFrameHeight() +
+                              style.ItemSpacing.x + toggleWidth;
+        ImGui::SameLine();
+        float controlsX = ImGui::GetWindowWidth() - controlsWidth - 8;
+        if (ImGui::GetCursorPosX() < controlsX) {
+            ImGui::SetCursorPosX(controlsX);
+        }
+
+        std::string sortLabel = std::string("Sort: ") + ListingSort::columnName(m_sort.column);
+        ImGui::SetNextItemWidth(comboWidth);
+        if (ImGui::BeginCombo("##sort", sortLabel.c_str())) {
+            for (int column = 0; column < ListingSort::COLUMN_COUNT; ++column) {
+                auto value = static_cast<ListingSort::Column>(column);
+                if (ImGui::Selectable(ListingSort::columnName(value), m_sort.column == value)) {
+                    m_sort.column = value;
+                }
+            }
+            ImGui::EndCombo();
+        }
+        ImGui::SameLine(0, style.ItemInnerSpacing.x);
+        if (ImGui::ArrowButton("##sort_direction", m_sort.descending ? ImGuiDir_Down : ImGuiDir_Up)) {
+            m_sort.descending = !m_sort.descending;
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip(m_sort.descending ? "Descending" : "Ascending");
+        }
+        ImGui::SameLine();
+        ImGui::Checkbox(toggleLabel, &m_gridView);
     }
 }
 
+void BrowserUI::renderStatusTooltip(const FolderNode* node) {
+    ImGui::BeginTooltip();
+
+    // Folder breakdown, when there are files to describe
+    if (node && node->stats().files > 0) {
+        const ListingStats& stats = node->stats();
+        ImGui::Text("Largest file: %s", formatSize(stats.largestFile).c_str());
+        if (stats.newest != 0) {
+            ImGui::Text("Modified: %s to %s", formatTime(stats.oldest).c_str(), formatTime(stats.newest).c_str());
+        }
+        int64_t lowerLimit = 0;
+        for (int bucket = 0; bucket < ListingStats::SIZE_BUCKETS; ++bucket) {
+            int64_t limit = ListingStats::sizeBucketLimit(bucket);
+            size_t count = stats.sizeHistogram[bucket];
+            if (count > 0) {
+                std::string range = limit == INT64_MAX ? formatSize(lowerLimit) + " and up"
+                                                       : "under " + formatSize(limit);
+                float fraction = static_cast<float>(count) / static_cast<float>(stats.files);
+                ImGui::ProgressBar(fraction, ImVec2(120, 0), formatNumber(static_cast<int64_t>(count)).c_str());
+                ImGui::SameLine();
+                ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "%s", range.c_str());
+            }
+            lowerLimit = limit;
+        }
+        ImGui::Separator();
+    }
+
+    const CacheBudget& cache = m_model.cacheBudget();
+    ImGui::Text("Listing and preview cache: %s of %s", formatSize(static_cast<int64_t>(cache.usedBytes())).c_str(),
+                formatSize(static_cast<int64_t>(cache.budget())).c_str());
+    const char* names[CacheBudget::KIND_COUNT] = {"Folders", "Previews"};
+    for (int kind = 0; kind < CacheBudget::KIND_COUNT; ++kind) {
+        const CacheBudget::Stats& stats = cache.stats(static_cast<CacheBudget::Kind>(kind));
+        ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f),
+            "%s: %s cached (%s), %s hits, %s misses, %s evicted", names[kind],
+            formatNumber(static_cast<int64_t>(stats.entries)).c_str(),
+            formatSize(static_cast<int64_t>(stats.bytes)).c_str(),
+            formatNumber(static_cast<int64_t>(stats.hits)).c_str(),
+            formatNumber(static_cast<int64_t>(stats.misses)).c_str(),
+            formatNumber(static_cast<int64_t>(stats.evictions)).c_str());
+    }
+    ImGui::EndTooltip();
+}
+
 void BrowserUI::renderPreviewPane(float width, float height) {
     ImGui::BeginChild("PreviewPane", ImVec2(width, height), true);
 
@@ -527,6 +735,16 @@ std::string BrowserUI::formatSize(int64_t bytes) {
     return formatNumber(bytes / (1024 * 1024 * 1024)) + " GB";
 }
 
+std::string BrowserUI::formatTime(int64_t unixSeconds) {
+    time_t time = static_cast<time_t>(unixSeconds);
+    struct tm utc;
+    char buf[32];
+    if (!gmtime_r(&time, &utc) || strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M UTC", &utc) == 0) {
+        return "?";
+    }
+    return buf;
+}
+
 std::string BrowserUI::buildS3Path(const std::string& bucket, const std::string& prefix) {
     if (bucket.empty()) {
         return "s3://";
@@ -2,6 +2,7 @@
 
 #include "browser_model.h"
 #include "preview/preview_renderer.h"
+#include "preview/thumbnail_cache.h"
 #include <memory>
 #include <vector>
 
@@ -20,11 +21,17 @@ private:
     void renderContent();
     void renderBucketList();
     void renderFolderContents();
+    void renderFolderList(FolderNode& node);
+    void renderFolderGrid(FolderNode& node);
+    void renderFolderContextMenu(const std::string& bucket, const std::string& prefix);
+    void renderFileContextMenu(const std::string& bucket, const std::string& key);
     void renderStatusBar();
+    void renderStatusTooltip(const FolderNode* node);
     void renderPreviewPane(float width, float height);
 
     static std::string formatSize(int64_t bytes);
     static std::string formatNumber(int64_t number);
+    static std::string formatTime(int64_t unixSeconds);
     static std::string buildS3Path(const std::string& bucket, const std::string& prefix);
 
     BrowserModel& m_model;
@@ -35,4 +42,12 @@ private:
     // Preview renderers
     std::vector<std::unique_ptr<IPreviewRenderer>> m_previewRenderers;
     IPreviewRenderer* m_activeRenderer = nullptr;
+
+    // Folder contents as a grid of thumbnails instead of a list
+    bool m_gridView = false;
+    ThumbnailCache m_thumbnails;
+    static constexpr float GRID_CELL_SIZE = 128.0f;
+
+    // Order of folder listings (folders still come first)
+    ListingSort m_sort;
 };
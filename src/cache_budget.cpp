@@ -0,0 +1,87 @@
+#include "cache_budget.h"
+
+CacheBudget::CacheBudget(size_t budgetBytes)
+    : m_budget(budgetBytes)
+{
+}
+
+std::string CacheBudget::makeId(Kind kind, const std::string& key) {
+    return std::string(1, static_cast<char>('0' + kind)) + key;
+}
+
+void CacheBudget::record(Kind kind, const std::string& key, size_t bytes) {
+    std::string id = makeId(kind, key);
+    auto it = m_index.find(id);
+    if (it == m_index.end()) {
+        m_order.push_front(Entry{kind, key, bytes});
+        m_index.emplace(std::move(id), m_order.begin());
+        m_stats[kind].entries++;
+    } else {
+        Entry& entry = *it->second;
+        m_used -= entry.bytes;
+        m_stats[kind].bytes -= entry.bytes;
+        entry.bytes = bytes;
+        m_order.splice(m_order.begin(), m_order, it->second);
+    }
+    m_used += bytes;
+    m_stats[kind].bytes += bytes;
+}
+
+void CacheBudget::touch(Kind kind, const std::string& key) {
+    auto it = m_index.find(makeId(kind, key));
+    if (it != m_index.end()) {
+        m_order.splice(m_order.begin(), m_order, it->second);
+    }
+}
+
+void CacheBudget::forget(Kind kind, const std::string& key) {
+    auto it = m_index.find(makeId(kind, key));
+    if (it == m_index.end()) return;
+
+    m_used -= it->second->bytes;
+    m_stats[kind].bytes -= it->second->bytes;
+    m_stats[kind].entries--;
+    m_order.erase(it->second);
+    m_index.erase(it);
+}
+
+void CacheBudget::clear(Kind kind) {
+    for (auto it = m_order.begin(); it != m_order.end();) {
+        if (it->kind == kind) {
+            m_used -= it->bytes;
+            m_index.erase(makeId(kind, it->key));
+            it = m_order.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    m_stats[kind].entries = 0;
+    m_stats[kind].bytes = 0;
+}
+
+void CacheBudget::countLookup(Kind kind, bool hit) {
+    if (hit) {
+        m_stats[kind].hits++;
+    } else {
+        m_stats[kind].misses++;
+    }
+}
+
+std::vector<std::pair<CacheBudget::Kind, std::string>> CacheBudget::evict(const Pinned& isPinned) {
+    std::vector<std::pair<Kind, std::string>> evicted;
+    auto it = m_order.end();
+    while (m_used > m_budget && it != m_order.begin()) {
+        --it;
+        if (isPinned(it->kind, it->key)) continue;
+
+        Entry& entry = *it;
+        m_used -= entry.bytes;
+        m_stats[entry.kind].bytes -= entry.bytes;
+        m_stats[entry.kind].entries--;
+        m_stats[entry.kind].evictions++;
+        m_index.erase(makeId(entry.kind, entry.key));
+        evicted.emplace_back(entry.kind, std::move(entry.key));
+        it = m_order.erase(it);
+    }
+    return evicted;
+}
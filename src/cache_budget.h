@@ -0,0 +1,69 @@
+#pragma once
+
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Memory accounting for the model's caches (folder listings and prefetched
+// previews) under one byte budget. Owners report each entry's approximate
+// size as it changes and mark it used on access; once the total is over
+// budget, evict() names the least recently used entries to drop, skipping
+// any the owner pins (e.g. the current folder and the selected file).
+// Streaming previews (temp files) and decoded images aren't entries: they
+// belong to the open preview and are bounded by their own limits.
+// Not thread-safe: used from the UI thread.
+class CacheBudget {
+public:
+    enum Kind { Folder, Preview, KIND_COUNT };
+
+    explicit CacheBudget(size_t budgetBytes);
+
+    void setBudget(size_t budgetBytes) { m_budget = budgetBytes; }
+    size_t budget() const { return m_budget; }
+    size_t usedBytes() const { return m_used; }
+
+    // Insert or resize an entry and mark it most recently used
+    void record(Kind kind, const std::string& key, size_t bytes);
+    // Mark an entry most recently used; no-op if unknown
+    void touch(Kind kind, const std::string& key);
+    void forget(Kind kind, const std::string& key);
+    void clear(Kind kind);
+
+    // Count a lookup, for the hit rate
+    void countLookup(Kind kind, bool hit);
+
+    // Entries to drop, least recently used first, until the total is within
+    // budget. They're forgotten here; the owner erases its copies.
+    using Pinned = std::function<bool(Kind kind, const std::string& key)>;
+    std::vector<std::pair<Kind, std::string>> evict(const Pinned& isPinned);
+
+    struct Stats {
+        size_t entries = 0;
+        size_t bytes = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+    };
+    const Stats& stats(Kind kind) const { return m_stats[kind]; }
+
+private:
+    struct Entry {
+        Kind kind;
+        std::string key;
+        size_t bytes;
+    };
+    using Order = std::list<Entry>;  // Most recently used first
+
+    static std::string makeId(Kind kind, const std::string& key);
+
+    size_t m_budget;
+    size_t m_used = 0;
+    Order m_order;
+    std::unordered_map<std::string, Order::iterator> m_index;  // By makeId
+    Stats m_stats[KIND_COUNT];
+};
@@ -3,6 +3,7 @@
 #include <string>
 #include <vector>
 #include <variant>
+#include <cstdint>
 
 // Forward declarations
 struct S3Bucket;
@@ -58,6 +59,7 @@ struct ObjectRangeLoadedPayload {
     size_t startByte;
     size_t totalSize;  // Total size of the object
     std::string data;
+    uint64_t tag = 0;  // As passed to getObjectRange; 0 for streaming chunks
 };
 
 struct ObjectRangeErrorPayload {
@@ -65,6 +67,7 @@ struct ObjectRangeErrorPayload {
     std::string key;
     size_t startByte;
     std::string error_message;
+    uint64_t tag = 0;  // As passed to getObjectRange; 0 for streaming errors
 };
 
 // A state change event from a backend
@@ -150,11 +153,12 @@ struct StateEvent {
         const std::string& key,
         size_t startByte,
         size_t totalSize,
-        std::string data
+        std::string data,
+        uint64_t tag = 0
     ) {
         StateEvent e;
         e.type = EventType::ObjectRangeLoaded;
-        e.payload = ObjectRangeLoadedPayload{bucket, key, startByte, totalSize, std::move(data)};
+        e.payload = ObjectRangeLoadedPayload{bucket, key, startByte, totalSize, std::move(data), tag};
         return e;
     }
 
@@ -162,11 +166,12 @@ struct StateEvent {
         const std::string& bucket,
         const std::string& key,
         size_t startByte,
-        const std::string& error
+        const std::string& error,
+        uint64_t tag = 0
     ) {
         StateEvent e;
         e.type = EventType::ObjectRangeLoadError;
-        e.payload = ObjectRangeErrorPayload{bucket, key, startByte, error};
+        e.payload = ObjectRangeErrorPayload{bucket, key, startByte, error, tag};
         return e;
     }
 };
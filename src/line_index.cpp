@@ -0,0 +1,396 @@
+#include "line_index.h"
+#include "loguru.hpp"
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+// ============================================================================
+// Newline scanning
+// ============================================================================
+
+namespace {
+
+// Emit a line start for every set bit of a newline mask covering data[pos..]
+inline void emitMask(uint64_t mask, uint64_t base, std::vector<uint64_t>& out) {
+    while (mask) {
+        out.push_back(base + static_cast<uint64_t>(__builtin_ctzll(mask)) + 1);
+        mask &= mask - 1;
+    }
+}
+
+size_t scanScalar(const char* data, size_t len, uint64_t baseOffset, std::vector<uint64_t>& out) {
+    size_t pos = 0;
+    while (pos < len) {
+        const void* found = memchr(data + pos, '\n', len - pos);
+        if (!found) break;
+        size_t nl = static_cast<size_t>(static_cast<const char*>(found) - data);
+        out.push_back(baseOffset + nl + 1);
+        pos = nl + 1;
+    }
+    return len;
+}
+
+#if defined(__x86_64__)
+
+// SSE2 is part of x86-64, so this needs no runtime check
+size_t scanSSE2(const char* data, size_t len, uint64_t baseOffset, std::vector<uint64_t>& out) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    size_t i = 0;
+    for (; i + 64 <= len; i += 64) {
+        const __m128i* p = reinterpret_cast<const __m128i*>(data + i);
+        uint64_t m0 = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(p + 0), newline)));
+        uint64_t m1 = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(p + 1), newline)));
+        uint64_t m2 = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(p + 2), newline)));
+        uint64_t m3 = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(p + 3), newline)));
+        emitMask(m0 | (m1 << 16) | (m2 << 32) | (m3 << 48), baseOffset + i, out);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+size_t scanAVX2(const char* data, size_t len, uint64_t baseOffset, std::vector<uint64_t>& out) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    size_t i = 0;
+    for (; i + 64 <= len; i += 64) {
+        const __m256i* p = reinterpret_cast<const __m256i*>(data + i);
+        uint64_t lo = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(p + 0), newline)));
+        uint64_t hi = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(p + 1), newline)));
+        emitMask(lo | (hi << 32), baseOffset + i, out);
+    }
+    return i;
+}
+
+#elif defined(__aarch64__)
+
+// NEON has no movemask; narrowing each 16-bit lane by 4 leaves one nibble per
+// byte, so a 16-byte compare becomes a 64-bit mask with 4 bits per byte
+size_t scanNEON(const char* data, size_t len, uint64_t baseOffset, std::vector<uint64_t>& out) {
+    const uint8x16_t newline = vdupq_n_u8('\n');
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    size_t i = 0;
+    for (; i + 64 <= len; i += 64) {
+        uint8x16_t e0 = vceqq_u8(vld1q_u8(bytes + i), newline);
+        uint8x16_t e1 = vceqq_u8(vld1q_u8(bytes + i + 16), newline);
+        uint8x16_t e2 = vceqq_u8(vld1q_u8(bytes + i + 32), newline);
+        uint8x16_t e3 = vceqq_u8(vld1q_u8(bytes + i + 48), newline);
+        // Most 64-byte blocks of text hold at most one newline; skip empty ones fast
+        if (vmaxvq_u8(vorrq_u8(vorrq_u8(e0, e1), vorrq_u8(e2, e3))) == 0)
+            continue;
+        const uint8x16_t eq[4] = {e0, e1, e2, e3};
+        for (int k = 0; k < 4; ++k) {
+            uint64_t nibbles = vget_lane_u64(vreinterpret_u64_u8(
+                vshrn_n_u16(vreinterpretq_u16_u8(eq[k]), 4)), 0);
+            nibbles &= 0x8888888888888888ULL;
+            while (nibbles) {
+                out.push_back(baseOffset + i + 16 * k + (__builtin_ctzll(nibbles) >> 2) + 1);
+                nibbles &= nibbles - 1;
+            }
+        }
+    }
+    return i;
+}
+
+#endif
+
+using ScanFn = size_t (*)(const char*, size_t, uint64_t, std::vector<uint64_t>&);
+
+struct Scanner {
+    ScanFn scan;
+    const char* name;
+};
+
+Scanner pickScanner() {
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("avx2"))
+        return {scanAVX2, "avx2"};
+    return {scanSSE2, "sse2"};
+#elif defined(__aarch64__)
+    return {scanNEON, "neon"};
+#else
+    return {scanScalar, "scalar"};
+#endif
+}
+
+const Scanner& scanner() {
+    static const Scanner s = pickScanner();
+    return s;
+}
+
+} // namespace
+
+void findNewlines(const char* data, size_t len, uint64_t baseOffset,
+                  std::vector<uint64_t>& lineStarts) {
+    // The vector loops handle whole 64-byte blocks; the rest goes to memchr
+    size_t done = scanner().scan(data, len, baseOffset, lineStarts);
+    if (done < len) {
+        scanScalar(data + done, len - done, baseOffset + done, lineStarts);
+    }
+}
+
+const char* newlineScannerName() {
+    return scanner().name;
+}
+
+// ============================================================================
+// LineIndex
+// ============================================================================
+
+namespace {
+
+inline uint64_t readBits(const uint64_t* words, size_t pos, unsigned width) {
+    if (width == 0) return 0;
+    size_t i = pos / 64;
+    unsigned shift = pos % 64;
+    uint64_t v = words[i] >> shift;
+    if (shift + width > 64) v |= words[i + 1] << (64 - shift);
+    return v & ((uint64_t(1) << width) - 1);
+}
+
+inline void writeBits(uint64_t* words, size_t pos, unsigned width, uint64_t value) {
+    if (width == 0) return;
+    size_t i = pos / 64;
+    unsigned shift = pos % 64;
+    words[i] |= value << shift;
+    if (shift + width > 64) words[i + 1] |= value >> (64 - shift);
+}
+
+// Position of the (rank+1)-th set bit of word
+inline unsigned selectInWord(uint64_t word, unsigned rank) {
+    unsigned shift = 0;
+    for (;;) {
+        unsigned count = static_cast<unsigned>(__builtin_popcountll(word & 0xFF));
+        if (rank < count) break;
+        rank -= count;
+        word >>= 8;
+        shift += 8;
+    }
+    while (rank--) word &= word - 1;
+    return shift + static_cast<unsigned>(__builtin_ctzll(word));
+}
+
+} // namespace
+
+// Block encoding, in 64-bit words:
+//   [0]      low bits per value (l) | high words << 8
+//   [1..h]   high parts: bit (x >> l) + k is set for the k-th value x
+//   [h+1..]  low parts: l bits per value
+// where x is the line start minus the block's base.
+
+LineIndex::LineIndex(size_t memoryBudget)
+    : m_memoryBudget(memoryBudget)
+{
+    m_tail.reserve(BLOCK_LINES);
+    m_tail.push_back(0);
+}
+
+LineIndex::~LineIndex() {
+    for (size_t s = 0; s < m_spilledSegments; ++s) {
+        munmap(const_cast<uint64_t*>(m_segments[s].mapped), SEGMENT_BYTES);
+    }
+    if (m_spillFd >= 0) {
+        ::close(m_spillFd);
+    }
+}
+
+void LineIndex::append(const std::vector<uint64_t>& lineStarts) {
+    if (lineStarts.empty()) return;
+
+    {
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        for (uint64_t start : lineStarts) {
+            m_tail.push_back(start);
+            if (m_tail.size() == BLOCK_LINES) {
+                sealBlock(m_tail.data());
+                m_tail.clear();
+            }
+        }
+    }
+
+    if (m_residentBytes > m_memoryBudget && !m_spillFailed) {
+        spillFullSegments();
+    }
+}
+
+void LineIndex::sealBlock(const uint64_t* starts) {
+    // Caller holds m_mutex exclusively
+    uint64_t base = starts[0];
+    uint64_t range = starts[BLOCK_LINES - 1] - base;
+    uint64_t perLine = range / BLOCK_LINES;
+    unsigned lowBits = perLine ? 63 - static_cast<unsigned>(__builtin_clzll(perLine)) : 0;
+    size_t highWords = static_cast<size_t>(((range >> lowBits) + BLOCK_LINES + 63) / 64);
+    size_t lowWords = (BLOCK_LINES * lowBits + 63) / 64;
+    size_t total = 1 + highWords + lowWords;
+
+    if (m_segments.empty() || m_segments.back().memory.size() + total > SEGMENT_WORDS) {
+        m_segments.emplace_back();
+        m_segments.back().memory.reserve(SEGMENT_WORDS);  // Filled without reallocating
+        m_residentBytes += SEGMENT_BYTES;
+    }
+    Segment& segment = m_segments.back();
+    size_t at = segment.memory.size();
+    segment.memory.resize(at + total, 0);
+
+    uint64_t* words = segment.memory.data() + at;
+    words[0] = lowBits | (static_cast<uint64_t>(highWords) << 8);
+    uint64_t* high = words + 1;
+    uint64_t* low = high + highWords;
+    for (size_t k = 0; k < BLOCK_LINES; ++k) {
+        uint64_t x = starts[k] - base;
+        size_t bit = static_cast<size_t>(x >> lowBits) + k;
+        high[bit / 64] |= uint64_t(1) << (bit % 64);
+        writeBits(low, k * lowBits, lowBits, x & ((uint64_t(1) << lowBits) - 1));
+    }
+
+    m_blocks.push_back(Block{base, static_cast<uint32_t>(m_segments.size() - 1), static_cast<uint32_t>(at)});
+}
+
+uint64_t LineIndex::decode(const Block& block, size_t k) const {
+    const uint64_t* words = m_segments[block.segment].words() + block.word;
+    unsigned lowBits = static_cast<unsigned>(words[0] & 0xFF);
+    size_t highWords = static_cast<size_t>(words[0] >> 8);
+    const uint64_t* high = words + 1;
+
+    // Find the k-th set bit among the high parts
+    unsigned rank = static_cast<unsigned>(k);
+    size_t bit = 0;
+    for (size_t w = 0; w < highWords; ++w) {
+        unsigned count = static_cast<unsigned>(__builtin_popcountll(high[w]));
+        if (rank < count) {
+            bit = w * 64 + selectInWord(high[w], rank);
+            break;
+        }
+        rank -= count;
+    }
+
+    uint64_t x = (static_cast<uint64_t>(bit - k) << lowBits) |
+                 readBits(high + highWords, k * lowBits, lowBits);
+    return block.base + x;
+}
+
+void LineIndex::spillFullSegments() {
+    // Writer only. Full segments never change again, so they can be written
+    // out without holding the lock; only swapping in the mapping needs it.
+    if (m_spillFd < 0) {
+        const char* tmpdir = std::getenv("TMPDIR");
+        if (!tmpdir) tmpdir = "/tmp";
+        std::string path = std::string(tmpdir) + "/s6ui_lines_XXXXXX";
+        std::vector<char> pathBuf(path.begin(), path.end());
+        pathBuf.push_back('\0');
+        m_spillFd = mkstemp(pathBuf.data());
+        if (m_spillFd < 0) {
+            LOG_F(WARNING, "LineIndex: can't create spill file, keeping index in memory: %s", strerror(errno));
+            m_spillFailed = true;
+            return;
+        }
+        // Nobody else needs the name; the space is freed when the fd is closed
+        unlink(pathBuf.data());
+    }
+
+    while (m_residentBytes > m_memoryBudget && m_spilledSegments + 1 < m_segments.size()) {
+        size_t s = m_spilledSegments;
+        const std::vector<uint64_t>& memory = m_segments[s].memory;
+        const char* data = reinterpret_cast<const char*>(memory.data());
+        size_t len = memory.size() * sizeof(uint64_t);
+        off_t fileOffset = static_cast<off_t>(s * SEGMENT_BYTES);
+
+        size_t written = 0;
+        while (written < len) {
+            ssize_t n = pwrite(m_spillFd, data + written, len - written, fileOffset + static_cast<off_t>(written));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            written += static_cast<size_t>(n);
+        }
+        void* mapped = written == len
+            ? mmap(nullptr, SEGMENT_BYTES, PROT_READ, MAP_SHARED, m_spillFd, fileOffset)
+            : MAP_FAILED;
+        if (mapped == MAP_FAILED) {
+            LOG_F(WARNING, "LineIndex: spilling to disk failed, keeping index in memory: %s", strerror(errno));
+            m_spillFailed = true;
+            return;
+        }
+
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        Segment& segment = m_segments[s];
+        segment.mapped = static_cast<const uint64_t*>(mapped);
+        m_residentBytes -= SEGMENT_BYTES;
+        std::vector<uint64_t>().swap(segment.memory);
+        m_spilledSegments++;
+    }
+}
+
+size_t LineIndex::lineCount() const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_blocks.size() * BLOCK_LINES + m_tail.size();
+}
+
+uint64_t LineIndex::lineStartLocked(size_t line) const {
+    size_t block = line / BLOCK_LINES;
+    if (block < m_blocks.size()) {
+        return decode(m_blocks[block], line % BLOCK_LINES);
+    }
+    size_t k = line - m_blocks.size() * BLOCK_LINES;
+    return k < m_tail.size() ? m_tail[k] : 0;
+}
+
+uint64_t LineIndex::lineStart(size_t line) const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return lineStartLocked(line);
+}
+
+size_t LineIndex::linesBefore(uint64_t byteOffset) const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    size_t sealed = m_blocks.size() * BLOCK_LINES;
+
+    size_t count;
+    if (!m_tail.empty() && m_tail.front() < byteOffset) {
+        count = sealed + static_cast<size_t>(
+            std::lower_bound(m_tail.begin(), m_tail.end(), byteOffset) - m_tail.begin());
+    } else {
+        // Last block starting before byteOffset, then search within it
+        auto it = std::lower_bound(m_blocks.begin(), m_blocks.end(), byteOffset,
+                                   [](const Block& b, uint64_t offset) { return b.base < offset; });
+        if (it == m_blocks.begin()) return 1;
+        const Block& block = *(it - 1);
+        size_t lo = 1, hi = BLOCK_LINES;  // Values before lo are < byteOffset
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (decode(block, mid) < byteOffset) lo = mid + 1;
+            else hi = mid;
+        }
+        count = static_cast<size_t>(it - 1 - m_blocks.begin()) * BLOCK_LINES + lo;
+    }
+    return std::max<size_t>(1, count);
+}
+
+bool LineIndex::lineRange(size_t line, uint64_t fileSize, uint64_t& start, uint64_t& end) const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    size_t count = m_blocks.size() * BLOCK_LINES + m_tail.size();
+    if (line >= count) return false;
+    start = lineStartLocked(line);
+    end = line + 1 < count ? lineStartLocked(line + 1) : fileSize;
+    end = std::min(end, fileSize);
+    if (start > end) start = end;
+    return true;
+}
+
+size_t LineIndex::memoryBytes() const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_residentBytes + m_blocks.capacity() * sizeof(Block) +
+           m_tail.capacity() * sizeof(uint64_t);
+}
+
+size_t LineIndex::spilledBytes() const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_spilledSegments * SEGMENT_BYTES;
+}
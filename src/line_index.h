@@ -0,0 +1,95 @@
+#pragma once
+
+#include <vector>
+#include <shared_mutex>
+#include <cstddef>
+#include <cstdint>
+
+// Appends baseOffset + i + 1 to lineStarts for every '\n' at data[i], i.e.
+// the offset where the following line starts. Vectorized (AVX2 or SSE2 on
+// x86-64, NEON on arm64) with a memchr fallback elsewhere.
+void findNewlines(const char* data, size_t len, uint64_t baseOffset,
+                  std::vector<uint64_t>& lineStarts);
+
+// Name of the implementation findNewlines picked for this CPU
+const char* newlineScannerName();
+
+// Where each line of a growing text file starts. Filled once by whoever
+// writes the file and shared with everything that displays it, so the bytes
+// are only scanned for newlines once.
+//
+// Line starts are Elias-Fano coded in blocks of BLOCK_LINES, each block
+// relative to its first (absolute) offset, which takes 1-2 bytes per line for
+// typical text instead of 8. Encoded blocks live in fixed-size segments; once
+// they outgrow the memory budget, full segments are written to an unlinked
+// temp file and mapped back in, so the OS can page them out.
+// Thread-safe: one writer appends while any number of readers look lines up.
+class LineIndex {
+public:
+    static constexpr size_t DEFAULT_MEMORY_BUDGET = 64 * 1024 * 1024;
+
+    // Line 0 starts at byte 0
+    explicit LineIndex(size_t memoryBudget = DEFAULT_MEMORY_BUDGET);
+    ~LineIndex();
+
+    LineIndex(const LineIndex&) = delete;
+    LineIndex& operator=(const LineIndex&) = delete;
+
+    // Add line starts found by findNewlines (must be past the current last one)
+    void append(const std::vector<uint64_t>& lineStarts);
+
+    // Lines started so far, counting the (empty) one after a trailing newline
+    size_t lineCount() const;
+
+    // Byte offset where a line starts, or 0 if it hasn't been seen yet
+    uint64_t lineStart(size_t line) const;
+
+    // Lines that start before byteOffset, i.e. the line count of a file
+    // truncated there (at least 1)
+    size_t linesBefore(uint64_t byteOffset) const;
+
+    // Byte range of a line: from its start up to the start of the next line
+    // (so including the newline), or up to fileSize for the last line
+    bool lineRange(size_t line, uint64_t fileSize, uint64_t& start, uint64_t& end) const;
+
+    // Bytes held in memory, and bytes moved out to the spill file
+    size_t memoryBytes() const;
+    size_t spilledBytes() const;
+
+private:
+    static constexpr size_t BLOCK_LINES = 128;
+    static constexpr size_t SEGMENT_WORDS = 1 << 20;
+    static constexpr size_t SEGMENT_BYTES = SEGMENT_WORDS * sizeof(uint64_t);  // 8MB
+
+    struct Block {
+        uint64_t base;     // Absolute offset of the block's first line
+        uint32_t segment;  // Where its encoding starts
+        uint32_t word;
+    };
+
+    struct Segment {
+        std::vector<uint64_t> memory;     // Until spilled
+        const uint64_t* mapped = nullptr; // After spilling
+        const uint64_t* words() const { return mapped ? mapped : memory.data(); }
+    };
+
+    // Callers hold m_mutex (shared is enough)
+    uint64_t lineStartLocked(size_t line) const;
+    uint64_t decode(const Block& block, size_t k) const;
+
+    // Writer only
+    void sealBlock(const uint64_t* starts);
+    void spillFullSegments();
+
+    size_t m_memoryBudget;
+
+    mutable std::shared_mutex m_mutex;
+    std::vector<Block> m_blocks;
+    std::vector<Segment> m_segments;
+    std::vector<uint64_t> m_tail;  // Line starts not yet sealed into a block
+    size_t m_residentBytes = 0;    // Segment bytes still in memory (reserved whole)
+    size_t m_spilledSegments = 0;  // Segments [0, m_spilledSegments) are mapped
+
+    int m_spillFd = -1;
+    bool m_spillFailed = false;
+};
@@ -0,0 +1,337 @@
+#include "listing_cache.h"
+#include "object_store.h"
+#include "settings.h"
+#include "thread_pool.h"
+#include "loguru.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// On-disk format (native byte order, it never leaves this machine):
+//   magic, object count, then per object
+//   flags, varint shared key prefix, varint suffix length, suffix,
+//   varint size, varint modification time (Unix seconds),
+//   varint ETag length, ETag bytes (16 raw bytes if ETAG_PACKED)
+// Keys are relative to the folder prefix; the shared prefix is with the
+// previous object's key.
+static constexpr char LISTING_MAGIC[8] = {'S', '6', 'L', 'S', 'T', '0', '0', '2'};
+
+// Limits on the cache directory. Listings are dropped least recently used
+// first (loading one refreshes its modification time); temp files are only
+// left behind by a crash mid-save.
+static constexpr uint64_t MAX_CACHE_BYTES = 256 * 1024 * 1024;
+static constexpr time_t MAX_LISTING_AGE = 30 * 24 * 60 * 60;
+static constexpr time_t MAX_TEMP_AGE = 24 * 60 * 60;
+static constexpr uint64_t SAVES_PER_PRUNE = 64;
+
+enum : uint8_t {
+    IS_FOLDER = 1,
+    ETAG_PACKED = 2,
+};
+
+static void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+static size_t sharedPrefix(std::string_view a, std::string_view b) {
+    size_t n = std::min(a.size(), b.size());
+    size_t i = 0;
+    while (i < n && a[i] == b[i]) ++i;
+    return i;
+}
+
+// Bounds-checked reader over the mapped file
+namespace {
+struct Reader {
+    const uint8_t* pos;
+    const uint8_t* end;
+
+    bool varint(uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && pos < end; shift += 7) {
+            uint8_t byte = *pos++;
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    bool bytes(std::string_view& out) {
+        uint64_t length;
+        if (!varint(length) || length > static_cast<uint64_t>(end - pos)) return false;
+        out = std::string_view(reinterpret_cast<const char*>(pos), length);
+        pos += length;
+        return true;
+    }
+
+    // Replace s past its first base + `shared` characters with the next suffix
+    bool frontCoded(std::string& s, size_t base) {
+        uint64_t shared, length;
+        if (!varint(shared) || !varint(length) || shared > s.size() - base ||
+            length > static_cast<uint64_t>(end - pos)) {
+            return false;
+        }
+        s.resize(base + shared);
+        s.append(reinterpret_cast<const char*>(pos), length);
+        pos += length;
+        return true;
+    }
+};
+} // namespace
+
+std::string listingCachePath(const std::string& profile, const std::string& bucket,
+                             const std::string& prefix) {
+    std::string dir = cacheDirectory("listings");
+    if (dir.empty()) return "";
+
+    // FNV-1a over the listing identity keeps file names short and stable
+    uint64_t hash = 14695981039346656037ULL;
+    for (const std::string* part : {&profile, &bucket, &prefix}) {
+        for (unsigned char c : *part) {
+            hash = (hash ^ c) * 1099511628211ULL;
+        }
+        hash = (hash ^ '\n') * 1099511628211ULL;
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.lst", static_cast<unsigned long long>(hash));
+    return dir + "/" + name;
+}
+
+static void pruneDirectory(const std::string& dir) {
+    DIR* listing = opendir(dir.c_str());
+    if (!listing) return;
+
+    struct File {
+        std::string path;
+        time_t modified;
+        uint64_t bytes;
+    };
+    std::vector<File> files;
+    uint64_t totalBytes = 0;
+    size_t removed = 0;
+    time_t now = time(nullptr);
+    while (dirent* entry = readdir(listing)) {
+        std::string_view name = entry->d_name;
+        bool isTemp = name.find(".lst.tmp") != std::string_view::npos;
+        bool isListing = name.size() > 4 && name.substr(name.size() - 4) == ".lst";
+        if (!isTemp && !isListing) continue;
+
+        std::string path = dir + "/" + entry->d_name;
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) continue;
+        if (now - st.st_mtime > (isTemp ? MAX_TEMP_AGE : MAX_LISTING_AGE)) {
+            if (std::remove(path.c_str()) == 0) removed++;
+            continue;
+        }
+        if (isListing) {
+            files.push_back(File{std::move(path), st.st_mtime, static_cast<uint64_t>(st.st_size)});
+            totalBytes += static_cast<uint64_t>(st.st_size);
+        }
+    }
+    closedir(listing);
+
+    if (totalBytes > MAX_CACHE_BYTES) {
+        std::sort(files.begin(), files.end(),
+                  [](const File& a, const File& b) { return a.modified < b.modified; });
+        for (const File& file : files) {
+            if (totalBytes <= MAX_CACHE_BYTES) break;
+            if (std::remove(file.path.c_str()) == 0) {
+                totalBytes -= file.bytes;
+                removed++;
+            }
+        }
+    }
+    if (removed > 0) {
+        LOG_F(INFO, "ListingCache: pruned %zu files from %s, %llu bytes left",
+              removed, dir.c_str(), static_cast<unsigned long long>(totalBytes));
+    }
+}
+
+bool loadListing(const std::string& path, const std::string& prefix, ObjectStore& objects) {
+    if (path.empty()) return false;
+
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(LISTING_MAGIC) + sizeof(uint64_t))) {
+        close(fd);
+        return false;
+    }
+    size_t fileSize = static_cast<size_t>(st.st_size);
+    void* mapped = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    futimens(fd, nullptr);  // Recently used, for pruning
+    close(fd);
+    if (mapped == MAP_FAILED) return false;
+
+    const auto* data = static_cast<const uint8_t*>(mapped);
+    uint64_t count = 0;
+    memcpy(&count, data + sizeof(LISTING_MAGIC), sizeof(count));
+    Reader in{data + sizeof(LISTING_MAGIC) + sizeof(count), data + fileSize};
+    bool ok = memcmp(data, LISTING_MAGIC, sizeof(LISTING_MAGIC)) == 0 &&
+              count <= fileSize;  // Every object takes at least a byte
+
+    ObjectStore loaded;
+    if (ok) loaded.reserve(count);
+    std::string key = prefix;
+    for (uint64_t i = 0; ok && i < count; ++i) {
+        uint8_t flags = 0;
+        uint64_t size = 0;
+        uint64_t lastModified = 0;
+        std::string_view etag;
+        if (in.pos >= in.end) {
+            ok = false;
+            break;
+        }
+        flags = *in.pos++;
+        if (!in.frontCoded(key, prefix.size()) || !in.varint(size) || !in.varint(lastModified) || !in.bytes(etag)) {
+            ok = false;
+            break;
+        }
+        loaded.append(key, flags & IS_FOLDER, static_cast<int64_t>(size), static_cast<int64_t>(lastModified),
+                      etag, flags & ETAG_PACKED);
+    }
+    munmap(mapped, fileSize);
+
+    if (!ok) {
+        LOG_F(WARNING, "ListingCache: ignoring unreadable listing %s", path.c_str());
+        return false;
+    }
+    objects = std::move(loaded);
+    LOG_F(INFO, "ListingCache: loaded %zu objects for prefix=%s from %s",
+          objects.size(), prefix.c_str(), path.c_str());
+    return true;
+}
+
+void saveListing(const std::string& path, const std::string& prefix, const ObjectStore& objects) {
+    if (path.empty()) return;
+
+    // Temp names are unique in case the same folder is saved twice at once
+    static std::atomic<uint64_t> saveNumber{0};
+    uint64_t number = saveNumber++;
+    auto entries = std::make_shared<const std::vector<ObjectStore::Entry>>(objects.begin(), objects.end());
+    std::shared_ptr<const void> arena = objects.arena();
+    ThreadPool::shared().submit([path, prefix, entries, arena, number] {
+        std::string encoded(LISTING_MAGIC, sizeof(LISTING_MAGIC));
+        uint64_t count = entries->size();
+        encoded.append(reinterpret_cast<const char*>(&count), sizeof(count));
+
+        std::string_view previousKey;
+        for (const auto& obj : *entries) {
+            std::string_view key = obj.key();
+            if (key.compare(0, prefix.size(), prefix) != 0) {
+                LOG_F(WARNING, "ListingCache: key %.*s outside prefix %s, not saving",
+                      static_cast<int>(key.size()), key.data(), prefix.c_str());
+                return;
+            }
+            key.remove_prefix(prefix.size());
+            encoded.push_back(static_cast<char>((obj.isFolder() ? IS_FOLDER : 0) | (obj.etagPacked() ? ETAG_PACKED : 0)));
+
+            size_t shared = sharedPrefix(previousKey, key);
+            putVarint(encoded, shared);
+            putVarint(encoded, key.size() - shared);
+            encoded.append(key.data() + shared, key.size() - shared);
+            putVarint(encoded, static_cast<uint64_t>(std::max<int64_t>(obj.size(), 0)));
+            putVarint(encoded, static_cast<uint64_t>(std::max<int64_t>(obj.lastModified(), 0)));
+            std::string_view etag = obj.etagBytes();
+            putVarint(encoded, etag.size());
+            encoded.append(etag.data(), etag.size());
+
+            previousKey = key;
+        }
+
+        // Write to a temp file and rename so a crash never leaves a torn listing
+        std::string tmpPath = path + ".tmp" + std::to_string(number);
+        {
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!out.is_open() || !out.write(encoded.data(), static_cast<std::streamsize>(encoded.size()))) {
+                LOG_F(WARNING, "ListingCache: failed to write %s", tmpPath.c_str());
+                std::remove(tmpPath.c_str());
+                return;
+            }
+        }
+        if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+            LOG_F(WARNING, "ListingCache: failed to replace %s", path.c_str());
+            std::remove(tmpPath.c_str());
+            return;
+        }
+        LOG_F(INFO, "ListingCache: saved %llu objects (%zu bytes) to %s",
+              static_cast<unsigned long long>(count), encoded.size(), path.c_str());
+
+        if (number % SAVES_PER_PRUNE == SAVES_PER_PRUNE - 1) {
+            pruneDirectory(path.substr(0, path.rfind('/')));
+        }
+    });
+}
+
+void pruneListingCache() {
+    std::string dir = cacheDirectory("listings");
+    if (dir.empty()) return;
+    ThreadPool::shared().submit([dir] { pruneDirectory(dir); });
+}
+
+ListingDiff updateListing(ObjectStore& objects, const ObjectStore& fresh) {
+    std::unordered_map<std::string_view, size_t> previous;
+    previous.reserve(objects.size());
+    for (size_t i = 0; i < objects.size(); ++i) {
+        previous.emplace(objects[i].key(), i);
+    }
+
+    ListingDiff diff;
+    diff.previousCount = objects.size();
+    std::vector<bool> removed(objects.size(), true);
+    std::vector<std::pair<size_t, const ObjectStore::Entry*>> changed;
+    std::vector<const ObjectStore::Entry*> added;
+    for (const auto& obj : fresh) {
+        auto it = previous.find(obj.key());
+        // A key that turned from folder to file (or back) moves section, so
+        // it's taken out and added again
+        if (it == previous.end() || objects[it->second].isFolder() != obj.isFolder()) {
+            added.push_back(&obj);
+            continue;
+        }
+        removed[it->second] = false;
+        const auto& old = objects[it->second];
+        if (old.size() != obj.size() || old.lastModified() != obj.lastModified() ||
+            old.etagPacked() != obj.etagPacked() || old.etagBytes() != obj.etagBytes()) {
+            changed.emplace_back(it->second, &obj);
+        }
+    }
+    diff.added = added.size();
+    diff.changed = changed.size();
+    diff.removed = static_cast<size_t>(std::count(removed.begin(), removed.end(), true));
+
+    if (!changed.empty()) {
+        objects.assign(changed);
+    }
+    if (diff.removed > 0) {
+        diff.moved.resize(removed.size());
+        size_t next = 0;
+        for (size_t i = 0; i < removed.size(); ++i) {
+            diff.moved[i] = removed[i] ? SIZE_MAX : next++;
+        }
+        objects.erase(removed);
+    }
+    diff.firstAdded = objects.size();
+    for (const ObjectStore::Entry* obj : added) {
+        objects.append(obj->key(), obj->isFolder(), obj->size(), obj->lastModified(),
+                       obj->etagBytes(), obj->etagPacked());
+    }
+    return diff;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+class ObjectStore;
+
+// Folder listings saved between sessions, so a folder seen before shows at
+// once while a fresh listing loads in the background. One file per profile,
+// bucket and prefix under the cache directory, in a compact binary form:
+// keys are stored relative to the prefix and front-coded against the
+// previous key, ETags as the ObjectStore holds them.
+
+// Cache file for a listing, or "" if there's no cache directory
+std::string listingCachePath(const std::string& profile, const std::string& bucket,
+                             const std::string& prefix);
+
+// Read a listing saved by saveListing, decoding the mapped file into objects
+// (keys and ETags are copied into its arena; the mapping is released).
+// Returns false if there is none or it's unreadable.
+bool loadListing(const std::string& path, const std::string& prefix, ObjectStore& objects);
+
+// Save a complete listing. Its entries are copied (not their text, which the
+// arena keeps alive), then encoded and written on the shared thread pool.
+void saveListing(const std::string& path, const std::string& prefix, const ObjectStore& objects);
+
+// Drop expired listings and, past the size cap, the least recently used;
+// runs on the shared thread pool. Also done now and then by saveListing.
+void pruneListingCache();
+
+// How a fresh listing differed from a cached one, as applied by updateListing
+struct ListingDiff {
+    size_t added = 0;
+    size_t removed = 0;
+    size_t changed = 0;  // Same key, different size, ETag or modification time
+    bool empty() const { return added == 0 && removed == 0 && changed == 0; }
+
+    size_t previousCount = 0;   // Objects before
+    std::vector<size_t> moved;  // Old index -> new index, or SIZE_MAX if removed (empty if none were)
+    size_t firstAdded = 0;      // Added objects were appended from here on, in key order
+};
+
+// Bring a cached listing up to date with a fresh one of the same folder in
+// place: changed objects are updated where they are, removed ones dropped and
+// new ones appended, so a view of it only has to take in the difference.
+ListingDiff updateListing(ObjectStore& objects, const ObjectStore& fresh);
@@ -0,0 +1,160 @@
+#include "listing_sort.h"
+#include "thread_pool.h"
+#include "loguru.hpp"
+#include <algorithm>
+#include <string_view>
+#include <cstdint>
+
+// Smallest share of a sort given to one worker
+static constexpr size_t MIN_CHUNK_ITEMS = 32 * 1024;
+
+const char* ListingSort::columnName(Column column) {
+    switch (column) {
+        case Name: return "Name";
+        case Size: return "Size";
+        case Modified: return "Modified";
+        case Extension: return "Extension";
+        default: return "?";
+    }
+}
+
+ListingSorter::~ListingSorter() {
+    cancel();
+}
+
+bool ListingSorter::less(const ListingSort& sort, const Item& a, const Item& b) {
+    std::string_view nameA(a.name, a.nameLength);
+    std::string_view nameB(b.name, b.nameLength);
+
+    int primary = 0;
+    switch (sort.column) {
+        case ListingSort::Size:
+        case ListingSort::Modified:
+            primary = (a.value < b.value) ? -1 : (a.value > b.value) ? 1 : 0;
+            break;
+        case ListingSort::Extension:
+            primary = nameA.substr(a.extensionOffset).compare(nameB.substr(b.extensionOffset));
+            break;
+        default:
+            primary = nameA.compare(nameB);
+            break;
+    }
+    if (primary != 0) {
+        return sort.descending ? primary > 0 : primary < 0;
+    }
+    int byName = nameA.compare(nameB);
+    if (byName != 0) return byName < 0;
+    return a.position < b.position;
+}
+
+void ListingSorter::update(const ObjectStore& objects, const std::vector<size_t>& arrival, const ListingSort& sort) {
+    if (sort != m_sort || arrival.size() < m_submitted) {
+        reset();
+        m_sort = sort;
+    }
+    // Arrival order is already sorted by name
+    if (m_sort.isKeyOrder()) return;
+
+    if (m_run) {
+        std::shared_ptr<const Order> result;
+        {
+            std::lock_guard<std::mutex> lock(m_run->mutex);
+            result = m_run->result;
+        }
+        if (!result) return;  // Still sorting; the next batch waits for it
+        m_order = std::move(result);
+        m_run.reset();
+    }
+    if (m_submitted >= arrival.size()) return;
+
+    // Sort what arrived since the last run and merge it into the current order
+    auto run = std::make_shared<Run>();
+    run->sort = m_sort;
+    run->arena = objects.arena();
+    run->base = m_order;
+    run->items.reserve(arrival.size() - m_submitted);
+    for (size_t position = m_submitted; position < arrival.size(); ++position) {
+        const ObjectStore::Entry& obj = objects[arrival[position]];
+        std::string_view name = obj.displayName();
+        size_t dot = name.rfind('.');
+        Item item;
+        item.value = (m_sort.column == ListingSort::Modified) ? obj.lastModified() : obj.size();
+        item.name = name.data();
+        // Clamped like ObjectStore clamps display names, so nothing wraps
+        size_t nameLength = std::min<size_t>(name.size(), UINT16_MAX);
+        item.nameLength = static_cast<uint16_t>(nameLength);
+        item.extensionOffset = static_cast<uint16_t>(dot != std::string_view::npos ? std::min(dot, nameLength) : nameLength);
+        item.position = static_cast<uint32_t>(std::min<size_t>(position, UINT32_MAX));
+        run->items.push_back(item);
+    }
+    m_submitted = arrival.size();
+
+    size_t count = run->items.size();
+    size_t chunks = std::clamp<size_t>(count / MIN_CHUNK_ITEMS, 1, ThreadPool::shared().threadCount());
+    for (size_t chunk = 1; chunk <= chunks; ++chunk) {
+        run->chunkEnds.push_back(count * chunk / chunks);
+    }
+    run->pendingChunks = chunks;
+    LOG_F(INFO, "ListingSorter: sorting %zu objects by %s%s in %zu chunks, merging into %zu",
+          count, ListingSort::columnName(m_sort.column), m_sort.descending ? " (descending)" : "",
+          chunks, m_order ? m_order->size() : 0);
+    for (size_t chunk = 0; chunk < chunks; ++chunk) {
+        ThreadPool::shared().submit([run, chunk] { run->sortChunk(chunk); });
+    }
+    m_run = std::move(run);
+}
+
+void ListingSorter::Run::sortChunk(size_t chunk) {
+    if (!cancelled.load()) {
+        size_t begin = chunk == 0 ? 0 : chunkEnds[chunk - 1];
+        const ListingSort& by = sort;
+        std::sort(items.begin() + begin, items.begin() + chunkEnds[chunk],
+                  [&by](const Item& a, const Item& b) { return less(by, a, b); });
+    }
+
+    // The last chunk to finish merges, so no worker waits on another
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--pendingChunks > 0) return;
+    }
+    finish();
+}
+
+void ListingSorter::Run::finish() {
+    auto order = std::make_shared<Order>();
+    if (!cancelled.load()) {
+        const ListingSort& by = sort;
+        auto cmp = [&by](const Item& a, const Item& b) { return less(by, a, b); };
+        for (size_t chunk = 1; chunk < chunkEnds.size(); ++chunk) {
+            std::inplace_merge(items.begin(), items.begin() + chunkEnds[chunk - 1],
+                               items.begin() + chunkEnds[chunk], cmp);
+        }
+        if (base) {
+            order->resize(base->size() + items.size());
+            std::merge(base->begin(), base->end(), items.begin(), items.end(), order->begin(), cmp);
+        } else {
+            *order = std::move(items);
+        }
+    }
+    items = Order();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    result = std::move(order);
+}
+
+void ListingSorter::cancel() {
+    if (m_run) {
+        m_run->cancelled.store(true);
+        m_run.reset();
+    }
+}
+
+void ListingSorter::reset() {
+    cancel();
+    m_order.reset();
+    m_submitted = 0;
+}
+
+size_t ListingSorter::memoryBytes() const {
+    return m_order ? m_order->capacity() * sizeof(Item) : 0;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "object_store.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// How a folder's listing is ordered. Folders and files are sorted separately
+// (folders stay first); ties fall back to the name.
+struct ListingSort {
+    enum Column { Name, Size, Modified, Extension, COLUMN_COUNT };
+    Column column = Name;
+    bool descending = false;
+
+    // Ascending by name is S3's key order, which listings already come in
+    bool isKeyOrder() const { return column == Name && !descending; }
+    bool operator==(const ListingSort& other) const {
+        return column == other.column && descending == other.descending;
+    }
+    bool operator!=(const ListingSort& other) const { return !(*this == other); }
+
+    static const char* columnName(Column column);
+};
+
+// Keeps one section of a folder view (its folders or its files) sorted
+// without ever blocking the UI. Objects are given by their position in the
+// section's arrival order; those not sorted yet are shown after the sorted
+// ones, in arrival order. A full sort runs on the shared thread pool in
+// parallel chunks; objects that arrive later are sorted on their own and
+// merged in, so a new page costs O(page log page + n) off the UI thread.
+class ListingSorter {
+public:
+    ListingSorter() = default;
+    ~ListingSorter();
+    ListingSorter(ListingSorter&&) = default;
+    ListingSorter& operator=(ListingSorter&&) = default;
+
+    // Call once per frame: collects a finished sort and starts the next one.
+    // arrival holds object indices, in the order they were listed.
+    void update(const ObjectStore& objects, const std::vector<size_t>& arrival, const ListingSort& sort);
+    // Forget everything, e.g. when the objects are replaced
+    void reset();
+
+    // Rows [0, sortedCount()) are sorted; row -> position in arrival order
+    size_t sortedCount() const { return m_order ? m_order->size() : 0; }
+    size_t positionAt(size_t row) const { return row < sortedCount() ? (*m_order)[row].position : row; }
+
+    // A sort is running (the view may still change order)
+    bool busy() const { return m_run != nullptr; }
+
+    size_t memoryBytes() const;
+
+private:
+    // What comparisons need, so sorting never touches the ObjectStore (the
+    // name points into its arena, which the run keeps alive)
+    struct Item {
+        int64_t value;  // Size or modification time
+        const char* name;
+        uint16_t nameLength;
+        uint16_t extensionOffset;  // Into name; nameLength if none
+        uint32_t position;
+    };
+    using Order = std::vector<Item>;
+
+    struct Run {
+        ListingSort sort;
+        std::shared_ptr<const void> arena;
+        std::shared_ptr<const Order> base;  // Sorted earlier, merged with items
+        Order items;                        // To sort, in chunks
+        std::vector<size_t> chunkEnds;
+        std::atomic<bool> cancelled{false};
+
+        std::mutex mutex;
+        size_t pendingChunks = 0;
+        std::shared_ptr<const Order> result;  // Set when done
+
+        void sortChunk(size_t chunk);
+        void finish();
+    };
+
+    static bool less(const ListingSort& sort, const Item& a, const Item& b);
+    void cancel();
+
+    ListingSort m_sort;
+    std::shared_ptr<const Order> m_order;
+    std::shared_ptr<Run> m_run;
+    size_t m_submitted = 0;  // Arrival positions handed to runs so far
+};
@@ -0,0 +1,250 @@
+#include "object_store.h"
+#include "aws/s3_backend.h"
+#include <algorithm>
+#include <cstring>
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// Parse `count` digits at text[pos], or -1
+static int parseDigits(std::string_view text, size_t pos, size_t count) {
+    if (pos + count > text.size()) return -1;
+    int value = 0;
+    for (size_t i = pos; i < pos + count; ++i) {
+        if (text[i] < '0' || text[i] > '9') return -1;
+        value = value * 10 + (text[i] - '0');
+    }
+    return value;
+}
+
+int64_t parseS3Timestamp(std::string_view text) {
+    // YYYY-MM-DDTHH:MM:SS, then fractional seconds and a zone we ignore (S3 uses Z)
+    int year = parseDigits(text, 0, 4);
+    int month = parseDigits(text, 5, 2);
+    int day = parseDigits(text, 8, 2);
+    int hour = parseDigits(text, 11, 2);
+    int minute = parseDigits(text, 14, 2);
+    int second = parseDigits(text, 17, 2);
+    if (year < 0 || month < 1 || month > 12 || day < 1 || day > 31 ||
+        hour < 0 || minute < 0 || second < 0) {
+        return 0;
+    }
+
+    // Days since 1970-01-01 in the proleptic Gregorian calendar
+    int64_t y = year - (month <= 2 ? 1 : 0);
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yearOfEra = y - era * 400;
+    int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    int64_t days = era * 146097 + dayOfEra - 719468;
+    return days * 86400 + hour * 3600 + minute * 60 + second;
+}
+
+int ListingStats::sizeBucket(int64_t bytes) {
+    int bucket = 0;
+    for (int64_t limit = 1024; bucket < SIZE_BUCKETS - 1 && bytes >= limit; limit *= 16) {
+        bucket++;
+    }
+    return bucket;
+}
+
+int64_t ListingStats::sizeBucketLimit(int bucket) {
+    if (bucket >= SIZE_BUCKETS - 1) return INT64_MAX;
+    return int64_t(1024) << (4 * bucket);
+}
+
+void ListingStats::add(bool isFolder, int64_t size, int64_t lastModified) {
+    if (isFolder) {
+        folders++;
+        return;
+    }
+    files++;
+    totalBytes += size;
+    largestFile = std::max(largestFile, size);
+    sizeHistogram[sizeBucket(size)]++;
+    if (lastModified != 0) {
+        oldest = (oldest == 0) ? lastModified : std::min(oldest, lastModified);
+        newest = std::max(newest, lastModified);
+    }
+}
+
+std::string ObjectStore::Entry::etag() const {
+    std::string_view bytes = etagBytes();
+    if (!etagPacked()) return std::string(bytes);
+
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(bytes.size() * 2, '0');
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        auto byte = static_cast<unsigned char>(bytes[i]);
+        hex[2 * i] = digits[byte >> 4];
+        hex[2 * i + 1] = digits[byte & 15];
+    }
+    return hex;
+}
+
+ObjectStore::ObjectStore(ObjectStore&& other) noexcept {
+    *this = std::move(other);
+}
+
+ObjectStore& ObjectStore::operator=(ObjectStore&& other) noexcept {
+    if (this != &other) {
+        // Reset other, or its next append would write into the last block
+        // of the arena this store now owns
+        m_entries = std::move(other.m_entries);
+        m_arena = std::move(other.m_arena);
+        m_blockBytes = other.m_blockBytes;
+        m_blockPos = other.m_blockPos;
+        m_blockFree = other.m_blockFree;
+        m_stats = other.m_stats;
+        m_maxKey = other.m_maxKey;
+        other.clear();
+    }
+    return *this;
+}
+
+void ObjectStore::append(const S3Object& obj) {
+    // Plain-upload ETags are the MD5 in hex; pack those
+    char packed[16];
+    bool isMd5 = obj.etag.size() == 32 &&
+                 std::all_of(obj.etag.begin(), obj.etag.end(), [](char c) { return hexValue(c) >= 0; });
+    if (isMd5) {
+        for (size_t i = 0; i < 16; ++i) {
+            packed[i] = static_cast<char>((hexValue(obj.etag[2 * i]) << 4) | hexValue(obj.etag[2 * i + 1]));
+        }
+    }
+    append(obj.key, obj.is_folder, obj.size, parseS3Timestamp(obj.last_modified),
+           isMd5 ? std::string_view(packed, sizeof(packed)) : std::string_view(obj.etag), isMd5);
+}
+
+void ObjectStore::append(std::string_view key, bool isFolder, int64_t size, int64_t lastModified,
+                         std::string_view etag, bool etagPacked) {
+    // S3 keys are at most 1024 bytes and ETags far shorter; anything odder
+    // than that loses its ETag rather than overflowing a length field
+    if (etag.size() > UINT8_MAX) {
+        etag = std::string_view();
+        etagPacked = false;
+    }
+
+    char* text = allocate(key.size() + etag.size());
+    memcpy(text, key.data(), key.size());
+    memcpy(text + key.size(), etag.data(), etag.size());
+
+    // Display name is the last path component, without a folder's trailing '/'
+    std::string_view name = key;
+    if (isFolder && !name.empty() && name.back() == '/') {
+        name.remove_suffix(1);
+    }
+    size_t lastSlash = name.rfind('/');
+    size_t nameOffset = (lastSlash != std::string_view::npos) ? lastSlash + 1 : 0;
+    size_t nameLength = std::min<size_t>(name.size() - nameOffset, UINT16_MAX);
+    nameOffset = std::min<size_t>(nameOffset, UINT16_MAX);
+
+    Entry entry;
+    entry.m_key = text;
+    entry.m_size = size;
+    entry.m_lastModified = lastModified;
+    entry.m_keyLength = static_cast<uint32_t>(key.size());
+    entry.m_nameOffset = static_cast<uint16_t>(nameOffset);
+    entry.m_nameLength = static_cast<uint16_t>(nameLength);
+    entry.m_etagLength = static_cast<uint8_t>(etag.size());
+    entry.m_flags = (isFolder ? Entry::IS_FOLDER : 0) | (etagPacked ? Entry::ETAG_PACKED : 0);
+    m_entries.push_back(entry);
+
+    m_stats.add(isFolder, size, lastModified);
+    if (m_entries.size() == 1 || entry.key() > m_maxKey) {
+        m_maxKey = entry.key();
+    }
+}
+
+size_t ObjectStore::appendPage(const std::vector<S3Object>& page, bool continuation) {
+    // Within a page folders come before files, so the mark is taken before
+    // appending. It stays valid: the arena never moves.
+    std::string_view watermark = m_maxKey;
+    bool checkRepeats = continuation && !empty();
+    size_t skipped = 0;
+    for (const auto& obj : page) {
+        if (checkRepeats && std::string_view(obj.key) <= watermark) {
+            skipped++;
+            continue;
+        }
+        append(obj);
+    }
+    return skipped;
+}
+
+void ObjectStore::assign(const std::vector<std::pair<size_t, const Entry*>>& updates) {
+    for (const auto& [index, from] : updates) {
+        Entry& entry = m_entries[index];
+        std::string_view key = entry.key();
+        std::string_view etag = from->etagBytes();
+
+        // The ETag follows the key in the arena, so both move to new text
+        if (etag != entry.etagBytes()) {
+            char* text = allocate(key.size() + etag.size());
+            memcpy(text, key.data(), key.size());
+            memcpy(text + key.size(), etag.data(), etag.size());
+            entry.m_key = text;
+            entry.m_etagLength = from->m_etagLength;
+        }
+        entry.m_size = from->m_size;
+        entry.m_lastModified = from->m_lastModified;
+        entry.m_flags = from->m_flags;
+    }
+    recount();
+}
+
+void ObjectStore::erase(const std::vector<bool>& remove) {
+    size_t kept = 0;
+    for (size_t i = 0; i < m_entries.size(); ++i) {
+        if (i < remove.size() && remove[i]) continue;
+        m_entries[kept++] = m_entries[i];
+    }
+    m_entries.resize(kept);
+    recount();
+}
+
+void ObjectStore::recount() {
+    // Extremes can't be taken back one entry at a time, so start over
+    m_stats = ListingStats();
+    m_maxKey = std::string_view();
+    for (const Entry& entry : m_entries) {
+        m_stats.add(entry.isFolder(), entry.m_size, entry.m_lastModified);
+        if (entry.key() > m_maxKey) m_maxKey = entry.key();
+    }
+}
+
+void ObjectStore::clear() {
+    m_entries = std::vector<Entry>();
+    m_arena.reset();
+    m_blockBytes = 0;
+    m_blockPos = nullptr;
+    m_blockFree = 0;
+    m_stats = ListingStats();
+    m_maxKey = std::string_view();
+}
+
+size_t ObjectStore::memoryBytes() const {
+    size_t blockList = m_arena ? m_arena->blocks.capacity() * sizeof(m_arena->blocks[0]) : 0;
+    return m_blockBytes + blockList + m_entries.capacity() * sizeof(Entry);
+}
+
+char* ObjectStore::allocate(size_t bytes) {
+    if (bytes > m_blockFree || !m_blockPos) {
+        // Start a new block; the rest of the old one is wasted (at most a key's worth)
+        size_t blockSize = std::max(bytes, BLOCK_SIZE);
+        if (!m_arena) {
+            m_arena = std::make_shared<Arena>();
+        }
+        m_arena->blocks.emplace_back(new char[blockSize]);  // Not zeroed
+        m_blockBytes += blockSize;
+        m_blockPos = m_arena->blocks.back().get();
+        m_blockFree = blockSize;
+    }
+    char* result = m_blockPos;
+    m_blockPos += bytes;
+    m_blockFree -= bytes;
+    return result;
+}
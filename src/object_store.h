@@ -0,0 +1,135 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+struct S3Object;
+
+// Parse an S3 timestamp ("2024-05-01T10:00:00.000Z") to Unix seconds; 0 if malformed
+int64_t parseS3Timestamp(std::string_view text);
+
+// Running totals over a listing, updated as objects are added, so views of a
+// folder's size and age cost nothing per frame however many objects it holds
+struct ListingStats {
+    // Files by size: under 1 KB, 16 KB, 256 KB, ... 16 GB, then the rest
+    static constexpr int SIZE_BUCKETS = 8;
+    static int sizeBucket(int64_t bytes);
+    static int64_t sizeBucketLimit(int bucket);  // Exclusive upper bound; INT64_MAX for the last
+
+    size_t folders = 0;
+    size_t files = 0;
+    int64_t totalBytes = 0;  // Of files
+    int64_t largestFile = 0;
+    int64_t oldest = 0;      // Modification times (Unix seconds) of files; 0 if none known
+    int64_t newest = 0;
+    size_t sizeHistogram[SIZE_BUCKETS] = {};
+
+    void add(bool isFolder, int64_t size, int64_t lastModified);
+};
+
+// A folder's listing, packed for folders of millions of objects. Keys and
+// ETags are copied into a per-store arena of large blocks (no allocation per
+// object); the display name is a range of the key, the modification time an
+// int64 and a hex MD5 ETag 16 raw bytes. Entries are fixed-size and point
+// into the arena, which never moves, so they stay valid until clear().
+// ListingStats are kept as entries are added.
+class ObjectStore {
+public:
+    class Entry {
+    public:
+        std::string_view key() const { return std::string_view(m_key, m_keyLength); }
+        std::string_view displayName() const { return std::string_view(m_key + m_nameOffset, m_nameLength); }
+        int64_t size() const { return m_size; }
+        int64_t lastModified() const { return m_lastModified; }  // Unix seconds, 0 if unknown
+        bool isFolder() const { return m_flags & IS_FOLDER; }
+        std::string etag() const;  // As S3 reports it (quotes stripped)
+
+        // The ETag as stored: 16 bytes if etagPacked(), else the text
+        std::string_view etagBytes() const { return std::string_view(m_key + m_keyLength, m_etagLength); }
+        bool etagPacked() const { return m_flags & ETAG_PACKED; }
+
+    private:
+        friend class ObjectStore;
+        enum : uint8_t { IS_FOLDER = 1, ETAG_PACKED = 2 };
+
+        const char* m_key;  // In the arena, followed by the ETag
+        int64_t m_size;
+        int64_t m_lastModified;
+        uint32_t m_keyLength;
+        uint16_t m_nameOffset;
+        uint16_t m_nameLength;
+        uint8_t m_etagLength;
+        uint8_t m_flags;
+    };
+
+    ObjectStore() = default;
+    // Leaves other empty, as after clear()
+    ObjectStore(ObjectStore&& other) noexcept;
+    ObjectStore& operator=(ObjectStore&& other) noexcept;
+    ObjectStore(const ObjectStore&) = delete;
+    ObjectStore& operator=(const ObjectStore&) = delete;
+
+    void append(const S3Object& obj);
+    // etag is 16 raw bytes if etagPacked, else text
+    void append(std::string_view key, bool isFolder, int64_t size, int64_t lastModified,
+                std::string_view etag, bool etagPacked);
+    // Add a page of a listing. Pages of one listing come in S3's key order,
+    // each after the last, so in a continuation page anything not past the
+    // greatest key already held is a repeat (from several requests in flight
+    // for the same page) and is skipped; returns how many were.
+    size_t appendPage(const std::vector<S3Object>& page, bool continuation);
+    void reserve(size_t count) { m_entries.reserve(count); }
+    // Frees the arena too
+    void clear();
+
+    // Bring entries up to date with a fresher listing of the same folder.
+    // assign gives each (index, entry) pair's entry here the size,
+    // modification time and ETag of the other one, whose key must be the same;
+    // erase drops the entries marked in remove (one flag per entry), moving
+    // later ones down. Both recount stats() once per call.
+    void assign(const std::vector<std::pair<size_t, const Entry*>>& updates);
+    void erase(const std::vector<bool>& remove);
+
+    size_t size() const { return m_entries.size(); }
+    bool empty() const { return m_entries.empty(); }
+    const Entry& operator[](size_t i) const { return m_entries[i]; }
+    std::vector<Entry>::const_iterator begin() const { return m_entries.begin(); }
+    std::vector<Entry>::const_iterator end() const { return m_entries.end(); }
+
+    const ListingStats& stats() const { return m_stats; }
+
+    // Greatest key held. Listing pages come in key order, so a page whose
+    // keys are all greater can't repeat anything already here.
+    std::string_view maxKey() const { return m_maxKey; }
+
+    // Arena blocks plus the entry array
+    size_t memoryBytes() const;
+
+    // Keeps the text behind every entry added so far alive (for work on
+    // other threads), even if the store is cleared or destroyed meanwhile
+    std::shared_ptr<const void> arena() const { return m_arena; }
+
+private:
+    static constexpr size_t BLOCK_SIZE = 256 * 1024;
+
+    char* allocate(size_t bytes);
+    void recount();
+
+    // Only the UI thread adds blocks; holders of arena() just keep them alive
+    struct Arena {
+        std::vector<std::unique_ptr<char[]>> blocks;
+    };
+
+    std::vector<Entry> m_entries;
+    std::shared_ptr<Arena> m_arena;  // Created on first append, dropped by clear()
+    size_t m_blockBytes = 0;         // Total allocated, for memoryBytes()
+    char* m_blockPos = nullptr;      // Free space in the last block
+    size_t m_blockFree = 0;
+    ListingStats m_stats;
+    std::string_view m_maxKey;
+};
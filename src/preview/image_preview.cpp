@@ -2,15 +2,65 @@
 #include "browser_model.h"
 #include "streaming_preview.h"
 #include "imgui/imgui.h"
+#include "image_resize.h"
+#include "thread_pool.h"
 #include "stb/stb_image.h"
 #include "loguru.hpp"
 #include <algorithm>
 #include <cctype>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstring>
 
 // Platform-specific texture creation functions (implemented in image_texture_*.cpp/.mm)
 extern "C" bool CreateGPUTexture(unsigned char* pixels, int width, int height, void** outTexture);
 extern "C" void DestroyGPUTexture(void* texture);
 
+namespace {
+
+// Compressed bytes handed to stb_image as a stream that ends early once the
+// decode is cancelled, so even a multi-second decode stops soon after
+struct CancellableReader {
+    const char* data;
+    size_t size;
+    size_t pos;
+    const std::atomic<bool>* cancelled;
+};
+
+int readBytes(void* user, char* out, int count) {
+    auto* reader = static_cast<CancellableReader*>(user);
+    if (reader->cancelled->load(std::memory_order_relaxed)) return 0;
+    size_t n = std::min(static_cast<size_t>(std::max(count, 0)), reader->size - reader->pos);
+    memcpy(out, reader->data + reader->pos, n);
+    reader->pos += n;
+    return static_cast<int>(n);
+}
+
+void skipBytes(void* user, int count) {
+    auto* reader = static_cast<CancellableReader*>(user);
+    if (count < 0) {
+        reader->pos -= std::min(static_cast<size_t>(-static_cast<int64_t>(count)), reader->pos);
+    } else {
+        reader->pos += std::min(static_cast<size_t>(count), reader->size - reader->pos);
+    }
+}
+
+int atEnd(void* user) {
+    auto* reader = static_cast<CancellableReader*>(user);
+    return reader->pos >= reader->size || reader->cancelled->load(std::memory_order_relaxed);
+}
+
+// Full resolution RGBA (free with stbi_image_free), or null on error or cancel
+unsigned char* loadRGBA(const ContentView& content, const std::atomic<bool>& cancelled,
+                        int& width, int& height, int& channels) {
+    CancellableReader reader{content.data(), content.size(), 0, &cancelled};
+    stbi_io_callbacks callbacks{readBytes, skipBytes, atEnd};
+    return stbi_load_from_callbacks(&callbacks, &reader, &width, &height, &channels, 4);
+}
+
+} // namespace
+
 ImagePreviewRenderer::ImagePreviewRenderer()
     : m_texture(nullptr)
     , m_imageWidth(0)
@@ -19,7 +69,8 @@ ImagePreviewRenderer::ImagePreviewRenderer()
 }
 
 ImagePreviewRenderer::~ImagePreviewRenderer() {
-    destroyTexture();
+    cancelJobs();
+    destroyTextures();
 }
 
 bool ImagePreviewRenderer::isImageExtension(const std::string& ext) {
@@ -64,25 +115,31 @@ void ImagePreviewRenderer::render(const PreviewContext& ctx) {
 
     // Check if we need to load a new image
     std::string fullKey = ctx.bucket + "/" + ctx.key;
-    const std::string& content = ctx.model.previewContent();
-
-    if (content.empty()) {
-        ImGui::TextColored(ImVec4(0.5f, 0.5f, 0.5f, 1.0f), "(empty file)");
-        return;
-    }
 
     // For images, we need the complete file data before we can decode
     // Check if we're still downloading
     int64_t totalSize = ctx.model.selectedFileSize();
     bool downloadComplete = true;
+    size_t contentSize = 0;
+    std::shared_ptr<const ContentView> content;  // Only fetched without a stream, or to decode
 
     if (ctx.streamingPreview) {
         // Streaming is active - check if complete
         downloadComplete = ctx.streamingPreview->isComplete();
-    } else if (totalSize > 0 && static_cast<int64_t>(content.size()) < totalSize) {
-        // No streaming preview yet, but content is smaller than file size
-        // This means we only have the initial 64KB preview
-        downloadComplete = false;
+        contentSize = ctx.streamingPreview->bytesWritten();
+    } else {
+        content = ctx.model.previewContent();
+        contentSize = content->size();
+        if (totalSize > 0 && static_cast<int64_t>(contentSize) < totalSize) {
+            // No streaming preview yet, but content is smaller than file size
+            // This means we only have the initial 64KB preview
+            downloadComplete = false;
+        }
+    }
+
+    if (contentSize == 0 && downloadComplete) {
+        ImGui::TextColored(ImVec4(0.5f, 0.5f, 0.5f, 1.0f), "(empty file)");
+        return;
     }
 
     if (!downloadComplete) {
@@ -92,7 +149,7 @@ void ImagePreviewRenderer::render(const PreviewContext& ctx) {
             progress = static_cast<float>(ctx.streamingPreview->bytesDownloaded()) /
                        static_cast<float>(ctx.streamingPreview->totalSourceBytes());
         } else if (totalSize > 0) {
-            progress = static_cast<float>(content.size()) / static_cast<float>(totalSize);
+            progress = static_cast<float>(contentSize) / static_cast<float>(totalSize);
         }
 
         ImGui::TextColored(ImVec4(0.5f, 0.5f, 1.0f, 1.0f),
@@ -103,16 +160,37 @@ void ImagePreviewRenderer::render(const PreviewContext& ctx) {
         return;
     }
 
-    // Load image if key changed or not loaded yet
-    if (m_currentKey != fullKey || m_texture == nullptr) {
+    // Decode when the key or the content changes; a failed decode isn't
+    // retried until then
+    const StreamingFilePreview* source = ctx.streamingPreview.get();
+    uint64_t generation = source ? source->generation() : 0;
+    if (m_currentKey != fullKey || m_loadedSource != source || m_loadedGeneration != generation) {
         m_currentKey = fullKey;
+        m_loadedSource = source;
+        m_loadedGeneration = generation;
+        cancelJobs();
+        destroyTextures();
+        m_tileSource.reset();
         m_errorMessage.clear();
-
-        if (!loadImage(reinterpret_cast<const unsigned char*>(content.data()), content.size())) {
-            LOG_F(WARNING, "Failed to load image: %s", m_errorMessage.c_str());
-        }
+        m_zoom = 1.0f;
+
+        // Shrink to about the preview's size on screen
+        if (!content) content = ctx.model.previewContent();
+        ImVec2 availSize = ImGui::GetContentRegionAvail();
+        ImVec2 fbScale = ImGui::GetIO().DisplayFramebufferScale;
+        int side = static_cast<int>(std::max(availSize.x * fbScale.x, availSize.y * fbScale.y));
+        side = std::clamp(side, 1024, MAX_OVERVIEW_SIZE);
+
+        auto cancelled = std::make_shared<std::atomic<bool>>(false);
+        m_decodeCancelled = cancelled;
+        m_decode = ThreadPool::shared().submit([content, side, cancelled] {
+            return decodeImage(content, side, side, cancelled);
+        });
+        m_tileSource = content;
     }
 
+    collectJobs();
+
     // Show error if loading failed
     if (!m_errorMessage.empty()) {
         ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "Error: %s", m_errorMessage.c_str());
@@ -120,98 +198,312 @@ void ImagePreviewRenderer::render(const PreviewContext& ctx) {
     }
 
     if (m_texture == nullptr) {
-        ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "Loading image...");
+        ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "Decoding image...");
         return;
     }
 
-    // Calculate display size maintaining aspect ratio
     ImVec2 availSize = ImGui::GetContentRegionAvail();
-    float imageAspect = static_cast<float>(m_imageWidth) / static_cast<float>(m_imageHeight);
-    float availAspect = availSize.x / availSize.y;
-
-    ImVec2 displaySize;
-    if (imageAspect > availAspect) {
-        // Image is wider than available space - fit to width
-        displaySize.x = availSize.x;
-        displaySize.y = availSize.x / imageAspect;
-    } else {
-        // Image is taller than available space - fit to height
-        displaySize.y = availSize.y;
-        displaySize.x = availSize.y * imageAspect;
+    renderImage(availSize.x, availSize.y);
+}
+
+void ImagePreviewRenderer::renderImage(float width, float height) {
+    // Leave a line for the image info below
+    float areaHeight = height - ImGui::GetTextLineHeightWithSpacing() - ImGui::GetStyle().ItemSpacing.y;
+    if (width <= 0.0f || areaHeight <= 0.0f) {
+        return;
     }
 
-    // Don't scale up small images beyond their native size
-    if (displaySize.x > m_imageWidth) {
-        displaySize.x = static_cast<float>(m_imageWidth);
-        displaySize.y = static_cast<float>(m_imageHeight);
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    ImGui::InvisibleButton("##image", ImVec2(width, areaHeight));
+    bool hovered = ImGui::IsItemHovered();
+    bool active = ImGui::IsItemActive();
+    ImGuiIO& io = ImGui::GetIO();
+
+    // Zoom 1 fits the image, without scaling small images up
+    float imageWidth = static_cast<float>(m_imageWidth);
+    float imageHeight = static_cast<float>(m_imageHeight);
+    float fit = std::min({width / imageWidth, areaHeight / imageHeight, 1.0f});
+    float maxZoom = std::max(1.0f, MAX_MAGNIFICATION / fit);
+    float scale = fit * m_zoom;  // Screen pixels per image pixel
+    ImVec2 areaCenter(origin.x + width * 0.5f, origin.y + areaHeight * 0.5f);
+
+    m_viewChanged = false;
+    if (hovered && io.MouseWheel != 0.0f) {
+        // Keep the image point under the mouse where it is
+        float mouseX = m_centerX + (io.MousePos.x - areaCenter.x) / scale;
+        float mouseY = m_centerY + (io.MousePos.y - areaCenter.y) / scale;
+        m_zoom = std::clamp(m_zoom * std::pow(1.25f, io.MouseWheel), 1.0f, maxZoom);
+        scale = fit * m_zoom;
+        m_centerX = mouseX - (io.MousePos.x - areaCenter.x) / scale;
+        m_centerY = mouseY - (io.MousePos.y - areaCenter.y) / scale;
+        m_viewChanged = true;
+    }
+    if (active && (io.MouseDelta.x != 0.0f || io.MouseDelta.y != 0.0f)) {
+        m_centerX -= io.MouseDelta.x / scale;
+        m_centerY -= io.MouseDelta.y / scale;
+        m_viewChanged = true;
+    }
+    if (hovered && ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) {
+        m_zoom = 1.0f;
+        scale = fit;
+        m_viewChanged = true;
     }
 
-    // Center the image horizontally
-    float offsetX = (availSize.x - displaySize.x) * 0.5f;
-    if (offsetX > 0) {
-        ImGui::SetCursorPosX(ImGui::GetCursorPosX() + offsetX);
+    // Centered along a side that fits, otherwise kept covering the area
+    float halfWidth = width * 0.5f / scale;
+    float halfHeight = areaHeight * 0.5f / scale;
+    m_centerX = halfWidth * 2.0f >= imageWidth ? imageWidth * 0.5f
+                                               : std::clamp(m_centerX, halfWidth, imageWidth - halfWidth);
+    m_centerY = halfHeight * 2.0f >= imageHeight ? imageHeight * 0.5f
+                                                 : std::clamp(m_centerY, halfHeight, imageHeight - halfHeight);
+
+    // Visible part of the image, in image pixels
+    float x0 = std::max(0.0f, m_centerX - halfWidth);
+    float y0 = std::max(0.0f, m_centerY - halfHeight);
+    float x1 = std::min(imageWidth, m_centerX + halfWidth);
+    float y1 = std::min(imageHeight, m_centerY + halfHeight);
+    auto toScreen = [&](float x, float y) {
+        return ImVec2(areaCenter.x + (x - m_centerX) * scale, areaCenter.y + (y - m_centerY) * scale);
+    };
+
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    drawList->PushClipRect(origin, ImVec2(origin.x + width, origin.y + areaHeight), true);
+    drawList->AddImage(reinterpret_cast<ImTextureID>(m_texture), toScreen(x0, y0), toScreen(x1, y1),
+                       ImVec2(x0 / imageWidth, y0 / imageHeight), ImVec2(x1 / imageWidth, y1 / imageHeight));
+    if (m_tileTexture != nullptr) {
+        // Sharper pixels over part of the overview
+        float tx = static_cast<float>(m_tile.x);
+        float ty = static_cast<float>(m_tile.y);
+        drawList->AddImage(reinterpret_cast<ImTextureID>(m_tileTexture), toScreen(tx, ty),
+                           toScreen(tx + static_cast<float>(m_tile.width), ty + static_cast<float>(m_tile.height)));
     }
+    drawList->PopClipRect();
 
-    // Display the image
-    ImGui::Image(reinterpret_cast<ImTextureID>(m_texture), displaySize);
+    if (!m_viewChanged && !active) {
+        requestTile(x0, y0, x1 - x0, y1 - y0, scale * io.DisplayFramebufferScale.x);
+    }
 
     // Show image info below
     ImGui::Spacing();
-    ImGui::TextColored(ImVec4(0.5f, 0.5f, 0.5f, 1.0f),
-        "%dx%d pixels", m_imageWidth, m_imageHeight);
+    ImGui::TextColored(ImVec4(0.5f, 0.5f, 0.5f, 1.0f), "%dx%d pixels, %.0f%%%s", m_imageWidth, m_imageHeight,
+                       scale * 100.0f, m_tileJob.valid() ? " (loading detail...)" : "");
+    ImGui::SameLine();
+    ImGui::TextDisabled("Scroll to zoom, drag to pan, double-click to fit");
 }
 
-void ImagePreviewRenderer::reset() {
-    destroyTexture();
-    m_currentKey.clear();
-    m_errorMessage.clear();
-    m_imageWidth = 0;
-    m_imageHeight = 0;
-}
+void ImagePreviewRenderer::requestTile(float viewX, float viewY, float viewWidth, float viewHeight,
+                                       float pixelScale) {
+    if (!m_tileSource || m_tileJob.valid()) {
+        return;
+    }
+
+    // Only needed where the overview is magnified on screen
+    float overviewScale = static_cast<float>(m_textureWidth) / static_cast<float>(m_imageWidth);
+    if (pixelScale <= overviewScale * 1.05f) {
+        if (m_tileTexture != nullptr) {
+            DestroyGPUTexture(m_tileTexture);
+            m_tileTexture = nullptr;
+        }
+        return;
+    }
 
-bool ImagePreviewRenderer::loadImage(const unsigned char* data, size_t dataSize) {
-    // First destroy any existing texture
-    destroyTexture();
+    // Keep a tile that covers the view in about the right detail
+    float needed = std::min(pixelScale, 1.0f);  // Tile pixels per image pixel
+    if (m_tileTexture != nullptr) {
+        float tileScale = static_cast<float>(m_tile.pixels.width) / static_cast<float>(m_tile.width);
+        bool covers = viewX >= m_tile.x && viewY >= m_tile.y &&
+                      viewX + viewWidth <= m_tile.x + m_tile.width &&
+                      viewY + viewHeight <= m_tile.y + m_tile.height;
+        if (covers && tileScale >= needed * 0.95f && tileScale <= needed * 2.0f) {
+            return;
+        }
+    }
 
-    // Decode image using stb_image
-    int width, height, channels;
-    unsigned char* pixels = stbi_load_from_memory(
-        data,
-        static_cast<int>(dataSize),
-        &width,
-        &height,
-        &channels,
-        4  // Force RGBA
-    );
+    // The visible area plus a margin, so small pans stay covered
+    float marginX = viewWidth * 0.25f;
+    float marginY = viewHeight * 0.25f;
+    int x = std::max(0, static_cast<int>(std::floor(viewX - marginX)));
+    int y = std::max(0, static_cast<int>(std::floor(viewY - marginY)));
+    int width = std::min(m_imageWidth, static_cast<int>(std::ceil(viewX + viewWidth + marginX))) - x;
+    int height = std::min(m_imageHeight, static_cast<int>(std::ceil(viewY + viewHeight + marginY))) - y;
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+    int outWidth = std::clamp(static_cast<int>(std::lround(width * needed)), 1, width);
+    int outHeight = std::clamp(static_cast<int>(std::lround(height * needed)), 1, height);
+
+    std::shared_ptr<const ContentView> content = m_tileSource;
+    int imageWidth = m_imageWidth;
+    int imageHeight = m_imageHeight;
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    m_tileCancelled = cancelled;
+    m_tileJob = ThreadPool::shared().submit([=] {
+        return makeTile(content, imageWidth, imageHeight, x, y, width, height, outWidth, outHeight, cancelled);
+    });
+}
 
-    if (pixels == nullptr) {
-        m_errorMessage = stbi_failure_reason() ? stbi_failure_reason() : "Unknown error decoding image";
-        return false;
+void ImagePreviewRenderer::collectJobs() {
+    if (m_decode.valid() && m_decode.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        std::shared_ptr<Decoded> decoded = m_decode.get();
+        if (decoded && !decoded->error.empty()) {
+            m_errorMessage = decoded->error;
+            LOG_F(WARNING, "Failed to load image: %s", m_errorMessage.c_str());
+        } else if (decoded) {
+            m_texture = createTexture(decoded->overview);
+            if (m_texture == nullptr) {
+                m_errorMessage = "Failed to create texture";
+            } else {
+                m_imageWidth = decoded->imageWidth;
+                m_imageHeight = decoded->imageHeight;
+                m_textureWidth = decoded->overview.width;
+                m_textureHeight = decoded->overview.height;
+                if (m_textureWidth == m_imageWidth && m_textureHeight == m_imageHeight) {
+                    m_tileSource.reset();  // Nothing more to show
+                }
+                m_centerX = static_cast<float>(m_imageWidth) * 0.5f;
+                m_centerY = static_cast<float>(m_imageHeight) * 0.5f;
+            }
+        }
     }
 
-    LOG_F(INFO, "Decoded image: %dx%d, %d channels", width, height, channels);
+    if (m_tileJob.valid() && m_tileJob.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        std::shared_ptr<Tile> tile = m_tileJob.get();
+        m_tileCancelled.reset();
+        if (!tile) {
+            LOG_F(WARNING, "Failed to decode image detail; showing the overview only");
+            m_tileSource.reset();
+            return;
+        }
+        if (m_tileTexture != nullptr) {
+            DestroyGPUTexture(m_tileTexture);
+        }
+        m_tileTexture = createTexture(tile->pixels);
+        m_tile = std::move(*tile);
+        m_tile.pixels.rgba = std::vector<uint8_t>();  // Only its size is kept
+    }
+}
 
-    // Create GPU texture
-    bool success = createTexture(pixels, width, height);
+std::shared_ptr<ImagePreviewRenderer::Decoded> ImagePreviewRenderer::decodeImage(
+        std::shared_ptr<const ContentView> content, int maxWidth, int maxHeight,
+        std::shared_ptr<std::atomic<bool>> cancelled) {
+    // Skipped if another image was picked while this one waited
+    if (cancelled->load()) {
+        return nullptr;
+    }
 
-    // Free the CPU pixel data
-    stbi_image_free(pixels);
+    auto decoded = std::make_shared<Decoded>();
+    if (content->size() > static_cast<size_t>(INT_MAX)) {
+        decoded->error = "Image file too large";
+        return decoded;
+    }
 
-    if (success) {
-        m_imageWidth = width;
-        m_imageHeight = height;
+    // Decode image using stb_image
+    int width, height, channels;
+    unsigned char* pixels = loadRGBA(*content, *cancelled, width, height, channels);
+    if (cancelled->load()) {
+        stbi_image_free(pixels);
+        return nullptr;
     }
+    if (pixels == nullptr) {
+        decoded->error = stbi_failure_reason() ? stbi_failure_reason() : "Unknown error decoding image";
+        return decoded;
+    }
+    std::unique_ptr<unsigned char, void (*)(void*)> full(pixels, stbi_image_free);
+
+    int outWidth, outHeight;
+    fitWithin(width, height, maxWidth, maxHeight, outWidth, outHeight);
+    LOG_F(INFO, "Decoded image: %dx%d, %d channels, showing %dx%d", width, height, channels, outWidth, outHeight);
+
+    decoded->imageWidth = width;
+    decoded->imageHeight = height;
+    Pixels& overview = decoded->overview;
+    overview.width = outWidth;
+    overview.height = outHeight;
+    if (outWidth == width && outHeight == height) {
+        overview.rgba.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+    } else {
+        overview.rgba.resize(static_cast<size_t>(outWidth) * outHeight * 4);
+        if (!resizeAreaRGBA(pixels, width, height, static_cast<size_t>(width) * 4,
+                            overview.rgba.data(), outWidth, outHeight, cancelled.get())) {
+            return nullptr;
+        }
+    }
+    return decoded;
+}
 
-    return success;
+std::shared_ptr<ImagePreviewRenderer::Tile> ImagePreviewRenderer::makeTile(
+        std::shared_ptr<const ContentView> content, int imageWidth, int imageHeight, int x, int y,
+        int width, int height, int outWidth, int outHeight, std::shared_ptr<std::atomic<bool>> cancelled) {
+    int decodedWidth, decodedHeight, channels;
+    unsigned char* pixels = loadRGBA(*content, *cancelled, decodedWidth, decodedHeight, channels);
+    if (pixels == nullptr || cancelled->load() || decodedWidth != imageWidth || decodedHeight != imageHeight) {
+        stbi_image_free(pixels);
+        return nullptr;
+    }
+    std::unique_ptr<unsigned char, void (*)(void*)> full(pixels, stbi_image_free);
+
+    auto tile = std::make_shared<Tile>();
+    tile->x = x;
+    tile->y = y;
+    tile->width = width;
+    tile->height = height;
+    tile->pixels.width = outWidth;
+    tile->pixels.height = outHeight;
+    tile->pixels.rgba.resize(static_cast<size_t>(outWidth) * outHeight * 4);
+
+    size_t stride = static_cast<size_t>(imageWidth) * 4;
+    const uint8_t* corner = pixels + static_cast<size_t>(y) * stride + static_cast<size_t>(x) * 4;
+    if (!resizeAreaRGBA(corner, width, height, stride, tile->pixels.rgba.data(), outWidth, outHeight,
+                        cancelled.get())) {
+        return nullptr;
+    }
+    return tile;
 }
 
-bool ImagePreviewRenderer::createTexture(unsigned char* pixels, int width, int height) {
-    return CreateGPUTexture(pixels, width, height, &m_texture);
+void ImagePreviewRenderer::reset() {
+    cancelJobs();
+    destroyTextures();
+    m_tileSource.reset();
+    m_currentKey.clear();
+    m_loadedSource = nullptr;
+    m_loadedGeneration = 0;
+    m_errorMessage.clear();
+    m_imageWidth = 0;
+    m_imageHeight = 0;
+    m_zoom = 1.0f;
+}
+
+TextureHandle ImagePreviewRenderer::createTexture(Pixels& pixels) {
+    TextureHandle texture = nullptr;
+    if (!CreateGPUTexture(pixels.rgba.data(), pixels.width, pixels.height, &texture)) {
+        return nullptr;
+    }
+    return texture;
 }
 
-void ImagePreviewRenderer::destroyTexture() {
+void ImagePreviewRenderer::destroyTextures() {
     if (m_texture != nullptr) {
         DestroyGPUTexture(m_texture);
         m_texture = nullptr;
     }
+    if (m_tileTexture != nullptr) {
+        DestroyGPUTexture(m_tileTexture);
+        m_tileTexture = nullptr;
+    }
+    m_textureWidth = 0;
+    m_textureHeight = 0;
+}
+
+void ImagePreviewRenderer::cancelJobs() {
+    // Jobs already running finish on their own; their results are dropped
+    if (m_decodeCancelled) {
+        *m_decodeCancelled = true;
+        m_decodeCancelled.reset();
+    }
+    if (m_tileCancelled) {
+        *m_tileCancelled = true;
+        m_tileCancelled.reset();
+    }
+    m_decode = {};
+    m_tileJob = {};
 }
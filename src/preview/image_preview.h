@@ -1,7 +1,11 @@
 #pragma once
 
 #include "preview_renderer.h"
+#include <atomic>
+#include <future>
+#include <memory>
 #include <string>
+#include <vector>
 #include <cstdint>
 
 // Forward declaration for platform-specific texture handle
@@ -9,6 +13,15 @@
 // On OpenGL: this is GLuint cast to void* via uintptr_t
 using TextureHandle = void*;
 
+class StreamingFilePreview;
+class ContentView;
+
+// Images are decoded on the shared thread pool and shrunk to about the
+// size of the preview before upload, so large images neither stall the UI
+// nor fill VRAM. Only the overview's pixels are kept: zooming in past its
+// detail decodes the image again from the compressed bytes and loads a tile
+// of the visible area at full resolution. Decodes give up soon after the
+// preview moves on.
 class ImagePreviewRenderer : public IPreviewRenderer {
 public:
     ImagePreviewRenderer();
@@ -22,20 +35,79 @@ public:
     void render(const PreviewContext& ctx) override;
     void reset() override;
 
+    // Check if file extension (with the dot) is a supported image format
+    static bool isImageExtension(const std::string& ext);
+
+    // Overview textures are at most this many pixels on a side
+    static constexpr int MAX_OVERVIEW_SIZE = 4096;
+    // Zoom limit, in screen pixels per image pixel
+    static constexpr float MAX_MAGNIFICATION = 8.0f;
+
 private:
-    // Load image from raw bytes and create GPU texture
-    bool loadImage(const unsigned char* data, size_t dataSize);
+    // Pixels ready for upload, made on the pool
+    struct Pixels {
+        std::vector<uint8_t> rgba;
+        int width = 0;
+        int height = 0;
+    };
 
-    // Platform-specific texture creation/destruction
-    bool createTexture(unsigned char* pixels, int width, int height);
-    void destroyTexture();
+    struct Decoded {
+        Pixels overview;
+        int imageWidth = 0;
+        int imageHeight = 0;
+        std::string error;
+    };
 
-    // Check if file extension is a supported image format
-    static bool isImageExtension(const std::string& ext);
+    // Part of the image at a resolution fit for the current zoom
+    struct Tile {
+        Pixels pixels;
+        int x = 0, y = 0, width = 0, height = 0;  // Covered area in image pixels
+    };
+
+    static std::shared_ptr<Decoded> decodeImage(std::shared_ptr<const ContentView> content, int maxWidth,
+                                                int maxHeight, std::shared_ptr<std::atomic<bool>> cancelled);
+    // Null if cancelled or the image no longer decodes as before
+    static std::shared_ptr<Tile> makeTile(std::shared_ptr<const ContentView> content, int imageWidth,
+                                          int imageHeight, int x, int y, int width, int height,
+                                          int outWidth, int outHeight, std::shared_ptr<std::atomic<bool>> cancelled);
+
+    // Take finished decode and tile jobs, uploading their pixels
+    void collectJobs();
+    // Zoomable view of the image in the given area
+    void renderImage(float width, float height);
+    // Ask for a full-resolution tile if the overview is magnified
+    void requestTile(float viewX, float viewY, float viewWidth, float viewHeight, float pixelScale);
+
+    // Platform-specific texture creation/destruction
+    static TextureHandle createTexture(Pixels& pixels);
+    void destroyTextures();
+    void cancelJobs();
 
     std::string m_currentKey;   // bucket/key of loaded image
-    TextureHandle m_texture;    // Platform-specific texture handle
+    const StreamingFilePreview* m_loadedSource = nullptr;  // Stream and generation the image was
+    uint64_t m_loadedGeneration = 0;                        // decoded from (see render)
+
+    std::future<std::shared_ptr<Decoded>> m_decode;
+    std::shared_ptr<std::atomic<bool>> m_decodeCancelled;
+    // Compressed image to decode tiles from; only while the overview is smaller
+    std::shared_ptr<const ContentView> m_tileSource;
+
+    TextureHandle m_texture;    // Overview, covering the whole image
     int m_imageWidth;
     int m_imageHeight;
+    int m_textureWidth = 0;
+    int m_textureHeight = 0;
+
+    std::future<std::shared_ptr<Tile>> m_tileJob;
+    std::shared_ptr<std::atomic<bool>> m_tileCancelled;
+    TextureHandle m_tileTexture = nullptr;
+    Tile m_tile;                // Area and size of m_tileTexture (pixels released)
+
+    // View: 1 fits the image in the area; center is in image pixels
+    float m_zoom = 1.0f;
+    float m_centerX = 0.0f;
+    float m_centerY = 0.0f;
+    bool m_viewChanged = false;  // Zoomed or panned this frame
+
     std::string m_errorMessage; // Error message if loading failed
 };
@@ -0,0 +1,151 @@
+#include "image_resize.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// Which source pixels (or rows) each output pixel covers, and how much
+struct Spans {
+    std::vector<int> first;      // First source index per output index
+    std::vector<int> count;      // Source indices covered
+    std::vector<size_t> offset;  // Into weights
+    std::vector<float> weights;  // Coverage / scale, summing to 1 per output
+};
+
+Spans makeSpans(int srcSize, int dstSize) {
+    Spans spans;
+    double scale = static_cast<double>(srcSize) / dstSize;
+    for (int o = 0; o < dstSize; ++o) {
+        double a = o * scale;
+        double b = std::min((o + 1) * scale, static_cast<double>(srcSize));
+        int first = static_cast<int>(a);
+        int last = std::min(static_cast<int>(std::ceil(b)), srcSize);
+        spans.first.push_back(first);
+        spans.count.push_back(last - first);
+        spans.offset.push_back(spans.weights.size());
+        for (int i = first; i < last; ++i) {
+            double covered = std::min<double>(i + 1, b) - std::max<double>(i, a);
+            spans.weights.push_back(static_cast<float>(covered / scale));
+        }
+    }
+    return spans;
+}
+
+// out[x] = sum of src pixels weighted by the column spans, as 4 floats per
+// pixel, with color premultiplied by alpha (in 0..1)
+void resizeRow(const uint8_t* src, const Spans& columns, int dstWidth, float* out) {
+    constexpr float ALPHA_SCALE = 1.0f / 255.0f;
+    for (int x = 0; x < dstWidth; ++x) {
+        const uint8_t* p = src + static_cast<size_t>(columns.first[x]) * 4;
+        const float* w = columns.weights.data() + columns.offset[x];
+        int n = columns.count[x];
+#if defined(__x86_64__)
+        const __m128i zero = _mm_setzero_si128();
+        __m128 sum = _mm_setzero_ps();
+        for (int i = 0; i < n; ++i) {
+            int32_t pixel;
+            memcpy(&pixel, p + i * 4, 4);
+            __m128i bytes = _mm_cvtsi32_si128(pixel);
+            __m128i words = _mm_unpacklo_epi8(bytes, zero);
+            __m128 values = _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero));
+            float colorWeight = w[i] * static_cast<float>(p[i * 4 + 3]) * ALPHA_SCALE;
+            __m128 weights = _mm_set_ps(w[i], colorWeight, colorWeight, colorWeight);
+            sum = _mm_add_ps(sum, _mm_mul_ps(values, weights));
+        }
+        _mm_storeu_ps(out + x * 4, sum);
+#elif defined(__aarch64__)
+        float32x4_t sum = vdupq_n_f32(0.0f);
+        for (int i = 0; i < n; ++i) {
+            uint32_t pixel;
+            memcpy(&pixel, p + i * 4, 4);
+            uint16x8_t words = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(pixel)));
+            float32x4_t values = vcvtq_f32_u32(vmovl_u16(vget_low_u16(words)));
+            float colorWeight = w[i] * static_cast<float>(p[i * 4 + 3]) * ALPHA_SCALE;
+            float32x4_t weights = vsetq_lane_f32(w[i], vdupq_n_f32(colorWeight), 3);
+            sum = vmlaq_f32(sum, values, weights);
+        }
+        vst1q_f32(out + x * 4, sum);
+#else
+        float sum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        for (int i = 0; i < n; ++i) {
+            float colorWeight = w[i] * static_cast<float>(p[i * 4 + 3]) * ALPHA_SCALE;
+            for (int c = 0; c < 3; ++c) sum[c] += p[i * 4 + c] * colorWeight;
+            sum[3] += p[i * 4 + 3] * w[i];
+        }
+        memcpy(out + x * 4, sum, sizeof(sum));
+#endif
+    }
+}
+
+// acc += row * weight, over n floats (a multiple of 4)
+void accumulate(float* acc, const float* row, float weight, size_t n) {
+#if defined(__x86_64__)
+    const __m128 w = _mm_set1_ps(weight);
+    for (size_t i = 0; i < n; i += 4) {
+        _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_mul_ps(_mm_loadu_ps(row + i), w)));
+    }
+#elif defined(__aarch64__)
+    for (size_t i = 0; i < n; i += 4) {
+        vst1q_f32(acc + i, vmlaq_n_f32(vld1q_f32(acc + i), vld1q_f32(row + i), weight));
+    }
+#else
+    for (size_t i = 0; i < n; ++i) acc[i] += row[i] * weight;
+#endif
+}
+
+} // namespace
+
+bool resizeAreaRGBA(const uint8_t* src, int srcWidth, int srcHeight, size_t srcStride,
+                    uint8_t* dst, int dstWidth, int dstHeight, const std::atomic<bool>* cancelled) {
+    if (dstWidth <= 0 || dstHeight <= 0)
+        return true;
+    Spans columns = makeSpans(srcWidth, dstWidth);
+    Spans rows = makeSpans(srcHeight, dstHeight);
+
+    // A source row on a boundary feeds two output rows; keep the last one
+    size_t n = static_cast<size_t>(dstWidth) * 4;
+    std::vector<float> row(n);
+    std::vector<float> acc(n);
+    int rowSource = -1;
+    for (int y = 0; y < dstHeight; ++y) {
+        if (cancelled && cancelled->load(std::memory_order_relaxed))
+            return false;
+        std::fill(acc.begin(), acc.end(), 0.0f);
+        const float* w = rows.weights.data() + rows.offset[y];
+        for (int i = 0; i < rows.count[y]; ++i) {
+            int sy = rows.first[y] + i;
+            if (sy != rowSource) {
+                resizeRow(src + static_cast<size_t>(sy) * srcStride, columns, dstWidth, row.data());
+                rowSource = sy;
+            }
+            accumulate(acc.data(), row.data(), w[i], n);
+        }
+
+        // Back from premultiplied color
+        uint8_t* out = dst + static_cast<size_t>(y) * n;
+        for (size_t i = 0; i < n; i += 4) {
+            float alpha = acc[i + 3];
+            float unpremultiply = alpha > 0.0f ? 255.0f / alpha : 0.0f;
+            for (size_t c = 0; c < 4; ++c) {
+                float v = (c == 3 ? alpha : acc[i + c] * unpremultiply) + 0.5f;
+                out[i + c] = static_cast<uint8_t>(v <= 0.0f ? 0 : v >= 255.0f ? 255 : static_cast<int>(v));
+            }
+        }
+    }
+    return true;
+}
+
+void fitWithin(int width, int height, int maxWidth, int maxHeight, int& outWidth, int& outHeight) {
+    double scale = std::min({1.0, static_cast<double>(maxWidth) / std::max(width, 1),
+                             static_cast<double>(maxHeight) / std::max(height, 1)});
+    outWidth = std::max(1, static_cast<int>(std::lround(width * scale)));
+    outHeight = std::max(1, static_cast<int>(std::lround(height * scale)));
+}
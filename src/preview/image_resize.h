@@ -0,0 +1,22 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Shrink an RGBA8 image by area averaging: each output pixel is the mean of
+// the source pixels it covers, with partly covered ones weighted by
+// coverage. Colors are averaged premultiplied by alpha, so transparent
+// pixels don't darken the edges of opaque ones. Reads srcWidth x srcHeight
+// pixels starting at src, whose rows are srcStride bytes apart (so a crop
+// can be passed as a pointer into a larger image), and writes
+// dstWidth x dstHeight tightly packed pixels. The output must not be larger
+// than the source in either direction. Gives up between output rows, and
+// returns false, once *cancelled is set.
+bool resizeAreaRGBA(const uint8_t* src, int srcWidth, int srcHeight, size_t srcStride,
+                    uint8_t* dst, int dstWidth, int dstHeight,
+                    const std::atomic<bool>* cancelled = nullptr);
+
+// Largest size that fits in maxWidth x maxHeight with the image's aspect
+// ratio, never larger than the image itself (and at least 1x1)
+void fitWithin(int width, int height, int maxWidth, int maxHeight, int& outWidth, int& outHeight);
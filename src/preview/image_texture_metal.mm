@@ -64,3 +64,16 @@ extern "C" void DestroyGPUTexture(void* texture) {
         (void)mtlTexture; // Silence unused variable warning
     }
 }
+
+extern "C" bool UpdateGPUTextureRegion(void* texture, int x, int y, int width, int height, unsigned char* pixels) {
+    if (texture == nullptr) {
+        return false;
+    }
+    id<MTLTexture> mtlTexture = (__bridge id<MTLTexture>)texture;
+    MTLRegion region = MTLRegionMake2D(x, y, width, height);
+    [mtlTexture replaceRegion:region
+                  mipmapLevel:0
+                    withBytes:pixels
+                  bytesPerRow:4 * width];
+    return true;
+}
@@ -34,3 +34,15 @@ extern "C" void DestroyGPUTexture(void* texture) {
         LOG_F(INFO, "Destroyed OpenGL texture: id=%u", textureId);
     }
 }
+
+extern "C" bool UpdateGPUTextureRegion(void* texture, int x, int y, int width, int height, unsigned char* pixels) {
+    if (texture == nullptr) {
+        return false;
+    }
+    GLuint textureId = static_cast<GLuint>(reinterpret_cast<uintptr_t>(texture));
+    glBindTexture(GL_TEXTURE_2D, textureId);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return true;
+}
@@ -0,0 +1,501 @@
+#include "json_format.h"
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// First '"', '\\' or control character in [p, end), or end. String contents
+// are most of a typical record, so they're skipped 16 bytes at a time.
+const char* findStringSpecial(const char* p, const char* end) {
+#if defined(__x86_64__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    for (; p + 16 <= end; p += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+                                   _mm_cmpeq_epi8(_mm_min_epu8(v, control), v));
+        int mask = _mm_movemask_epi8(hit);
+        if (mask) return p + __builtin_ctz(static_cast<unsigned>(mask));
+    }
+#elif defined(__aarch64__)
+    // One nibble per byte, as in findNewlines
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t space = vdupq_n_u8(0x20);
+    for (; p + 16 <= end; p += 16) {
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+        uint8x16_t hit = vorrq_u8(vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, backslash)), vcltq_u8(v, space));
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(
+            vshrn_n_u16(vreinterpretq_u16_u8(hit), 4)), 0);
+        if (mask) return p + (__builtin_ctzll(mask) >> 2);
+    }
+#endif
+    for (; p < end; ++p) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (c == '"' || c == '\\' || c < 0x20) return p;
+    }
+    return end;
+}
+
+void appendUtf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+// Write a decoded character back into a JSON string the way
+// nlohmann::json::dump does: short escapes, \u00XX for other control
+// characters, everything else as UTF-8
+void appendEscaped(std::string& out, uint32_t cp) {
+    switch (cp) {
+        case '"':  out += "\\\""; return;
+        case '\\': out += "\\\\"; return;
+        case '\b': out += "\\b"; return;
+        case '\f': out += "\\f"; return;
+        case '\n': out += "\\n"; return;
+        case '\r': out += "\\r"; return;
+        case '\t': out += "\\t"; return;
+        default: break;
+    }
+    if (cp < 0x20) {
+        char buf[8];
+        snprintf(buf, sizeof(buf), "\\u%04x", cp);
+        out += buf;
+        return;
+    }
+    appendUtf8(out, cp);
+}
+
+class JsonScanner {
+public:
+    // out and result may be null (validation only)
+    JsonScanner(std::string_view json, std::string* out, const char* fieldName, JsonFormatResult* result)
+        : m_begin(json.data()), m_p(json.data()), m_end(json.data() + json.size()),
+          m_out(out), m_fieldName(fieldName), m_result(result) {}
+
+    // Projecting instead of formatting
+    JsonScanner(std::string_view json, const JsonProjection* projection, std::vector<JsonProjection::Value>* values)
+        : m_begin(json.data()), m_p(json.data()), m_end(json.data() + json.size()),
+          m_out(nullptr), m_fieldName(nullptr), m_result(nullptr),
+          m_projection(projection), m_values(values) {}
+
+    bool run();
+    const std::string& error() const { return m_error; }
+
+private:
+    bool parseKey();
+    bool parseString(std::string* decoded);
+    bool parseEscape(uint32_t& cp);
+    bool parseHex4(uint32_t& value);
+    bool parseNumber();
+    bool parseLiteral(const char* word, size_t len);
+
+    void skipSpace() {
+        while (m_p < m_end && (*m_p == ' ' || *m_p == '\n' || *m_p == '\r' || *m_p == '\t')) ++m_p;
+    }
+    void emit(char c) { if (m_out) *m_out += c; }
+    void emit(const char* s, size_t n) { if (m_out) m_out->append(s, n); }
+    void newline() {
+        if (!m_out) return;
+        *m_out += '\n';
+        m_out->append(2 * m_stack.size(), ' ');
+    }
+    bool projected() const {
+        return m_projection && !m_stack.empty() && m_arrayDepth == 0 && m_projection->wants(m_path);
+    }
+    bool fail(const char* what) {
+        m_error = std::string(what) + " at byte " + std::to_string(m_p - m_begin);
+        return false;
+    }
+
+    const char* m_begin;
+    const char* m_p;
+    const char* m_end;
+    std::string* m_out;
+    const char* m_fieldName;
+    JsonFormatResult* m_result;
+    const JsonProjection* m_projection = nullptr;
+    std::vector<JsonProjection::Value>* m_values = nullptr;
+
+    struct Level {
+        char type;           // '{' or '['
+        bool projected;      // Report the whole container when it closes
+        size_t pathLength;   // m_path of the container itself
+        const char* start;
+    };
+    std::vector<Level> m_stack; // Open containers
+    std::string m_key;          // Current key, when it's needed
+    bool m_fieldNext = false;   // The next value is the requested field's
+    std::string m_path;         // Key path of the current value (projecting)
+    size_t m_arrayDepth = 0;    // Open arrays; nothing inside them is projected
+    std::string m_decoded;      // A projected string value
+    std::string m_error;
+};
+
+bool JsonScanner::run() {
+    skipSpace();
+    for (;;) {
+        if (m_p == m_end)
+            return fail("unexpected end of input");
+
+        bool isField = m_fieldNext;
+        m_fieldNext = false;
+        char c = *m_p;
+        if (isField && c != '"')
+            m_result->hasField = false;
+
+        bool project = projected();
+        const char* start = m_p;
+        if (c == '{' || c == '[') {
+            char close = c == '{' ? '}' : ']';
+            ++m_p;
+            skipSpace();
+            if (m_p < m_end && *m_p == close) {
+                ++m_p;
+                emit(c);
+                emit(close);
+                if (project) m_projection->collect(m_path, std::string_view(start, m_p - start), false, *m_values);
+            } else {
+                // Descend; the first element is parsed by the next iteration
+                m_stack.push_back({c, project, m_path.size(), start});
+                if (c == '[') m_arrayDepth++;
+                emit(c);
+                newline();
+                if (c == '{' && !parseKey()) return false;
+                continue;
+            }
+        } else if (c == '"') {
+            std::string* decoded = isField ? &m_result->fieldValue : project ? &m_decoded : nullptr;
+            if (decoded) decoded->clear();
+            if (!parseString(decoded)) return false;
+            if (isField) m_result->hasField = true;
+            if (project) m_projection->collect(m_path, m_decoded, true, *m_values);
+        } else {
+            if (c == 't') {
+                if (!parseLiteral("true", 4)) return false;
+            } else if (c == 'f') {
+                if (!parseLiteral("false", 5)) return false;
+            } else if (c == 'n') {
+                if (!parseLiteral("null", 4)) return false;
+            } else if (c == '-' || (c >= '0' && c <= '9')) {
+                if (!parseNumber()) return false;
+            } else {
+                return fail("unexpected character");
+            }
+            if (project) m_projection->collect(m_path, std::string_view(start, m_p - start), false, *m_values);
+        }
+
+        // A value is done: close finished containers, then move on to the
+        // next element
+        for (;;) {
+            skipSpace();
+            if (m_stack.empty())
+                return m_p == m_end || fail("unexpected characters after the document");
+            if (m_p == m_end)
+                return fail("unexpected end of input");
+
+            char top = m_stack.back().type;
+            char close = top == '{' ? '}' : ']';
+            if (*m_p == ',') {
+                ++m_p;
+                emit(',');
+                newline();
+                skipSpace();
+                if (top == '{' && !parseKey()) return false;
+                break;
+            }
+            if (*m_p == close) {
+                ++m_p;
+                Level level = m_stack.back();
+                m_stack.pop_back();
+                newline();
+                emit(close);
+                if (level.type == '[') m_arrayDepth--;
+                if (m_projection) {
+                    m_path.resize(level.pathLength);
+                    if (level.projected) {
+                        m_projection->collect(m_path, std::string_view(level.start, m_p - level.start),
+                                              false, *m_values);
+                    }
+                }
+                continue;
+            }
+            return fail(top == '{' ? "expected ',' or '}'" : "expected ',' or ']'");
+        }
+    }
+}
+
+bool JsonScanner::parseKey() {
+    skipSpace();
+    if (m_p == m_end || *m_p != '"')
+        return fail("expected a string key");
+
+    bool topLevel = m_fieldName && m_stack.size() == 1;
+    bool project = m_projection && m_arrayDepth == 0;
+    m_key.clear();
+    if (!parseString(topLevel || project ? &m_key : nullptr))
+        return false;
+
+    if (project) {
+        // This object's path plus the key
+        m_path.resize(m_stack.back().pathLength);
+        if (!m_path.empty()) m_path += '.';
+        m_path += m_key;
+    }
+
+    skipSpace();
+    if (m_p == m_end || *m_p != ':')
+        return fail("expected ':'");
+    ++m_p;
+    emit(": ", 2);
+    skipSpace();
+
+    m_fieldNext = topLevel && m_key == m_fieldName;
+    return true;
+}
+
+bool JsonScanner::parseString(std::string* decoded) {
+    // At the opening quote
+    ++m_p;
+    emit('"');
+    for (;;) {
+        const char* special = findStringSpecial(m_p, m_end);
+        if (special > m_p) {
+            emit(m_p, static_cast<size_t>(special - m_p));
+            if (decoded) decoded->append(m_p, static_cast<size_t>(special - m_p));
+            m_p = special;
+        }
+        if (m_p == m_end)
+            return fail("unterminated string");
+
+        if (*m_p == '"') {
+            ++m_p;
+            emit('"');
+            return true;
+        }
+        if (*m_p != '\\')
+            return fail("control character in string");
+
+        // Short escapes are written back unchanged
+        const char* escape = m_p;
+        uint32_t cp;
+        if (!parseEscape(cp))
+            return false;
+        if (escape[1] != 'u' && escape[1] != '/')
+            emit(escape, 2);
+        else if (m_out)
+            appendEscaped(*m_out, cp);
+        if (decoded) appendUtf8(*decoded, cp);
+    }
+}
+
+bool JsonScanner::parseEscape(uint32_t& cp) {
+    // At the backslash
+    if (m_end - m_p < 2)
+        return fail("unterminated string");
+    char e = m_p[1];
+    m_p += 2;
+    switch (e) {
+        case '"':  cp = '"'; return true;
+        case '\\': cp = '\\'; return true;
+        case '/':  cp = '/'; return true;
+        case 'b':  cp = '\b'; return true;
+        case 'f':  cp = '\f'; return true;
+        case 'n':  cp = '\n'; return true;
+        case 'r':  cp = '\r'; return true;
+        case 't':  cp = '\t'; return true;
+        case 'u':  break;
+        default:   return fail("invalid escape");
+    }
+
+    if (!parseHex4(cp))
+        return false;
+    if (cp >= 0xDC00 && cp <= 0xDFFF)
+        return fail("unpaired surrogate");
+    if (cp >= 0xD800 && cp <= 0xDBFF) {
+        uint32_t low;
+        if (m_end - m_p < 2 || m_p[0] != '\\' || m_p[1] != 'u')
+            return fail("unpaired surrogate");
+        m_p += 2;
+        if (!parseHex4(low))
+            return false;
+        if (low < 0xDC00 || low > 0xDFFF)
+            return fail("unpaired surrogate");
+        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+    }
+    return true;
+}
+
+bool JsonScanner::parseHex4(uint32_t& value) {
+    if (m_end - m_p < 4)
+        return fail("invalid \\u escape");
+    value = 0;
+    for (int i = 0; i < 4; ++i) {
+        char c = m_p[i];
+        uint32_t digit;
+        if (c >= '0' && c <= '9') digit = static_cast<uint32_t>(c - '0');
+        else if (c >= 'a' && c <= 'f') digit = static_cast<uint32_t>(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') digit = static_cast<uint32_t>(c - 'A' + 10);
+        else return fail("invalid \\u escape");
+        value = (value << 4) | digit;
+    }
+    m_p += 4;
+    return true;
+}
+
+bool JsonScanner::parseNumber() {
+    // Validated against the JSON grammar and copied as written
+    auto isDigit = [this] { return m_p < m_end && *m_p >= '0' && *m_p <= '9'; };
+    const char* start = m_p;
+
+    if (*m_p == '-') ++m_p;
+    if (m_p < m_end && *m_p == '0') {
+        ++m_p;
+    } else if (isDigit()) {
+        while (isDigit()) ++m_p;
+    } else {
+        return fail("invalid number");
+    }
+
+    if (m_p < m_end && *m_p == '.') {
+        ++m_p;
+        if (!isDigit()) return fail("invalid number");
+        while (isDigit()) ++m_p;
+    }
+
+    if (m_p < m_end && (*m_p == 'e' || *m_p == 'E')) {
+        ++m_p;
+        if (m_p < m_end && (*m_p == '+' || *m_p == '-')) ++m_p;
+        if (!isDigit()) return fail("invalid number");
+        while (isDigit()) ++m_p;
+    }
+
+    emit(start, static_cast<size_t>(m_p - start));
+    return true;
+}
+
+bool JsonScanner::parseLiteral(const char* word, size_t len) {
+    if (static_cast<size_t>(m_end - m_p) < len || std::string_view(m_p, len) != std::string_view(word, len))
+        return fail("invalid literal");
+    emit(word, len);
+    m_p += len;
+    return true;
+}
+
+} // namespace
+
+bool formatJson(std::string_view json, const char* fieldName, JsonFormatResult& out) {
+    out.formatted.clear();
+    out.formatted.reserve(json.size() + json.size() / 4);
+    out.hasField = false;
+    out.fieldValue.clear();
+    out.error.clear();
+
+    JsonScanner scanner(json, &out.formatted, fieldName, &out);
+    if (scanner.run())
+        return true;
+    out.error = scanner.error();
+    return false;
+}
+
+bool validateJson(std::string_view json, std::string* error) {
+    JsonScanner scanner(json, nullptr, nullptr, nullptr);
+    if (scanner.run())
+        return true;
+    if (error) *error = scanner.error();
+    return false;
+}
+
+// ============================================================================
+// JsonProjection
+// ============================================================================
+
+JsonProjection::JsonProjection(const std::vector<std::string>& specs) {
+    for (const std::string& spec : specs) {
+        if (spec.size() > 5 && spec.compare(0, 4, "len(") == 0 && spec.back() == ')') {
+            m_exact.push_back({spec.substr(4, spec.size() - 5), spec, true});
+        } else if (spec == "**") {
+            m_allPaths = true;
+        } else if (spec == "*") {
+            m_wildcards.emplace_back();
+        } else if (spec.size() > 2 && spec.compare(spec.size() - 2, 2, ".*") == 0) {
+            m_wildcards.push_back(spec.substr(0, spec.size() - 2));
+        } else if (!spec.empty()) {
+            m_exact.push_back({spec, spec, false});
+        }
+    }
+}
+
+namespace {
+
+// A key directly inside the object at parent ("" being the document)
+bool isChildPath(std::string_view path, const std::string& parent) {
+    if (parent.empty())
+        return path.find('.') == std::string_view::npos;
+    return path.size() > parent.size() + 1 && path.compare(0, parent.size(), parent) == 0 &&
+           path[parent.size()] == '.' && path.find('.', parent.size() + 1) == std::string_view::npos;
+}
+
+} // namespace
+
+bool JsonProjection::wants(std::string_view path) const {
+    if (m_allPaths) return true;
+    for (const Exact& e : m_exact) {
+        if (e.path == path) return true;
+    }
+    for (const std::string& parent : m_wildcards) {
+        if (isChildPath(path, parent)) return true;
+    }
+    return false;
+}
+
+void JsonProjection::collect(std::string_view path, std::string_view value, bool isString,
+                             std::vector<Value>& out) const {
+    for (const Exact& e : m_exact) {
+        if (e.path != path) continue;
+        if (!e.length) {
+            out.push_back({e.column, std::string(value), isString});
+        } else if (isString) {
+            // Characters, i.e. bytes that don't continue a UTF-8 sequence
+            size_t chars = 0;
+            for (char c : value) {
+                if ((static_cast<unsigned char>(c) & 0xC0) != 0x80) ++chars;
+            }
+            out.push_back({e.column, std::to_string(chars), false});
+        }
+    }
+    for (const std::string& parent : m_wildcards) {
+        if (isChildPath(path, parent)) {
+            out.push_back({std::string(path), std::string(value), isString});
+            return;
+        }
+    }
+    if (m_allPaths) {
+        out.push_back({std::string(path), std::string(value), isString});
+    }
+}
+
+bool JsonProjection::extract(std::string_view json, std::vector<Value>& out) const {
+    JsonScanner scanner(json, this, &out);
+    return scanner.run();
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct JsonFormatResult {
+    std::string formatted;   // Pretty-printed document
+    bool hasField = false;   // The requested top-level field holds a string
+    std::string fieldValue;  // Its decoded value
+    std::string error;       // Why the document isn't valid JSON
+};
+
+// Pretty-print one JSON document in a single pass, without building a DOM.
+// Indents by 2 like nlohmann::json::dump(2) and escapes strings the same
+// way (\uXXXX escapes come out as UTF-8), but keeps keys in document order
+// and numbers as written. If fieldName is given, the string value of that
+// top-level key is decoded during the same pass.
+// Returns false (with out.error set) if the document isn't valid JSON.
+bool formatJson(std::string_view json, const char* fieldName, JsonFormatResult& out);
+
+// Syntax check only; no output is built
+bool validateJson(std::string_view json, std::string* error = nullptr);
+
+// Picks values out of JSON documents by key path, e.g. "id" or
+// "metadata.url". "metadata.*" picks every key of that object ("*" every
+// top-level key, "**" every key at any depth) and "len(text)" gives the
+// length of a string in characters. Paths don't descend into arrays.
+class JsonProjection {
+public:
+    explicit JsonProjection(const std::vector<std::string>& specs);
+
+    struct Value {
+        std::string column;  // The spec, or the key path a wildcard matched
+        std::string text;    // Strings decoded, anything else as written
+        bool isString = false;
+    };
+
+    // Values found in one document, in document order (same single pass as
+    // formatJson); false if it isn't valid JSON
+    bool extract(std::string_view json, std::vector<Value>& out) const;
+
+    // For the scanner: whether a value's path is projected, and recording it
+    bool wants(std::string_view path) const;
+    void collect(std::string_view path, std::string_view value, bool isString,
+                 std::vector<Value>& out) const;
+
+private:
+    struct Exact {
+        std::string path;
+        std::string column;
+        bool length;
+    };
+    std::vector<Exact> m_exact;
+    std::vector<std::string> m_wildcards;  // Objects whose keys are all picked
+    bool m_allPaths = false;               // "**"
+};
@@ -0,0 +1,551 @@
+#include "jsonl_filter.h"
+#include "text_buffer.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+// Conditions the program can hold at once (one bit each)
+constexpr size_t MAX_STACK_DEPTH = 64;
+
+// Text that can only appear in a record spelled exactly as written: no
+// characters JSON may escape, and nothing outside printable ASCII
+bool isPlainText(const std::string& text) {
+    if (text.empty()) return false;
+    for (char c : text) {
+        if (c < 0x20 || c > 0x7E || c == '"' || c == '\\' || c == '/') return false;
+    }
+    return true;
+}
+
+// Whether a record spells any printable ASCII character as a \u escape,
+// which would hide plain text from a byte search
+bool hasAsciiEscape(std::string_view record) {
+    size_t pos = 0;
+    while ((pos = record.find("\\u00", pos)) != std::string_view::npos) {
+        pos += 4;
+        if (pos < record.size() && record[pos] >= '2' && record[pos] <= '7') return true;
+    }
+    return false;
+}
+
+// Length of the JSON number at p (RFC 8259: no leading '+' or zeros, no
+// bare '.', no inf, nan or hex), or 0 if there isn't one
+size_t jsonNumberLength(const char* p) {
+    const char* start = p;
+    if (*p == '-') ++p;
+    if (*p == '0') {
+        ++p;
+    } else if (*p >= '1' && *p <= '9') {
+        while (*p >= '0' && *p <= '9') ++p;
+    } else {
+        return 0;
+    }
+    if (*p == '.') {
+        if (p[1] < '0' || p[1] > '9') return 0;
+        p += 2;
+        while (*p >= '0' && *p <= '9') ++p;
+    }
+    if (*p == 'e' || *p == 'E') {
+        const char* exponent = p + 1;
+        if (*exponent == '+' || *exponent == '-') ++exponent;
+        if (*exponent < '0' || *exponent > '9') return 0;
+        p = exponent;
+        while (*p >= '0' && *p <= '9') ++p;
+    }
+    return static_cast<size_t>(p - start);
+}
+
+} // namespace
+
+// ============================================================================
+// Parser
+// ============================================================================
+
+// Recursive descent straight to postfix. Each parse function also returns
+// text any record passing that subexpression must contain.
+class JsonFilter::Parser {
+public:
+    Parser(JsonFilter& filter, const std::string& expression)
+        : m_filter(filter), m_p(expression.c_str()), m_begin(expression.c_str()) {}
+
+    bool run() {
+        std::vector<std::string> required;
+        if (!parseOr(required)) return false;
+        skipSpace();
+        if (*m_p != '\0') return fail("unexpected text");
+        m_filter.m_required = std::move(required);
+        return true;
+    }
+
+private:
+    bool parseOr(std::vector<std::string>& required) {
+        if (!parseAnd(required)) return false;
+        while (acceptWord("or") || accept("||")) {
+            std::vector<std::string> other;
+            if (!parseAnd(other)) return false;
+            required.clear();  // Either side may pass
+            emit(Op::Or);
+        }
+        return true;
+    }
+
+    bool parseAnd(std::vector<std::string>& required) {
+        if (!parseUnary(required)) return false;
+        while (acceptWord("and") || accept("&&")) {
+            if (!parseUnary(required)) return false;
+            emit(Op::And);
+        }
+        return true;
+    }
+
+    bool parseUnary(std::vector<std::string>& required) {
+        if (acceptWord("not") || accept("!")) {
+            std::vector<std::string> ignored;
+            if (!parseUnary(ignored)) return false;
+            emit(Op::Not);
+            return true;
+        }
+        return parsePrimary(required);
+    }
+
+    bool parsePrimary(std::vector<std::string>& required) {
+        if (accept("(")) {
+            std::vector<std::string> inner;
+            if (!parseOr(inner)) return false;
+            if (!accept(")")) return fail("expected ')'");
+            required.insert(required.end(), inner.begin(), inner.end());
+            return true;
+        }
+
+        Instruction instruction;
+        if (!parseOperand(instruction.path)) return false;
+
+        struct { const char* token; Op op; } comparisons[] = {
+            {"==", Op::Equal}, {"!=", Op::NotEqual}, {"<=", Op::LessEqual}, {">=", Op::GreaterEqual},
+            {"<", Op::Less}, {">", Op::Greater},
+        };
+        instruction.op = Op::Truthy;
+        for (const auto& c : comparisons) {
+            if (accept(c.token)) {
+                instruction.op = c.op;
+                break;
+            }
+        }
+        if (instruction.op == Op::Truthy && acceptWord("contains")) {
+            instruction.op = Op::Contains;
+        }
+        if (instruction.op != Op::Truthy) {
+            if (!parseLiteral(instruction.literal)) return false;
+            if (instruction.op == Op::Contains && instruction.literal.type != Literal::String)
+                return fail("contains needs a string");
+
+            const std::string& text = instruction.literal.text;
+            if (instruction.literal.type == Literal::String && isPlainText(text)) {
+                if (instruction.op == Op::Equal) required.push_back("\"" + text + "\"");
+                if (instruction.op == Op::Contains) required.push_back(text);
+            }
+        }
+        m_filter.m_program.push_back(std::move(instruction));
+        return push();
+    }
+
+    // A path, or len(path); becomes a projection spec
+    bool parseOperand(size_t& path) {
+        std::string spec;
+        if (acceptWord("len")) {
+            if (!accept("(")) return fail("expected '('");
+            std::string inner;
+            if (!parsePath(inner)) return false;
+            if (!accept(")")) return fail("expected ')'");
+            spec = "len(" + inner + ")";
+        } else if (!parsePath(spec)) {
+            return false;
+        }
+
+        auto it = std::find(m_filter.m_paths.begin(), m_filter.m_paths.end(), spec);
+        path = static_cast<size_t>(it - m_filter.m_paths.begin());
+        if (it == m_filter.m_paths.end()) m_filter.m_paths.push_back(spec);
+        return true;
+    }
+
+    // .a.b or a.b (a leading dot also allows keys named like keywords)
+    bool parsePath(std::string& path) {
+        skipSpace();
+        bool dotted = *m_p == '.';
+        if (dotted) ++m_p;
+        const char* start = m_p;
+        while (isKeyChar(*m_p) || (*m_p == '.' && m_p > start && isKeyChar(m_p[1]))) ++m_p;
+        if (m_p == start) return fail("expected a field path");
+        path.assign(start, static_cast<size_t>(m_p - start));
+        if (!dotted && isKeyword(path)) {
+            m_p = start;
+            return fail("expected a field path");
+        }
+        return true;
+    }
+
+    bool parseLiteral(Literal& literal) {
+        skipSpace();
+        char quote = *m_p;
+        if (quote == '"' || quote == '\'') {
+            ++m_p;
+            literal.type = Literal::String;
+            while (*m_p != quote) {
+                if (*m_p == '\0') return fail("unterminated string");
+                char c = *m_p++;
+                if (c == '\\') {
+                    switch (*m_p++) {
+                        case 'n': c = '\n'; break;
+                        case 't': c = '\t'; break;
+                        case 'r': c = '\r'; break;
+                        case '\\': c = '\\'; break;
+                        case '"': c = '"'; break;
+                        case '\'': c = '\''; break;
+                        default: --m_p; return fail("unknown escape");
+                    }
+                }
+                literal.text += c;
+            }
+            ++m_p;
+            return true;
+        }
+        if (acceptWord("true")) {
+            literal.type = Literal::Bool;
+            literal.boolean = true;
+            return true;
+        }
+        if (acceptWord("false")) {
+            literal.type = Literal::Bool;
+            return true;
+        }
+        if (acceptWord("null")) {
+            literal.type = Literal::Null;
+            return true;
+        }
+        size_t length = jsonNumberLength(m_p);
+        if (length == 0 || isKeyChar(m_p[length]) || m_p[length] == '.') {
+            return fail("expected a string, number, true, false or null");
+        }
+        literal.type = Literal::Number;
+        literal.text.assign(m_p, length);
+        literal.number = std::strtod(literal.text.c_str(), nullptr);
+        m_p += length;
+        return true;
+    }
+
+    void emit(Op op) {
+        Instruction instruction;
+        instruction.op = op;
+        m_filter.m_program.push_back(std::move(instruction));
+        m_depth -= op == Op::Not ? 0 : 1;
+    }
+
+    bool push() {
+        if (++m_depth > m_maxDepth) m_maxDepth = m_depth;
+        return m_maxDepth <= MAX_STACK_DEPTH || fail("expression too deep");
+    }
+
+    static bool isKeyChar(char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '-' || c == '$' ||
+               (static_cast<unsigned char>(c) & 0x80);
+    }
+    static bool isKeyword(const std::string& word) {
+        return word == "and" || word == "or" || word == "not" || word == "contains" || word == "len" ||
+               word == "true" || word == "false" || word == "null";
+    }
+
+    void skipSpace() {
+        while (*m_p == ' ' || *m_p == '\t' || *m_p == '\n' || *m_p == '\r') ++m_p;
+    }
+    bool accept(const char* token) {
+        skipSpace();
+        size_t len = strlen(token);
+        if (strncmp(m_p, token, len) != 0) return false;
+        m_p += len;
+        return true;
+    }
+    // A keyword, not the start of a longer name
+    bool acceptWord(const char* word) {
+        skipSpace();
+        size_t len = strlen(word);
+        if (strncmp(m_p, word, len) != 0 || isKeyChar(m_p[len]) || m_p[len] == '.') return false;
+        m_p += len;
+        return true;
+    }
+    bool fail(const char* what) {
+        m_filter.m_error = std::string(what) + " at column " + std::to_string(m_p - m_begin + 1);
+        return false;
+    }
+
+    JsonFilter& m_filter;
+    const char* m_p;
+    const char* m_begin;
+    size_t m_depth = 0;
+    size_t m_maxDepth = 0;
+};
+
+// ============================================================================
+// JsonFilter
+// ============================================================================
+
+JsonFilter::JsonFilter(const std::string& expression) {
+    Parser parser(*this, expression);
+    if (!parser.run()) {
+        m_program.clear();
+        return;
+    }
+    m_projection = std::make_unique<JsonProjection>(m_paths);
+}
+
+bool JsonFilter::matches(std::string_view record, std::vector<JsonProjection::Value>& scratch) const {
+    if (!m_projection)
+        return false;
+
+    // Most records fail on a byte search without being parsed
+    for (const std::string& text : m_required) {
+        if (record.find(text) == std::string_view::npos && !hasAsciiEscape(record))
+            return false;
+    }
+
+    scratch.clear();
+    if (!m_projection->extract(record, scratch))
+        return false;
+
+    uint64_t stack = 0;  // Bit 0 is the top
+    for (const Instruction& instruction : m_program) {
+        bool result = false;
+        switch (instruction.op) {
+            case Op::And:
+                result = (stack & 1) && (stack & 2);
+                stack >>= 2;
+                break;
+            case Op::Or:
+                result = (stack & 1) || (stack & 2);
+                stack >>= 2;
+                break;
+            case Op::Not:
+                result = !(stack & 1);
+                stack >>= 1;
+                break;
+            default: {
+                const JsonProjection::Value* value = nullptr;
+                for (const JsonProjection::Value& v : scratch) {
+                    if (v.column == m_paths[instruction.path]) {
+                        value = &v;
+                        break;
+                    }
+                }
+
+                // Classify the value like a literal; containers match nothing
+                const Literal& literal = instruction.literal;
+                Literal::Type type = Literal::Null;
+                bool container = false;
+                if (value) {
+                    const std::string& text = value->text;
+                    if (value->isString) type = Literal::String;
+                    else if (text == "true" || text == "false") type = Literal::Bool;
+                    else if (text == "null") type = Literal::Null;
+                    else if (text[0] == '{' || text[0] == '[') container = true;
+                    else type = Literal::Number;
+                }
+
+                bool equal = false;
+                int order = 0;  // Valid when ordered
+                bool ordered = false;
+                if (!container && type == literal.type) {
+                    switch (type) {
+                        case Literal::String:
+                            order = value->text.compare(literal.text);
+                            equal = order == 0;
+                            ordered = true;
+                            break;
+                        case Literal::Number: {
+                            double number = std::strtod(value->text.c_str(), nullptr);
+                            order = number < literal.number ? -1 : number > literal.number ? 1 : 0;
+                            equal = order == 0;
+                            ordered = true;
+                            break;
+                        }
+                        case Literal::Bool:
+                            equal = (value->text == "true") == literal.boolean;
+                            break;
+                        case Literal::Null:
+                            equal = true;
+                            break;
+                    }
+                }
+
+                switch (instruction.op) {
+                    case Op::Truthy:
+                        result = value && (container || (type != Literal::Null &&
+                                                          !(type == Literal::Bool && value->text == "false")));
+                        break;
+                    case Op::Equal: result = equal; break;
+                    case Op::NotEqual: result = !equal; break;
+                    case Op::Less: result = ordered && order < 0; break;
+                    case Op::LessEqual: result = ordered && order <= 0; break;
+                    case Op::Greater: result = ordered && order > 0; break;
+                    case Op::GreaterEqual: result = ordered && order >= 0; break;
+                    case Op::Contains:
+                        result = value && type == Literal::String &&
+                                 value->text.find(literal.text) != std::string::npos;
+                        break;
+                    default: break;
+                }
+                break;
+            }
+        }
+        stack = (stack << 1) | (result ? 1 : 0);
+    }
+    return stack & 1;
+}
+
+// ============================================================================
+// JsonlMatchIndex
+// ============================================================================
+
+std::shared_ptr<JsonlMatchIndex::Block> JsonlMatchIndex::Run::scanBlock(const JsonlBlockScanner::Lines& lines) const {
+    auto block = std::make_shared<Block>();
+    block->rows = lines.rows();
+    std::vector<JsonProjection::Value> scratch;
+    lines.forEach([&](uint64_t row, std::string_view line) {
+        if (!line.empty() && filter->matches(line, scratch)) {
+            block->matches.push_back(lines.firstLine() + row);
+            block->text.append(line.data(), line.size());
+            block->text += '\n';
+        }
+    });
+    return block;
+}
+
+void JsonlMatchIndex::Run::publish(Block&& block) {
+    std::lock_guard<std::mutex> lock(mutex);
+    matches.insert(matches.end(), block.matches.begin(), block.matches.end());
+    if (!textTruncated && textBytes + block.text.size() <= MAX_TEXT_BYTES) {
+        if (!block.text.empty()) {
+            textBytes += block.text.size();
+            textChunks.push_back(std::make_shared<const std::string>(std::move(block.text)));
+        }
+    } else {
+        textTruncated = true;
+    }
+    scannedLines += block.rows;
+    generation++;
+}
+
+JsonlMatchIndex::~JsonlMatchIndex() {
+    reset();
+}
+
+void JsonlMatchIndex::start(std::shared_ptr<StreamingFilePreview> source, std::shared_ptr<const JsonFilter> filter) {
+    reset();
+    if (!source || !filter || !filter->isValid())
+        return;
+    m_source = source;
+
+    auto run = std::make_shared<Run>();
+    run->filter = std::move(filter);
+    bool started = m_scanner.start(source, "JsonlMatchIndex", [run](const JsonlBlockScanner::Lines& lines) {
+        std::shared_ptr<Block> block = run->scanBlock(lines);
+        return JsonlBlockScanner::Publish([run, block] { run->publish(std::move(*block)); });
+    });
+    if (started)
+        m_run = std::move(run);
+}
+
+void JsonlMatchIndex::reset() {
+    // Jobs still running finish on their own and drop their blocks
+    m_scanner.reset();
+    m_run.reset();
+    m_source.reset();
+}
+
+void JsonlMatchIndex::update() {
+    m_scanner.update();
+}
+
+bool JsonlMatchIndex::isBusy() const {
+    return m_run && m_scanner.isBusy();
+}
+
+uint64_t JsonlMatchIndex::scannedLines() const {
+    if (!m_run) return 0;
+    std::lock_guard<std::mutex> lock(m_run->mutex);
+    return m_run->scannedLines;
+}
+
+size_t JsonlMatchIndex::matchCount() const {
+    if (!m_run) return 0;
+    std::lock_guard<std::mutex> lock(m_run->mutex);
+    return m_run->matches.size();
+}
+
+bool JsonlMatchIndex::nextMatch(uint64_t line, uint64_t& out) const {
+    if (!m_run) return false;
+    std::lock_guard<std::mutex> lock(m_run->mutex);
+    auto it = std::upper_bound(m_run->matches.begin(), m_run->matches.end(), line);
+    if (it == m_run->matches.end()) return false;
+    out = *it;
+    return true;
+}
+
+bool JsonlMatchIndex::prevMatch(uint64_t line, uint64_t& out) const {
+    if (!m_run) return false;
+    std::lock_guard<std::mutex> lock(m_run->mutex);
+    auto it = std::lower_bound(m_run->matches.begin(), m_run->matches.end(), line);
+    if (it == m_run->matches.begin()) return false;
+    out = *std::prev(it);
+    return true;
+}
+
+bool JsonlMatchIndex::nearestMatch(uint64_t line, uint64_t& out) const {
+    if (!m_run) return false;
+    std::lock_guard<std::mutex> lock(m_run->mutex);
+    const std::vector<uint64_t>& matches = m_run->matches;
+    if (matches.empty()) return false;
+    auto it = std::lower_bound(matches.begin(), matches.end(), line);
+    out = it != matches.end() ? *it : matches.back();
+    return true;
+}
+
+size_t JsonlMatchIndex::matchesBefore(uint64_t line) const {
+    if (!m_run) return 0;
+    std::lock_guard<std::mutex> lock(m_run->mutex);
+    return static_cast<size_t>(std::lower_bound(m_run->matches.begin(), m_run->matches.end(), line) -
+                               m_run->matches.begin());
+}
+
+uint64_t JsonlMatchIndex::generation() const {
+    if (!m_run) return 0;
+    std::lock_guard<std::mutex> lock(m_run->mutex);
+    return m_run->generation;
+}
+
+std::future<std::shared_ptr<const TextBuffer>> JsonlMatchIndex::buildMatchedText() const {
+    std::shared_ptr<Run> run = m_run;
+    return ThreadPool::shared().submit([run]() -> std::shared_ptr<const TextBuffer> {
+        std::vector<std::shared_ptr<const std::string>> chunks;
+        size_t bytes = 0;
+        if (run) {
+            std::lock_guard<std::mutex> lock(run->mutex);
+            chunks = run->textChunks;
+            bytes = run->textBytes;
+        }
+        std::string text;
+        text.reserve(bytes);
+        for (const auto& chunk : chunks) {
+            text += *chunk;
+        }
+        return std::make_shared<TextBuffer>(std::move(text));
+    });
+}
+
+bool JsonlMatchIndex::isTextTruncated() const {
+    if (!m_run) return false;
+    std::lock_guard<std::mutex> lock(m_run->mutex);
+    return m_run->textTruncated;
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "json_format.h"
+#include "jsonl_scanner.h"
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+class StreamingFilePreview;
+class TextBuffer;
+
+// A record filter in a small jq-like language, compiled once into a postfix
+// program:
+//   .metadata.lang == "de" and len(.text) > 100
+//   .score >= 0.5 or not .flagged
+//   .url contains "wiki"
+// Comparisons are ==, !=, <, <=, >, >= and contains; a bare path is true
+// unless missing, null or false; missing values compare equal to null.
+// Combined with and/or/not (or &&, ||, !) and parentheses. Paths follow
+// JsonProjection (dotted keys, not into arrays).
+class JsonFilter {
+public:
+    explicit JsonFilter(const std::string& expression);
+
+    // False (with error() saying why) if the expression didn't compile
+    bool isValid() const { return m_error.empty(); }
+    const std::string& error() const { return m_error; }
+
+    // Whether one JSONL record passes; invalid JSON never does.
+    // Thread-safe: each caller passes its own scratch vector.
+    bool matches(std::string_view record, std::vector<JsonProjection::Value>& scratch) const;
+
+private:
+    struct Literal {
+        enum Type { String, Number, Bool, Null } type = Null;
+        std::string text;
+        double number = 0.0;
+        bool boolean = false;
+    };
+
+    enum class Op : uint8_t { Truthy, Equal, NotEqual, Less, LessEqual, Greater, GreaterEqual, Contains, And, Or, Not };
+    struct Instruction {
+        Op op;
+        size_t path = 0;     // Into m_paths, for comparisons
+        Literal literal;
+    };
+
+    class Parser;
+
+    std::vector<Instruction> m_program;  // Postfix
+    std::vector<std::string> m_paths;    // Projection specs the program reads
+    std::unique_ptr<JsonProjection> m_projection;
+    // Text every passing record contains as written, checked before parsing
+    std::vector<std::string> m_required;
+    std::string m_error;
+};
+
+// Line numbers of the records of a JSONL stream that pass a filter, found on
+// the shared thread pool in blocks as the stream arrives (see
+// JsonlBlockScanner). Blocks are published in order, so the index always covers a prefix of the
+// stream and stays sorted. The matching lines' text is kept as well (up to
+// MAX_TEXT_BYTES) for showing them on their own.
+// The UI thread drives it; pool threads scan blocks.
+class JsonlMatchIndex {
+public:
+    JsonlMatchIndex() = default;
+    ~JsonlMatchIndex();
+
+    JsonlMatchIndex(const JsonlMatchIndex&) = delete;
+    JsonlMatchIndex& operator=(const JsonlMatchIndex&) = delete;
+
+    void start(std::shared_ptr<StreamingFilePreview> source, std::shared_ptr<const JsonFilter> filter);
+    void reset();
+
+    // Hand newly complete lines to the pool (call each frame)
+    void update();
+
+    const std::shared_ptr<StreamingFilePreview>& source() const { return m_source; }
+    bool isActive() const { return m_run != nullptr; }
+    bool isBusy() const;
+
+    // Lines checked so far (always a prefix) and the matches among them
+    uint64_t scannedLines() const;
+    size_t matchCount() const;
+
+    // First match after line / last match before it; false if none yet
+    bool nextMatch(uint64_t line, uint64_t& out) const;
+    bool prevMatch(uint64_t line, uint64_t& out) const;
+    // First match at or after line, else the last one before it
+    bool nearestMatch(uint64_t line, uint64_t& out) const;
+    // Ordinal of a match line (or of the next match after a line)
+    size_t matchesBefore(uint64_t line) const;
+
+    // Bumped whenever more matches are published
+    uint64_t generation() const;
+
+    // The matching lines so far, one per line, copied into a buffer of
+    // their own on the pool without holding up queries meanwhile. Past
+    // MAX_TEXT_BYTES only the first matches are included.
+    std::future<std::shared_ptr<const TextBuffer>> buildMatchedText() const;
+    bool isTextTruncated() const;
+
+    static constexpr size_t MAX_TEXT_BYTES = 64 * 1024 * 1024;
+
+private:
+    struct Block {
+        std::vector<uint64_t> matches;  // Line indices in the source
+        std::string text;               // Their lines, each ending in '\n'
+        uint64_t rows = 0;
+    };
+
+    // Matches found in one stream; shared with the pool jobs
+    struct Run {
+        std::shared_ptr<const JsonFilter> filter;
+
+        mutable std::mutex mutex;
+        uint64_t scannedLines = 0;
+        std::vector<uint64_t> matches;
+        // Matching lines, one immutable chunk per block, so building the
+        // text copies them without holding the mutex
+        std::vector<std::shared_ptr<const std::string>> textChunks;
+        size_t textBytes = 0;
+        bool textTruncated = false;
+        uint64_t generation = 0;
+
+        std::shared_ptr<Block> scanBlock(const JsonlBlockScanner::Lines& lines) const;
+        void publish(Block&& block);
+    };
+
+    std::shared_ptr<StreamingFilePreview> m_source;
+    JsonlBlockScanner m_scanner;
+    std::shared_ptr<Run> m_run;
+};
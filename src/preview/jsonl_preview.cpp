@@ -1,9 +1,20 @@
 #include "jsonl_preview.h"
 #include "browser_model.h"
 #include "streaming_preview.h"
+#include "text_buffer.h"
+#include "json_format.h"
+#include "thread_pool.h"
 #include "imgui/imgui.h"
-#include "nlohmann/json.hpp"
+#include <algorithm>
 #include <cctype>
+#include <chrono>
+#include <cstdio>
+
+namespace {
+// Projected columns shown in table mode; ImGui tables allow up to 512
+// including the line number column
+constexpr size_t MAX_TABLE_COLUMNS = 256;
+}
 
 bool JsonlPreviewRenderer::isJsonlFile(const std::string& key) {
     size_t dotPos = key.rfind('.');
@@ -46,26 +57,47 @@ void JsonlPreviewRenderer::render(const PreviewContext& ctx) {
     bool fileChanged = (m_currentKey != fullKey);
     if (fileChanged) {
         m_currentKey = fullKey;
+        m_currentSource = sp;
         m_currentLine = 0;
-        m_formattedLineIndex = SIZE_MAX;
-        // Close all viewers BEFORE clearing strings they may reference
-        m_rawViewer.close();
-        m_jsonViewer.close();
-        m_textViewer.close();
-        m_jsonSP.reset();
-        m_textSP.reset();
-        m_incompleteSP.reset();
-        // Now safe to clear strings
-        m_formattedCache.clear();
-        m_textFieldCache.clear();
-        m_textFieldName.clear();
+        m_gotoInput = 0;
+        m_pendingLine = UINT64_MAX;
+        m_pendingEnd = false;
+        closeViewers();
+        resetScans();
         m_validatedFirstLine = false;
         m_fallbackKey.clear();
-        m_rawViewerKey.clear();
-        m_jsonViewerLine = SIZE_MAX;
-        m_textViewerLine = SIZE_MAX;
-        m_rawViewerLine = SIZE_MAX;
+    } else if (m_currentSource != sp) {
+        // A seek restarted the download; line indices now count from its first line
+        m_currentSource = sp;
+        m_currentLine = 0;
+        closeViewers();
+        resetScans();
+    }
+
+    // Show a line requested with "Go to" once it has been decoded. Without
+    // line numbers the seek started near an estimate of where it is, which is
+    // as close as it gets.
+    uint64_t firstLine = sp->firstLineNumber();
+    size_t lineCount = sp->lineCount();
+    if (m_pendingLine != UINT64_MAX && firstLine == SeekCheckpoint::UNKNOWN_LINE) {
+        m_currentLine = 0;
+        m_pendingLine = UINT64_MAX;
+    } else if (m_pendingLine != UINT64_MAX && m_pendingLine >= firstLine) {
+        if (m_pendingLine - firstLine < lineCount) {
+            m_currentLine = static_cast<size_t>(m_pendingLine - firstLine);
+            m_pendingLine = UINT64_MAX;
+        } else if (sp->isComplete()) {
+            m_currentLine = lineCount > 0 ? lineCount - 1 : 0;
+            m_pendingLine = UINT64_MAX;
+        }
+    }
+    if (m_pendingEnd && sp->isComplete()) {
+        // Skip the empty "line" after a trailing newline
+        m_currentLine = lineCount > 1 && sp->getLine(lineCount - 1).empty() ? lineCount - 2
+                      : lineCount > 0 ? lineCount - 1 : 0;
+        m_pendingEnd = false;
     }
+    ctx.model.keepStreamingPreviewAhead(m_pendingLine != UINT64_MAX || m_pendingEnd ? lineCount : m_currentLine);
 
     // Validate first line once it's complete - if not valid JSON, trigger fallback
     if (!m_validatedFirstLine && sp->lineCount() > 0 && sp->isLineComplete(0)) {
@@ -85,7 +117,11 @@ void JsonlPreviewRenderer::render(const PreviewContext& ctx) {
 
     // Header with filename and progress
     ImGui::Text("Preview: %s", ctx.filename.c_str());
-    if (!sp->isComplete()) {
+    std::string streamError = sp->error();
+    if (!streamError.empty()) {
+        ImGui::SameLine();
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), " (%s)", streamError.c_str());
+    } else if (!sp->isComplete()) {
         size_t totalBytes = sp->totalSourceBytes();
         size_t downloadedBytes = sp->bytesDownloaded();
         float progress = totalBytes > 0 ? static_cast<float>(downloadedBytes) / static_cast<float>(totalBytes) : 0.0f;
@@ -95,8 +131,6 @@ void JsonlPreviewRenderer::render(const PreviewContext& ctx) {
     ImGui::Separator();
 
     // Navigation bar
-    size_t lineCount = sp->lineCount();
-
     // Clamp current line to valid range
     if (m_currentLine >= lineCount && lineCount > 0) {
         m_currentLine = lineCount - 1;
@@ -110,7 +144,15 @@ void JsonlPreviewRenderer::render(const PreviewContext& ctx) {
     }
     ImGui::SameLine();
 
-    ImGui::Text("Line %zu / %zu", m_currentLine + 1, lineCount);
+    // Line numbers are within the whole file, even after seeking into the middle
+    // of it; a zstd seek table gives no line numbers, so those show as offsets
+    if (firstLine == SeekCheckpoint::UNKNOWN_LINE) {
+        ImGui::Text("Line ?+%zu", m_currentLine + 1);
+    } else {
+        ImGui::Text("Line %llu / %llu",
+                    static_cast<unsigned long long>(firstLine + m_currentLine + 1),
+                    static_cast<unsigned long long>(firstLine + lineCount));
+    }
     ImGui::SameLine();
 
     if (ImGui::Button(">") || (ImGui::IsKeyPressed(ImGuiKey_RightArrow) && !ImGui::GetIO().WantTextInput)) {
@@ -118,13 +160,65 @@ void JsonlPreviewRenderer::render(const PreviewContext& ctx) {
     }
     ImGui::SameLine();
 
+    ImGui::SetNextItemWidth(100.0f);
+    if (ImGui::InputScalar("##goto", ImGuiDataType_U64, &m_gotoInput, nullptr, nullptr, nullptr,
+                           ImGuiInputTextFlags_EnterReturnsTrue) && m_gotoInput > 0) {
+        uint64_t target = m_gotoInput - 1;
+        if (target >= firstLine && target - firstLine < lineCount) {
+            m_currentLine = static_cast<size_t>(target - firstLine);
+        } else {
+            // Compressed objects with recorded checkpoints jump there; otherwise
+            // the line shows up once decoding reaches it
+            m_pendingEnd = false;
+            m_pendingLine = target;
+            ctx.model.seekStreamingPreviewToLine(target);
+        }
+    }
+    ImGui::SameLine();
+    ImGui::TextDisabled("Go to line");
+    ImGui::SameLine();
+
+    if (ImGui::Button("End")) {
+        m_pendingLine = UINT64_MAX;
+        m_pendingEnd = true;
+        ctx.model.seekStreamingPreviewToEnd();
+    }
+    ImGui::SameLine();
+
     if (ImGui::Checkbox("Raw", &m_rawMode)) {
         m_formattedLineIndex = SIZE_MAX;  // Force refresh
     }
+    ImGui::SameLine();
+    if (ImGui::Checkbox("Table", &m_tableMode) && m_tableMode) {
+        m_statsMode = false;
+    }
+    ImGui::SameLine();
+    if (ImGui::Checkbox("Stats", &m_statsMode) && m_statsMode) {
+        m_tableMode = false;
+    }
 
     ImGui::EndGroup();
+    renderFilterBar(ctx);
+    if (m_pendingLine != UINT64_MAX) {
+        ImGui::TextColored(ImVec4(0.5f, 0.5f, 1.0f, 1.0f), "Seeking to line %llu...",
+                           static_cast<unsigned long long>(m_pendingLine + 1));
+    } else if (m_pendingEnd) {
+        ImGui::TextColored(ImVec4(0.5f, 0.5f, 1.0f, 1.0f), "Seeking to end...");
+    }
     ImGui::Separator();
 
+    if (m_stats.source()) {
+        m_stats.update();
+    }
+    if (m_statsMode) {
+        renderStats(ctx);
+        return;
+    }
+    if (m_tableMode) {
+        renderTable(ctx);
+        return;
+    }
+
     // Get current line content
     if (lineCount > 0) {
         bool lineComplete = sp->isLineComplete(m_currentLine);
@@ -142,26 +236,31 @@ void JsonlPreviewRenderer::render(const PreviewContext& ctx) {
                 "Line incomplete (%zu bytes loaded so far)...", lineContent.size());
             ImGui::Spacing();
 
-            // Show partial content with MmapTextViewer
-            std::string displayContent;
-            if (lineContent.size() > 1000) {
-                displayContent = lineContent.substr(0, 500) + "\n...\n" +
-                                 lineContent.substr(lineContent.size() - 500);
-            } else {
-                displayContent = lineContent;
+            // Show partial content, rebuilt only when more of the line arrives
+            if (m_incompleteBytes != lineContent.size()) {
+                std::string displayContent;
+                if (lineContent.size() > 1000) {
+                    displayContent = lineContent.substr(0, 500) + "\n...\n" +
+                                     lineContent.substr(lineContent.size() - 500);
+                } else {
+                    displayContent = lineContent;
+                }
+                m_incompleteViewer.open(std::make_shared<TextBuffer>(std::move(displayContent)));
+                m_incompleteBytes = lineContent.size();
             }
 
-            m_incompleteSP = std::make_shared<StreamingFilePreview>("", "", displayContent, displayContent.size());
-            MmapTextViewer incompleteViewer;
-            incompleteViewer.open(m_incompleteSP);
-
             ImVec2 availSize = ImGui::GetContentRegionAvail();
             if (availSize.y > 0.0f) {
-                incompleteViewer.render(availSize.x, availSize.y);
+                m_incompleteViewer.render(availSize.x, availSize.y);
             }
+        } else if (m_rawMode && m_filter) {
+            m_incompleteViewer.close();
+            m_incompleteBytes = SIZE_MAX;
+            renderFilteredRaw();
         } else if (m_rawMode) {
             // Clean up incomplete state if we transitioned to complete
-            m_incompleteSP.reset();
+            m_incompleteViewer.close();
+            m_incompleteBytes = SIZE_MAX;
 
             // Raw mode - open the main streaming temp file and scroll to current line
             if (m_rawViewerKey != fullKey) {
@@ -185,36 +284,43 @@ void JsonlPreviewRenderer::render(const PreviewContext& ctx) {
             }
         } else {
             // Clean up incomplete state if we transitioned to complete
-            m_incompleteSP.reset();
+            m_incompleteViewer.close();
+            m_incompleteBytes = SIZE_MAX;
 
             // Formatted mode - show pretty-printed JSON (and extract text field)
             if (m_formattedLineIndex != m_currentLine) {
-                updateCache(lineContent);
+                // Usually formatted in the background while the previous line
+                // was shown. Never wait for that: if it hasn't finished, format
+                // here and let the pool's copy be dropped.
+                auto it = m_records.find(m_currentLine);
+                bool ready = it != m_records.end() &&
+                             it->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+                if (!ready) {
+                    std::promise<std::shared_ptr<const Record>> formatted;
+                    formatted.set_value(formatRecord(lineContent));
+                    it = m_records.insert_or_assign(m_currentLine, formatted.get_future().share()).first;
+                }
+                m_record = it->second.get();
                 m_formattedLineIndex = m_currentLine;
 
-                // Create StreamingFilePreview for formatted JSON
-                m_jsonSP = std::make_shared<StreamingFilePreview>("", "", m_formattedCache, m_formattedCache.size());
-                m_jsonViewer.close();
-                m_jsonViewer.open(m_jsonSP);
+                m_jsonViewer.open(m_record->formatted);
                 m_jsonViewerLine = m_currentLine;
 
-                // Create StreamingFilePreview for text field if present
-                if (!m_textFieldCache.empty()) {
-                    m_textSP = std::make_shared<StreamingFilePreview>("", "", m_textFieldCache, m_textFieldCache.size());
-                    m_textViewer.close();
-                    m_textViewer.open(m_textSP);
+                if (m_record->textField) {
+                    m_textViewer.open(m_record->textField);
                     m_textViewer.setWordWrap(true);
                     m_textViewerLine = m_currentLine;
                 } else {
                     m_textViewer.close();
-                    m_textSP.reset();
                     m_textViewerLine = SIZE_MAX;
                 }
             }
 
+            prefetchNeighbors(ctx);
+
             ImVec2 availSize = ImGui::GetContentRegionAvail();
 
-            if (!m_textFieldCache.empty()) {
+            if (m_record->textField) {
                 float halfHeight = availSize.y * 0.5f - 4;
 
                 // Top pane: formatted JSON
@@ -242,26 +348,342 @@ void JsonlPreviewRenderer::render(const PreviewContext& ctx) {
 
 void JsonlPreviewRenderer::reset() {
     m_currentKey.clear();
+    m_currentSource = nullptr;
     m_currentLine = 0;
+    m_gotoInput = 0;
+    m_pendingLine = UINT64_MAX;
+    m_pendingEnd = false;
     m_rawMode = false;
-    m_formattedCache.clear();
-    m_textFieldCache.clear();
-    m_textFieldName.clear();
-    m_formattedLineIndex = SIZE_MAX;
+    m_tableMode = false;
+    m_statsMode = false;
+    m_filterInput[0] = '\0';
+    m_filter.reset();
+    m_filterJump = false;
     m_validatedFirstLine = false;
+    closeViewers();
+    resetScans();
+}
 
+void JsonlPreviewRenderer::closeViewers() {
+    m_formattedLineIndex = SIZE_MAX;
     m_rawViewer.close();
     m_jsonViewer.close();
     m_textViewer.close();
-    m_jsonSP.reset();
-    m_textSP.reset();
-    m_incompleteSP.reset();
+    m_incompleteViewer.close();
+    m_incompleteBytes = SIZE_MAX;
+    m_record.reset();
+    m_records.clear();
     m_rawViewerKey.clear();
     m_jsonViewerLine = SIZE_MAX;
     m_textViewerLine = SIZE_MAX;
     m_rawViewerLine = SIZE_MAX;
 }
 
+// The table, stats and filter matches are scans of one source. They're kept
+// while it stays (switching views, seeking within it) and only dropped when a
+// restarted download or another file replaces it.
+void JsonlPreviewRenderer::resetScans() {
+    m_table.reset();
+    m_stats.reset();
+    m_statsSummary = JsonlStats::Summary();
+    m_statsGeneration = UINT64_MAX;
+    m_matches.reset();
+    m_filterViewer.close();
+    m_filterText = {};
+    m_filterTextGeneration = UINT64_MAX;
+    m_filterViewerLine = SIZE_MAX;
+}
+
+void JsonlPreviewRenderer::renderFilterBar(const PreviewContext& ctx) {
+    ImGui::SetNextItemWidth(std::max(ImGui::GetContentRegionAvail().x * 0.5f, 200.0f));
+    if (ImGui::InputTextWithHint("##filter", "Filter, e.g. .metadata.lang == \"de\" and len(.text) > 100",
+                                 m_filterInput, sizeof(m_filterInput), ImGuiInputTextFlags_EnterReturnsTrue)) {
+        m_matches.reset();
+        m_filterViewer.close();
+        m_filterText = {};
+        m_filterTextGeneration = UINT64_MAX;
+        m_filterViewerLine = SIZE_MAX;
+        m_filter.reset();
+        if (m_filterInput[0] != '\0') {
+            m_filter = std::make_shared<JsonFilter>(m_filterInput);
+            m_filterJump = m_filter->isValid();
+        }
+    }
+    if (!m_filter)
+        return;
+
+    ImGui::SameLine();
+    if (!m_filter->isValid()) {
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", m_filter->error().c_str());
+        return;
+    }
+
+    // Follows seeks and new files
+    if (m_matches.source() != ctx.streamingPreview) {
+        m_matches.start(ctx.streamingPreview, m_filter);
+        m_filterViewer.close();
+        m_filterTextGeneration = UINT64_MAX;
+        m_filterViewerLine = SIZE_MAX;
+    }
+    m_matches.update();
+
+    uint64_t line = 0;
+    if (m_filterJump && m_matches.nearestMatch(m_currentLine, line)) {
+        m_currentLine = static_cast<size_t>(line);
+        m_filterJump = false;
+    }
+
+    size_t count = m_matches.matchCount();
+    const char* busy = m_matches.isBusy() ? " (filtering...)" : "";
+    if (count == 0) {
+        ImGui::TextDisabled("No matches in %llu lines%s", static_cast<unsigned long long>(m_matches.scannedLines()),
+                            busy);
+    } else {
+        size_t ordinal = m_matches.matchesBefore(m_currentLine);
+        if (m_matches.matchesBefore(m_currentLine + 1) > ordinal) {
+            ImGui::TextDisabled("Match %zu of %zu%s", ordinal + 1, count, busy);
+        } else {
+            ImGui::TextDisabled("%zu matches%s", count, busy);
+        }
+    }
+}
+
+void JsonlPreviewRenderer::renderFilteredRaw() {
+    // Rebuilt on the pool as matches come in, at most once a second
+    double now = ImGui::GetTime();
+    uint64_t generation = m_matches.generation();
+    if (m_filterText.valid() &&
+        m_filterText.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        m_filterViewer.open(m_filterText.get());
+        m_filterViewerLine = SIZE_MAX;
+    }
+    if (!m_filterText.valid() && generation != m_filterTextGeneration &&
+        (now - m_filterTextTime >= 1.0 || !m_filterViewer.isOpen() || !m_matches.isBusy())) {
+        m_filterText = m_matches.buildMatchedText();
+        m_filterTextGeneration = generation;
+        m_filterTextTime = now;
+    }
+
+    if (m_matches.isTextTruncated()) {
+        ImGui::TextColored(ImVec4(0.5f, 0.5f, 0.5f, 1.0f), "Showing the first %zu MB of matching lines",
+                           JsonlMatchIndex::MAX_TEXT_BYTES / (1024 * 1024));
+    }
+    if (!m_filterViewer.isOpen()) {
+        ImGui::TextColored(ImVec4(0.5f, 0.5f, 0.5f, 1.0f), "Filtering...");
+        return;
+    }
+
+    // Line n of the viewer is match n
+    if (m_filterViewerLine != m_currentLine) {
+        m_filterViewer.scrollToLine(static_cast<uint64_t>(m_matches.matchesBefore(m_currentLine)));
+        m_filterViewerLine = m_currentLine;
+    }
+    ImVec2 availSize = ImGui::GetContentRegionAvail();
+    if (availSize.y > 0.0f) {
+        m_filterViewer.render(availSize.x, availSize.y);
+    }
+}
+
+void JsonlPreviewRenderer::renderTable(const PreviewContext& ctx) {
+    // Columns are applied on Enter or when the field loses focus
+    ImGui::SetNextItemWidth(-FLT_MIN);
+    bool columnsChanged = ImGui::InputTextWithHint("##columns", "Columns, e.g. id, metadata.*, len(text)",
+                                                   m_tableColumns, sizeof(m_tableColumns),
+                                                   ImGuiInputTextFlags_EnterReturnsTrue);
+    columnsChanged |= ImGui::IsItemDeactivatedAfterEdit();
+    if (columnsChanged || m_table.source() != ctx.streamingPreview) {
+        m_table.start(ctx.streamingPreview, m_tableColumns);
+    }
+    m_table.update();
+
+    uint64_t rows = m_table.rowCount();
+    size_t columns = std::min<size_t>(m_table.columnCount(), MAX_TABLE_COLUMNS);
+    ImGui::TextDisabled("%llu records%s", static_cast<unsigned long long>(rows),
+                        m_table.isBusy() ? " (loading...)" : "");
+
+    ImGuiTableFlags flags = ImGuiTableFlags_ScrollX | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable |
+                            ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV |
+                            ImGuiTableFlags_SizingFixedFit;
+    if (!ImGui::BeginTable("##records", static_cast<int>(columns) + 1, flags)) {
+        return;
+    }
+    ImGui::TableSetupScrollFreeze(1, 1);
+    ImGui::TableSetupColumn("Line");
+    for (size_t c = 0; c < columns; ++c) {
+        ImGui::TableSetupColumn(m_table.columnName(c).c_str());
+    }
+    ImGui::TableHeadersRow();
+
+    uint64_t firstLine = ctx.streamingPreview->firstLineNumber();
+    std::string value;
+    char label[32];
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(std::min<uint64_t>(rows, INT_MAX)));
+    int lastRow = 0;
+    while (clipper.Step()) {
+        lastRow = std::max(lastRow, clipper.DisplayEnd - 1);
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            if (firstLine == SeekCheckpoint::UNKNOWN_LINE) {
+                snprintf(label, sizeof(label), "?+%d", row + 1);
+            } else {
+                snprintf(label, sizeof(label), "%llu", static_cast<unsigned long long>(firstLine + row + 1));
+            }
+
+            // Double-click opens the record
+            ImGui::PushID(row);
+            if (ImGui::Selectable(label, false, ImGuiSelectableFlags_SpanAllColumns |
+                                                ImGuiSelectableFlags_AllowDoubleClick) &&
+                ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) {
+                m_currentLine = static_cast<size_t>(row);
+                m_formattedLineIndex = SIZE_MAX;
+                m_tableMode = false;
+            }
+            ImGui::PopID();
+
+            if (!m_table.isValidRow(static_cast<uint64_t>(row))) {
+                ImGui::TableNextColumn();
+                ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "(invalid JSON)");
+                continue;
+            }
+            for (size_t c = 0; c < columns; ++c) {
+                ImGui::TableNextColumn();
+                m_table.cell(static_cast<uint64_t>(row), c, value);
+                ImGui::TextUnformatted(value.data(), value.data() + value.size());
+            }
+        }
+    }
+    ImGui::EndTable();
+    ctx.model.keepStreamingPreviewAhead(static_cast<size_t>(lastRow));
+}
+
+void JsonlPreviewRenderer::renderStats(const PreviewContext& ctx) {
+    if (m_stats.source() != ctx.streamingPreview) {
+        m_stats.start(ctx.streamingPreview);
+        m_stats.update();
+    }
+    uint64_t generation = m_stats.generation();
+    if (generation != m_statsGeneration) {
+        m_stats.snapshot(m_statsSummary);
+        m_statsGeneration = generation;
+    }
+    const JsonlStats::Summary& summary = m_statsSummary;
+
+    ImGui::TextDisabled("%llu records, %llu invalid%s", static_cast<unsigned long long>(summary.records),
+                        static_cast<unsigned long long>(summary.invalid),
+                        m_stats.isBusy() ? " (loading...)" : "");
+    if (summary.otherFields > 0) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("- %llu values of further paths not tracked",
+                            static_cast<unsigned long long>(summary.otherFields));
+    }
+
+    const JsonlStats::Field* selected = nullptr;
+    for (const JsonlStats::Field& field : summary.fields) {
+        if (field.path == m_statsField) selected = &field;
+    }
+
+    // Fields on top, details of the selected one below
+    ImVec2 avail = ImGui::GetContentRegionAvail();
+    float tableHeight = selected ? avail.y * 0.55f : avail.y;
+    ImGuiTableFlags flags = ImGuiTableFlags_ScrollX | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable |
+                            ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV |
+                            ImGuiTableFlags_SizingFixedFit;
+    if (tableHeight > 0.0f && ImGui::BeginTable("##fields", 5, flags, ImVec2(0.0f, tableHeight))) {
+        ImGui::TableSetupScrollFreeze(1, 1);
+        ImGui::TableSetupColumn("Field");
+        ImGui::TableSetupColumn("Present");
+        ImGui::TableSetupColumn("Types");
+        ImGui::TableSetupColumn("Distinct");
+        ImGui::TableSetupColumn("Length min / mean / max");
+        ImGui::TableHeadersRow();
+
+        char text[128];
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(summary.fields.size()));
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+                const JsonlStats::Field& field = summary.fields[static_cast<size_t>(i)];
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                if (ImGui::Selectable(field.path.c_str(), &field == selected, ImGuiSelectableFlags_SpanAllColumns)) {
+                    m_statsField = &field == selected ? std::string() : field.path;
+                }
+
+                ImGui::TableNextColumn();
+                uint64_t valid = summary.records - summary.invalid;
+                ImGui::Text("%.1f%%", valid > 0 ? 100.0 * static_cast<double>(field.count) / static_cast<double>(valid) : 0.0);
+
+                // Share of each type seen
+                ImGui::TableNextColumn();
+                std::string types;
+                for (int t = 0; t < JsonlStats::TYPE_COUNT; ++t) {
+                    if (field.types[t] == 0) continue;
+                    if (!types.empty()) types += ", ";
+                    snprintf(text, sizeof(text), "%s %.0f%%", JsonlStats::typeName(static_cast<JsonlStats::ValueType>(t)),
+                             100.0 * static_cast<double>(field.types[t]) / static_cast<double>(field.count));
+                    types += text;
+                }
+                ImGui::TextUnformatted(types.c_str());
+
+                ImGui::TableNextColumn();
+                ImGui::Text("~%llu", static_cast<unsigned long long>(field.distinct));
+
+                ImGui::TableNextColumn();
+                uint64_t strings = field.types[JsonlStats::String];
+                if (strings > 0) {
+                    ImGui::Text("%llu / %.0f / %llu", static_cast<unsigned long long>(field.minLength),
+                                static_cast<double>(field.totalLength) / static_cast<double>(strings),
+                                static_cast<unsigned long long>(field.maxLength));
+                }
+            }
+        }
+        ImGui::EndTable();
+    }
+
+    if (!selected)
+        return;
+    ImGui::Separator();
+    ImGui::Text("%s", selected->path.c_str());
+
+    // String lengths by power of two, up to the longest seen
+    int buckets = 0;
+    for (int b = 0; b < JsonlStats::LENGTH_BUCKETS; ++b) {
+        if (selected->lengths[b] > 0) buckets = b + 1;
+    }
+    float half = ImGui::GetContentRegionAvail().x * 0.5f;
+    if (buckets > 0) {
+        float counts[JsonlStats::LENGTH_BUCKETS];
+        for (int b = 0; b < buckets; ++b) counts[b] = static_cast<float>(selected->lengths[b]);
+        ImGui::PlotHistogram("##lengths", counts, buckets, 0,
+                             "String length (bucket b: < 2^b chars)", 0.0f, FLT_MAX,
+                             ImVec2(half - 8.0f, ImGui::GetContentRegionAvail().y));
+        ImGui::SameLine();
+    }
+
+    // Frequent values; counts may be overestimated by up to the error shown
+    if (ImGui::BeginTable("##top", 2, ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Value");
+        ImGui::TableSetupColumn("Count", ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableHeadersRow();
+        for (const JsonlStats::Field::TopValue& top : selected->top) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(top.value.data(), top.value.data() + top.value.size());
+            ImGui::TableNextColumn();
+            if (top.error > 0) {
+                ImGui::Text("%llu (+-%llu)", static_cast<unsigned long long>(top.count),
+                            static_cast<unsigned long long>(top.error));
+            } else {
+                ImGui::Text("%llu", static_cast<unsigned long long>(top.count));
+            }
+        }
+        ImGui::EndTable();
+    }
+}
+
 bool JsonlPreviewRenderer::wantsFallback(const std::string& bucket, const std::string& key) const {
     std::string fullKey = bucket + "/" + key;
     return fullKey == m_fallbackKey;
@@ -281,12 +703,7 @@ bool JsonlPreviewRenderer::isValidJsonLine(const std::string& line) {
         return false;
     }
 
-    try {
-        (void)nlohmann::json::parse(line);
-        return true;
-    } catch (...) {
-        return false;
-    }
+    return validateJson(line);
 }
 
 void JsonlPreviewRenderer::navigateLine(int delta, const PreviewContext& ctx) {
@@ -296,6 +713,16 @@ void JsonlPreviewRenderer::navigateLine(int delta, const PreviewContext& ctx) {
     size_t lineCount = sp->lineCount();
     if (lineCount == 0) return;
 
+    m_pendingLine = UINT64_MAX;
+    m_pendingEnd = false;
+    if (m_matches.isActive()) {
+        // Step between matches; stay put past the first or last one
+        uint64_t line = 0;
+        if (delta < 0 ? m_matches.prevMatch(m_currentLine, line) : m_matches.nextMatch(m_currentLine, line)) {
+            m_currentLine = static_cast<size_t>(line);
+        }
+        return;
+    }
     if (delta < 0) {
         size_t absDelta = static_cast<size_t>(-delta);
         if (m_currentLine >= absDelta) {
@@ -313,43 +740,45 @@ void JsonlPreviewRenderer::navigateLine(int delta, const PreviewContext& ctx) {
     }
 }
 
-void JsonlPreviewRenderer::updateCache(const std::string& rawJson) {
-    try {
-        auto parsed = nlohmann::json::parse(rawJson);
-        m_formattedCache = parsed.dump(2);
-        m_textFieldCache = extractTextField(rawJson, m_textFieldName);
-    } catch (const nlohmann::json::parse_error& e) {
-        m_formattedCache = std::string("(Invalid JSON: ") + e.what() + ")\n\n" + rawJson;
-        m_textFieldCache.clear();
-        m_textFieldName.clear();
-    } catch (const std::exception& e) {
-        m_formattedCache = std::string("(Error: ") + e.what() + ")";
-        m_textFieldCache.clear();
-        m_textFieldName.clear();
-    } catch (...) {
-        m_formattedCache = "(Error formatting JSON)";
-        m_textFieldCache.clear();
-        m_textFieldName.clear();
+std::shared_ptr<const JsonlPreviewRenderer::Record> JsonlPreviewRenderer::formatRecord(const std::string& rawJson) {
+    // One pass both pretty-prints and pulls out the text field
+    JsonFormatResult result;
+    auto record = std::make_shared<Record>();
+    if (formatJson(rawJson, "text", result)) {
+        record->formatted = std::make_shared<TextBuffer>(std::move(result.formatted));
+        if (result.hasField && !result.fieldValue.empty()) {
+            record->textField = std::make_shared<TextBuffer>(std::move(result.fieldValue));
+        }
+    } else {
+        record->formatted = std::make_shared<TextBuffer>("(Invalid JSON: " + result.error + ")\n\n" + rawJson);
     }
+    return record;
 }
 
-std::string JsonlPreviewRenderer::extractTextField(const std::string& json, std::string& outFieldName) {
-    outFieldName.clear();
-
-    try {
-        auto parsed = nlohmann::json::parse(json);
-        if (!parsed.is_object()) {
-            return "";
-        }
-
-        if (parsed.contains("text") && parsed["text"].is_string()) {
-            outFieldName = "text";
-            return parsed["text"].get<std::string>();
-        }
+void JsonlPreviewRenderer::prefetchNeighbors(const PreviewContext& ctx) {
+    // The lines < and > go to: adjacent ones, or adjacent matches
+    size_t prev = m_currentLine - 1;  // Wraps around on the first line
+    size_t next = m_currentLine + 1;
+    if (m_matches.isActive()) {
+        uint64_t line = 0;
+        prev = m_matches.prevMatch(m_currentLine, line) ? static_cast<size_t>(line) : SIZE_MAX;
+        next = m_matches.nextMatch(m_currentLine, line) ? static_cast<size_t>(line) : SIZE_MAX;
+    }
 
-    } catch (...) {
-        // Ignore parse errors
+    // Forget records that are no longer next to the current line
+    for (auto it = m_records.begin(); it != m_records.end();) {
+        bool near = it->first == prev || it->first == m_currentLine || it->first == next;
+        it = near ? std::next(it) : m_records.erase(it);
     }
 
-    return "";
+    StreamingFilePreview* sp = ctx.streamingPreview.get();
+    size_t lineCount = sp->lineCount();
+    for (size_t line : {prev, next}) {
+        if (line >= lineCount || m_records.count(line) || !sp->isLineComplete(line))
+            continue;
+        std::shared_ptr<StreamingFilePreview> source = ctx.streamingPreview;
+        m_records.emplace(line, ThreadPool::shared().submit([source, line] {
+            return formatRecord(source->getLine(line));
+        }).share());
+    }
 }
@@ -2,12 +2,18 @@
 
 #include "preview_renderer.h"
 #include "mmap_text_viewer.h"
+#include "jsonl_table.h"
+#include "jsonl_stats.h"
+#include "jsonl_filter.h"
 #include <string>
 #include <memory>
+#include <map>
+#include <future>
 #include <climits>
 #include <cstdint>
 
 class StreamingFilePreview;
+class TextBuffer;
 
 class JsonlPreviewRenderer : public IPreviewRenderer {
 public:
@@ -23,20 +29,65 @@ public:
 
 private:
     void navigateLine(int delta, const PreviewContext& ctx);
-    void updateCache(const std::string& rawJson);
-    static std::string extractTextField(const std::string& json, std::string& outFieldName);
+    void closeViewers();
+    void resetScans();
+
+    // Chosen fields of every record, one row per line
+    void renderTable(const PreviewContext& ctx);
+
+    // Aggregates over all records downloaded so far
+    void renderStats(const PreviewContext& ctx);
+
+    // Filter expression field and match count; keeps the match index going
+    void renderFilterBar(const PreviewContext& ctx);
+    // Raw mode with a filter: only the matching lines
+    void renderFilteredRaw();
+
+    // A line formatted for display, ready to hand to the viewers
+    struct Record {
+        std::shared_ptr<const TextBuffer> formatted;  // Pretty-printed JSON, or the error and raw line
+        std::shared_ptr<const TextBuffer> textField;  // Top-level "text" string, if there is one
+    };
+    static std::shared_ptr<const Record> formatRecord(const std::string& rawJson);
+
+    // Format the lines either side of the current one on the thread pool
+    void prefetchNeighbors(const PreviewContext& ctx);
 
     // Try to parse a line as JSON, returns true if valid
     static bool isValidJsonLine(const std::string& line);
 
     std::string m_currentKey;        // bucket/key of loaded file
-    size_t m_currentLine = 0;
+    const StreamingFilePreview* m_currentSource = nullptr;  // Changes when a seek restarts the stream
+    size_t m_currentLine = 0;        // Index into the current source's lines
+    uint64_t m_gotoInput = 0;        // "Go to line" field (1-based)
+    uint64_t m_pendingLine = UINT64_MAX;  // Absolute line to show once it's decoded
+    bool m_pendingEnd = false;       // Show the last line once the download completes
     bool m_rawMode = false;
-    std::string m_formattedCache;    // Pretty-printed JSON
-    std::string m_textFieldCache;    // Extracted text field content
-    std::string m_textFieldName;     // Name of the extracted text field
+    bool m_tableMode = false;
+    char m_tableColumns[256] = "id, source, metadata.*, len(text)";
+    JsonlTable m_table;
+    bool m_statsMode = false;
+    JsonlStats m_stats;                  // Keeps going in other modes once started
+    JsonlStats::Summary m_statsSummary;
+    uint64_t m_statsGeneration = UINT64_MAX;
+    std::string m_statsField;            // Path whose details are shown
+
+    // Record filter; < and > step through its matches
+    char m_filterInput[512] = "";
+    std::shared_ptr<const JsonFilter> m_filter;  // Null when not filtering
+    JsonlMatchIndex m_matches;
+    bool m_filterJump = false;           // Go to the nearest match once there is one
+    MmapTextViewer m_filterViewer;       // Matching lines in raw mode
+    std::future<std::shared_ptr<const TextBuffer>> m_filterText;
+    uint64_t m_filterTextGeneration = UINT64_MAX;
+    double m_filterTextTime = 0.0;
+    size_t m_filterViewerLine = SIZE_MAX;
+    std::shared_ptr<const Record> m_record;  // Shown in formatted mode
     size_t m_formattedLineIndex = SIZE_MAX;
 
+    // The current line and its neighbors, formatted or being formatted
+    std::map<size_t, std::shared_future<std::shared_ptr<const Record>>> m_records;
+
     // Fallback tracking - stores bucket/key of files that failed JSON parsing
     std::string m_fallbackKey;
     bool m_validatedFirstLine = false;  // True once we've checked the first line
@@ -45,11 +96,8 @@ private:
     MmapTextViewer m_rawViewer;        // Raw mode (full file, scroll to line)
     MmapTextViewer m_jsonViewer;       // Formatted JSON display
     MmapTextViewer m_textViewer;       // Text field display
-
-    // StreamingFilePreview instances for formatted content
-    std::shared_ptr<StreamingFilePreview> m_jsonSP;
-    std::shared_ptr<StreamingFilePreview> m_textSP;
-    std::shared_ptr<StreamingFilePreview> m_incompleteSP;
+    MmapTextViewer m_incompleteViewer; // Partial line while it downloads
+    size_t m_incompleteBytes = SIZE_MAX;  // Size of the partial line shown
 
     // Track what's currently loaded in viewers
     std::string m_rawViewerKey;
@@ -0,0 +1,166 @@
+#include "jsonl_scanner.h"
+#include "streaming_preview.h"
+#include "line_index.h"
+#include "thread_pool.h"
+#include "loguru.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+
+namespace {
+
+// Blocks queued, being scanned or waiting to be published per pool thread;
+// bounds memory held by their read buffers and results
+constexpr size_t BLOCKS_IN_FLIGHT_PER_THREAD = 2;
+
+} // namespace
+
+// ============================================================================
+// Run
+// ============================================================================
+
+JsonlBlockScanner::Run::~Run() {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+void JsonlBlockScanner::Run::scanBlock(size_t blockNumber, uint64_t firstLine, uint64_t rows,
+                                       uint64_t startByte, uint64_t endByte) {
+    std::string buffer;
+    if (!cancelled.load(std::memory_order_relaxed)) {
+        buffer.resize(endByte - startByte);
+        size_t done = 0;
+        while (done < buffer.size()) {
+            ssize_t n = pread(fd, &buffer[done], buffer.size() - done, static_cast<off_t>(startByte + done));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                LOG_F(WARNING, "%s: read at %llu failed: %s", name,
+                      static_cast<unsigned long long>(startByte + done), n < 0 ? strerror(errno) : "end of file");
+                break;
+            }
+            done += static_cast<size_t>(n);
+        }
+        buffer.resize(done);
+    }
+
+    Publish publish;
+    if (!cancelled.load(std::memory_order_relaxed)) {
+        publish = scan(Lines(buffer, firstLine, rows, cancelled));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        scanned.emplace(blockNumber, std::move(publish));
+    }
+    publishReady();
+}
+
+void JsonlBlockScanner::Run::publishReady() {
+    // Whoever holds publishMutex publishes every block that is next in
+    // line, including ones finished meanwhile by other threads
+    std::lock_guard<std::mutex> publishing(publishMutex);
+    for (;;) {
+        Publish publish;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = scanned.begin();
+            if (it == scanned.end() || it->first != publishedBlocks)
+                return;
+            publish = std::move(it->second);
+            scanned.erase(it);
+        }
+
+        if (publish && !cancelled.load(std::memory_order_relaxed))
+            publish();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        publishedBlocks++;
+        pendingBlocks--;
+    }
+}
+
+// ============================================================================
+// JsonlBlockScanner
+// ============================================================================
+
+JsonlBlockScanner::~JsonlBlockScanner() {
+    reset();
+}
+
+bool JsonlBlockScanner::start(std::shared_ptr<StreamingFilePreview> source, const char* name, ScanBlock scan) {
+    reset();
+    if (!source)
+        return false;
+
+    auto run = std::make_shared<Run>();
+    run->source = source;
+    run->index = source->lineIndex();
+    run->scan = std::move(scan);
+    run->name = name;
+    run->fd = open(source->tempFilePath().c_str(), O_RDONLY | O_CLOEXEC);
+    if (run->fd < 0) {
+        LOG_F(WARNING, "%s: open %s failed: %s", name, source->tempFilePath().c_str(), strerror(errno));
+        return false;
+    }
+    m_run = std::move(run);
+    return true;
+}
+
+void JsonlBlockScanner::reset() {
+    if (m_run) {
+        m_run->cancelled = true;
+        m_run.reset();
+    }
+    m_scheduledLines = 0;
+    m_allScheduled = false;
+}
+
+void JsonlBlockScanner::update() {
+    if (!m_run || m_allScheduled)
+        return;
+
+    // Only complete lines; a finished stream's trailing newline doesn't
+    // start another record
+    StreamingFilePreview& source = *m_run->source;
+    bool complete = source.isComplete();
+    uint64_t lines = source.lineCount();
+    uint64_t written = source.bytesWritten();
+    uint64_t available = lines > 0 ? lines - 1 : 0;
+    if (complete && lines > 0 && m_run->index->lineStart(lines - 1) < written)
+        available = lines;
+
+    size_t maxInFlight = BLOCKS_IN_FLIGHT_PER_THREAD * ThreadPool::shared().threadCount();
+    while (m_scheduledLines < available) {
+        uint64_t rows = std::min(BLOCK_ROWS, available - m_scheduledLines);
+        if (rows < BLOCK_ROWS && !complete)
+            break;
+
+        {
+            std::lock_guard<std::mutex> lock(m_run->mutex);
+            if (m_run->pendingBlocks >= maxInFlight)
+                break;
+            m_run->pendingBlocks++;
+        }
+
+        uint64_t first = m_scheduledLines;
+        uint64_t startByte = m_run->index->lineStart(first);
+        uint64_t endByte = first + rows < lines ? m_run->index->lineStart(first + rows) : written;
+        size_t blockNumber = static_cast<size_t>(first / BLOCK_ROWS);
+        std::shared_ptr<Run> run = m_run;
+        ThreadPool::shared().submit([run, blockNumber, first, rows, startByte, endByte] {
+            run->scanBlock(blockNumber, first, rows, startByte, endByte);
+        });
+        m_scheduledLines += rows;
+    }
+
+    if (complete && m_scheduledLines >= available)
+        m_allScheduled = true;
+}
+
+bool JsonlBlockScanner::isBusy() const {
+    if (!m_run) return false;
+    std::lock_guard<std::mutex> lock(m_run->mutex);
+    return !m_allScheduled || m_run->pendingBlocks > 0;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+class StreamingFilePreview;
+class LineIndex;
+
+// Scans the complete lines of a JSONL stream on the shared thread pool in
+// blocks of BLOCK_ROWS as the stream arrives. Each block is read into a
+// buffer of its own and handed to a scan callback on a pool thread, several
+// blocks at once; what the callback returns is then run once every block
+// before it has been published, one block at a time, so results are folded
+// in stream order and always cover a prefix of it. Shared by JsonlTable,
+// JsonlStats and JsonlMatchIndex.
+// The UI thread drives it; pool threads scan blocks.
+class JsonlBlockScanner {
+public:
+    // The lines of one block, without their '\n' or '\r'
+    class Lines {
+    public:
+        uint64_t firstLine() const { return m_firstLine; }
+        uint64_t rows() const { return m_rows; }
+
+        // Calls f(row, line) for each row in order; stops early once the
+        // scan is cancelled
+        template <typename F>
+        void forEach(F&& f) const {
+            size_t pos = 0;
+            for (uint64_t row = 0; row < m_rows && !m_cancelled.load(std::memory_order_relaxed); ++row) {
+                size_t lineEnd = m_buffer.size();
+                if (pos < m_buffer.size()) {
+                    const void* nl = memchr(m_buffer.data() + pos, '\n', m_buffer.size() - pos);
+                    if (nl) lineEnd = static_cast<size_t>(static_cast<const char*>(nl) - m_buffer.data());
+                }
+                size_t len = pos < lineEnd ? lineEnd - pos : 0;
+                if (len > 0 && m_buffer[pos + len - 1] == '\r') --len;
+                f(row, std::string_view(m_buffer.data() + pos, len));
+                pos = lineEnd + 1;
+            }
+        }
+
+    private:
+        friend class JsonlBlockScanner;
+        Lines(const std::string& buffer, uint64_t firstLine, uint64_t rows, const std::atomic<bool>& cancelled)
+            : m_buffer(buffer), m_firstLine(firstLine), m_rows(rows), m_cancelled(cancelled) {}
+
+        const std::string& m_buffer;
+        uint64_t m_firstLine;
+        uint64_t m_rows;
+        const std::atomic<bool>& m_cancelled;
+    };
+
+    // Scans a block on a pool thread (several may run at once) and returns
+    // how to publish its result; that runs in block order, never concurrently
+    // with another block's, and not at all once the scan is reset
+    using Publish = std::function<void()>;
+    using ScanBlock = std::function<Publish(const Lines& lines)>;
+
+    JsonlBlockScanner() = default;
+    ~JsonlBlockScanner();
+
+    JsonlBlockScanner(const JsonlBlockScanner&) = delete;
+    JsonlBlockScanner& operator=(const JsonlBlockScanner&) = delete;
+
+    // Start over on a stream; name prefixes log messages. False if the
+    // stream's temp file can't be opened.
+    bool start(std::shared_ptr<StreamingFilePreview> source, const char* name, ScanBlock scan);
+    // Jobs still running finish on their own and drop their results
+    void reset();
+
+    // Hand newly complete lines to the pool (call each frame)
+    void update();
+
+    bool isActive() const { return m_run != nullptr; }
+    // Lines not yet scanned or downloaded, or results not yet published
+    bool isBusy() const;
+
+    static constexpr uint64_t BLOCK_ROWS = 4096;
+
+private:
+    // One scan over one stream; shared with the pool jobs
+    struct Run {
+        std::shared_ptr<StreamingFilePreview> source;
+        std::shared_ptr<const LineIndex> index;
+        ScanBlock scan;
+        const char* name = "";
+        int fd = -1;
+        std::atomic<bool> cancelled{false};
+
+        std::mutex mutex;
+        std::map<size_t, Publish> scanned;  // By block number, waiting for earlier blocks
+        size_t publishedBlocks = 0;
+        size_t pendingBlocks = 0;   // Scheduled but not yet published
+
+        std::mutex publishMutex;    // Held while publishing, so blocks go one at a time
+
+        ~Run();
+        void scanBlock(size_t blockNumber, uint64_t firstLine, uint64_t rows, uint64_t startByte, uint64_t endByte);
+        void publishReady();
+    };
+
+    std::shared_ptr<Run> m_run;
+    uint64_t m_scheduledLines = 0;
+    bool m_allScheduled = false;
+};
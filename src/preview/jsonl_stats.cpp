@@ -0,0 +1,353 @@
+#include "jsonl_stats.h"
+#include "json_format.h"
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cmath>
+#include <functional>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace {
+
+uint64_t hashValue(std::string_view value) {
+    // Finish with splitmix64 so every bit of the hash is usable
+    uint64_t h = std::hash<std::string_view>{}(value);
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebull;
+    h ^= h >> 31;
+    return h;
+}
+
+// Distinct count estimate in 2^BITS bytes (about 3% error at BITS = 10)
+class HyperLogLog {
+public:
+    static constexpr int BITS = 10;
+    static constexpr size_t REGISTERS = size_t(1) << BITS;
+
+    void add(uint64_t hash) {
+        size_t index = static_cast<size_t>(hash >> (64 - BITS));
+        uint64_t rest = hash << BITS;
+        uint8_t rank = rest == 0 ? 64 - BITS + 1 : static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+        m_registers[index] = std::max(m_registers[index], rank);
+    }
+
+    void merge(const HyperLogLog& other) {
+        for (size_t i = 0; i < REGISTERS; ++i) {
+            m_registers[i] = std::max(m_registers[i], other.m_registers[i]);
+        }
+    }
+
+    uint64_t estimate() const {
+        double sum = 0.0;
+        size_t zeros = 0;
+        for (uint8_t r : m_registers) {
+            sum += std::ldexp(1.0, -static_cast<int>(r));
+            if (r == 0) ++zeros;
+        }
+        const double m = static_cast<double>(REGISTERS);
+        double estimate = 0.7213 / (1.0 + 1.079 / m) * m * m / sum;
+        // Small cardinalities: count the empty registers instead
+        if (estimate <= 2.5 * m && zeros > 0) {
+            estimate = m * std::log(m / static_cast<double>(zeros));
+        }
+        return static_cast<uint64_t>(std::llround(estimate));
+    }
+
+private:
+    std::array<uint8_t, REGISTERS> m_registers{};
+};
+
+// The most frequent values in a fixed number of counters (Space-Saving):
+// an unseen value takes over the smallest counter and inherits its count
+// as the error
+class TopValues {
+public:
+    void add(const std::string& value, uint64_t weight) {
+        auto it = m_index.find(value);
+        if (it != m_index.end()) {
+            m_entries[it->second].count += weight;
+            return;
+        }
+        if (m_entries.size() < JsonlStats::TOP_VALUES) {
+            m_index.emplace(value, m_entries.size());
+            m_entries.push_back({value, weight, 0});
+            return;
+        }
+        size_t slot = 0;
+        for (size_t i = 1; i < m_entries.size(); ++i) {
+            if (m_entries[i].count < m_entries[slot].count) slot = i;
+        }
+        JsonlStats::Field::TopValue& entry = m_entries[slot];
+        m_index.erase(entry.value);
+        m_index.emplace(value, slot);
+        entry.value = value;
+        entry.error = entry.count;
+        entry.count += weight;
+    }
+
+    // Most frequent first, leaving out counts that are mostly error (what's
+    // left of high-cardinality fields)
+    std::vector<JsonlStats::Field::TopValue> sorted() const {
+        std::vector<JsonlStats::Field::TopValue> out;
+        for (const JsonlStats::Field::TopValue& entry : m_entries) {
+            if (entry.error * 2 < entry.count) out.push_back(entry);
+        }
+        std::sort(out.begin(), out.end(), [](const auto& a, const auto& b) { return a.count > b.count; });
+        return out;
+    }
+
+private:
+    std::vector<JsonlStats::Field::TopValue> m_entries;
+    std::unordered_map<std::string, size_t> m_index;
+};
+
+// Everything about one path except its frequent values
+struct Sketch {
+    uint64_t count = 0;
+    uint64_t types[JsonlStats::TYPE_COUNT] = {};
+    uint64_t lengths[JsonlStats::LENGTH_BUCKETS] = {};
+    uint64_t minLength = UINT64_MAX;
+    uint64_t maxLength = 0;
+    uint64_t totalLength = 0;
+    HyperLogLog distinct;
+
+    void merge(const Sketch& other) {
+        count += other.count;
+        for (int t = 0; t < JsonlStats::TYPE_COUNT; ++t) types[t] += other.types[t];
+        for (int b = 0; b < JsonlStats::LENGTH_BUCKETS; ++b) lengths[b] += other.lengths[b];
+        minLength = std::min(minLength, other.minLength);
+        maxLength = std::max(maxLength, other.maxLength);
+        totalLength += other.totalLength;
+        distinct.merge(other.distinct);
+    }
+};
+
+JsonlStats::ValueType valueType(const JsonProjection::Value& value) {
+    if (value.isString) return JsonlStats::String;
+    switch (value.text.empty() ? '\0' : value.text[0]) {
+        case '{': return JsonlStats::Object;
+        case '[': return JsonlStats::Array;
+        case 't':
+        case 'f': return JsonlStats::Bool;
+        case 'n': return JsonlStats::Null;
+        default: return JsonlStats::Number;
+    }
+}
+
+int lengthBucket(uint64_t length) {
+    int bucket = 0;
+    while (length > 0 && bucket < JsonlStats::LENGTH_BUCKETS - 1) {
+        length >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+// A value as counted among the frequent ones: one line, at most maxBytes,
+// cut on a UTF-8 boundary
+std::string valueKey(const std::string& value, size_t maxBytes) {
+    size_t len = value.size();
+    if (len > maxBytes) {
+        len = maxBytes;
+        while (len > 0 && (static_cast<unsigned char>(value[len]) & 0xC0) == 0x80) --len;
+    }
+    std::string key = value.substr(0, len);
+    for (char& c : key) {
+        if (static_cast<unsigned char>(c) < 0x20) c = ' ';
+    }
+    return key;
+}
+
+} // namespace
+
+// ============================================================================
+// Run
+// ============================================================================
+
+// Aggregates over one stream; shared with the pool jobs
+struct JsonlStats::Run {
+    JsonProjection projection{std::vector<std::string>{"**"}};
+
+    struct Tracked {
+        std::string path;
+        Sketch sketch;
+        TopValues top;
+    };
+
+    mutable std::mutex mutex;
+    uint64_t records = 0;
+    uint64_t invalid = 0;
+    uint64_t otherFields = 0;
+    uint64_t generation = 0;
+    std::vector<std::unique_ptr<Tracked>> fields;
+    std::unordered_map<std::string, size_t> fieldIndex;
+
+    // Exact within a block, then folded into the run's sketches at once
+    struct BlockField {
+        Sketch sketch;
+        std::unordered_map<std::string, uint64_t> values;
+    };
+    struct Block {
+        std::vector<std::pair<std::string, BlockField>> fields;  // In the order first seen
+        uint64_t records = 0;
+        uint64_t invalid = 0;
+    };
+
+    std::shared_ptr<Block> scanBlock(const JsonlBlockScanner::Lines& lines) const;
+    void fold(Block& block);
+};
+
+std::shared_ptr<JsonlStats::Run::Block> JsonlStats::Run::scanBlock(const JsonlBlockScanner::Lines& lines) const {
+    auto block = std::make_shared<Block>();
+    std::unordered_map<std::string, size_t> blockIndex;
+
+    std::vector<JsonProjection::Value> values;
+    lines.forEach([&](uint64_t, std::string_view line) {
+        if (line.empty())
+            return;
+
+        block->records++;
+        values.clear();
+        if (!projection.extract(line, values)) {
+            block->invalid++;
+            return;
+        }
+
+        for (const JsonProjection::Value& value : values) {
+            auto it = blockIndex.find(value.column);
+            if (it == blockIndex.end()) {
+                it = blockIndex.emplace(value.column, block->fields.size()).first;
+                block->fields.emplace_back(value.column, BlockField());
+            }
+            BlockField& field = block->fields[it->second].second;
+            Sketch& sketch = field.sketch;
+
+            ValueType type = valueType(value);
+            sketch.count++;
+            sketch.types[type]++;
+            if (type == String) {
+                uint64_t chars = 0;
+                for (char c : value.text) {
+                    if ((static_cast<unsigned char>(c) & 0xC0) != 0x80) ++chars;
+                }
+                sketch.lengths[lengthBucket(chars)]++;
+                sketch.minLength = std::min(sketch.minLength, chars);
+                sketch.maxLength = std::max(sketch.maxLength, chars);
+                sketch.totalLength += chars;
+            }
+            sketch.distinct.add(hashValue(value.text));
+            if (type != Object && type != Array) {
+                field.values[valueKey(value.text, MAX_VALUE_BYTES)]++;
+            }
+        }
+    });
+    return block;
+}
+
+void JsonlStats::Run::fold(Block& block) {
+    std::lock_guard<std::mutex> lock(mutex);
+    records += block.records;
+    invalid += block.invalid;
+    for (auto& [path, field] : block.fields) {
+        auto it = fieldIndex.find(path);
+        if (it == fieldIndex.end()) {
+            if (fields.size() >= MAX_FIELDS) {
+                otherFields += field.sketch.count;
+                continue;
+            }
+            it = fieldIndex.emplace(path, fields.size()).first;
+            fields.push_back(std::make_unique<Tracked>());
+            fields.back()->path = path;
+        }
+        Tracked& tracked = *fields[it->second];
+        tracked.sketch.merge(field.sketch);
+        for (const auto& [value, count] : field.values) {
+            tracked.top.add(value, count);
+        }
+    }
+    generation++;
+}
+
+// ============================================================================
+// JsonlStats
+// ============================================================================
+
+JsonlStats::~JsonlStats() {
+    reset();
+}
+
+const char* JsonlStats::typeName(ValueType type) {
+    switch (type) {
+        case Object: return "object";
+        case Array: return "array";
+        case String: return "string";
+        case Number: return "number";
+        case Bool: return "bool";
+        case Null: return "null";
+        default: return "?";
+    }
+}
+
+void JsonlStats::start(std::shared_ptr<StreamingFilePreview> source) {
+    reset();
+    if (!source)
+        return;
+    m_source = source;
+
+    auto run = std::make_shared<Run>();
+    bool started = m_scanner.start(source, "JsonlStats", [run](const JsonlBlockScanner::Lines& lines) {
+        std::shared_ptr<Run::Block> block = run->scanBlock(lines);
+        return JsonlBlockScanner::Publish([run, block] { run->fold(*block); });
+    });
+    if (started)
+        m_run = std::move(run);
+}
+
+void JsonlStats::reset() {
+    // Jobs still running finish on their own and drop their results
+    m_scanner.reset();
+    m_run.reset();
+    m_source.reset();
+}
+
+void JsonlStats::update() {
+    m_scanner.update();
+}
+
+bool JsonlStats::isBusy() const {
+    return m_run && m_scanner.isBusy();
+}
+
+uint64_t JsonlStats::generation() const {
+    if (!m_run) return 0;
+    std::lock_guard<std::mutex> lock(m_run->mutex);
+    return m_run->generation;
+}
+
+void JsonlStats::snapshot(Summary& out) const {
+    out = Summary();
+    if (!m_run) return;
+    std::lock_guard<std::mutex> lock(m_run->mutex);
+    out.records = m_run->records;
+    out.invalid = m_run->invalid;
+    out.otherFields = m_run->otherFields;
+    out.fields.reserve(m_run->fields.size());
+    for (const auto& tracked : m_run->fields) {
+        const Sketch& sketch = tracked->sketch;
+        Field field;
+        field.path = tracked->path;
+        field.count = sketch.count;
+        std::copy(std::begin(sketch.types), std::end(sketch.types), field.types);
+        std::copy(std::begin(sketch.lengths), std::end(sketch.lengths), field.lengths);
+        field.distinct = sketch.distinct.estimate();
+        field.minLength = sketch.types[String] > 0 ? sketch.minLength : 0;
+        field.maxLength = sketch.maxLength;
+        field.totalLength = sketch.totalLength;
+        field.top = tracked->top.sorted();
+        out.fields.push_back(std::move(field));
+    }
+}
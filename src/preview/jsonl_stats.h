@@ -0,0 +1,88 @@
+#pragma once
+
+#include "jsonl_scanner.h"
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <cstdint>
+
+class StreamingFilePreview;
+
+// Running aggregates over every record of a JSONL stream, for checking a
+// dataset without reading it: how often each key path is present, the
+// types its values have, roughly how many distinct values it takes, its
+// most common values and how long its strings are.
+// Complete lines are scanned on the shared thread pool in blocks as the
+// stream arrives (see JsonlBlockScanner) and folded, in stream order, into
+// fixed-size sketches (HyperLogLog for
+// distinct counts, Space-Saving for frequent values), so memory stays
+// bounded however large the file is.
+// The UI thread drives it; pool threads scan blocks.
+class JsonlStats {
+public:
+    JsonlStats() = default;
+    ~JsonlStats();
+
+    JsonlStats(const JsonlStats&) = delete;
+    JsonlStats& operator=(const JsonlStats&) = delete;
+
+    void start(std::shared_ptr<StreamingFilePreview> source);
+    void reset();
+
+    // Hand newly complete lines to the pool (call each frame)
+    void update();
+
+    const std::shared_ptr<StreamingFilePreview>& source() const { return m_source; }
+
+    // Whether lines are still being scanned or downloaded
+    bool isBusy() const;
+
+    enum ValueType { Object, Array, String, Number, Bool, Null, TYPE_COUNT };
+    static const char* typeName(ValueType type);
+
+    // String lengths in characters, by power of two: bucket 0 holds empty
+    // strings, bucket b lengths in [2^(b-1), 2^b)
+    static constexpr int LENGTH_BUCKETS = 33;
+
+    struct Field {
+        std::string path;
+        uint64_t count = 0;  // Records that have it
+        uint64_t types[TYPE_COUNT] = {};
+        uint64_t distinct = 0;  // Estimated distinct values
+        uint64_t lengths[LENGTH_BUCKETS] = {};
+        uint64_t minLength = 0;
+        uint64_t maxLength = 0;
+        uint64_t totalLength = 0;  // Of all strings, for the mean
+        // Most common values with their counts, which overestimate by at
+        // most the paired error; none for fields where no value stands out
+        struct TopValue {
+            std::string value;
+            uint64_t count;
+            uint64_t error;
+        };
+        std::vector<TopValue> top;
+    };
+
+    struct Summary {
+        uint64_t records = 0;  // Non-empty lines scanned
+        uint64_t invalid = 0;  // Of those, not valid JSON
+        uint64_t otherFields = 0;  // Values of paths past MAX_FIELDS, not tracked
+        std::vector<Field> fields;  // In the order paths first appear in the stream
+    };
+
+    // Bumped whenever more lines have been folded in
+    uint64_t generation() const;
+    void snapshot(Summary& out) const;
+
+    static constexpr size_t MAX_FIELDS = 1024;
+    static constexpr size_t TOP_VALUES = 64;         // Space-Saving counters per field
+    static constexpr size_t MAX_VALUE_BYTES = 64;    // Longer values are counted by prefix
+
+private:
+    struct Run;
+
+    std::shared_ptr<StreamingFilePreview> m_source;
+    JsonlBlockScanner m_scanner;
+    std::shared_ptr<Run> m_run;
+};
@@ -0,0 +1,178 @@
+#include "jsonl_table.h"
+#include <algorithm>
+
+namespace {
+
+// Append a value as one line of at most maxBytes, cut on a UTF-8 boundary
+void appendCell(std::string& out, const std::string& value, size_t maxBytes) {
+    size_t len = value.size();
+    if (len > maxBytes) {
+        len = maxBytes;
+        while (len > 0 && (static_cast<unsigned char>(value[len]) & 0xC0) == 0x80) --len;
+    }
+    for (size_t i = 0; i < len; ++i) {
+        char c = value[i];
+        out += static_cast<unsigned char>(c) < 0x20 ? ' ' : c;
+    }
+}
+
+std::vector<std::string> splitColumns(const std::string& columns) {
+    std::vector<std::string> specs;
+    size_t pos = 0;
+    while (pos <= columns.size()) {
+        size_t comma = columns.find(',', pos);
+        if (comma == std::string::npos) comma = columns.size();
+        size_t b = columns.find_first_not_of(" \t", pos);
+        size_t e = columns.find_last_not_of(" \t", comma == 0 ? 0 : comma - 1);
+        if (b != std::string::npos && b < comma && e != std::string::npos && e >= b) {
+            specs.push_back(columns.substr(b, e - b + 1));
+        }
+        pos = comma + 1;
+    }
+    return specs;
+}
+
+} // namespace
+
+// ============================================================================
+// Run
+// ============================================================================
+
+std::shared_ptr<JsonlTable::Block> JsonlTable::Run::extractBlock(const JsonlBlockScanner::Lines& lines) const {
+    uint64_t rows = lines.rows();
+    auto block = std::make_shared<Block>();
+    block->rows = rows;
+    block->invalid.assign(rows, false);
+
+    std::vector<JsonProjection::Value> values;
+    lines.forEach([&](uint64_t row, std::string_view line) {
+        values.clear();
+        if (!line.empty() && !projection->extract(line, values)) {
+            block->invalid[row] = true;
+            values.clear();
+        }
+
+        for (const JsonProjection::Value& value : values) {
+            auto it = std::find(block->names.begin(), block->names.end(), value.column);
+            size_t c = static_cast<size_t>(it - block->names.begin());
+            if (it == block->names.end()) {
+                block->names.push_back(value.column);
+                block->columns.emplace_back();
+            }
+            Column& column = block->columns[c];
+            if (column.ends.size() > row)
+                continue;  // Same path picked twice
+            column.ends.resize(row, static_cast<uint32_t>(column.bytes.size()));
+            appendCell(column.bytes, value.text, MAX_CELL_BYTES);
+            column.ends.push_back(static_cast<uint32_t>(column.bytes.size()));
+        }
+    });
+
+    for (Column& column : block->columns) {
+        column.ends.resize(rows, static_cast<uint32_t>(column.bytes.size()));
+    }
+    return block;
+}
+
+void JsonlTable::Run::publish(std::shared_ptr<Block> block) {
+    // Blocks arrive in order, so columns are numbered in the order their
+    // paths first appear in the stream
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Map the block's columns onto the table's, adding new paths at the end
+    std::vector<size_t> tableColumns;
+    for (const std::string& name : block->names) {
+        auto it = columnIndex.find(name);
+        if (it == columnIndex.end()) {
+            it = columnIndex.emplace(name, columns.size()).first;
+            columns.push_back(name);
+        }
+        tableColumns.push_back(it->second);
+    }
+    block->columnOf.assign(columns.size(), -1);
+    for (size_t c = 0; c < tableColumns.size(); ++c) {
+        block->columnOf[tableColumns[c]] = static_cast<int>(c);
+    }
+
+    readyRows += block->rows;
+    blocks.push_back(std::move(block));
+}
+
+// ============================================================================
+// JsonlTable
+// ============================================================================
+
+JsonlTable::~JsonlTable() {
+    reset();
+}
+
+void JsonlTable::start(std::shared_ptr<StreamingFilePreview> source, const std::string& columns) {
+    reset();
+    if (!source)
+        return;
+    m_source = source;
+
+    auto run = std::make_shared<Run>();
+    run->projection = std::make_unique<JsonProjection>(splitColumns(columns));
+    bool started = m_scanner.start(source, "JsonlTable", [run](const JsonlBlockScanner::Lines& lines) {
+        std::shared_ptr<Block> block = run->extractBlock(lines);
+        return JsonlBlockScanner::Publish([run, block] { run->publish(block); });
+    });
+    if (started)
+        m_run = std::move(run);
+}
+
+void JsonlTable::reset() {
+    // Jobs still running finish on their own and drop their blocks
+    m_scanner.reset();
+    m_run.reset();
+    m_source.reset();
+}
+
+void JsonlTable::update() {
+    m_scanner.update();
+}
+
+uint64_t JsonlTable::rowCount() const {
+    if (!m_run) return 0;
+    std::lock_guard<std::mutex> lock(m_run->mutex);
+    return m_run->readyRows;
+}
+
+bool JsonlTable::isBusy() const {
+    return m_run && m_scanner.isBusy();
+}
+
+size_t JsonlTable::columnCount() const {
+    if (!m_run) return 0;
+    std::lock_guard<std::mutex> lock(m_run->mutex);
+    return m_run->columns.size();
+}
+
+std::string JsonlTable::columnName(size_t column) const {
+    if (!m_run) return "";
+    std::lock_guard<std::mutex> lock(m_run->mutex);
+    return column < m_run->columns.size() ? m_run->columns[column] : "";
+}
+
+bool JsonlTable::isValidRow(uint64_t row) const {
+    if (!m_run) return false;
+    std::lock_guard<std::mutex> lock(m_run->mutex);
+    if (row >= m_run->readyRows) return false;
+    const Block& block = *m_run->blocks[static_cast<size_t>(row / BLOCK_ROWS)];
+    return !block.invalid[static_cast<size_t>(row % BLOCK_ROWS)];
+}
+
+void JsonlTable::cell(uint64_t row, size_t column, std::string& out) const {
+    out.clear();
+    if (!m_run) return;
+    std::lock_guard<std::mutex> lock(m_run->mutex);
+    if (row >= m_run->readyRows) return;
+
+    const Block& block = *m_run->blocks[static_cast<size_t>(row / BLOCK_ROWS)];
+    if (column >= block.columnOf.size() || block.columnOf[column] < 0) return;
+    const Column& values = block.columns[static_cast<size_t>(block.columnOf[column])];
+    size_t i = static_cast<size_t>(row % BLOCK_ROWS);
+    uint32_t begin = i > 0 ? values.ends[i - 1] : 0;
+    out.assign(values.bytes, begin, values.ends[i] - begin);
+}
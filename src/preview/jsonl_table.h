@@ -0,0 +1,88 @@
+#pragma once
+
+#include "json_format.h"
+#include "jsonl_scanner.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+class StreamingFilePreview;
+
+// Chosen JSON paths of every record in a JSONL stream, for showing records
+// side by side. Complete lines are extracted on the shared thread pool in
+// blocks of BLOCK_ROWS as the stream arrives (see JsonlBlockScanner), and
+// each block stores its values column by column (one byte buffer plus end
+// offsets per column). A block becomes visible once it and every block
+// before it are done, so the visible rows are always a prefix of the stream.
+// The UI thread drives it; pool threads fill blocks.
+class JsonlTable {
+public:
+    JsonlTable() = default;
+    ~JsonlTable();
+
+    JsonlTable(const JsonlTable&) = delete;
+    JsonlTable& operator=(const JsonlTable&) = delete;
+
+    // Start over on a stream; columns is a comma-separated list of
+    // JsonProjection specs, e.g. "id, metadata.*, len(text)"
+    void start(std::shared_ptr<StreamingFilePreview> source, const std::string& columns);
+    void reset();
+
+    // Hand newly complete lines to the pool (call each frame)
+    void update();
+
+    const std::shared_ptr<StreamingFilePreview>& source() const { return m_source; }
+
+    // Rows ready to show, and whether more are coming
+    uint64_t rowCount() const;
+    bool isBusy() const;
+
+    // Columns in the order their paths first appear in the stream
+    size_t columnCount() const;
+    std::string columnName(size_t column) const;
+
+    // False if the row's line isn't valid JSON
+    bool isValidRow(uint64_t row) const;
+
+    // Value of a cell, truncated to MAX_CELL_BYTES on one line; empty if the
+    // record has nothing at that path
+    void cell(uint64_t row, size_t column, std::string& out) const;
+
+    static constexpr uint64_t BLOCK_ROWS = JsonlBlockScanner::BLOCK_ROWS;
+    static constexpr size_t MAX_CELL_BYTES = 256;
+
+private:
+    struct Column {
+        std::string bytes;          // Values back to back
+        std::vector<uint32_t> ends; // End of each row's value in bytes
+    };
+
+    struct Block {
+        uint64_t rows = 0;
+        std::vector<std::string> names;  // Block-local columns
+        std::vector<Column> columns;
+        std::vector<bool> invalid;
+        std::vector<int> columnOf;       // Table column -> block column, or -1
+    };
+
+    // Rows extracted from one stream; shared with the pool jobs
+    struct Run {
+        std::unique_ptr<JsonProjection> projection;
+
+        mutable std::mutex mutex;
+        std::vector<std::string> columns;
+        std::unordered_map<std::string, size_t> columnIndex;
+        std::vector<std::shared_ptr<Block>> blocks;  // Published, in order
+        uint64_t readyRows = 0;
+
+        std::shared_ptr<Block> extractBlock(const JsonlBlockScanner::Lines& lines) const;
+        void publish(std::shared_ptr<Block> block);
+    };
+
+    std::shared_ptr<StreamingFilePreview> m_source;
+    JsonlBlockScanner m_scanner;
+    std::shared_ptr<Run> m_run;
+};
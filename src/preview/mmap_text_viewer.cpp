@@ -1,5 +1,7 @@
 #include "mmap_text_viewer.h"
 #include "streaming_preview.h"
+#include "line_index.h"
+#include "text_buffer.h"
 #include "imgui/imgui.h"
 
 #include <sys/mman.h>
@@ -10,6 +12,23 @@
 #include <algorithm>
 #include <cmath>
 
+namespace {
+
+uint64_t pageSize() {
+    static const uint64_t size = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+uint64_t pageFloor(uint64_t offset) {
+    return offset & ~(pageSize() - 1);
+}
+
+uint64_t pageCeil(uint64_t offset) {
+    return pageFloor(offset + pageSize() - 1);
+}
+
+} // namespace
+
 MmapTextViewer::MmapTextViewer() = default;
 
 MmapTextViewer::~MmapTextViewer() {
@@ -23,6 +42,7 @@ void MmapTextViewer::open(std::shared_ptr<StreamingFilePreview> source) {
         return;
 
     m_source = std::move(source);
+    m_lineIndex = m_source->lineIndex();
     const std::string& path = m_source->tempFilePath();
     if (path.empty())
         return;
@@ -30,71 +50,137 @@ void MmapTextViewer::open(std::shared_ptr<StreamingFilePreview> source) {
     m_fd = ::open(path.c_str(), O_RDONLY);
     if (m_fd < 0)
         return;
+    m_path = path;
 
     uint64_t size = m_source->bytesWritten();
     m_fileSize = size;
 
     if (m_fileSize == 0) {
         // Valid but empty so far - will get data on refresh
-        m_lineOffsets.push_back(0);
+        m_lineCount = 1;
         return;
     }
 
-    m_mapBase = mmap(nullptr, m_fileSize, PROT_READ, MAP_PRIVATE, m_fd, 0);
-    if (m_mapBase == MAP_FAILED) {
-        m_mapBase = nullptr;
-        ::close(m_fd);
-        m_fd = -1;
+    if (!growMapping(m_fileSize)) {
+        close();
         return;
     }
 
-    madvise(m_mapBase, m_fileSize, MADV_RANDOM);
-
-    // Index newlines synchronously
-    m_lineOffsets.push_back(0);
-    indexNewlinesFrom(0);
+    // The source has already indexed everything it wrote
+    updateLineCount(m_fileSize);
 }
 
-void MmapTextViewer::refresh() {
-    if (!m_source || m_fd < 0)
-        return;
+void MmapTextViewer::open(std::shared_ptr<const TextBuffer> buffer) {
+    close();
 
-    uint64_t newSize = m_source->bytesWritten();
-    if (newSize <= m_fileSize)
+    if (!buffer)
         return;
 
-    // Unmap old mapping
-    if (m_mapBase && m_mapBase != MAP_FAILED) {
-        munmap(m_mapBase, m_fileSize);
-        m_mapBase = nullptr;
+    m_buffer = std::move(buffer);
+    m_lineIndex = m_buffer->lineIndex();
+    m_fileSize = m_buffer->size();
+    updateLineCount(m_fileSize);
+}
+
+bool MmapTextViewer::open(const std::string& path) {
+    close();
+
+    m_fd = ::open(path.c_str(), O_RDONLY);
+    if (m_fd < 0)
+        return false;
+    m_path = path;
+
+    struct stat st;
+    if (fstat(m_fd, &st) != 0) {
+        close();
+        return false;
     }
+    m_fileSize = static_cast<uint64_t>(st.st_size);
 
-    uint64_t oldSize = m_fileSize;
-    m_fileSize = newSize;
+    auto index = std::make_shared<LineIndex>();
+    m_lineIndex = index;
+    m_lineCount = 1;
 
-    m_mapBase = mmap(nullptr, m_fileSize, PROT_READ, MAP_PRIVATE, m_fd, 0);
-    if (m_mapBase == MAP_FAILED) {
-        m_mapBase = nullptr;
-        return;
+    if (m_fileSize == 0)
+        return true;
+
+    if (!growMapping(m_fileSize)) {
+        close();
+        return false;
     }
 
-    madvise(m_mapBase, m_fileSize, MADV_RANDOM);
+    m_indexThread = std::thread(&MmapTextViewer::indexFile, this, std::move(index),
+                                static_cast<const char*>(m_mapBase), m_fileSize);
+    return true;
+}
+
+void MmapTextViewer::indexFile(std::shared_ptr<LineIndex> index, const char* base, uint64_t size) {
+    // Runs on m_indexThread; close() joins it before unmapping base
+    std::vector<uint64_t> starts;
+    for (uint64_t pos = 0; pos < size && !m_stopIndexer.load(std::memory_order_relaxed);) {
+        uint64_t len = std::min(INDEX_CHUNK_BYTES, size - pos);
 
-    // If this is the first data (was empty before), add initial line offset
-    if (oldSize == 0 && m_lineOffsets.empty()) {
-        m_lineOffsets.push_back(0);
+        // Have the next chunk read in while this one is scanned
+        if (pos + len < size) {
+            madvise(const_cast<char*>(base) + pos + len,
+                    std::min(INDEX_CHUNK_BYTES, size - pos - len), MADV_WILLNEED);
+        }
+
+        starts.clear();
+        findNewlines(base + pos, len, pos, starts);
+        index->append(starts);
+        pos += len;
+        m_indexerBytes.store(pos, std::memory_order_release);
     }
+}
 
-    // Index newlines from where we left off
-    indexNewlinesFrom(oldSize);
+void MmapTextViewer::syncIndexProgress() {
+    if (!m_indexThread.joinable())
+        return;
+
+    uint64_t indexed = m_indexerBytes.load(std::memory_order_acquire);
+    if (indexed != m_indexedSize)
+        updateLineCount(indexed);
+
+    // Done: the join is immediate
+    if (indexed >= m_fileSize)
+        m_indexThread.join();
+}
+
+bool MmapTextViewer::isIndexing() const {
+    return m_indexThread.joinable();
+}
+
+float MmapTextViewer::indexProgress() const {
+    if (m_fileSize == 0)
+        return 1.0f;
+    return static_cast<float>(static_cast<double>(m_indexedSize) / static_cast<double>(m_fileSize));
+}
+
+uint64_t MmapTextViewer::estimatedLineCount() const {
+    if (m_indexedSize == 0 || m_indexedSize >= m_fileSize)
+        return m_lineCount;
+    return static_cast<uint64_t>(static_cast<double>(m_lineCount) *
+                                 static_cast<double>(m_fileSize) / static_cast<double>(m_indexedSize));
+}
 
-    // Invalidate wrap cache for the last line (it may have grown)
-    if (!m_wrapCache.empty() && !m_lineOffsets.empty()) {
-        uint64_t lastLine = m_lineOffsets.size() - 1;
-        // Remove any cached wrap info for the last line at any width
+bool MmapTextViewer::isComplete() const {
+    if (m_source)
+        return m_source->isComplete() && m_indexedSize >= m_source->bytesWritten();
+    return !m_indexThread.joinable();
+}
+
+void MmapTextViewer::updateLineCount(uint64_t indexedSize) {
+    uint64_t oldLastLine = m_lineCount > 0 ? m_lineCount - 1 : 0;
+    m_indexedSize = indexedSize;
+    m_lineCount = m_lineIndex->linesBefore(indexedSize);
+
+    // Invalidate wrap cache for the previous last line (it may have grown)
+    if (!m_wrapCache.empty()) {
+        // Remove any cached wrap info for that line at any width
         auto it = m_wrapCache.begin();
         while (it != m_wrapCache.end()) {
-            if (it->first.line == lastLine) {
+            if (it->first.line == oldLastLine) {
                 it = m_wrapCache.erase(it);
             } else {
                 ++it;
@@ -103,20 +189,135 @@ void MmapTextViewer::refresh() {
     }
 }
 
+void MmapTextViewer::refresh() {
+    if (!m_source || m_fd < 0)
+        return;
+
+    uint64_t newSize = m_source->bytesWritten();
+    if (newSize <= m_fileSize)
+        return;
+
+    // Map just the new bytes; on failure keep showing what's mapped
+    if (!growMapping(newSize)) {
+        if (!m_mapBase)
+            m_fileSize = m_indexedSize = 0;
+        return;
+    }
+
+    m_fileSize = newSize;
+
+    // Pick up the lines the source indexed since the last refresh
+    updateLineCount(m_fileSize);
+}
+
+bool MmapTextViewer::growMapping(uint64_t newSize) {
+    if (newSize > m_reservedBytes) {
+        // First data, or outgrew the reservation: reserve address space (no
+        // memory) for far more than the file needs so later growth is in place
+        if (m_mapBase) {
+            m_wrapRows.stop();
+            munmap(m_mapBase, m_reservedBytes);
+        }
+        m_mapBase = nullptr;
+        m_reservedBytes = 0;
+        m_mappedBytes = 0;
+        m_advisedStart = m_advisedEnd = 0;
+        m_sequentialAccess = false;
+
+        uint64_t reserve = std::max(VIRTUAL_RESERVE_BYTES, pageCeil(newSize) * 2);
+        void* base = mmap(nullptr, reserve, PROT_NONE, MAP_PRIVATE | MAP_ANON, -1, 0);
+        if (base == MAP_FAILED)
+            return false;
+        m_mapBase = base;
+        m_reservedBytes = reserve;
+    }
+
+    // Map from the page holding the old end (it may have been partial) over
+    // the reservation. MAP_SHARED so bytes the source appends to a mapped
+    // page show up without remapping it.
+    uint64_t from = pageFloor(m_mappedBytes);
+    uint64_t to = pageCeil(newSize);
+    if (to > from) {
+        char* at = static_cast<char*>(m_mapBase) + from;
+        void* mapped = mmap(at, to - from, PROT_READ, MAP_SHARED | MAP_FIXED, m_fd, static_cast<off_t>(from));
+        if (mapped == MAP_FAILED) {
+            if (from == 0) {
+                // Nothing usable is mapped; drop the reservation
+                munmap(m_mapBase, m_reservedBytes);
+                m_mapBase = nullptr;
+                m_reservedBytes = 0;
+            }
+            return false;
+        }
+        if (m_sequentialAccess)
+            madvise(at, to - from, MADV_SEQUENTIAL);
+    }
+    m_mappedBytes = newSize;
+    return true;
+}
+
+void MmapTextViewer::adviseViewport(uint64_t firstLine, uint64_t lastLine) {
+    if (!m_mapBase || m_fileSize == 0 || m_lineCount == 0)
+        return;
+
+    uint64_t start, end, unused;
+    lastLine = std::min(lastLine, m_lineCount - 1);
+    if (!m_lineIndex->lineRange(firstLine, m_indexedSize, start, unused) ||
+        !m_lineIndex->lineRange(lastLine, m_indexedSize, unused, end))
+        return;
+
+    // Still within what was prefetched last time
+    if (start >= m_advisedStart && end <= m_advisedEnd)
+        return;
+
+    // Scrolling on past the prefetched range reads the file front to back,
+    // so let the kernel read ahead hard; after a jump readahead is wasted I/O
+    bool sequential = start >= m_advisedStart && start < m_advisedEnd;
+    if (sequential != m_sequentialAccess) {
+        m_sequentialAccess = sequential;
+        madvise(m_mapBase, pageCeil(m_mappedBytes), sequential ? MADV_SEQUENTIAL : MADV_NORMAL);
+    }
+
+    // Prefetch the visible bytes plus a screenful (at least
+    // VIEWPORT_PREFETCH_BYTES) either side
+    uint64_t margin = std::max(end - start, VIEWPORT_PREFETCH_BYTES);
+    m_advisedStart = start > margin ? start - margin : 0;
+    m_advisedEnd = std::min(end + margin, m_fileSize);
+    uint64_t from = pageFloor(m_advisedStart);
+    madvise(static_cast<char*>(m_mapBase) + from, pageCeil(m_advisedEnd) - from, MADV_WILLNEED);
+}
+
 void MmapTextViewer::close() {
-    if (m_mapBase && m_mapBase != MAP_FAILED) {
-        munmap(m_mapBase, m_fileSize);
+    // The indexer reads the mapping, so stop it first
+    if (m_indexThread.joinable()) {
+        m_stopIndexer = true;
+        m_indexThread.join();
+    }
+    m_stopIndexer = false;
+    m_indexerBytes = 0;
+    m_wrapRows.stop();
+    m_search.clear();
+
+    if (m_mapBase) {
+        munmap(m_mapBase, m_reservedBytes);
         m_mapBase = nullptr;
     }
+    m_reservedBytes = 0;
+    m_mappedBytes = 0;
+    m_advisedStart = m_advisedEnd = 0;
+    m_sequentialAccess = false;
     if (m_fd >= 0) {
         ::close(m_fd);
         m_fd = -1;
     }
 
     m_source.reset();
+    m_path.clear();
+    m_buffer.reset();
+    m_lineIndex.reset();
     m_fileSize = 0;
-    m_lineOffsets.clear();
-    m_indexedBytes = 0;
+    m_lineCount = 0;
+    m_indexedSize = 0;
     m_anchorLine = 0;
     m_anchorSubRow = 0;
     m_smoothOffsetY = 0.0f;
@@ -124,12 +325,11 @@ void MmapTextViewer::close() {
     m_selectionActive = false;
     m_mouseDown = false;
     m_scrollbarDragging = false;
-    m_avgVisualRows = 1.0f;
-    m_avgVisualRowsSampleLine = 0;
+    m_hasCurrentMatch = false;
 }
 
 bool MmapTextViewer::isOpen() const {
-    return m_fd >= 0;
+    return m_fd >= 0 || m_buffer;
 }
 
 uint64_t MmapTextViewer::fileSize() const {
@@ -137,7 +337,7 @@ uint64_t MmapTextViewer::fileSize() const {
 }
 
 uint64_t MmapTextViewer::lineCount() const {
-    return m_lineOffsets.size();
+    return m_lineCount;
 }
 
 void MmapTextViewer::setWordWrap(bool enabled) {
@@ -161,9 +361,48 @@ void MmapTextViewer::scrollToTop() {
 void MmapTextViewer::scrollToBottom() {
     uint64_t lc = lineCount();
     if (lc == 0) return;
-    m_anchorLine = (lc > 100) ? lc - 100 : 0;
-    m_anchorSubRow = 0;
     m_smoothOffsetY = 0.0f;
+
+    if (!m_wordWrap) {
+        m_anchorLine = lc > m_visibleRows ? lc - m_visibleRows : 0;
+        m_anchorSubRow = 0;
+        return;
+    }
+
+    // Counted rows up to the last line (which may still be growing, so
+    // m_wrapRows leaves it out), plus that line's own
+    uint64_t lastLine = lc - 1;
+    uint64_t rowsBefore;
+    uint32_t lastRows = computeWrapInfo(lastLine, m_lastWrapWidth).visualRowCount;
+    if (m_wrapRows.rowsBefore(lastLine, rowsBefore)) {
+        uint64_t total = rowsBefore + lastRows;
+        uint64_t target = total > m_visibleRows ? total - m_visibleRows : 0;
+        uint64_t line;
+        uint32_t subRow;
+        if (target >= rowsBefore) {
+            m_anchorLine = lastLine;
+            m_anchorSubRow = static_cast<uint32_t>(target - rowsBefore);
+            return;
+        }
+        if (m_wrapRows.findRow(target, line, subRow)) {
+            m_anchorLine = line;
+            m_anchorSubRow = subRow;
+            return;
+        }
+    }
+
+    // Not counted that far yet: wrap lines back from the end until the view
+    // is full
+    uint64_t line = lastLine;
+    uint64_t need = m_visibleRows;
+    uint32_t rows = lastRows;
+    while (rows < need && line > 0) {
+        need -= rows;
+        --line;
+        rows = computeWrapInfo(line, m_lastWrapWidth).visualRowCount;
+    }
+    m_anchorLine = line;
+    m_anchorSubRow = rows > need ? static_cast<uint32_t>(rows - need) : 0;
 }
 
 void MmapTextViewer::scrollToLine(uint64_t line) {
@@ -174,47 +413,20 @@ void MmapTextViewer::scrollToLine(uint64_t line) {
     m_smoothOffsetY = 0.0f;
 }
 
-void MmapTextViewer::indexNewlinesFrom(uint64_t fromByte) {
-    if (!m_mapBase || m_fileSize == 0)
-        return;
-
-    const char* base = static_cast<const char*>(m_mapBase);
-    uint64_t pos = fromByte;
-
-    while (pos < m_fileSize) {
-        const void* found = memchr(base + pos, '\n', m_fileSize - pos);
-        if (!found)
-            break;
-
-        uint64_t nlPos = static_cast<uint64_t>(static_cast<const char*>(found) - base);
-        uint64_t nextLineStart = nlPos + 1;
-
-        if (nextLineStart < m_fileSize) {
-            m_lineOffsets.push_back(nextLineStart);
-        }
-
-        pos = nextLineStart;
-    }
-
-    m_indexedBytes = m_fileSize;
+const char* MmapTextViewer::bytes() const {
+    return m_buffer ? m_buffer->data() : static_cast<const char*>(m_mapBase);
 }
 
 MmapTextViewer::LineData MmapTextViewer::getLineData(uint64_t lineIndex) const {
-    const char* base = static_cast<const char*>(m_mapBase);
+    const char* base = bytes();
     if (!base) return {nullptr, 0};
 
-    uint64_t lc = m_lineOffsets.size();
-    if (lineIndex >= lc)
+    if (lineIndex >= m_lineCount)
         return {nullptr, 0};
 
-    uint64_t start = m_lineOffsets[lineIndex];
-
-    uint64_t end;
-    if (lineIndex + 1 < lc) {
-        end = m_lineOffsets[lineIndex + 1];
-    } else {
-        end = m_fileSize;
-    }
+    uint64_t start, end;
+    if (!m_lineIndex->lineRange(lineIndex, m_indexedSize, start, end))
+        return {nullptr, 0};
 
     // Strip trailing \n and \r
     while (end > start && (base[end - 1] == '\n' || base[end - 1] == '\r'))
@@ -232,86 +444,96 @@ MmapTextViewer::WrapInfo MmapTextViewer::computeWrapInfo(uint64_t lineIndex, flo
     if (!ld.ptr || ld.length == 0)
         return info;
 
-    ImFontBaked* font = ImGui::GetFontBaked();
-    float x = 0.0f;
-    uint32_t lastBreakOffset = 0;
     uint32_t lineLen = static_cast<uint32_t>(std::min(ld.length, static_cast<uint64_t>(MAX_DISPLAY_LINE_BYTES)));
+    info.visualRowCount = wrapLine(ld.ptr, lineLen, wrapWidth, m_charAdvances, &info.rowStartOffsets);
+    return info;
+}
 
-    uint32_t i = 0;
-    while (i < lineLen) {
-        // Decode UTF-8 character
-        unsigned int c = 0;
-        int charBytes = 1;
-        unsigned char ch = static_cast<unsigned char>(ld.ptr[i]);
-        if (ch < 0x80) {
-            c = ch;
-        } else if (ch < 0xE0 && i + 1 < lineLen) {
-            c = ch;
-            charBytes = 2;
-        } else if (ch < 0xF0 && i + 2 < lineLen) {
-            c = ch;
-            charBytes = 3;
-        } else if (i + 3 < lineLen) {
-            c = ch;
-            charBytes = 4;
+void MmapTextViewer::syncWrapRows(float wrapWidth) {
+    // Glyph advances only change with the font, so read them once per font
+    ImFontBaked* font = ImGui::GetFontBaked();
+    if (font != m_advancesFont) {
+        for (int c = 0; c < 256; ++c) {
+            m_charAdvances[c] = font->GetCharAdvance(static_cast<ImWchar>(c));
         }
+        m_advancesFont = font;
+    }
 
-        float charWidth = font->GetCharAdvance(static_cast<ImWchar>(c));
-
-        if (x + charWidth > wrapWidth && x > 0.0f) {
-            uint32_t breakAt = i;
-
-            if (lastBreakOffset > info.rowStartOffsets.back()) {
-                breakAt = lastBreakOffset;
-            }
-
-            info.rowStartOffsets.push_back(breakAt);
-            info.visualRowCount++;
-            x = 0.0f;
-
-            if (breakAt < i) {
-                i = breakAt;
-                continue;
-            }
-        }
+    if (!m_wordWrap || wrapWidth <= 0.0f || !bytes()) {
+        m_wrapRows.setWidth(0.0f, m_charAdvances);
+        return;
+    }
 
-        if (c == ' ' || c == '\t' || c == '-' || c == '/' || c == '\\' || c == ',' || c == ';') {
-            lastBreakOffset = i + static_cast<uint32_t>(charBytes);
-        }
+    m_wrapRows.setSource(bytes(), m_lineIndex);
+    m_wrapRows.setWidth(wrapWidth, m_charAdvances);
+    m_wrapRows.setExtent(m_lineCount, m_indexedSize, isComplete());
+}
 
-        x += charWidth;
-        i += static_cast<uint32_t>(charBytes);
-    }
+double MmapTextViewer::totalVisualRows() const {
+    uint64_t totalLines = estimatedLineCount();
+    if (!m_wordWrap)
+        return static_cast<double>(totalLines);
 
-    return info;
+    uint64_t lines, rows;
+    m_wrapRows.counted(lines, rows);
+    double avg = lines > 0 ? static_cast<double>(rows) / static_cast<double>(lines) : 1.0;
+    return static_cast<double>(rows) + static_cast<double>(totalLines > lines ? totalLines - lines : 0) * avg;
 }
 
-float MmapTextViewer::estimateAverageVisualRowsPerLine() {
+double MmapTextViewer::visualRowOf(uint64_t line, uint32_t subRow) const {
     if (!m_wordWrap)
-        return 1.0f;
+        return static_cast<double>(line);
 
-    uint64_t lc = lineCount();
-    if (lc == 0)
-        return 1.0f;
+    uint64_t rowsBefore;
+    if (m_wrapRows.rowsBefore(line, rowsBefore))
+        return static_cast<double>(rowsBefore + subRow);
 
-    uint64_t sampleCount = std::min(lc, static_cast<uint64_t>(1000));
-    float totalRows = 0.0f;
+    uint64_t lines, rows;
+    m_wrapRows.counted(lines, rows);
+    double avg = lines > 0 ? static_cast<double>(rows) / static_cast<double>(lines) : 1.0;
+    return static_cast<double>(rows) + static_cast<double>(line - lines) * avg + subRow;
+}
+
+void MmapTextViewer::scrollToVisualRow(double row) {
+    row = std::max(row, 0.0);
+    if (!m_wordWrap) {
+        scrollToLine(static_cast<uint64_t>(row));
+        return;
+    }
 
-    for (uint64_t i = 0; i < sampleCount; ++i) {
-        uint64_t idx = (i * lc) / sampleCount;
-        WrapInfo wi = computeWrapInfo(idx, m_lastWrapWidth);
-        totalRows += wi.visualRowCount;
+    uint64_t line;
+    uint32_t subRow;
+    if (m_wrapRows.findRow(static_cast<uint64_t>(row), line, subRow) && line < lineCount()) {
+        m_anchorLine = line;
+        m_anchorSubRow = subRow;
+        m_smoothOffsetY = 0.0f;
+        return;
     }
 
-    m_avgVisualRows = totalRows / static_cast<float>(sampleCount);
-    m_avgVisualRowsSampleLine = lc;
-    return m_avgVisualRows;
+    // Past what's been counted: extrapolate from the average so far
+    uint64_t lines, rows;
+    m_wrapRows.counted(lines, rows);
+    double avg = lines > 0 ? static_cast<double>(rows) / static_cast<double>(lines) : 1.0;
+    scrollToLine(lines + static_cast<uint64_t>((row - static_cast<double>(rows)) / avg));
 }
 
 void MmapTextViewer::scrollByVisualRows(int64_t rows) {
     uint64_t lc = lineCount();
     if (lc == 0) return;
 
+    // Jump straight there if the rows are counted; otherwise step line by line
+    uint64_t rowsBefore;
+    if (m_wordWrap && m_wrapRows.rowsBefore(m_anchorLine, rowsBefore)) {
+        int64_t target = std::max<int64_t>(0, static_cast<int64_t>(rowsBefore + m_anchorSubRow) + rows);
+        uint64_t line;
+        uint32_t subRow;
+        if (m_wrapRows.findRow(static_cast<uint64_t>(target), line, subRow) && line < lc) {
+            m_anchorLine = line;
+            m_anchorSubRow = subRow;
+            return;
+        }
+    }
+
     if (rows > 0) {
         for (int64_t r = 0; r < rows; ++r) {
             if (m_wordWrap) {
@@ -350,14 +572,13 @@ void MmapTextViewer::scrollByVisualRows(int64_t rows) {
     }
 }
 
-void MmapTextViewer::renderScrollbar(float x, float y, float height, float totalLines) {
+void MmapTextViewer::renderScrollbar(float x, float y, float height) {
     ImDrawList* dl = ImGui::GetWindowDrawList();
-    float avg = m_wordWrap ? m_avgVisualRows : 1.0f;
-    float totalVisualRows = totalLines * avg;
+    double totalRows = totalVisualRows();
     float lineHeight = ImGui::GetTextLineHeightWithSpacing();
     float viewportRows = height / lineHeight;
 
-    if (totalVisualRows <= viewportRows) {
+    if (totalRows <= viewportRows) {
         dl->AddRectFilled(ImVec2(x, y), ImVec2(x + SCROLLBAR_WIDTH, y + height),
                           IM_COL32(30, 30, 30, 255));
         return;
@@ -366,10 +587,11 @@ void MmapTextViewer::renderScrollbar(float x, float y, float height, float total
     dl->AddRectFilled(ImVec2(x, y), ImVec2(x + SCROLLBAR_WIDTH, y + height),
                       IM_COL32(30, 30, 30, 255));
 
-    float thumbRatio = viewportRows / totalVisualRows;
+    float thumbRatio = static_cast<float>(viewportRows / totalRows);
     float thumbH = std::max(20.0f, height * thumbRatio);
-    float currentVisualRow = static_cast<float>(m_anchorLine) * avg + m_anchorSubRow;
-    float scrollFraction = currentVisualRow / (totalVisualRows - viewportRows);
+    double scrollableRows = totalRows - viewportRows;
+    double currentRow = visualRowOf(m_anchorLine, m_anchorSubRow);
+    float scrollFraction = static_cast<float>(currentRow / scrollableRows);
     scrollFraction = std::clamp(scrollFraction, 0.0f, 1.0f);
     float thumbY = y + scrollFraction * (height - thumbH);
 
@@ -384,8 +606,7 @@ void MmapTextViewer::renderScrollbar(float x, float y, float height, float total
             m_scrollbarDragStartY = mousePos.y - thumbY;
         } else {
             float clickFraction = (mousePos.y - y) / height;
-            uint64_t targetLine = static_cast<uint64_t>(clickFraction * totalLines);
-            scrollToLine(targetLine);
+            scrollToVisualRow(clickFraction * totalRows);
             m_scrollbarDragging = true;
             m_scrollbarDragStartY = thumbH * 0.5f;
         }
@@ -396,8 +617,7 @@ void MmapTextViewer::renderScrollbar(float x, float y, float height, float total
             float newThumbY = mousePos.y - m_scrollbarDragStartY;
             float newFraction = (newThumbY - y) / (height - thumbH);
             newFraction = std::clamp(newFraction, 0.0f, 1.0f);
-            uint64_t targetLine = static_cast<uint64_t>(newFraction * (totalLines > 0 ? totalLines - 1 : 0));
-            scrollToLine(targetLine);
+            scrollToVisualRow(newFraction * scrollableRows);
         } else {
             m_scrollbarDragging = false;
         }
@@ -410,6 +630,104 @@ void MmapTextViewer::renderScrollbar(float x, float y, float height, float total
                       thumbColor, 4.0f);
 }
 
+void MmapTextViewer::openSearch() {
+    m_searchOpen = true;
+    m_focusSearchInput = true;
+}
+
+void MmapTextViewer::closeSearch() {
+    m_searchOpen = false;
+    m_hasCurrentMatch = false;
+    m_search.setQuery(SearchQuery());
+}
+
+void MmapTextViewer::renderSearchBar(float width) {
+    ImGuiIO& io = ImGui::GetIO();
+
+    ImGui::SetNextItemWidth(std::min(260.0f, width * 0.4f));
+    if (m_focusSearchInput) {
+        ImGui::SetKeyboardFocusHere();
+        m_focusSearchInput = false;
+    }
+    bool enter = ImGui::InputTextWithHint("##search", "Find", m_searchBuf, sizeof(m_searchBuf),
+                                          ImGuiInputTextFlags_EnterReturnsTrue);
+    bool escape = ImGui::IsItemDeactivated() && ImGui::IsKeyPressed(ImGuiKey_Escape);
+    if (enter) {
+        // Keep typing focus so Enter steps through matches
+        ImGui::SetKeyboardFocusHere(-1);
+    }
+
+    ImGui::SameLine();
+    ImGui::Checkbox("Aa", &m_searchCaseSensitive);
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Match case");
+    ImGui::SameLine();
+    ImGui::Checkbox(".*", &m_searchRegex);
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Regular expression");
+
+    SearchQuery query;
+    query.pattern = m_searchBuf;
+    query.caseSensitive = m_searchCaseSensitive;
+    query.regex = m_searchRegex;
+    if (query != m_search.query())
+        m_hasCurrentMatch = false;
+    m_search.setQuery(query);
+    if (m_buffer)
+        m_search.setSource(m_buffer);
+    else
+        m_search.setSource(m_path, m_lineIndex);
+    m_search.setExtent(m_lineCount, m_indexedSize, isComplete());
+
+    ImGui::SameLine();
+    bool prev = ImGui::ArrowButton("##prev_match", ImGuiDir_Up);
+    ImGui::SameLine();
+    bool next = ImGui::ArrowButton("##next_match", ImGuiDir_Down);
+    if (prev || (enter && io.KeyShift))
+        jumpToMatch(false);
+    else if (next || enter)
+        jumpToMatch(true);
+
+    ImGui::SameLine();
+    if (!m_search.error().empty()) {
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", m_search.error().c_str());
+    } else if (!query.pattern.empty()) {
+        size_t count = m_search.matchCount();
+        const char* more = m_search.isTruncated() ? "+" : "";
+        if (m_hasCurrentMatch) {
+            ImGui::Text("%zu of %zu%s", m_search.matchesBefore(m_currentMatch.offset) + 1, count, more);
+        } else {
+            ImGui::Text("%zu%s match%s", count, more, count == 1 ? "" : "es");
+        }
+        if (m_search.isSearching()) {
+            ImGui::SameLine();
+            ImGui::TextColored(ImVec4(0.5f, 0.5f, 0.5f, 1.0f), "(searching...)");
+        }
+    }
+
+    ImGui::SameLine();
+    if (ImGui::SmallButton("x##close_search") || escape)
+        closeSearch();
+}
+
+void MmapTextViewer::jumpToMatch(bool forward) {
+    // Step from the current match, or start from the top of the view
+    uint64_t from = 0;
+    if (m_hasCurrentMatch) {
+        from = forward ? m_currentMatch.offset + 1 : m_currentMatch.offset;
+    } else {
+        from = m_lineIndex->lineStart(m_anchorLine);
+    }
+
+    SearchMatch match;
+    if (!(forward ? m_search.nextMatch(from, match) : m_search.prevMatch(from, match)))
+        return;
+
+    m_currentMatch = match;
+    m_hasCurrentMatch = true;
+
+    uint64_t line = m_lineIndex->linesBefore(match.offset + 1) - 1;
+    scrollToLine(line > SEARCH_CONTEXT_LINES ? line - SEARCH_CONTEXT_LINES : 0);
+}
+
 TextPosition MmapTextViewer::hitTest(float mouseX, float mouseY, float /*startX*/, float startY, float textX, float lineHeight) const {
     TextPosition result;
     uint64_t lc = lineCount();
@@ -577,6 +895,9 @@ void MmapTextViewer::render(float width, float height) {
         return;
     }
 
+    // Never waits: takes whatever the indexer has finished so far
+    syncIndexProgress();
+
     if (m_fileSize == 0) {
         ImGui::TextColored(ImVec4(0.5f, 0.5f, 0.5f, 1.0f), "(empty file)");
         ImGui::PopID();
@@ -593,6 +914,7 @@ void MmapTextViewer::render(float width, float height) {
     float lineHeight = ImGui::GetTextLineHeightWithSpacing();
     float textAreaWidth = width - LINE_NUMBER_GUTTER_WIDTH - SCROLLBAR_WIDTH;
     m_lastWrapWidth = textAreaWidth;
+    syncWrapRows(textAreaWidth);
 
     // Clear wrap cache if width changed significantly
     if (!m_wrapCache.empty()) {
@@ -602,6 +924,14 @@ void MmapTextViewer::render(float width, float height) {
         }
     }
 
+    if (m_searchOpen) {
+        float barTop = ImGui::GetCursorPosY();
+        renderSearchBar(width);
+        height -= ImGui::GetCursorPosY() - barTop;
+        if (height <= lineHeight) { ImGui::PopID(); return; }
+    }
+    m_visibleRows = std::max<uint64_t>(1, static_cast<uint64_t>(height / lineHeight));
+
     // Handle input
     ImGuiIO& io = ImGui::GetIO();
     ImVec2 windowPos = ImGui::GetCursorScreenPos();
@@ -631,11 +961,10 @@ void MmapTextViewer::render(float width, float height) {
         if (ImGui::IsKeyPressed(ImGuiKey_UpArrow))
             scrollByVisualRows(-1);
 
-        int visibleRows = static_cast<int>(height / lineHeight);
         if (ImGui::IsKeyPressed(ImGuiKey_PageDown))
-            scrollByVisualRows(visibleRows);
+            scrollByVisualRows(static_cast<int64_t>(m_visibleRows));
         if (ImGui::IsKeyPressed(ImGuiKey_PageUp))
-            scrollByVisualRows(-visibleRows);
+            scrollByVisualRows(-static_cast<int64_t>(m_visibleRows));
 
         if (ImGui::IsKeyPressed(ImGuiKey_Home))
             scrollToTop();
@@ -645,6 +974,11 @@ void MmapTextViewer::render(float width, float height) {
         if (m_selectionActive && ImGui::IsKeyPressed(ImGuiKey_C) && (io.KeySuper || io.KeyCtrl)) {
             copySelection();
         }
+
+        if (ImGui::IsKeyPressed(ImGuiKey_F) && (io.KeySuper || io.KeyCtrl))
+            openSearch();
+        if (m_searchOpen && ImGui::IsKeyPressed(ImGuiKey_Escape))
+            closeSearch();
     }
 
     if (mouseInTextArea && ImGui::IsMouseClicked(ImGuiMouseButton_Right)) {
@@ -715,11 +1049,32 @@ void MmapTextViewer::render(float width, float height) {
     };
 
     ImU32 selColor = IM_COL32(60, 100, 180, 128);
+    ImU32 matchColor = IM_COL32(180, 140, 40, 110);
+    ImU32 currentMatchColor = IM_COL32(240, 150, 30, 200);
+
+    // Search matches within [rowStart, rowEnd) of a line, in m_lineMatches
+    const char* base = bytes();
+    bool highlightMatches = m_searchOpen && m_search.matchCount() > 0;
+    auto drawMatches = [&](const LineData& ld, uint32_t rowStart, uint32_t rowEnd, float y) {
+        uint64_t lineOffset = static_cast<uint64_t>(ld.ptr - base);
+        for (const SearchMatch& match : m_lineMatches) {
+            uint64_t mStart = std::max(match.offset, lineOffset + rowStart);
+            uint64_t mEnd = std::min(match.offset + match.length, lineOffset + rowEnd);
+            if (mEnd <= mStart) continue;
+            float x0 = textX + computeXForOffset(ld.ptr, rowStart, static_cast<uint32_t>(mStart - lineOffset));
+            float x1 = textX + computeXForOffset(ld.ptr, rowStart, static_cast<uint32_t>(mEnd - lineOffset));
+            bool current = m_hasCurrentMatch && match.offset == m_currentMatch.offset;
+            dl->AddRectFilled(ImVec2(x0, y), ImVec2(x1, y + lineHeight),
+                              current ? currentMatchColor : matchColor);
+        }
+    };
 
     // Clip text rendering to exclude scrollbar area
     dl->PushClipRect(ImVec2(startX, startY),
                      ImVec2(startX + width - SCROLLBAR_WIDTH, startY + height), true);
 
+    adviseViewport(m_anchorLine, m_anchorLine + static_cast<uint64_t>(height / lineHeight) + 1);
+
     // Render lines
     float cursorY = startY;
     uint64_t currentLine = m_anchorLine;
@@ -731,6 +1086,11 @@ void MmapTextViewer::render(float width, float height) {
 
     while (cursorY < startY + height && currentLine < lc) {
         LineData ld = getLineData(currentLine);
+        m_lineMatches.clear();
+        if (highlightMatches && ld.ptr) {
+            uint64_t lineOffset = static_cast<uint64_t>(ld.ptr - base);
+            m_search.matchesIn(lineOffset, lineOffset + std::min(ld.length, MAX_DISPLAY_LINE_BYTES), m_lineMatches);
+        }
 
         if (m_wordWrap && textAreaWidth > 0.0f) {
             WrapCacheKey key{currentLine, textAreaWidth};
@@ -773,6 +1133,10 @@ void MmapTextViewer::render(float width, float height) {
                     }
                 }
 
+                if (!m_lineMatches.empty()) {
+                    drawMatches(ld, rowStart, rowEnd, cursorY);
+                }
+
                 if (ld.ptr && rowEnd > rowStart) {
                     dl->AddText(ImVec2(textX, cursorY), textColor,
                                 ld.ptr + rowStart, ld.ptr + rowEnd);
@@ -806,6 +1170,10 @@ void MmapTextViewer::render(float width, float height) {
                 }
             }
 
+            if (!m_lineMatches.empty()) {
+                drawMatches(ld, 0, static_cast<uint32_t>(displayLen), cursorY);
+            }
+
             if (ld.ptr && ld.length > 0) {
                 dl->AddText(ImVec2(textX, cursorY), textColor,
                             ld.ptr, ld.ptr + displayLen);
@@ -820,10 +1188,7 @@ void MmapTextViewer::render(float width, float height) {
     dl->PopClipRect();
 
     // Scrollbar
-    if (m_wordWrap && m_avgVisualRowsSampleLine != lc) {
-        estimateAverageVisualRowsPerLine();
-    }
-    renderScrollbar(startX + width - SCROLLBAR_WIDTH, startY, height, static_cast<float>(lc));
+    renderScrollbar(startX + width - SCROLLBAR_WIDTH, startY, height);
 
     ImGui::PopID();
 }
@@ -4,9 +4,16 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <atomic>
+#include <thread>
 #include <cstdint>
 
+#include "wrap_row_index.h"
+#include "text_search.h"
+
 class StreamingFilePreview;
+class TextBuffer;
+class LineIndex;
 
 struct TextPosition {
     uint64_t line = 0;
@@ -27,6 +34,13 @@ public:
     // Open from a StreamingFilePreview (mmaps its temp file)
     void open(std::shared_ptr<StreamingFilePreview> source);
 
+    // Show text already in memory (nothing to map or index)
+    void open(std::shared_ptr<const TextBuffer> buffer);
+
+    // Open a local file: maps it whole and indexes its lines on a background
+    // thread. Lines become viewable as soon as their part of the file is indexed.
+    bool open(const std::string& path);
+
     // Refresh mapping if source has new data (call each frame while streaming)
     void refresh();
 
@@ -35,15 +49,24 @@ public:
     uint64_t fileSize() const;
     uint64_t lineCount() const;
 
+    // Still indexing a file opened by path, and how far along (0-1)
+    bool isIndexing() const;
+    float indexProgress() const;
+
     void render(float width, float height);
 
     void setWordWrap(bool enabled);
     bool wordWrap() const;
 
     void scrollToTop();
+    // Last line at the bottom of the view, as of the last frame's height
     void scrollToBottom();
     void scrollToLine(uint64_t line);
 
+    // Search bar (also opened with Cmd/Ctrl+F while the viewer has focus)
+    void openSearch();
+    void closeSearch();
+
 private:
     // Line data access - returns pointer into mmap and length
     struct LineData {
@@ -52,8 +75,27 @@ private:
     };
     LineData getLineData(uint64_t lineIndex) const;
 
-    // Newline indexing (synchronous, called in open/refresh)
-    void indexNewlinesFrom(uint64_t fromByte);
+    // Start of the text: the mapping, or the in-memory buffer
+    const char* bytes() const;
+
+    // Map file bytes up to newSize, extending the mapping in place
+    bool growMapping(uint64_t newSize);
+
+    // Page-cache hints for the bytes around the visible lines
+    void adviseViewport(uint64_t firstLine, uint64_t lastLine);
+
+    // Background indexing of a file opened by path
+    void indexFile(std::shared_ptr<LineIndex> index, const char* base, uint64_t size);
+    void syncIndexProgress();
+
+    // Take in the lines of the first indexedSize bytes
+    void updateLineCount(uint64_t indexedSize);
+
+    // Line count to size the scrollbar for; extrapolated while indexing
+    uint64_t estimatedLineCount() const;
+
+    // Everything is indexed and the file won't grow any more
+    bool isComplete() const;
 
     // Word wrap
     struct WrapInfo {
@@ -79,34 +121,67 @@ private:
 
     WrapInfo computeWrapInfo(uint64_t lineIndex, float wrapWidth) const;
 
+    // Keep m_wrapRows counting for the current width, font and extent
+    void syncWrapRows(float wrapWidth);
+
+    // Position in visual rows (wrapped rows with word wrap, else lines);
+    // exact where m_wrapRows has counted, extrapolated beyond
+    double totalVisualRows() const;
+    double visualRowOf(uint64_t line, uint32_t subRow) const;
+    void scrollToVisualRow(double row);
+
     // Scrollbar
-    void renderScrollbar(float x, float y, float height, float totalLines);
-    float estimateAverageVisualRowsPerLine();
+    void renderScrollbar(float x, float y, float height);
+
+    // Search
+    void renderSearchBar(float width);
+    void jumpToMatch(bool forward);
 
     // Scroll helpers
     void scrollByVisualRows(int64_t rows);
 
     // Data source
     std::shared_ptr<StreamingFilePreview> m_source;
+    std::string m_path;  // File being shown (the source's temp file when streaming)
+    std::shared_ptr<const TextBuffer> m_buffer;  // Or the text in memory
 
-    // File mapping
+    // File mapping: a PROT_NONE reservation that the file is mapped into
+    // piece by piece as it grows, so m_mapBase stays put while streaming
     int m_fd = -1;
     void* m_mapBase = nullptr;
+    uint64_t m_reservedBytes = 0;
+    uint64_t m_mappedBytes = 0;
     uint64_t m_fileSize = 0;
 
-    // Newline index
-    std::vector<uint64_t> m_lineOffsets;
-    uint64_t m_indexedBytes = 0;
+    // Byte range last passed to MADV_WILLNEED, and whether the mapping is
+    // marked MADV_SEQUENTIAL (scrolling forward) rather than MADV_NORMAL
+    uint64_t m_advisedStart = 0;
+    uint64_t m_advisedEnd = 0;
+    bool m_sequentialAccess = false;
+
+    // Newline index, shared with the source (which builds it as it writes)
+    // or filled by m_indexThread for a file opened by path
+    std::shared_ptr<const LineIndex> m_lineIndex;
+    uint64_t m_lineCount = 0;    // Lines within the first m_indexedSize bytes
+    uint64_t m_indexedSize = 0;  // m_fileSize, except while m_indexThread runs
+
+    std::thread m_indexThread;
+    std::atomic<uint64_t> m_indexerBytes{0};  // Bytes the indexer has finished
+    std::atomic<bool> m_stopIndexer{false};
 
     // Scroll state
     uint64_t m_anchorLine = 0;
     uint32_t m_anchorSubRow = 0;
     float m_smoothOffsetY = 0.0f;
+    uint64_t m_visibleRows = 1;  // Whole rows in the text area last frame
 
     // Word wrap
     bool m_wordWrap = false;
     mutable std::unordered_map<WrapCacheKey, WrapInfo, WrapCacheKeyHash> m_wrapCache;
     float m_lastWrapWidth = 0.0f;
+    WrapRowIndex m_wrapRows;
+    CharAdvances m_charAdvances{};
+    const void* m_advancesFont = nullptr;  // Font m_charAdvances was read from
 
     // Selection
     TextPosition hitTest(float mouseX, float mouseY, float startX, float startY, float textX, float lineHeight) const;
@@ -122,12 +197,23 @@ private:
     bool m_scrollbarDragging = false;
     float m_scrollbarDragStartY = 0.0f;
 
-    // Cached estimate
-    float m_avgVisualRows = 1.0f;
-    uint64_t m_avgVisualRowsSampleLine = 0;
+    // Search; the query is kept across files
+    TextSearch m_search;
+    bool m_searchOpen = false;
+    bool m_focusSearchInput = false;
+    char m_searchBuf[256] = {};
+    bool m_searchCaseSensitive = false;
+    bool m_searchRegex = false;
+    bool m_hasCurrentMatch = false;
+    SearchMatch m_currentMatch;
+    std::vector<SearchMatch> m_lineMatches;  // Scratch for highlighting
 
     static constexpr uint64_t MAX_DISPLAY_LINE_BYTES = 65536;
+    static constexpr uint64_t VIRTUAL_RESERVE_BYTES = 64ULL * 1024 * 1024 * 1024;
+    static constexpr uint64_t VIEWPORT_PREFETCH_BYTES = 1024 * 1024;
+    static constexpr uint64_t INDEX_CHUNK_BYTES = 1024 * 1024;
     static constexpr float LINE_NUMBER_GUTTER_WIDTH = 60.0f;
     static constexpr float SCROLLBAR_WIDTH = 14.0f;
     static constexpr size_t WRAP_CACHE_MAX_SIZE = 4096;
+    static constexpr uint64_t SEARCH_CONTEXT_LINES = 3;  // Shown above a match jumped to
 };
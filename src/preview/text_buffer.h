@@ -0,0 +1,33 @@
+#pragma once
+
+#include "line_index.h"
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Text held in memory together with its line index, for showing derived
+// content (formatted JSON, extracted fields) in a viewer without writing it
+// to a temp file first. Immutable once built, so viewers and searches can
+// share it freely.
+class TextBuffer {
+public:
+    explicit TextBuffer(std::string text) : m_text(std::move(text)) {
+        auto index = std::make_shared<LineIndex>();
+        std::vector<uint64_t> starts;
+        findNewlines(m_text.data(), m_text.size(), 0, starts);
+        index->append(starts);
+        m_lineIndex = std::move(index);
+    }
+
+    TextBuffer(const TextBuffer&) = delete;
+    TextBuffer& operator=(const TextBuffer&) = delete;
+
+    const char* data() const { return m_text.data(); }
+    uint64_t size() const { return m_text.size(); }
+    std::shared_ptr<const LineIndex> lineIndex() const { return m_lineIndex; }
+
+private:
+    std::string m_text;
+    std::shared_ptr<const LineIndex> m_lineIndex;
+};
@@ -12,8 +12,12 @@ bool TextPreviewRenderer::canHandle(const std::string& /*key*/) const {
 void TextPreviewRenderer::render(const PreviewContext& ctx) {
     ImGui::Text("Preview: %s", ctx.filename.c_str());
 
-    // Show streaming progress if active
-    if (ctx.streamingPreview && !ctx.streamingPreview->isComplete()) {
+    // Show streaming progress if active, or why it stopped
+    std::string streamError = ctx.streamingPreview ? ctx.streamingPreview->error() : std::string();
+    if (!streamError.empty()) {
+        ImGui::SameLine();
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), " (%s)", streamError.c_str());
+    } else if (ctx.streamingPreview && !ctx.streamingPreview->isComplete()) {
         float progress = static_cast<float>(ctx.streamingPreview->bytesDownloaded()) /
                          static_cast<float>(ctx.streamingPreview->totalSourceBytes());
         ImGui::SameLine();
@@ -0,0 +1,420 @@
+#include "text_search.h"
+#include "line_index.h"
+#include "text_buffer.h"
+#include "thread_pool.h"
+#include "loguru.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// Don't start a chunk for fewer bytes than this while the file still grows
+constexpr uint64_t MIN_STREAMING_CHUNK_BYTES = 1024 * 1024;
+
+// Chunks queued or being searched per pool thread; bounds memory held by
+// their read buffers and leaves the pool free for other work
+constexpr size_t CHUNKS_IN_FLIGHT_PER_THREAD = 2;
+
+// Matches kept per search; past this the count is reported as a lower bound
+constexpr size_t MAX_MATCHES = 4 * 1024 * 1024;
+
+// std::regex recurses per character, so very long lines are only searched
+// this far
+constexpr size_t MAX_REGEX_LINE_BYTES = 64 * 1024;
+
+void toLowerAscii(char* data, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        char c = data[i];
+        if (c >= 'A' && c <= 'Z') data[i] = static_cast<char>(c - 'A' + 'a');
+    }
+}
+
+} // namespace
+
+void findAllLiteral(const char* data, size_t len, const std::string& needle,
+                    uint64_t baseOffset, std::vector<SearchMatch>& out) {
+    const size_t m = needle.size();
+    if (m == 0 || len < m)
+        return;
+
+    const char* n = needle.data();
+    size_t next = 0;  // Matches don't overlap
+    auto check = [&](size_t pos) {
+        if (pos >= next && memcmp(data + pos, n, m) == 0) {
+            out.push_back({baseOffset + pos, static_cast<uint32_t>(m)});
+            next = pos + m;
+        }
+    };
+
+    size_t pos = 0;
+#if defined(__x86_64__)
+    const __m128i first = _mm_set1_epi8(n[0]);
+    const __m128i last = _mm_set1_epi8(n[m - 1]);
+    for (; pos + m - 1 + 16 <= len; pos += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + m - 1));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last))));
+        while (mask) {
+            check(pos + static_cast<size_t>(__builtin_ctz(mask)));
+            mask &= mask - 1;
+        }
+    }
+#elif defined(__aarch64__)
+    // One nibble per byte, as in findNewlines
+    const uint8x16_t first = vdupq_n_u8(static_cast<uint8_t>(n[0]));
+    const uint8x16_t last = vdupq_n_u8(static_cast<uint8_t>(n[m - 1]));
+    for (; pos + m - 1 + 16 <= len; pos += 16) {
+        uint8x16_t a = vld1q_u8(reinterpret_cast<const uint8_t*>(data + pos));
+        uint8x16_t b = vld1q_u8(reinterpret_cast<const uint8_t*>(data + pos + m - 1));
+        uint8x16_t eq = vandq_u8(vceqq_u8(a, first), vceqq_u8(b, last));
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(
+            vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+        while (mask) {
+            int bit = __builtin_ctzll(mask);
+            check(pos + static_cast<size_t>(bit >> 2));
+            mask &= ~(0xFull << (bit & ~3));
+        }
+    }
+#endif
+    for (; pos + m <= len; ++pos) {
+        if (data[pos] == n[0]) check(pos);
+    }
+}
+
+// ============================================================================
+// Run
+// ============================================================================
+
+TextSearch::Run::~Run() {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+void TextSearch::Run::searchChunk(uint64_t start, uint64_t end) {
+    std::vector<SearchMatch> matches;
+
+    std::string buffer;
+    if (text) {
+        end = std::min(end, text->size());
+        if (start < end && !cancelled.load(std::memory_order_relaxed))
+            buffer.assign(text->data() + start, end - start);
+    } else if (!cancelled.load(std::memory_order_relaxed)) {
+        buffer.resize(end - start);
+        size_t done = 0;
+        while (done < buffer.size()) {
+            ssize_t n = pread(fd, &buffer[done], buffer.size() - done, static_cast<off_t>(start + done));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                LOG_F(WARNING, "TextSearch: read at %llu failed: %s",
+                      static_cast<unsigned long long>(start + done), n < 0 ? strerror(errno) : "end of file");
+                break;
+            }
+            done += static_cast<size_t>(n);
+        }
+        buffer.resize(done);
+    }
+
+    if (!buffer.empty() && !query.regex) {
+        if (!query.caseSensitive) {
+            toLowerAscii(&buffer[0], buffer.size());
+        }
+        findAllLiteral(buffer.data(), buffer.size(), needle, start, matches);
+    } else if (!buffer.empty()) {
+        const char* data = buffer.data();
+        size_t pos = 0;
+        while (pos < buffer.size() && !cancelled.load(std::memory_order_relaxed)) {
+            const void* nl = memchr(data + pos, '\n', buffer.size() - pos);
+            size_t lineEnd = nl ? static_cast<size_t>(static_cast<const char*>(nl) - data) : buffer.size();
+            size_t searchEnd = std::min(lineEnd, pos + MAX_REGEX_LINE_BYTES);
+
+            std::cregex_iterator it(data + pos, data + searchEnd, regex);
+            for (; it != std::cregex_iterator(); ++it) {
+                if (it->length(0) == 0) continue;
+                matches.push_back({start + pos + static_cast<uint64_t>(it->position(0)),
+                                   static_cast<uint32_t>(it->length(0))});
+            }
+            pos = lineEnd + 1;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    pendingChunks--;
+    if (cancelled.load(std::memory_order_relaxed))
+        return;
+    if (matchCount + matches.size() > MAX_MATCHES) {
+        matches.resize(MAX_MATCHES - matchCount);
+        truncated = true;
+    }
+    matchCount += matches.size();
+    chunks[start] = std::move(matches);
+}
+
+void TextSearch::Run::startChunks(const std::shared_ptr<Run>& run) {
+    size_t maxInFlight = CHUNKS_IN_FLIGHT_PER_THREAD * ThreadPool::shared().threadCount();
+
+    std::lock_guard<std::mutex> lock(run->mutex);
+    while (run->scheduledUpTo < run->limit && run->pendingChunks < maxInFlight &&
+           !run->cancelled.load(std::memory_order_relaxed)) {
+        // End the chunk at the first line starting at or after the target
+        uint64_t start = run->scheduledUpTo;
+        uint64_t end = run->limit;
+        if (end - start > CHUNK_BYTES) {
+            size_t line = run->index->linesBefore(start + CHUNK_BYTES);
+            if (line < run->lineCount) {
+                end = std::min(end, run->index->lineStart(line));
+            }
+        }
+
+        run->pendingChunks++;
+        run->scheduledUpTo = end;
+        ThreadPool::shared().submit([run, start, end] {
+            run->searchChunk(start, end);
+            startChunks(run);
+        });
+    }
+}
+
+// ============================================================================
+// TextSearch
+// ============================================================================
+
+TextSearch::~TextSearch() {
+    clear();
+}
+
+void TextSearch::setSource(const std::string& path, std::shared_ptr<const LineIndex> index) {
+    if (path == m_path && index == m_index && !m_buffer)
+        return;
+
+    m_path = path;
+    m_buffer.reset();
+    m_index = std::move(index);
+    m_lineCount = 0;
+    m_indexedSize = 0;
+    m_complete = false;
+    restart();
+}
+
+void TextSearch::setSource(std::shared_ptr<const TextBuffer> buffer) {
+    if (buffer == m_buffer && m_path.empty())
+        return;
+
+    m_path.clear();
+    m_buffer = std::move(buffer);
+    m_index = m_buffer ? m_buffer->lineIndex() : nullptr;
+    m_lineCount = 0;
+    m_indexedSize = 0;
+    m_complete = false;
+    restart();
+}
+
+void TextSearch::setQuery(const SearchQuery& query) {
+    if (query == m_query)
+        return;
+
+    m_query = query;
+    restart();
+}
+
+void TextSearch::setExtent(uint64_t lineCount, uint64_t indexedSize, bool complete) {
+    m_lineCount = lineCount;
+    m_indexedSize = indexedSize;
+    m_complete = complete;
+    schedule();
+}
+
+void TextSearch::clear() {
+    if (m_run) {
+        m_run->cancelled = true;
+        m_run.reset();
+    }
+    m_path.clear();
+    m_buffer.reset();
+    m_index.reset();
+    m_error.clear();
+    m_scheduledUpTo = 0;
+    m_lineCount = 0;
+    m_indexedSize = 0;
+    m_complete = false;
+}
+
+void TextSearch::restart() {
+    // Jobs of the old run finish on their own and drop their results
+    if (m_run) {
+        m_run->cancelled = true;
+        m_run.reset();
+    }
+    m_scheduledUpTo = 0;
+    m_error.clear();
+
+    if (m_query.pattern.empty() || (m_path.empty() && !m_buffer) || !m_index)
+        return;
+
+    auto run = std::make_shared<Run>();
+    run->query = m_query;
+    run->index = m_index;
+    run->text = m_buffer;
+
+    if (m_query.regex) {
+        auto flags = std::regex::ECMAScript | std::regex::optimize;
+        if (!m_query.caseSensitive) flags |= std::regex::icase;
+        try {
+            run->regex = std::regex(m_query.pattern, flags);
+        } catch (const std::regex_error& e) {
+            m_error = std::string("Invalid regex: ") + e.what();
+            return;
+        }
+    } else {
+        run->needle = m_query.pattern;
+        if (!m_query.caseSensitive) {
+            toLowerAscii(&run->needle[0], run->needle.size());
+        }
+    }
+
+    if (!m_buffer)
+        run->fd = open(m_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (!m_buffer && run->fd < 0) {
+        m_error = std::string("Cannot read file: ") + strerror(errno);
+        LOG_F(WARNING, "TextSearch: open %s failed: %s", m_path.c_str(), strerror(errno));
+        return;
+    }
+
+    m_run = std::move(run);
+    schedule();
+}
+
+void TextSearch::schedule() {
+    if (!m_run || m_lineCount == 0)
+        return;
+
+    // Search complete lines only; the last one may still grow
+    uint64_t limit = m_complete ? m_indexedSize : m_index->lineStart(m_lineCount - 1);
+    if (limit <= m_scheduledUpTo)
+        return;
+    if (!m_complete && limit - m_scheduledUpTo < MIN_STREAMING_CHUNK_BYTES)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_run->mutex);
+        m_run->limit = limit;
+        m_run->lineCount = m_lineCount;
+    }
+    m_scheduledUpTo = limit;
+    Run::startChunks(m_run);
+}
+
+size_t TextSearch::matchCount() const {
+    if (!m_run) return 0;
+    std::lock_guard<std::mutex> lock(m_run->mutex);
+    return m_run->matchCount;
+}
+
+bool TextSearch::isTruncated() const {
+    if (!m_run) return false;
+    std::lock_guard<std::mutex> lock(m_run->mutex);
+    return m_run->truncated;
+}
+
+bool TextSearch::isSearching() const {
+    if (!m_run) return false;
+    std::lock_guard<std::mutex> lock(m_run->mutex);
+    return m_run->pendingChunks > 0 || m_run->scheduledUpTo < m_run->limit;
+}
+
+bool TextSearch::nextMatch(uint64_t from, SearchMatch& out) const {
+    if (!m_run) return false;
+    std::lock_guard<std::mutex> lock(m_run->mutex);
+    const auto& chunks = m_run->chunks;
+
+    auto it = chunks.upper_bound(from);
+    if (it != chunks.begin()) --it;
+    for (; it != chunks.end(); ++it) {
+        const auto& matches = it->second;
+        auto m = std::lower_bound(matches.begin(), matches.end(), from,
+            [](const SearchMatch& match, uint64_t offset) { return match.offset < offset; });
+        if (m != matches.end()) {
+            out = *m;
+            return true;
+        }
+    }
+
+    // Wrap around to the first match
+    for (const auto& chunk : chunks) {
+        if (!chunk.second.empty()) {
+            out = chunk.second.front();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TextSearch::prevMatch(uint64_t before, SearchMatch& out) const {
+    if (!m_run) return false;
+    std::lock_guard<std::mutex> lock(m_run->mutex);
+    const auto& chunks = m_run->chunks;
+
+    // Chunks starting at or after the offset only hold later matches
+    auto it = chunks.lower_bound(before);
+    while (it != chunks.begin()) {
+        --it;
+        const auto& matches = it->second;
+        auto m = std::lower_bound(matches.begin(), matches.end(), before,
+            [](const SearchMatch& match, uint64_t offset) { return match.offset < offset; });
+        if (m != matches.begin()) {
+            out = *(m - 1);
+            return true;
+        }
+    }
+
+    // Wrap around to the last match
+    for (auto r = chunks.rbegin(); r != chunks.rend(); ++r) {
+        if (!r->second.empty()) {
+            out = r->second.back();
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t TextSearch::matchesBefore(uint64_t offset) const {
+    if (!m_run) return 0;
+    std::lock_guard<std::mutex> lock(m_run->mutex);
+
+    size_t count = 0;
+    for (const auto& chunk : m_run->chunks) {
+        if (chunk.first >= offset) break;
+        const auto& matches = chunk.second;
+        count += static_cast<size_t>(std::lower_bound(matches.begin(), matches.end(), offset,
+            [](const SearchMatch& match, uint64_t o) { return match.offset < o; }) - matches.begin());
+    }
+    return count;
+}
+
+void TextSearch::matchesIn(uint64_t from, uint64_t to, std::vector<SearchMatch>& out) const {
+    out.clear();
+    if (!m_run) return;
+    std::lock_guard<std::mutex> lock(m_run->mutex);
+    const auto& chunks = m_run->chunks;
+
+    auto it = chunks.upper_bound(from);
+    if (it != chunks.begin()) --it;
+    for (; it != chunks.end() && it->first < to; ++it) {
+        const auto& matches = it->second;
+        auto m = std::lower_bound(matches.begin(), matches.end(), from,
+            [](const SearchMatch& match, uint64_t offset) { return match.offset < offset; });
+        for (; m != matches.end() && m->offset < to; ++m) {
+            out.push_back(*m);
+        }
+    }
+}
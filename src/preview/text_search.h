@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+class LineIndex;
+class TextBuffer;
+
+struct SearchQuery {
+    std::string pattern;
+    bool caseSensitive = false;
+    bool regex = false;
+
+    bool operator==(const SearchQuery& o) const {
+        return pattern == o.pattern && caseSensitive == o.caseSensitive && regex == o.regex;
+    }
+    bool operator!=(const SearchQuery& o) const { return !(*this == o); }
+};
+
+struct SearchMatch {
+    uint64_t offset = 0;  // Byte offset in the file
+    uint32_t length = 0;
+};
+
+// Appends the start of every non-overlapping occurrence of needle in data
+// (plus baseOffset). Vectorized (SSE2 on x86-64, NEON on arm64): candidates
+// are positions where both the first and last byte of needle match.
+void findAllLiteral(const char* data, size_t len, const std::string& needle,
+                    uint64_t baseOffset, std::vector<SearchMatch>& out);
+
+// Full-text (or regex) search over a text file that may still be growing.
+// Complete lines are split into chunks at line boundaries and searched on
+// the shared thread pool. Each search reads the file through its own fd (or
+// shares the in-memory text), so it doesn't depend on the viewer's mapping or
+// the temp file's name.
+// Matches never span lines. Results can be queried while the search runs.
+// Case-insensitive literal search folds ASCII letters only; regex search
+// (std::regex, icase when case-insensitive) looks at the first 64 KB of each
+// line, so later matches on longer lines aren't found.
+// Thread-safe: the UI thread drives it while pool threads add results.
+class TextSearch {
+public:
+    TextSearch() = default;
+    ~TextSearch();
+
+    TextSearch(const TextSearch&) = delete;
+    TextSearch& operator=(const TextSearch&) = delete;
+
+    // File to search and its line index, or text in memory; restarts the search
+    void setSource(const std::string& path, std::shared_ptr<const LineIndex> index);
+    void setSource(std::shared_ptr<const TextBuffer> buffer);
+
+    // Restarts the search if the query changed; an empty pattern clears it
+    void setQuery(const SearchQuery& query);
+    const SearchQuery& query() const { return m_query; }
+
+    // Lines available in the first indexedSize bytes (complete once the file
+    // won't grow). Searches whatever complete lines are new.
+    void setExtent(uint64_t lineCount, uint64_t indexedSize, bool complete);
+
+    // Cancel everything and forget the source
+    void clear();
+
+    // Invalid regex, or "" if the query is fine
+    const std::string& error() const { return m_error; }
+
+    // Matches found so far, and whether chunks are still being searched.
+    // Truncated once the search hit its match limit (the count is a lower bound).
+    size_t matchCount() const;
+    bool isTruncated() const;
+    bool isSearching() const;
+
+    // Nearest match starting at or after / before an offset, wrapping around
+    // the file
+    bool nextMatch(uint64_t from, SearchMatch& out) const;
+    bool prevMatch(uint64_t before, SearchMatch& out) const;
+
+    // Matches found so far that start before a given match (its ordinal)
+    size_t matchesBefore(uint64_t offset) const;
+
+    // Matches starting in [from, to), in order
+    void matchesIn(uint64_t from, uint64_t to, std::vector<SearchMatch>& out) const;
+
+    // Bytes per chunk handed to a pool thread
+    static constexpr uint64_t CHUNK_BYTES = 4 * 1024 * 1024;
+
+private:
+    // One query over one file; shared with the pool jobs searching it
+    struct Run {
+        SearchQuery query;
+        std::string needle;  // Lowercased unless case-sensitive
+        std::regex regex;
+        std::shared_ptr<const LineIndex> index;
+        std::shared_ptr<const TextBuffer> text;  // Read from here if set,
+        int fd = -1;                             // else from the file
+        std::atomic<bool> cancelled{false};
+
+        mutable std::mutex mutex;
+        std::map<uint64_t, std::vector<SearchMatch>> chunks;  // By chunk start offset
+        size_t matchCount = 0;
+        size_t pendingChunks = 0;
+        bool truncated = false;
+        // Complete lines end at limit; chunks up to scheduledUpTo are started,
+        // a few at a time, the next as soon as one finishes
+        uint64_t limit = 0;
+        uint64_t lineCount = 0;
+        uint64_t scheduledUpTo = 0;
+
+        ~Run();
+        void searchChunk(uint64_t start, uint64_t end);
+        static void startChunks(const std::shared_ptr<Run>& run);
+    };
+
+    void restart();
+    void schedule();
+
+    std::string m_path;
+    std::shared_ptr<const TextBuffer> m_buffer;
+    std::shared_ptr<const LineIndex> m_index;
+    SearchQuery m_query;
+    std::string m_error;
+
+    std::shared_ptr<Run> m_run;
+    uint64_t m_scheduledUpTo = 0;  // Bytes handed to the run so far
+    uint64_t m_lineCount = 0;
+    uint64_t m_indexedSize = 0;
+    bool m_complete = false;
+};
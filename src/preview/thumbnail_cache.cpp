@@ -0,0 +1,480 @@
+#include "thumbnail_cache.h"
+#include "image_resize.h"
+#include "../browser_model.h"
+#include "../thread_pool.h"
+#include "stb/stb_image.h"
+#include "loguru.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <climits>
+#include <cstring>
+
+// Platform-specific texture functions (implemented in image_texture_metal.mm or image_texture_opengl.cpp)
+extern "C" bool CreateGPUTexture(unsigned char* pixels, int width, int height, void** outTexture);
+extern "C" bool UpdateGPUTextureRegion(void* texture, int x, int y, int width, int height, unsigned char* pixels);
+extern "C" void DestroyGPUTexture(void* texture);
+
+namespace {
+
+constexpr int CELLS_PER_ROW = ThumbnailCache::ATLAS_PAGE_SIZE / ThumbnailCache::CELL_SIZE;
+constexpr int CELLS_PER_PAGE = CELLS_PER_ROW * CELLS_PER_ROW;
+
+// Larger images aren't decoded just for a thumbnail (about 100 MB of RGBA)
+constexpr int64_t MAX_DECODE_PIXELS = 25 * 1000 * 1000;
+
+bool isJpeg(const std::string& key) {
+    size_t dotPos = key.rfind('.');
+    if (dotPos == std::string::npos) return false;
+    std::string ext = key.substr(dotPos);
+    for (char& c : ext) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return ext == ".jpg" || ext == ".jpeg";
+}
+
+// Where the JPEG thumbnail of a JPEG's EXIF data (IFD1) lies, if within size
+bool findExifThumbnail(const uint8_t* data, size_t size, size_t& offset, size_t& length) {
+    if (size < 4 || data[0] != 0xFF || data[1] != 0xD8) return false;
+
+    size_t pos = 2;
+    while (pos + 4 <= size) {
+        if (data[pos] != 0xFF) return false;
+        uint8_t marker = data[pos + 1];
+        if (marker == 0xFF) {
+            ++pos;  // Fill byte
+            continue;
+        }
+        if (marker == 0xDA || marker == 0xD9) return false;  // Image data; metadata comes before it
+
+        size_t segmentLength = (static_cast<size_t>(data[pos + 2]) << 8) | data[pos + 3];
+        size_t start = pos + 4;
+        size_t end = std::min(pos + 2 + segmentLength, size);
+        pos += 2 + segmentLength;
+        if (marker != 0xE1 || end < start + 14 || memcmp(data + start, "Exif\0\0", 6) != 0) {
+            continue;  // Not EXIF (e.g. JFIF or XMP)
+        }
+
+        // TIFF structure, with offsets from its header
+        const uint8_t* tiff = data + start + 6;
+        size_t tiffSize = end - start - 6;
+        bool little = tiff[0] == 'I' && tiff[1] == 'I';
+        if (!little && !(tiff[0] == 'M' && tiff[1] == 'M')) return false;
+        auto read16 = [&](size_t at) -> uint32_t {
+            return little ? tiff[at] | (tiff[at + 1] << 8) : (tiff[at] << 8) | tiff[at + 1];
+        };
+        auto read32 = [&](size_t at) -> uint32_t {
+            return little ? read16(at) | (read16(at + 2) << 16) : (read16(at) << 16) | read16(at + 2);
+        };
+
+        // IFD0 only leads to IFD1, which describes the thumbnail
+        size_t ifd0 = read32(4);
+        if (ifd0 + 2 > tiffSize) return false;
+        size_t next = ifd0 + 2 + static_cast<size_t>(read16(ifd0)) * 12;
+        if (next + 4 > tiffSize) return false;
+        size_t ifd1 = read32(next);
+        if (ifd1 == 0 || ifd1 + 2 > tiffSize) return false;
+
+        size_t thumbnailOffset = 0;
+        size_t thumbnailLength = 0;
+        size_t count = read16(ifd1);
+        for (size_t i = 0; i < count; ++i) {
+            size_t entry = ifd1 + 2 + i * 12;
+            if (entry + 12 > tiffSize) return false;
+            uint32_t tag = read16(entry);
+            if (tag == 0x0201) thumbnailOffset = read32(entry + 8);  // JPEGInterchangeFormat
+            if (tag == 0x0202) thumbnailLength = read32(entry + 8);  // JPEGInterchangeFormatLength
+        }
+        size_t absolute = static_cast<size_t>(tiff - data) + thumbnailOffset;
+        if (thumbnailOffset == 0 || thumbnailLength < 4 || absolute + thumbnailLength > size ||
+            data[absolute] != 0xFF || data[absolute + 1] != 0xD8) {
+            return false;
+        }
+        offset = absolute;
+        length = thumbnailLength;
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+ThumbnailCache::ThumbnailCache(BrowserModel& model)
+    : m_model(model)
+{
+}
+
+ThumbnailCache::~ThumbnailCache() {
+    clear();
+}
+
+std::string ThumbnailCache::makeKey(const std::string& bucket, const std::string& key) {
+    return bucket + "/" + key;
+}
+
+ThumbnailCache::Thumbnail ThumbnailCache::get(const std::string& bucket, const std::string& key, int64_t size) {
+    auto [it, inserted] = m_entries.try_emplace(makeKey(bucket, key));
+    Entry& entry = it->second;
+    if (inserted) {
+        entry.bucket = bucket;
+        entry.key = key;
+        entry.size = size;
+        if (size <= 0) {
+            entry.state = State::Failed;
+        }
+    }
+    entry.lastUsed = m_frame;
+
+    Thumbnail thumbnail;
+    switch (entry.state) {
+        case State::Wanted:
+            m_wanted.push_back(it->first);
+            break;
+        case State::Ready: {
+            int withinPage = entry.cell % CELLS_PER_PAGE;
+            float page = static_cast<float>(ATLAS_PAGE_SIZE);
+            float x = static_cast<float>((withinPage % CELLS_PER_ROW) * CELL_SIZE + 1);
+            float y = static_cast<float>((withinPage / CELLS_PER_ROW) * CELL_SIZE + 1);
+            thumbnail.texture = m_pages[entry.cell / CELLS_PER_PAGE];
+            thumbnail.u0 = x / page;
+            thumbnail.v0 = y / page;
+            thumbnail.u1 = (x + static_cast<float>(entry.width)) / page;
+            thumbnail.v1 = (y + static_cast<float>(entry.height)) / page;
+            thumbnail.width = entry.width;
+            thumbnail.height = entry.height;
+            break;
+        }
+        case State::Failed:
+            thumbnail.failed = true;
+            break;
+        case State::Fetching:
+        case State::Decoding:
+        case State::Deferred:
+            break;
+    }
+    return thumbnail;
+}
+
+void ThumbnailCache::update() {
+    ++m_frame;
+
+    for (ThumbnailBytes& bytes : m_model.takeThumbnailBytes()) {
+        finishFetch(bytes);
+    }
+
+    // Upload finished decodes, and drop fetches that scrolled out of view
+    std::vector<std::string> decoded;
+    std::vector<std::string> stale;
+    for (const std::string& id : m_busy) {
+        Entry& entry = m_entries[id];
+        if (entry.state == State::Decoding &&
+            entry.decode.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            decoded.push_back(id);
+        } else if (entry.state == State::Fetching && entry.lastUsed + CANCEL_AFTER_FRAMES < m_frame) {
+            stale.push_back(id);
+        }
+    }
+    if (decoded.size() > static_cast<size_t>(MAX_UPLOADS_PER_FRAME)) {
+        decoded.resize(MAX_UPLOADS_PER_FRAME);  // The rest wait for the next frame
+    }
+    placeDeferred();
+    for (const std::string& id : decoded) {
+        finishDecode(id, m_entries[id]);
+    }
+    for (const std::string& id : stale) {
+        Entry& entry = m_entries[id];
+        m_model.cancelThumbnailFetch(entry.bucket, entry.key);
+        release(entry);
+        --m_fetchesInFlight;
+        entry.state = State::Wanted;
+        m_busy.erase(id);
+    }
+
+    // Fetch what was drawn last frame, top first
+    for (const std::string& id : m_wanted) {
+        auto it = m_entries.find(id);
+        if (it == m_entries.end() || it->second.state != State::Wanted) continue;
+        if (!startFetch(id, it->second)) break;
+    }
+    m_wanted.clear();
+
+    if (m_entries.size() > MAX_ENTRIES) {
+        trimEntries();
+    }
+}
+
+bool ThumbnailCache::startFetch(const std::string& id, Entry& entry) {
+    // Only JPEGs carry an embedded thumbnail worth probing for
+    if (!isJpeg(entry.key) || static_cast<size_t>(entry.size) <= PROBE_BYTES) {
+        entry.wholeObject = true;
+    }
+    if (entry.wholeObject && static_cast<size_t>(entry.size) > MAX_WHOLE_BYTES) {
+        entry.state = State::Failed;
+        return true;
+    }
+
+    size_t bytes = entry.wholeObject ? static_cast<size_t>(entry.size) : PROBE_BYTES;
+    if (m_fetchesInFlight >= MAX_FETCHES_IN_FLIGHT || m_pendingBytes + bytes > MAX_PENDING_BYTES) {
+        return false;
+    }
+
+    entry.state = State::Fetching;
+    entry.reservedBytes = bytes;
+    m_pendingBytes += bytes;
+    ++m_fetchesInFlight;
+    m_busy.insert(id);
+    m_model.fetchThumbnailBytes(entry.bucket, entry.key, bytes);
+    return true;
+}
+
+void ThumbnailCache::finishFetch(ThumbnailBytes& bytes) {
+    std::string id = makeKey(bytes.bucket, bytes.key);
+    auto it = m_entries.find(id);
+    if (it == m_entries.end() || it->second.state != State::Fetching) {
+        return;  // Dropped or cleared meanwhile
+    }
+    Entry& entry = it->second;
+    release(entry);
+    --m_fetchesInFlight;
+
+    if (bytes.cancelled) {
+        entry.state = State::Wanted;
+        m_busy.erase(id);
+        return;
+    }
+    if (!bytes.error.empty()) {
+        LOG_F(1, "ThumbnailCache: fetch failed for %s: %s", id.c_str(), bytes.error.c_str());
+        entry.state = State::Failed;
+        m_busy.erase(id);
+        return;
+    }
+
+    auto data = std::make_shared<const std::string>(std::move(bytes.data));
+    bool complete = data->size() >= static_cast<size_t>(entry.size);
+    entry.state = State::Decoding;
+    entry.reservedBytes = data->size();
+    m_pendingBytes += entry.reservedBytes;
+    entry.decode = ThreadPool::shared().submit([data, complete] {
+        return decodeThumbnail(data, complete);
+    });
+}
+
+void ThumbnailCache::finishDecode(const std::string& id, Entry& entry) {
+    std::shared_ptr<Decoded> decoded = entry.decode.get();
+    release(entry);
+    m_busy.erase(id);
+
+    if (decoded->needsWholeObject) {
+        // No embedded thumbnail: fetched again in full next time it's drawn
+        entry.wholeObject = true;
+        entry.state = static_cast<size_t>(entry.size) <= MAX_WHOLE_BYTES ? State::Wanted : State::Failed;
+        return;
+    }
+    if (!decoded->error.empty()) {
+        LOG_F(1, "ThumbnailCache: can't decode %s: %s", id.c_str(), decoded->error.c_str());
+        entry.state = State::Failed;
+        return;
+    }
+
+    if (!upload(id, entry, *decoded)) {
+        // Atlas full of visible thumbnails: keep the pixels until a cell frees
+        entry.state = State::Deferred;
+        entry.reservedBytes = decoded->rgba.size();
+        m_pendingBytes += entry.reservedBytes;
+        entry.deferred = std::move(decoded);
+        m_deferred.push_back(id);
+    }
+}
+
+bool ThumbnailCache::upload(const std::string& id, Entry& entry, Decoded& decoded) {
+    int cell = allocateCell();
+    if (cell < 0) {
+        return false;
+    }
+    int withinPage = cell % CELLS_PER_PAGE;
+    int x = (withinPage % CELLS_PER_ROW) * CELL_SIZE + 1;
+    int y = (withinPage / CELLS_PER_ROW) * CELL_SIZE + 1;
+    if (!UpdateGPUTextureRegion(m_pages[cell / CELLS_PER_PAGE], x, y, decoded.width, decoded.height,
+                                decoded.rgba.data())) {
+        freeCell(cell);
+        entry.state = State::Failed;
+        return true;
+    }
+    m_cellOwners[cell] = id;
+    entry.cell = cell;
+    entry.width = decoded.width;
+    entry.height = decoded.height;
+    entry.state = State::Ready;
+    return true;
+}
+
+void ThumbnailCache::placeDeferred() {
+    size_t kept = 0;
+    for (size_t i = 0; i < m_deferred.size(); ++i) {
+        auto it = m_entries.find(m_deferred[i]);
+        if (it == m_entries.end() || it->second.state != State::Deferred) {
+            continue;  // Trimmed or cleared meanwhile
+        }
+        Entry& entry = it->second;
+        std::shared_ptr<Decoded> decoded = entry.deferred;
+        if (entry.lastUsed + CANCEL_AFTER_FRAMES < m_frame) {
+            // Scrolled out of view: fetched again if it comes back
+            entry.state = State::Wanted;
+        } else if (!upload(it->first, entry, *decoded)) {
+            m_deferred[kept++] = m_deferred[i];
+            continue;
+        }
+        release(entry);
+        entry.deferred.reset();
+    }
+    m_deferred.resize(kept);
+}
+
+void ThumbnailCache::release(Entry& entry) {
+    m_pendingBytes -= entry.reservedBytes;
+    entry.reservedBytes = 0;
+}
+
+int ThumbnailCache::allocateCell() {
+    if (m_atlasFullFrame == m_frame) {
+        return -1;  // Nothing drawn since the last search was evictable either
+    }
+    if (m_freeCells.empty() && static_cast<int>(m_pages.size()) < MAX_ATLAS_PAGES) {
+        std::vector<uint8_t> blank(static_cast<size_t>(ATLAS_PAGE_SIZE) * ATLAS_PAGE_SIZE * 4, 0);
+        TextureHandle page = nullptr;
+        if (CreateGPUTexture(blank.data(), ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE, &page)) {
+            int first = static_cast<int>(m_pages.size()) * CELLS_PER_PAGE;
+            m_pages.push_back(page);
+            m_cellOwners.resize(m_pages.size() * CELLS_PER_PAGE);
+            for (int cell = first + CELLS_PER_PAGE - 1; cell >= first; --cell) {
+                m_freeCells.push_back(cell);
+            }
+            LOG_F(INFO, "ThumbnailCache: atlas page %zu of %d", m_pages.size(), MAX_ATLAS_PAGES);
+        }
+    }
+    if (!m_freeCells.empty()) {
+        int cell = m_freeCells.back();
+        m_freeCells.pop_back();
+        return cell;
+    }
+
+    // Evict the least recently drawn thumbnail that wasn't drawn last frame
+    int victim = -1;
+    uint64_t oldest = m_frame - 1;
+    for (size_t cell = 0; cell < m_cellOwners.size(); ++cell) {
+        auto owner = m_entries.find(m_cellOwners[cell]);
+        if (owner != m_entries.end() && owner->second.lastUsed < oldest) {
+            oldest = owner->second.lastUsed;
+            victim = static_cast<int>(cell);
+        }
+    }
+    if (victim < 0) {
+        m_atlasFullFrame = m_frame;
+        return -1;
+    }
+    Entry& evicted = m_entries[m_cellOwners[victim]];
+    evicted.state = State::Wanted;
+    evicted.cell = -1;
+    return victim;
+}
+
+void ThumbnailCache::freeCell(int cell) {
+    m_cellOwners[cell].clear();
+    m_freeCells.push_back(cell);
+}
+
+void ThumbnailCache::trimEntries() {
+    // Forget the longest undrawn entries that aren't in flight
+    std::vector<std::pair<uint64_t, std::string>> idle;
+    for (const auto& [id, entry] : m_entries) {
+        if (!m_busy.count(id) && entry.lastUsed + 1 < m_frame) {
+            idle.emplace_back(entry.lastUsed, id);
+        }
+    }
+    std::sort(idle.begin(), idle.end());
+    size_t excess = m_entries.size() - MAX_ENTRIES * 3 / 4;
+    for (size_t i = 0; i < idle.size() && i < excess; ++i) {
+        auto it = m_entries.find(idle[i].second);
+        if (it->second.cell >= 0) {
+            freeCell(it->second.cell);
+        }
+        release(it->second);  // Deferred pixels
+        m_entries.erase(it);
+    }
+}
+
+void ThumbnailCache::clear() {
+    for (const std::string& id : m_busy) {
+        Entry& entry = m_entries[id];
+        if (entry.state == State::Fetching) {
+            m_model.cancelThumbnailFetch(entry.bucket, entry.key);
+        }
+    }
+    // Decodes still running finish on their own; their results are dropped
+    m_entries.clear();
+    m_busy.clear();
+    m_wanted.clear();
+    m_deferred.clear();
+    m_fetchesInFlight = 0;
+    m_pendingBytes = 0;
+
+    for (TextureHandle page : m_pages) {
+        DestroyGPUTexture(page);
+    }
+    m_pages.clear();
+    m_cellOwners.clear();
+    m_freeCells.clear();
+}
+
+std::shared_ptr<ThumbnailCache::Decoded> ThumbnailCache::decodeThumbnail(
+        std::shared_ptr<const std::string> data, bool complete) {
+    auto decoded = std::make_shared<Decoded>();
+    const auto* bytes = reinterpret_cast<const unsigned char*>(data->data());
+
+    int width = 0, height = 0;
+    auto load = [&](size_t offset, size_t length) -> unsigned char* {
+        if (length > static_cast<size_t>(INT_MAX)) {
+            decoded->error = "Image file too large";
+            return nullptr;
+        }
+        int channels;
+        if (!stbi_info_from_memory(bytes + offset, static_cast<int>(length), &width, &height, &channels)) {
+            decoded->error = stbi_failure_reason() ? stbi_failure_reason() : "Unknown image format";
+            return nullptr;
+        }
+        if (static_cast<int64_t>(width) * height > MAX_DECODE_PIXELS) {
+            decoded->error = "Image too large for a thumbnail";
+            return nullptr;
+        }
+        unsigned char* pixels = stbi_load_from_memory(bytes + offset, static_cast<int>(length),
+                                                      &width, &height, &channels, 4);
+        if (pixels == nullptr) {
+            decoded->error = stbi_failure_reason() ? stbi_failure_reason() : "Unknown error decoding image";
+        }
+        return pixels;
+    };
+
+    // An embedded thumbnail is far less to decode than the image, when it's there
+    unsigned char* pixels = nullptr;
+    size_t offset = 0;
+    size_t length = 0;
+    if (findExifThumbnail(bytes, data->size(), offset, length)) {
+        pixels = load(offset, length);
+    }
+    if (pixels == nullptr) {
+        decoded->error.clear();
+        if (!complete) {
+            decoded->needsWholeObject = true;
+            return decoded;
+        }
+        pixels = load(0, data->size());
+        if (pixels == nullptr) {
+            return decoded;
+        }
+    }
+
+    fitWithin(width, height, CELL_SIZE - 2, CELL_SIZE - 2, decoded->width, decoded->height);
+    decoded->rgba.resize(static_cast<size_t>(decoded->width) * decoded->height * 4);
+    resizeAreaRGBA(pixels, width, height, static_cast<size_t>(width) * 4,
+                   decoded->rgba.data(), decoded->width, decoded->height);
+    stbi_image_free(pixels);
+    return decoded;
+}
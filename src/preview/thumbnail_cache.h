@@ -0,0 +1,128 @@
+#pragma once
+
+#include "image_preview.h"
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <cstdint>
+
+class BrowserModel;
+struct ThumbnailBytes;
+
+// Small previews of image objects for the folder grid. Only images the grid
+// asks for (the visible ones) are fetched, as low-priority ranged GETs that
+// run in parallel in the backend: for a JPEG the first PROBE_BYTES, which
+// usually hold the thumbnail the camera embedded in its EXIF data, and for
+// anything else (or a JPEG without one) the whole object if it's at most
+// MAX_WHOLE_BYTES. Decoding and shrinking run on the shared thread pool.
+// Finished thumbnails are packed into a few atlas textures and evicted least
+// recently drawn first, so VRAM stays within MAX_ATLAS_PAGES pages. While the
+// atlas is full of thumbnails drawn last frame, decoded ones keep their pixels
+// until a cell can be had rather than being fetched again. Fetched bytes
+// waiting to be decoded and pixels waiting for a cell stay within
+// MAX_PENDING_BYTES.
+// Used from the UI thread only.
+class ThumbnailCache {
+public:
+    explicit ThumbnailCache(BrowserModel& model);
+    ~ThumbnailCache();
+
+    ThumbnailCache(const ThumbnailCache&) = delete;
+    ThumbnailCache& operator=(const ThumbnailCache&) = delete;
+
+    // Where a thumbnail sits in the atlas
+    struct Thumbnail {
+        TextureHandle texture = nullptr;  // Null while loading or if failed
+        float u0 = 0.0f, v0 = 0.0f, u1 = 0.0f, v1 = 0.0f;
+        int width = 0;
+        int height = 0;
+        bool failed = false;  // No thumbnail can be made
+    };
+
+    // Thumbnail of an image object of the given size, requested if not known
+    // yet. Marks it as drawn this frame.
+    Thumbnail get(const std::string& bucket, const std::string& key, int64_t size);
+
+    // Take fetched bytes and decoded pixels, and start fetches for
+    // thumbnails asked for last frame (call once per frame, before get)
+    void update();
+
+    // Drop everything, e.g. when the profile changes
+    void clear();
+
+    // Thumbnails being fetched or decoded
+    size_t pendingCount() const { return m_busy.size(); }
+
+    static constexpr int CELL_SIZE = 128;            // Atlas cell; thumbnails are 2px smaller
+    static constexpr int ATLAS_PAGE_SIZE = 2048;     // 256 cells, 16 MB per page
+    static constexpr int MAX_ATLAS_PAGES = 4;
+    static constexpr size_t PROBE_BYTES = 128 * 1024;
+    static constexpr size_t MAX_WHOLE_BYTES = 4 * 1024 * 1024;
+    static constexpr size_t MAX_PENDING_BYTES = 48 * 1024 * 1024;
+    static constexpr size_t MAX_FETCHES_IN_FLIGHT = 32;
+    static constexpr int MAX_UPLOADS_PER_FRAME = 32;
+    static constexpr uint64_t CANCEL_AFTER_FRAMES = 30;  // Fetches not drawn for this long are dropped
+    static constexpr size_t MAX_ENTRIES = 16384;
+
+private:
+    // Made on the pool
+    struct Decoded {
+        std::vector<uint8_t> rgba;
+        int width = 0;
+        int height = 0;
+        bool needsWholeObject = false;  // The probe held no usable thumbnail
+        std::string error;
+    };
+
+    // Deferred: decoded, waiting for an atlas cell
+    enum class State { Wanted, Fetching, Decoding, Deferred, Ready, Failed };
+
+    struct Entry {
+        std::string bucket;
+        std::string key;
+        int64_t size = 0;
+        State state = State::Wanted;
+        bool wholeObject = false;  // Fetching all of it rather than the probe
+        size_t reservedBytes = 0;  // Counted in m_pendingBytes
+        std::future<std::shared_ptr<Decoded>> decode;
+        std::shared_ptr<Decoded> deferred;  // Pixels while Deferred
+        int cell = -1;             // Atlas cell while Ready
+        int width = 0;
+        int height = 0;
+        uint64_t lastUsed = 0;     // Frame it was last drawn
+    };
+
+    static std::shared_ptr<Decoded> decodeThumbnail(std::shared_ptr<const std::string> data, bool complete);
+
+    // False if the fetch has to wait for room in the budget
+    bool startFetch(const std::string& id, Entry& entry);
+    void finishFetch(ThumbnailBytes& bytes);
+    void finishDecode(const std::string& id, Entry& entry);
+    // Ready (or Failed if the upload fails); false if no atlas cell can be had this frame
+    bool upload(const std::string& id, Entry& entry, Decoded& decoded);
+    void placeDeferred();
+    void release(Entry& entry);
+    int allocateCell();
+    void freeCell(int cell);
+    void trimEntries();
+
+    static std::string makeKey(const std::string& bucket, const std::string& key);
+
+    BrowserModel& m_model;
+    std::unordered_map<std::string, Entry> m_entries;  // By bucket/key
+    std::unordered_set<std::string> m_busy;             // Fetching or decoding
+    std::vector<std::string> m_wanted;                  // Asked for this frame, in drawing order
+    std::vector<std::string> m_deferred;                // Decoded, waiting for an atlas cell
+    size_t m_fetchesInFlight = 0;
+    size_t m_pendingBytes = 0;
+    uint64_t m_frame = 1;
+
+    // Atlas: pages of CELL_SIZE cells; each cell's owner is an m_entries key
+    std::vector<TextureHandle> m_pages;
+    std::vector<std::string> m_cellOwners;
+    std::vector<int> m_freeCells;
+    uint64_t m_atlasFullFrame = 0;  // Frame in which no cell could be had
+};
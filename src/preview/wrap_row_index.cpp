@@ -0,0 +1,278 @@
+#include "wrap_row_index.h"
+#include "line_index.h"
+#include "loguru.hpp"
+#include <algorithm>
+
+uint32_t wrapLine(const char* text, uint32_t len, float wrapWidth,
+                  const CharAdvances& advances, std::vector<uint32_t>* rowStarts) {
+    uint32_t rowCount = 1;
+    uint32_t rowStart = 0;
+    if (rowStarts) {
+        rowStarts->assign(1, 0);
+    }
+
+    float x = 0.0f;
+    uint32_t lastBreakOffset = 0;
+
+    uint32_t i = 0;
+    while (i < len) {
+        // UTF-8 characters are measured by their lead byte (a truncated one
+        // at the end of the line by character 0)
+        unsigned char c = 0;
+        int charBytes = 1;
+        unsigned char ch = static_cast<unsigned char>(text[i]);
+        if (ch < 0x80) {
+            c = ch;
+        } else if (ch < 0xE0 && i + 1 < len) {
+            c = ch;
+            charBytes = 2;
+        } else if (ch < 0xF0 && i + 2 < len) {
+            c = ch;
+            charBytes = 3;
+        } else if (i + 3 < len) {
+            c = ch;
+            charBytes = 4;
+        }
+
+        float charWidth = advances[c];
+
+        if (x + charWidth > wrapWidth && x > 0.0f) {
+            uint32_t breakAt = i;
+
+            if (lastBreakOffset > rowStart) {
+                breakAt = lastBreakOffset;
+            }
+
+            rowStart = breakAt;
+            if (rowStarts) {
+                rowStarts->push_back(breakAt);
+            }
+            rowCount++;
+            x = 0.0f;
+
+            if (breakAt < i) {
+                i = breakAt;
+                continue;
+            }
+        }
+
+        if (c == ' ' || c == '\t' || c == '-' || c == '/' || c == '\\' || c == ',' || c == ';') {
+            lastBreakOffset = i + static_cast<uint32_t>(charBytes);
+        }
+
+        x += charWidth;
+        i += static_cast<uint32_t>(charBytes);
+    }
+
+    return rowCount;
+}
+
+// ============================================================================
+// RowTree
+// ============================================================================
+
+void WrapRowIndex::RowTree::clear() {
+    m_rows.clear();
+    m_tree.clear();
+    m_totalRows = 0;
+}
+
+void WrapRowIndex::RowTree::push(uint32_t rows) {
+    uint16_t stored = static_cast<uint16_t>(std::min<uint32_t>(rows, UINT16_MAX));
+    m_rows.push_back(stored);
+    m_totalRows += stored;
+
+    if (m_rows.size() % BLOCK_LINES != 0)
+        return;
+
+    // Block just filled: node i covers blocks (i - lowbit(i), i], which is
+    // this block plus nodes i-1, i-2, i-4, ... below it
+    uint64_t blockRows = 0;
+    for (size_t k = m_rows.size() - BLOCK_LINES; k < m_rows.size(); ++k) {
+        blockRows += m_rows[k];
+    }
+    size_t i = m_tree.size() + 1;
+    size_t lowbit = i & (~i + 1);
+    for (size_t step = 1; step < lowbit; step <<= 1) {
+        blockRows += m_tree[i - step - 1];
+    }
+    m_tree.push_back(blockRows);
+}
+
+uint64_t WrapRowIndex::RowTree::rowsBefore(uint64_t line) const {
+    uint64_t block = line / BLOCK_LINES;
+    uint64_t rows = 0;
+    for (uint64_t i = block; i > 0; i &= i - 1) {
+        rows += m_tree[i - 1];
+    }
+    for (uint64_t k = block * BLOCK_LINES; k < line; ++k) {
+        rows += m_rows[k];
+    }
+    return rows;
+}
+
+void WrapRowIndex::RowTree::findRow(uint64_t row, uint64_t& line, uint32_t& subRow) const {
+    // Descend to the last block that starts at or before the row
+    uint64_t block = 0;
+    uint64_t remaining = row;
+    uint64_t step = 1;
+    while (step * 2 <= m_tree.size()) step *= 2;
+    for (; step > 0; step >>= 1) {
+        if (block + step <= m_tree.size() && m_tree[block + step - 1] <= remaining) {
+            block += step;
+            remaining -= m_tree[block - 1];
+        }
+    }
+
+    line = block * BLOCK_LINES;
+    while (line + 1 < m_rows.size() && remaining >= m_rows[line]) {
+        remaining -= m_rows[line];
+        line++;
+    }
+    subRow = static_cast<uint32_t>(remaining);
+}
+
+// ============================================================================
+// WrapRowIndex
+// ============================================================================
+
+WrapRowIndex::~WrapRowIndex() {
+    stop();
+}
+
+void WrapRowIndex::setSource(const char* base, std::shared_ptr<const LineIndex> index) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (base == m_base && index == m_index)
+            return;
+    }
+
+    // The worker may be reading the old mapping
+    stop();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_base = base;
+    m_index = std::move(index);
+    ensureWorker();
+}
+
+void WrapRowIndex::setWidth(float width, const CharAdvances& advances) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (width == m_width && advances == m_advances)
+        return;
+
+    m_width = width;
+    m_advances = advances;
+    m_tree.clear();
+    m_generation++;
+    ensureWorker();
+    m_cv.notify_one();
+}
+
+void WrapRowIndex::setExtent(uint64_t lineCount, uint64_t indexedSize, bool complete) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (lineCount == m_lineCount && indexedSize == m_indexedSize && complete == m_complete)
+        return;
+
+    m_lineCount = lineCount;
+    m_indexedSize = indexedSize;
+    m_complete = complete;
+    ensureWorker();
+    m_cv.notify_one();
+}
+
+void WrapRowIndex::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = false;
+    m_base = nullptr;
+    m_index.reset();
+    m_lineCount = 0;
+    m_indexedSize = 0;
+    m_complete = false;
+    m_tree.clear();
+    m_generation++;
+}
+
+void WrapRowIndex::ensureWorker() {
+    // Caller holds m_mutex
+    if (!m_worker.joinable() && m_base && m_width > 0.0f) {
+        m_worker = std::thread(&WrapRowIndex::workerLoop, this);
+    }
+}
+
+void WrapRowIndex::counted(uint64_t& lines, uint64_t& rows) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    lines = m_tree.lines();
+    rows = m_tree.totalRows();
+}
+
+bool WrapRowIndex::rowsBefore(uint64_t line, uint64_t& rows) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (line > m_tree.lines())
+        return false;
+    rows = m_tree.rowsBefore(line);
+    return true;
+}
+
+bool WrapRowIndex::findRow(uint64_t row, uint64_t& line, uint32_t& subRow) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (row >= m_tree.totalRows())
+        return false;
+    m_tree.findRow(row, line, subRow);
+    return true;
+}
+
+void WrapRowIndex::workerLoop() {
+    loguru::set_thread_name("WrapRows");
+
+    std::vector<uint32_t> batch;
+    CharAdvances advances;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop) {
+        // The last line may still grow until the file is complete
+        uint64_t start = m_tree.lines();
+        uint64_t countable = m_complete ? m_lineCount : (m_lineCount > 0 ? m_lineCount - 1 : 0);
+        if (!m_base || m_width <= 0.0f || start >= countable) {
+            m_cv.wait(lock);
+            continue;
+        }
+
+        uint64_t end = std::min(countable, start + BATCH_LINES);
+        uint64_t generation = m_generation;
+        const char* base = m_base;
+        std::shared_ptr<const LineIndex> index = m_index;
+        float width = m_width;
+        uint64_t extent = m_indexedSize;
+        advances = m_advances;
+        lock.unlock();
+
+        batch.clear();
+        for (uint64_t line = start; line < end; ++line) {
+            uint64_t lineStart = 0, lineEnd = 0;
+            index->lineRange(line, extent, lineStart, lineEnd);
+            // Strip trailing \n and \r, as the viewer does
+            while (lineEnd > lineStart && (base[lineEnd - 1] == '\n' || base[lineEnd - 1] == '\r'))
+                --lineEnd;
+            uint32_t len = static_cast<uint32_t>(std::min(lineEnd - lineStart, MAX_LINE_BYTES));
+            batch.push_back(len ? wrapLine(base + lineStart, len, width, advances, nullptr) : 1);
+        }
+
+        lock.lock();
+        // Drop the batch if the width changed or the rows were reset meanwhile
+        if (generation == m_generation && m_tree.lines() == start) {
+            for (uint32_t rows : batch) {
+                m_tree.push(rows);
+            }
+        }
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+class LineIndex;
+
+// Per-byte glyph advances of the current font. Multi-byte UTF-8 characters
+// are measured by their lead byte, so 256 entries cover everything.
+using CharAdvances = std::array<float, 256>;
+
+// Word-wrap one line of text at wrapWidth. Returns its visual row count and,
+// if rowStarts is given, fills it with each row's byte offset in the line.
+uint32_t wrapLine(const char* text, uint32_t len, float wrapWidth,
+                  const CharAdvances& advances, std::vector<uint32_t>* rowStarts);
+
+// Visual (wrapped) row count of every line of a mapped text file at one wrap
+// width, computed on a background thread and kept as a Fenwick tree, so the
+// viewer can map between lines and visual rows exactly in O(log n).
+// Only complete lines are counted until the file is complete, so a line
+// never has to be recounted as more of it streams in.
+// Thread-safe: the UI thread configures and queries, the worker fills.
+class WrapRowIndex {
+public:
+    WrapRowIndex() = default;
+    ~WrapRowIndex();
+
+    WrapRowIndex(const WrapRowIndex&) = delete;
+    WrapRowIndex& operator=(const WrapRowIndex&) = delete;
+
+    // Where line bytes come from. base must stay mapped until the next
+    // setSource/stop call; changing it discards everything counted.
+    void setSource(const char* base, std::shared_ptr<const LineIndex> index);
+
+    // Wrap width and font; a change discards everything counted. A width of
+    // 0 (word wrap off) stops counting.
+    void setWidth(float width, const CharAdvances& advances);
+
+    // Lines available in the first indexedSize bytes; complete once the
+    // file won't grow any more
+    void setExtent(uint64_t lineCount, uint64_t indexedSize, bool complete);
+
+    // Stop the worker and forget the source
+    void stop();
+
+    // Lines counted so far (always a prefix of the file) and their rows
+    void counted(uint64_t& lines, uint64_t& rows) const;
+
+    // Rows before a line; false if that line's predecessors aren't all counted
+    bool rowsBefore(uint64_t line, uint64_t& rows) const;
+
+    // Line holding a visual row, and the row within it; false if not counted yet
+    bool findRow(uint64_t row, uint64_t& line, uint32_t& subRow) const;
+
+private:
+    // Prefix sums of rows per line: a Fenwick tree over blocks of
+    // BLOCK_LINES, plus the rows of each line to search within a block
+    class RowTree {
+    public:
+        void clear();
+        void push(uint32_t rows);
+        uint64_t lines() const { return m_rows.size(); }
+        uint64_t totalRows() const { return m_totalRows; }
+        uint64_t rowsBefore(uint64_t line) const;
+        void findRow(uint64_t row, uint64_t& line, uint32_t& subRow) const;
+
+    private:
+        static constexpr uint64_t BLOCK_LINES = 64;
+        std::vector<uint16_t> m_rows;  // Clamped to 65535 (lines are capped at 64KB anyway)
+        std::vector<uint64_t> m_tree;  // 1-based Fenwick tree over full blocks
+        uint64_t m_totalRows = 0;
+    };
+
+    void workerLoop();
+    void ensureWorker();
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::thread m_worker;
+    bool m_stop = false;
+
+    // What to count (UI side)
+    const char* m_base = nullptr;
+    std::shared_ptr<const LineIndex> m_index;
+    float m_width = 0.0f;
+    CharAdvances m_advances{};
+    uint64_t m_lineCount = 0;
+    uint64_t m_indexedSize = 0;
+    bool m_complete = false;
+    uint64_t m_generation = 0;  // Bumped whenever counted rows are discarded
+
+    RowTree m_tree;
+
+    static constexpr uint64_t BATCH_LINES = 1024;
+    static constexpr uint64_t MAX_LINE_BYTES = 65536;  // Same cap as the viewer
+};
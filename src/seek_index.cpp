@@ -0,0 +1,350 @@
+#include "seek_index.h"
+#include "settings.h"
+#include "loguru.hpp"
+#include <zlib.h>
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
+
+// On-disk format (native byte order, it never leaves this machine):
+//   magic, compressedSize, uncompressedSize, count, then per checkpoint
+//   compressedOffset, bits, uncompressedOffset, lineNumber, lineStart,
+//   window size, packed size, zlib-compressed window
+static constexpr char INDEX_MAGIC[8] = {'S', '6', 'S', 'K', 'I', 'X', '0', '1'};
+
+template <typename T>
+static void writePod(std::ofstream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+static bool readPod(std::ifstream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+static bool byOffset(const SeekCheckpoint& a, uint64_t offset) {
+    return a.uncompressedOffset < offset;
+}
+
+SeekIndex::SeekIndex(std::string path, uint64_t compressedSize)
+    : m_path(std::move(path))
+    , m_compressedSize(compressedSize)
+{
+}
+
+std::string SeekIndex::cachePath(const std::string& bucket, const std::string& key,
+                                 const std::string& etag) {
+    if (etag.empty()) return "";
+
+    std::string dir = cacheDirectory("seek_index");
+    if (dir.empty()) return "";
+
+    // FNV-1a over the object identity keeps file names short and stable
+    uint64_t hash = 14695981039346656037ULL;
+    for (const std::string* part : {&bucket, &key, &etag}) {
+        for (unsigned char c : *part) {
+            hash = (hash ^ c) * 1099511628211ULL;
+        }
+        hash = (hash ^ '\n') * 1099511628211ULL;
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.idx", static_cast<unsigned long long>(hash));
+    return dir + "/" + name;
+}
+
+void SeekIndex::load() {
+    if (m_path.empty()) return;
+
+    std::ifstream in(m_path, std::ios::binary);
+    if (!in.is_open()) return;
+
+    char magic[sizeof(INDEX_MAGIC)];
+    uint64_t compressedSize = 0;
+    uint64_t uncompressedSize = 0;
+    uint64_t count = 0;
+    if (!in.read(magic, sizeof(magic)) ||
+        !std::equal(magic, magic + sizeof(magic), INDEX_MAGIC) ||
+        !readPod(in, compressedSize) || !readPod(in, uncompressedSize) || !readPod(in, count) ||
+        compressedSize != m_compressedSize) {
+        LOG_F(WARNING, "SeekIndex: ignoring stale or unreadable index %s", m_path.c_str());
+        return;
+    }
+
+    std::vector<SeekCheckpoint> checkpoints;
+    for (uint64_t i = 0; i < count; ++i) {
+        SeekCheckpoint cp;
+        uint32_t bits = 0;
+        uint8_t lineStart = 0;
+        uint32_t windowSize = 0;
+        uint32_t packedSize = 0;
+        if (!readPod(in, cp.compressedOffset) || !readPod(in, bits) ||
+            !readPod(in, cp.uncompressedOffset) || !readPod(in, cp.lineNumber) ||
+            !readPod(in, lineStart) || !readPod(in, windowSize) || !readPod(in, packedSize) ||
+            windowSize > 32768 || bits > 7) {
+            LOG_F(WARNING, "SeekIndex: truncated index %s", m_path.c_str());
+            return;
+        }
+
+        std::string packed(packedSize, '\0');
+        if (!in.read(packed.data(), packedSize)) {
+            LOG_F(WARNING, "SeekIndex: truncated index %s", m_path.c_str());
+            return;
+        }
+
+        cp.bits = static_cast<int>(bits);
+        cp.lineStart = lineStart != 0;
+        if (windowSize > 0) {
+            cp.window.resize(windowSize);
+            uLongf destLen = windowSize;
+            if (uncompress(reinterpret_cast<Bytef*>(cp.window.data()), &destLen,
+                           reinterpret_cast<const Bytef*>(packed.data()), packedSize) != Z_OK ||
+                destLen != windowSize) {
+                LOG_F(WARNING, "SeekIndex: corrupt window in index %s", m_path.c_str());
+                return;
+            }
+        }
+        checkpoints.push_back(std::move(cp));
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& cp : checkpoints) {
+        auto it = std::lower_bound(m_checkpoints.begin(), m_checkpoints.end(), cp.uncompressedOffset, byOffset);
+        if (it == m_checkpoints.end() || it->uncompressedOffset != cp.uncompressedOffset) {
+            m_checkpoints.insert(it, std::move(cp));
+        }
+    }
+    if (m_uncompressedSize == 0) {
+        m_uncompressedSize = uncompressedSize;
+    }
+    LOG_F(INFO, "SeekIndex: loaded %zu checkpoints from %s", m_checkpoints.size(), m_path.c_str());
+}
+
+void SeekIndex::saveIfDirty() {
+    if (m_path.empty()) return;
+
+    // Snapshot under the lock, compress and write without it
+    std::vector<SeekCheckpoint> checkpoints;
+    uint64_t uncompressedSize = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_dirty) return;
+        checkpoints = m_checkpoints;
+        uncompressedSize = m_uncompressedSize;
+        m_dirty = false;
+    }
+
+    // Write to a temp file and rename so a crash never leaves a torn index
+    std::string tmpPath = m_path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            LOG_F(WARNING, "SeekIndex: failed to open %s for writing", tmpPath.c_str());
+            return;
+        }
+
+        out.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+        writePod<uint64_t>(out, m_compressedSize);
+        writePod<uint64_t>(out, uncompressedSize);
+        writePod<uint64_t>(out, checkpoints.size());
+
+        std::string packed;
+        for (const auto& cp : checkpoints) {
+            uLongf packedSize = 0;
+            if (!cp.window.empty()) {
+                packedSize = compressBound(cp.window.size());
+                packed.resize(packedSize);
+                if (compress(reinterpret_cast<Bytef*>(packed.data()), &packedSize,
+                             reinterpret_cast<const Bytef*>(cp.window.data()), cp.window.size()) != Z_OK) {
+                    LOG_F(WARNING, "SeekIndex: failed to compress window");
+                    return;
+                }
+            }
+
+            writePod<uint64_t>(out, cp.compressedOffset);
+            writePod<uint32_t>(out, static_cast<uint32_t>(cp.bits));
+            writePod<uint64_t>(out, cp.uncompressedOffset);
+            writePod<uint64_t>(out, cp.lineNumber);
+            writePod<uint8_t>(out, cp.lineStart ? 1 : 0);
+            writePod<uint32_t>(out, static_cast<uint32_t>(cp.window.size()));
+            writePod<uint32_t>(out, static_cast<uint32_t>(packedSize));
+            out.write(packed.data(), static_cast<std::streamsize>(packedSize));
+        }
+
+        if (!out.good()) {
+            LOG_F(WARNING, "SeekIndex: failed to write %s", tmpPath.c_str());
+            return;
+        }
+    }
+
+    if (std::rename(tmpPath.c_str(), m_path.c_str()) != 0) {
+        LOG_F(WARNING, "SeekIndex: failed to replace %s", m_path.c_str());
+        std::remove(tmpPath.c_str());
+        return;
+    }
+    LOG_F(INFO, "SeekIndex: saved %zu checkpoints to %s", checkpoints.size(), m_path.c_str());
+}
+
+bool SeekIndex::linesConsistent(std::vector<SeekCheckpoint>::const_iterator at, uint64_t lineNumber) const {
+    // Line numbers never decrease with the offset; one that would is miscounted
+    for (auto it = at; it != m_checkpoints.begin();) {
+        --it;
+        if (it->lineNumber != SeekCheckpoint::UNKNOWN_LINE) {
+            if (it->lineNumber > lineNumber) return false;
+            break;
+        }
+    }
+    for (auto it = std::next(at); it != m_checkpoints.end(); ++it) {
+        if (it->lineNumber != SeekCheckpoint::UNKNOWN_LINE) {
+            return lineNumber <= it->lineNumber;
+        }
+    }
+    return true;
+}
+
+void SeekIndex::add(SeekCheckpoint checkpoint) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = std::lower_bound(m_checkpoints.begin(), m_checkpoints.end(), checkpoint.uncompressedOffset, byOffset);
+
+    // Decoding past a zstd frame listed in the seek table learns its line number
+    if (it != m_checkpoints.end() && it->uncompressedOffset == checkpoint.uncompressedOffset) {
+        if (it->lineNumber == SeekCheckpoint::UNKNOWN_LINE &&
+            checkpoint.lineNumber != SeekCheckpoint::UNKNOWN_LINE &&
+            linesConsistent(it, checkpoint.lineNumber)) {
+            it->lineNumber = checkpoint.lineNumber;
+            it->lineStart = checkpoint.lineStart;
+            m_dirty = true;
+        }
+        return;
+    }
+
+    // A restarted stream finds block boundaries close to ones already recorded
+    constexpr uint64_t MIN_GAP = CHECKPOINT_SPAN / 2;
+    if (it != m_checkpoints.end() && it->uncompressedOffset - checkpoint.uncompressedOffset < MIN_GAP) {
+        return;
+    }
+    if (it != m_checkpoints.begin() &&
+        checkpoint.uncompressedOffset - std::prev(it)->uncompressedOffset < MIN_GAP) {
+        return;
+    }
+
+    m_checkpoints.insert(it, std::move(checkpoint));
+    m_dirty = true;
+}
+
+bool SeekIndex::findByOffset(uint64_t uncompressedOffset, SeekCheckpoint& out) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = std::upper_bound(m_checkpoints.begin(), m_checkpoints.end(), uncompressedOffset,
+        [](uint64_t offset, const SeekCheckpoint& a) { return offset < a.uncompressedOffset; });
+    if (it == m_checkpoints.begin()) return false;
+
+    out = *std::prev(it);
+    return true;
+}
+
+bool SeekIndex::findAfter(uint64_t uncompressedOffset, SeekCheckpoint& out) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = std::lower_bound(m_checkpoints.begin(), m_checkpoints.end(), uncompressedOffset,
+        [](const SeekCheckpoint& a, uint64_t offset) { return a.uncompressedOffset < offset; });
+    if (it == m_checkpoints.end()) return false;
+
+    out = *it;
+    return true;
+}
+
+bool SeekIndex::findByLine(uint64_t lineNumber, SeekCheckpoint& out) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Decoding from a checkpoint inside line L drops that partial line and
+    // starts at L + 1, so it can only reach lines after L. Checkpoints with
+    // unknown line numbers are interleaved, so scan rather than bisect.
+    for (auto it = m_checkpoints.rbegin(); it != m_checkpoints.rend(); ++it) {
+        if (it->lineNumber == SeekCheckpoint::UNKNOWN_LINE) continue;
+        if (it->lineNumber < lineNumber || (it->lineStart && it->lineNumber == lineNumber)) {
+            out = *it;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t SeekIndex::uncompressedSize() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_uncompressedSize;
+}
+
+void SeekIndex::setUncompressedSize(uint64_t size) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_uncompressedSize != size) {
+        m_uncompressedSize = size;
+        m_dirty = true;
+    }
+}
+
+size_t SeekIndex::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_checkpoints.size();
+}
+
+// ============================================================================
+// Zstd seekable format
+// ============================================================================
+
+static uint32_t readLE32(const char* p) {
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+    return static_cast<uint32_t>(u[0]) | (static_cast<uint32_t>(u[1]) << 8) |
+           (static_cast<uint32_t>(u[2]) << 16) | (static_cast<uint32_t>(u[3]) << 24);
+}
+
+size_t parseZstdSeekTable(const std::string& tail, uint64_t objectSize,
+                          std::vector<SeekCheckpoint>& frames, uint64_t& uncompressedSize) {
+    // Footer: Number_Of_Frames (4), Seek_Table_Descriptor (1), Seekable_Magic_Number (4)
+    constexpr size_t FOOTER_SIZE = 9;
+    constexpr uint32_t SEEKABLE_MAGIC = 0x8F92EAB1;
+    constexpr uint32_t SKIPPABLE_MAGIC = 0x184D2A5E;
+
+    if (tail.size() < FOOTER_SIZE || objectSize < tail.size()) return 0;
+
+    const char* footer = tail.data() + tail.size() - FOOTER_SIZE;
+    if (readLE32(footer + 5) != SEEKABLE_MAGIC) return 0;
+
+    uint32_t numFrames = readLE32(footer);
+    unsigned char descriptor = static_cast<unsigned char>(footer[4]);
+    if (descriptor & 0x7C) return 0;  // Reserved bits must be zero
+
+    // Each entry: Compressed_Size (4), Decompressed_Size (4), optional Checksum (4)
+    uint64_t entrySize = (descriptor & 0x80) ? 12 : 8;
+    uint64_t tableSize = 8 + numFrames * entrySize + FOOTER_SIZE;
+    if (tableSize > objectSize) return 0;
+    if (tableSize > tail.size()) return static_cast<size_t>(tableSize);
+
+    const char* table = tail.data() + tail.size() - tableSize;
+    if (readLE32(table) != SKIPPABLE_MAGIC || readLE32(table + 4) != tableSize - 8) return 0;
+
+    std::vector<SeekCheckpoint> parsed;
+    parsed.reserve(numFrames);
+    uint64_t compressedOffset = 0;
+    uint64_t uncompressedOffset = 0;
+    const char* entry = table + 8;
+    for (uint32_t i = 0; i < numFrames; ++i, entry += entrySize) {
+        SeekCheckpoint cp;
+        cp.compressedOffset = compressedOffset;
+        cp.uncompressedOffset = uncompressedOffset;
+        cp.lineNumber = uncompressedOffset == 0 ? 0 : SeekCheckpoint::UNKNOWN_LINE;
+        cp.lineStart = uncompressedOffset == 0;
+        parsed.push_back(std::move(cp));
+
+        compressedOffset += readLE32(entry);
+        uncompressedOffset += readLE32(entry + 4);
+    }
+
+    // The frames and the table must make up the whole object
+    if (compressedOffset + tableSize != objectSize) return 0;
+
+    frames = std::move(parsed);
+    uncompressedSize = uncompressedOffset;
+    return static_cast<size_t>(tableSize);
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+
+// A point in a compressed stream where decompression can be restarted
+// without decoding everything before it. For gzip this is a deflate block
+// boundary plus the inflate window (the technique from zlib's zran.c); for
+// zstd it's the start of a frame, which needs no extra state.
+struct SeekCheckpoint {
+    static constexpr uint64_t UNKNOWN_LINE = UINT64_MAX;
+
+    uint64_t compressedOffset = 0;    // First input byte not yet consumed at this point
+    int bits = 0;                     // Gzip: bits of the byte before compressedOffset still unused (0-7)
+    uint64_t uncompressedOffset = 0;  // Output produced before this point
+    uint64_t lineNumber = 0;          // Newlines in the output before this point, or UNKNOWN_LINE
+    bool lineStart = false;           // Output before this point ends with a newline
+    std::string window;               // Gzip: last 32KB of output (inflate dictionary)
+};
+
+// Checkpoints recorded while an object is decompressed (or read from a zstd
+// seek table), persisted per object version so a later open can seek straight
+// into the middle of it.
+// Thread-safe: the decode worker adds checkpoints while the UI looks them up.
+class SeekIndex {
+public:
+    // Spacing between checkpoints, in uncompressed bytes
+    static constexpr uint64_t CHECKPOINT_SPAN = 4 * 1024 * 1024;
+
+    // path is where the index is saved; empty keeps it in memory only
+    SeekIndex(std::string path, uint64_t compressedSize);
+
+    // Cache file for an object version, or "" if the object has no ETag
+    static std::string cachePath(const std::string& bucket, const std::string& key,
+                                 const std::string& etag);
+
+    // Load checkpoints saved by an earlier session, if any
+    void load();
+
+    // Save if checkpoints were added since the last load/save
+    void saveIfDirty();
+
+    // Add a checkpoint; ignored if one already exists within half a span of it,
+    // except that it fills in the unknown line number of one at the same offset
+    // (never a known one, nor with a number out of order with its neighbours)
+    void add(SeekCheckpoint checkpoint);
+
+    // Latest checkpoint at or before an uncompressed offset
+    bool findByOffset(uint64_t uncompressedOffset, SeekCheckpoint& out) const;
+
+    // Earliest checkpoint at or after an uncompressed offset
+    bool findAfter(uint64_t uncompressedOffset, SeekCheckpoint& out) const;
+
+    // Latest checkpoint with a known line number that lies before the start of a line
+    bool findByLine(uint64_t lineNumber, SeekCheckpoint& out) const;
+
+    // Size of the decompressed object, or 0 while unknown
+    uint64_t uncompressedSize() const;
+    void setUncompressedSize(uint64_t size);
+
+    size_t size() const;
+
+private:
+    std::string m_path;
+    uint64_t m_compressedSize;
+
+    // lineNumber fits between the known line numbers around at (m_mutex held)
+    bool linesConsistent(std::vector<SeekCheckpoint>::const_iterator at, uint64_t lineNumber) const;
+
+    mutable std::mutex m_mutex;
+    std::vector<SeekCheckpoint> m_checkpoints;  // Sorted by uncompressedOffset
+    uint64_t m_uncompressedSize = 0;
+    bool m_dirty = false;
+};
+
+// Reads the seek table of a zstd object in the seekable format (a skippable
+// frame at the end of the object listing every frame's sizes).
+// tail holds the last bytes of an object of objectSize bytes. Returns how many
+// trailing bytes the seek table spans; if that's more than tail.size(), fetch
+// that many and call again. Returns 0 if the object has no seek table.
+// On success, frames gets one checkpoint per frame (line numbers unknown)
+// and uncompressedSize the decompressed size of the whole object.
+size_t parseZstdSeekTable(const std::string& tail, uint64_t objectSize,
+                          std::vector<SeekCheckpoint>& frames, uint64_t& uncompressedSize);
@@ -73,6 +73,7 @@ AppSettings loadSettings() {
         settings.profile_name = j.value("profile", "");
         settings.bucket = j.value("bucket", "");
         settings.prefix = j.value("prefix", "");
+        settings.cache_budget_mb = j.value("cache_budget_mb", settings.cache_budget_mb);
         if (j.contains("frecent_paths") && j["frecent_paths"].is_object()) {
             for (auto& [profile, entries] : j["frecent_paths"].items()) {
                 if (entries.is_array()) {
@@ -122,6 +123,7 @@ void saveSettings(const AppSettings& settings) {
     j["profile"] = settings.profile_name;
     j["bucket"] = settings.bucket;
     j["prefix"] = settings.prefix;
+    j["cache_budget_mb"] = settings.cache_budget_mb;
     j["frecent_paths"] = json::object();
     for (const auto& [profile, entries] : settings.frecent_paths) {
         json arr = json::array();
@@ -134,3 +136,25 @@ void saveSettings(const AppSettings& settings) {
     file << j.dump(2) << std::endl;
     LOG_F(INFO, "Saved settings to %s", path.c_str());
 }
+
+std::string cacheDirectory(const std::string& subdir) {
+    const char* home = std::getenv("HOME");
+    if (!home) {
+        return "";
+    }
+
+#ifdef __APPLE__
+    std::string dir = std::string(home) + "/Library/Caches/s6ui/" + subdir;
+#else
+    const char* xdg_cache = std::getenv("XDG_CACHE_HOME");
+    std::string dir = (xdg_cache && xdg_cache[0] != '\0')
+        ? std::string(xdg_cache) + "/s6ui/" + subdir
+        : std::string(home) + "/.cache/s6ui/" + subdir;
+#endif
+
+    if (!createDirRecursive(dir)) {
+        LOG_F(WARNING, "Failed to create cache directory: %s", dir.c_str());
+        return "";
+    }
+    return dir;
+}
@@ -16,6 +16,7 @@ struct AppSettings {
     std::string bucket;
     std::string prefix;
     std::map<std::string, std::vector<PathEntry>> frecent_paths;  // per-profile frecency data
+    int64_t cache_budget_mb = 512;  // Memory for cached folder listings and prefetched previews only
 };
 
 // Load settings from ~/.config/s6ui/settings.json
@@ -25,3 +26,8 @@ AppSettings loadSettings();
 // Save settings to ~/.config/s6ui/settings.json
 // Creates directory if needed, logs warning on failure
 void saveSettings(const AppSettings& settings);
+
+// Per-user cache directory for subdir (~/.cache/s6ui/<subdir> on Linux,
+// ~/Library/Caches/s6ui/<subdir> on macOS), created if needed
+// Returns empty string if it can't be determined or created
+std::string cacheDirectory(const std::string& subdir);
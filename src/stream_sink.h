@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+// Receives streamed object bytes directly on the backend's I/O thread,
+// instead of through ObjectRangeLoaded events on the UI thread
+class IStreamSink {
+public:
+    virtual ~IStreamSink() = default;
+
+    // Offer the next in-order chunk (offset is the byte offset in the object).
+    // Returning false means the consumer is full; the chunk is left untouched
+    // and the backend offers it again later, slowing the download meanwhile.
+    virtual bool offerChunk(std::string& data, size_t offset) = 0;
+
+    // Bytes the consumer queues before it starts refusing chunks. The backend
+    // keeps no more than this in parts downloading ahead of it.
+    virtual size_t queueLimit() const = 0;
+};
@@ -3,8 +3,10 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <cstdlib>
 #include <cstring>
+#include <algorithm>
 
 // ============================================================================
 // GzipTransform implementation
@@ -25,6 +27,38 @@ GzipTransform::GzipTransform() {
     LOG_F(INFO, "GzipTransform: initialized successfully");
 }
 
+GzipTransform::GzipTransform(std::shared_ptr<SeekIndex> index)
+    : GzipTransform()
+{
+    m_index = std::move(index);
+}
+
+GzipTransform::GzipTransform(const SeekCheckpoint& from, std::shared_ptr<SeekIndex> index)
+    : m_index(std::move(index))
+    , m_inOffset(from.compressedOffset)
+    , m_outOffset(from.uncompressedOffset)
+    , m_lines(from.lineNumber)
+    , m_nextCheckpoint(from.uncompressedOffset + SeekIndex::CHECKPOINT_SPAN)
+    , m_resumePending(true)
+    , m_resumeBits(from.bits)
+    , m_resumeWindow(from.window)
+{
+    memset(&m_zstream, 0, sizeof(m_zstream));
+
+    // Checkpoints sit inside the deflate stream, past the gzip header
+    int ret = inflateInit2(&m_zstream, -MAX_WBITS);
+    if (ret != Z_OK) {
+        LOG_F(ERROR, "GzipTransform: inflateInit2 failed with code %d", ret);
+        m_error = true;
+        return;
+    }
+
+    m_initialized = true;
+    LOG_F(INFO, "GzipTransform: resuming at compressed offset %llu (uncompressed %llu)",
+          static_cast<unsigned long long>(from.compressedOffset),
+          static_cast<unsigned long long>(from.uncompressedOffset));
+}
+
 GzipTransform::~GzipTransform() {
     if (m_initialized) {
         inflateEnd(&m_zstream);
@@ -37,6 +71,30 @@ std::string GzipTransform::transform(const char* data, size_t len) {
         return "";
     }
 
+    if (m_resumePending) {
+        m_resumePending = false;
+
+        // A checkpoint between bytes needs the leftover bits of the byte before it
+        if (m_resumeBits) {
+            unsigned char partial = static_cast<unsigned char>(data[0]);
+            inflatePrime(&m_zstream, m_resumeBits, partial >> (8 - m_resumeBits));
+            ++data;
+            --len;
+        }
+
+        int ret = inflateSetDictionary(&m_zstream,
+            reinterpret_cast<const Bytef*>(m_resumeWindow.data()),
+            static_cast<uInt>(m_resumeWindow.size()));
+        std::string().swap(m_resumeWindow);
+        if (ret != Z_OK) {
+            LOG_F(ERROR, "GzipTransform: inflateSetDictionary failed with code %d", ret);
+            m_error = true;
+            return "";
+        }
+
+        if (len == 0) return "";
+    }
+
     std::string output;
     output.reserve(len * 2);  // Guess: decompressed is ~2x compressed
 
@@ -44,14 +102,17 @@ std::string GzipTransform::transform(const char* data, size_t len) {
     m_zstream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
     m_zstream.avail_in = static_cast<uInt>(len);
 
-    // Decompress in chunks
+    // Decompress in chunks, stopping at block boundaries when recording checkpoints
     char outbuf[32768];  // 32KB output buffer
+    int flush = m_index ? Z_BLOCK : Z_NO_FLUSH;
 
     do {
         m_zstream.next_out = reinterpret_cast<Bytef*>(outbuf);
         m_zstream.avail_out = sizeof(outbuf);
 
-        int ret = inflate(&m_zstream, Z_NO_FLUSH);
+        uInt availIn = m_zstream.avail_in;
+        int ret = inflate(&m_zstream, flush);
+        m_inOffset += availIn - m_zstream.avail_in;
 
         if (ret == Z_STREAM_ERROR) {
             LOG_F(ERROR, "GzipTransform: Z_STREAM_ERROR");
@@ -71,18 +132,57 @@ std::string GzipTransform::transform(const char* data, size_t len) {
 
         size_t have = sizeof(outbuf) - m_zstream.avail_out;
         output.append(outbuf, have);
+        m_outOffset += have;
+        // Resumed from a checkpoint whose line is unknown: stays unknown
+        if (m_index && m_lines != SeekCheckpoint::UNKNOWN_LINE) {
+            m_lines += static_cast<uint64_t>(std::count(outbuf, outbuf + have, '\n'));
+        }
 
         // Z_STREAM_END means we've finished decompressing
         if (ret == Z_STREAM_END) {
             LOG_F(INFO, "GzipTransform: reached end of compressed stream");
+            if (m_index) {
+                m_index->setUncompressedSize(m_outOffset);
+            }
             break;
         }
 
-    } while (m_zstream.avail_out == 0);
+        // Bit 7 of data_type: stopped at the end of a block; bit 6: it was the last one
+        if (m_index && m_outOffset >= m_nextCheckpoint &&
+            (m_zstream.data_type & 128) && !(m_zstream.data_type & 64)) {
+            recordCheckpoint();
+        }
+
+        // No progress possible until more input arrives
+        if (ret == Z_BUF_ERROR) {
+            break;
+        }
+
+    } while (m_zstream.avail_in > 0 || m_zstream.avail_out == 0);
 
     return output;
 }
 
+void GzipTransform::recordCheckpoint() {
+    SeekCheckpoint checkpoint;
+    checkpoint.compressedOffset = m_inOffset;
+    checkpoint.bits = m_zstream.data_type & 7;
+    checkpoint.uncompressedOffset = m_outOffset;
+    checkpoint.lineNumber = m_lines;
+
+    checkpoint.window.resize(32768);
+    uInt windowSize = static_cast<uInt>(checkpoint.window.size());
+    if (inflateGetDictionary(&m_zstream, reinterpret_cast<Bytef*>(checkpoint.window.data()),
+                             &windowSize) != Z_OK) {
+        return;
+    }
+    checkpoint.window.resize(windowSize);
+    checkpoint.lineStart = windowSize > 0 && checkpoint.window.back() == '\n';
+
+    m_index->add(std::move(checkpoint));
+    m_nextCheckpoint = m_outOffset + SeekIndex::CHECKPOINT_SPAN;
+}
+
 std::string GzipTransform::flush() {
     if (!m_initialized || m_error) {
         return "";
@@ -149,7 +249,28 @@ ZstdTransform::ZstdTransform() {
     LOG_F(INFO, "ZstdTransform: initialized successfully");
 }
 
+ZstdTransform::ZstdTransform(std::shared_ptr<SeekIndex> index)
+    : ZstdTransform()
+{
+    m_index = std::move(index);
+}
+
+ZstdTransform::ZstdTransform(const SeekCheckpoint& from, std::shared_ptr<SeekIndex> index)
+    : ZstdTransform()
+{
+    // Frames are independent, so resuming only needs the offsets
+    m_index = std::move(index);
+    m_inOffset = from.compressedOffset;
+    m_outOffset = from.uncompressedOffset;
+    m_lines = from.lineNumber;
+    m_lineStart = from.lineStart;
+    LOG_F(INFO, "ZstdTransform: resuming at compressed offset %llu (uncompressed %llu)",
+          static_cast<unsigned long long>(from.compressedOffset),
+          static_cast<unsigned long long>(from.uncompressedOffset));
+}
+
 ZstdTransform::~ZstdTransform() {
+    // Frame jobs own their input, so any still queued can be left to finish
     if (m_dstream) {
         ZSTD_freeDStream(m_dstream);
         m_dstream = nullptr;
@@ -162,45 +283,211 @@ std::string ZstdTransform::transform(const char* data, size_t len) {
     }
 
     std::string output;
-    output.reserve(len * 4);  // Guess: decompressed is ~4x compressed
+    if (!m_parallel) {
+        output.reserve(len * 4);  // Guess: decompressed is ~4x compressed
+        decodeSerial(data, len, output);
+        return output;
+    }
 
+    m_input.append(data, len);
+    splitFrames();
+    collectFrames(output, false);
+
+    if (!m_error && m_input.size() > MAX_FRAME_BYTES) {
+        // Frames this large gain little from the pool; stream the rest of the object
+        LOG_F(INFO, "ZstdTransform: frame larger than %zu bytes, decoding serially", MAX_FRAME_BYTES);
+        collectFrames(output, true);
+        m_parallel = false;
+        m_serialOnly = true;
+        m_inOffset = m_inputOffset;
+        std::string input;
+        input.swap(m_input);
+        decodeSerial(input.data(), input.size(), output);
+    }
+    return output;
+}
+
+void ZstdTransform::decodeSerial(const char* data, size_t len, std::string& output) {
     ZSTD_inBuffer input = { data, len, 0 };
 
     // Decompress in chunks
     const size_t outBufSize = ZSTD_DStreamOutSize();
     std::vector<char> outbuf(outBufSize);
+    bool outputFull = false;
+
+    while (input.pos < input.size || outputFull) {
+        if (m_frameDone && !m_serialOnly && input.pos < input.size) {
+            // Another frame follows: split the rest into frames for the pool
+            m_parallel = true;
+            m_inputOffset = m_inOffset;
+            m_input.assign(data + input.pos, input.size - input.pos);
+            splitFrames();
+            collectFrames(output, false);
+            return;
+        }
 
-    while (input.pos < input.size) {
         ZSTD_outBuffer outBuffer = { outbuf.data(), outbuf.size(), 0 };
 
+        size_t consumedBefore = input.pos;
         size_t ret = ZSTD_decompressStream(m_dstream, &outBuffer, &input);
+        m_inOffset += input.pos - consumedBefore;
 
         if (ZSTD_isError(ret)) {
             LOG_F(ERROR, "ZstdTransform: ZSTD_decompressStream error: %s", ZSTD_getErrorName(ret));
             m_error = true;
-            return output;
+            return;
         }
 
-        if (outBuffer.pos > 0) {
-            output.append(outbuf.data(), outBuffer.pos);
+        appendOutput(output, outbuf.data(), outBuffer.pos);
+        outputFull = outBuffer.pos == outBuffer.size;
+
+        // ret == 0 means end of frame; the DStream stops there, so any
+        // remaining input starts the next frame
+        m_frameDone = ret == 0;
+        if (m_frameDone) {
+            recordFrameStart(m_inOffset);
         }
+    }
+}
 
-        // ret == 0 means end of frame, but there might be more frames
-        // Continue processing input
+void ZstdTransform::splitFrames() {
+    size_t pos = 0;
+    while (pos < m_input.size()) {
+        size_t frameSize = ZSTD_findFrameCompressedSize(m_input.data() + pos, m_input.size() - pos);
+        if (ZSTD_isError(frameSize)) {
+            if (ZSTD_getErrorCode(frameSize) == ZSTD_error_srcSize_wrong) {
+                break;  // Rest of the frame hasn't arrived yet
+            }
+            LOG_F(ERROR, "ZstdTransform: bad frame at offset %llu: %s",
+                  static_cast<unsigned long long>(m_inputOffset + pos), ZSTD_getErrorName(frameSize));
+            m_error = true;
+            break;
+        }
+
+        // The job owns its copy of the frame, so it outlives this transform safely
+        std::string frame = m_input.substr(pos, frameSize);
+        m_jobs.push_back(FrameJob{
+            m_inputOffset + pos,
+            ThreadPool::shared().submit([frame = std::move(frame)] { return decompressFrame(frame); })
+        });
+        pos += frameSize;
     }
 
-    return output;
+    m_input.erase(0, pos);
+    m_inputOffset += pos;
+}
+
+void ZstdTransform::collectFrames(std::string& output, bool wait) {
+    // Keep about two frames per pool thread in flight to bound memory
+    const size_t maxJobs = 2 * ThreadPool::shared().threadCount();
+
+    while (!m_jobs.empty()) {
+        FrameJob& job = m_jobs.front();
+        bool ready = job.result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        if (!ready && !wait && m_jobs.size() <= maxJobs) break;
+
+        FrameResult result = job.result.get();
+        if (!result.error.empty()) {
+            LOG_F(ERROR, "ZstdTransform: frame at offset %llu: %s",
+                  static_cast<unsigned long long>(job.compressedOffset), result.error.c_str());
+            m_error = true;
+            m_jobs.clear();
+            return;
+        }
+
+        recordFrameStart(job.compressedOffset);
+        appendOutput(output, result.data.data(), result.data.size());
+        m_jobs.pop_front();
+    }
+}
+
+ZstdTransform::FrameResult ZstdTransform::decompressFrame(const std::string& frame) {
+    // Runs on a pool thread
+    FrameResult result;
+
+    unsigned long long contentSize = ZSTD_getFrameContentSize(frame.data(), frame.size());
+    if (contentSize != ZSTD_CONTENTSIZE_UNKNOWN && contentSize != ZSTD_CONTENTSIZE_ERROR &&
+        contentSize <= 4 * MAX_FRAME_BYTES) {
+        result.data.resize(static_cast<size_t>(contentSize));
+        size_t ret = ZSTD_decompress(result.data.data(), result.data.size(), frame.data(), frame.size());
+        if (ZSTD_isError(ret)) {
+            result.error = ZSTD_getErrorName(ret);
+        }
+        result.data.resize(ZSTD_isError(ret) ? 0 : ret);
+        return result;
+    }
+
+    // Size not in the header: stream it
+    ZSTD_DStream* dstream = ZSTD_createDStream();
+    if (!dstream) {
+        result.error = "ZSTD_createDStream failed";
+        return result;
+    }
+    ZSTD_inBuffer input = { frame.data(), frame.size(), 0 };
+    std::vector<char> outbuf(ZSTD_DStreamOutSize());
+    size_t ret = 1;
+    while (ret != 0) {
+        ZSTD_outBuffer outBuffer = { outbuf.data(), outbuf.size(), 0 };
+        ret = ZSTD_decompressStream(dstream, &outBuffer, &input);
+        if (ZSTD_isError(ret)) {
+            result.error = ZSTD_getErrorName(ret);
+            break;
+        }
+        result.data.append(outbuf.data(), outBuffer.pos);
+        if (input.pos == input.size && outBuffer.pos < outBuffer.size && ret != 0) {
+            result.error = "truncated frame";
+            break;
+        }
+    }
+    ZSTD_freeDStream(dstream);
+    return result;
+}
+
+void ZstdTransform::appendOutput(std::string& output, const char* data, size_t len) {
+    if (len == 0) return;
+
+    output.append(data, len);
+    m_outOffset += len;
+    if (m_index) {
+        // Resumed from a seek-table frame whose line is unknown: stays unknown,
+        // so frame starts are recorded without one
+        if (m_lines != SeekCheckpoint::UNKNOWN_LINE) {
+            m_lines += static_cast<uint64_t>(std::count(data, data + len, '\n'));
+        }
+        m_lineStart = data[len - 1] == '\n';
+    }
+}
+
+void ZstdTransform::recordFrameStart(uint64_t compressedOffset) {
+    if (!m_index || m_outOffset == 0) return;
+
+    SeekCheckpoint checkpoint;
+    checkpoint.compressedOffset = compressedOffset;
+    checkpoint.uncompressedOffset = m_outOffset;
+    checkpoint.lineNumber = m_lines;
+    checkpoint.lineStart = m_lineStart;
+    m_index->add(std::move(checkpoint));
 }
 
 std::string ZstdTransform::flush() {
-    // For zstd streaming, all data should be flushed during transform()
-    // This is called when stream completes, nothing special needed
+    // Serially decoded data is all flushed during transform(); only frames
+    // still on the pool are left
     if (!m_dstream || m_error) {
         return "";
     }
 
+    std::string output;
+    collectFrames(output, true);
+    if (!m_input.empty()) {
+        LOG_F(WARNING, "ZstdTransform::flush: %zu bytes of incomplete frame at end of stream", m_input.size());
+    }
+
+    if (m_index && !m_error) {
+        m_index->setUncompressedSize(m_outOffset);
+    }
+
     LOG_F(INFO, "ZstdTransform::flush: stream complete");
-    return "";
+    return output;
 }
 
 // ============================================================================
@@ -231,6 +518,7 @@ StreamingFilePreview::StreamingFilePreview(
     m_fd = mkstemp(pathBuf.data());
     if (m_fd < 0) {
         LOG_F(ERROR, "StreamingFilePreview: failed to create temp file: %s", strerror(errno));
+        m_queue->close();
         return;
     }
 
@@ -238,23 +526,31 @@ StreamingFilePreview::StreamingFilePreview(
     LOG_F(INFO, "StreamingFilePreview: created temp file %s for %s/%s (total=%zu bytes)",
           m_tempFilePath.c_str(), bucket.c_str(), key.c_str(), totalFileSize);
 
-    // Initialize with first line offset
-    m_lineOffsets.push_back(0);
+    m_lineIndex = std::make_shared<LineIndex>();
 
-    // Write initial data
+    // Process the initial data synchronously so the preview is usable right away
+    // (derived previews built from an in-memory string are complete at this point)
     if (!initialData.empty()) {
-        std::string transformed = m_transform->transform(initialData.data(), initialData.size());
-        writeToTempFile(transformed.data(), transformed.size());
-        m_bytesDownloaded = initialData.size();
+        processChunk(initialData.data(), initialData.size(), 0);
+    }
 
-        // Check if we got the whole file
-        if (m_bytesDownloaded >= m_totalSourceSize) {
-            finishStream();
-        }
+    // Started here, on the owner's thread, rather than by the first chunk,
+    // which may come from the backend's I/O thread
+    if (!m_complete && !m_failed) {
+        m_worker = std::thread(&StreamingFilePreview::workerLoop, this);
+    } else {
+        m_queue->close();
     }
 }
 
 StreamingFilePreview::~StreamingFilePreview() {
+    // Stop the decode worker before the file goes away. The backend may still
+    // hold the queue; it just drops whatever it offers from now on.
+    m_queue->close();
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+
     if (m_fd >= 0) {
         close(m_fd);
         m_fd = -1;
@@ -276,57 +572,193 @@ void StreamingFilePreview::setTransform(std::unique_ptr<IStreamTransform> transf
     m_transform = std::move(transform);
 }
 
+void StreamingFilePreview::seekTo(size_t sourceOffset, uint64_t uncompressedOffset,
+                                  uint64_t lineNumber, bool atLineStart) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_bytesDownloaded > 0 || m_bytesWritten > 0) {
+        LOG_F(WARNING, "StreamingFilePreview: seekTo called after data received, ignoring");
+        return;
+    }
+
+    // No chunks yet, so the decode worker hasn't started and can't race these
+    m_nextSourceOffset = sourceOffset;
+    m_skipPartialLine = !atLineStart;
+    m_bytesDownloaded = sourceOffset;
+    m_firstByteOffset = uncompressedOffset;
+    m_firstLineNumber = lineNumber;
+}
+
 void StreamingFilePreview::appendChunk(const std::string& data, size_t offset) {
+    if (m_fd < 0) return;
+    m_queue->push(data, offset);
+}
+
+bool StreamingFilePreview::ChunkQueue::offerChunk(std::string& data, size_t offset) {
     std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_closed) {
+        data.clear();
+        return true;
+    }
+    // Always take at least one chunk so an oversized one can't stall the stream
+    if (!m_chunks.empty() && m_bytes + data.size() > MAX_QUEUED_BYTES) {
+        return false;
+    }
+    m_bytes += data.size();
+    m_chunks.push_back(PendingChunk{std::move(data), offset});
+    m_cv.notify_one();
+    return true;
+}
+
+void StreamingFilePreview::ChunkQueue::push(std::string data, size_t offset) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_closed) return;
+    m_bytes += data.size();
+    m_chunks.push_back(PendingChunk{std::move(data), offset});
+    m_cv.notify_one();
+}
+
+bool StreamingFilePreview::ChunkQueue::pop(PendingChunk& chunk) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [this] { return m_closed || !m_chunks.empty(); });
+    if (m_closed) return false;
+
+    chunk = std::move(m_chunks.front());
+    m_chunks.pop_front();
+    m_bytes -= chunk.data.size();
+    return true;
+}
+
+void StreamingFilePreview::ChunkQueue::close() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_chunks.clear();
+        m_bytes = 0;
+    }
+    m_cv.notify_all();
+}
+
+void StreamingFilePreview::workerLoop() {
+    loguru::set_thread_name("PreviewDecode");
+
+    PendingChunk chunk;
+    while (m_queue->pop(chunk)) {
+        processChunk(chunk.data.data(), chunk.data.size(), chunk.offset);
+    }
+}
+
+void StreamingFilePreview::processChunk(const char* data, size_t len, size_t offset) {
+    // Runs on the decode worker (or in the constructor, before it exists)
 
     if (m_fd < 0) {
-        LOG_F(WARNING, "StreamingFilePreview: appendChunk called but no temp file");
+        LOG_F(WARNING, "StreamingFilePreview: chunk received but no temp file");
         return;
     }
+    if (m_failed) return;
 
-    if (offset != m_bytesDownloaded) {
+    if (offset != m_nextSourceOffset) {
         LOG_F(WARNING, "StreamingFilePreview: chunk offset mismatch, expected %zu got %zu",
-              m_bytesDownloaded, offset);
-        // We could handle out-of-order chunks here, but for now assume sequential
+              m_nextSourceOffset, offset);
+        // Chunks are delivered in order by the backend; anything else is stale
         return;
     }
 
-    // Transform the data (e.g., decompress)
-    std::string transformed = m_transform->transform(data.data(), data.size());
+    // Transform the data (e.g., decompress) and write it out without holding the lock
+    std::string transformed = m_transform->transform(data, len);
+    size_t skip = m_skipPartialLine ? skipPartialLine(transformed) : 0;
+    size_t baseOffset = m_bytesWrittenUnlocked;
+    size_t written = writeToTempFile(transformed.data() + skip, transformed.size() - skip);
+    m_nextSourceOffset += len;
+
+    std::vector<uint64_t> newOffsets;
+    findNewlines(transformed.data() + skip, written, baseOffset, newOffsets);
+    m_bytesWrittenUnlocked += written;
+
+    // Publish the finished work
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_lineIndex->append(newOffsets);
+        m_bytesWritten = m_bytesWrittenUnlocked;
+        m_bytesDownloaded = m_nextSourceOffset;
+        if (written > 0) m_generation++;
+    }
 
-    // Write to temp file
-    writeToTempFile(transformed.data(), transformed.size());
-    m_bytesDownloaded += data.size();
+    LOG_F(1, "StreamingFilePreview: decoded %zu bytes at offset %zu, total downloaded=%zu/%zu, written=%zu",
+          len, offset, m_nextSourceOffset, m_totalSourceSize, m_bytesWrittenUnlocked);
 
-    LOG_F(1, "StreamingFilePreview: appended %zu bytes at offset %zu, total downloaded=%zu/%zu, lines=%zu",
-          data.size(), offset, m_bytesDownloaded, m_totalSourceSize, m_lineOffsets.size());
+    // What came out before the corruption is kept; nothing after it is usable
+    if (m_transform->hasError()) {
+        failStream("Can't decompress the data at byte " + std::to_string(offset));
+        return;
+    }
 
     // Check if we're done
-    if (m_bytesDownloaded >= m_totalSourceSize) {
+    if (m_nextSourceOffset >= m_totalSourceSize) {
         finishStream();
     }
 }
 
 void StreamingFilePreview::finishStream() {
-    // Already holding lock from caller or constructor
+    // Runs on the decode worker (or in the constructor)
 
     if (m_complete) return;
 
     // Flush any remaining transform data
     std::string remaining = m_transform->flush();
-    if (!remaining.empty()) {
-        writeToTempFile(remaining.data(), remaining.size());
+    size_t skip = m_skipPartialLine ? skipPartialLine(remaining) : 0;
+    std::vector<uint64_t> newOffsets;
+    if (remaining.size() > skip) {
+        size_t baseOffset = m_bytesWrittenUnlocked;
+        size_t written = writeToTempFile(remaining.data() + skip, remaining.size() - skip);
+        findNewlines(remaining.data() + skip, written, baseOffset, newOffsets);
+        m_bytesWrittenUnlocked += written;
     }
 
-    m_complete = true;
-    LOG_F(INFO, "StreamingFilePreview: stream complete, %zu bytes downloaded, %zu bytes written, %zu lines",
-          m_bytesDownloaded, m_bytesWritten, m_lineOffsets.size());
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_lineIndex->append(newOffsets);
+        m_bytesWritten = m_bytesWrittenUnlocked;
+        if (!m_transform->hasError()) {
+            m_complete = true;
+            m_generation++;
+            LOG_F(INFO, "StreamingFilePreview: stream complete, %zu bytes downloaded, %zu bytes written, %zu lines",
+                  m_bytesDownloaded, m_bytesWritten, m_lineIndex->lineCount());
+            return;
+        }
+    }
+    failStream("Can't decompress the end of the file");
+}
+
+void StreamingFilePreview::failStream(const std::string& error) {
+    // Runs on the decode worker (or in the constructor)
+
+    m_failed = true;
+    m_queue->close();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_error = error;
+    m_generation++;
+    LOG_F(ERROR, "StreamingFilePreview: %s, stopped after %zu bytes written", m_error.c_str(), m_bytesWritten);
 }
 
-void StreamingFilePreview::writeToTempFile(const char* data, size_t len) {
-    // Caller must hold lock
+size_t StreamingFilePreview::skipPartialLine(const std::string& data) {
+    // After seekTo, output starts mid-line; drop it through the first newline
+    const char* newline = static_cast<const char*>(memchr(data.data(), '\n', data.size()));
+    size_t skip = newline ? static_cast<size_t>(newline - data.data()) + 1 : data.size();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_firstByteOffset += skip;
+    if (newline) {
+        m_skipPartialLine = false;
+        if (m_firstLineNumber != SeekCheckpoint::UNKNOWN_LINE) {
+            m_firstLineNumber += 1;
+        }
+    }
+    return skip;
+}
 
-    if (m_fd < 0 || len == 0) return;
+size_t StreamingFilePreview::writeToTempFile(const char* data, size_t len) {
+    if (m_fd < 0 || len == 0) return 0;
 
     // Write all data, handling partial writes
     size_t totalWritten = 0;
@@ -341,33 +773,12 @@ void StreamingFilePreview::writeToTempFile(const char* data, size_t len) {
         totalWritten += static_cast<size_t>(written);
     }
 
-    if (totalWritten == 0) return;
-
-    // Index newlines only in the data we actually wrote
-    size_t baseOffset = m_bytesWritten;
-    indexNewlines(data, totalWritten, baseOffset);
-
-    m_bytesWritten += totalWritten;
-}
-
-void StreamingFilePreview::indexNewlines(const char* data, size_t len, size_t baseOffset) {
-    // Caller must hold lock
-
-    for (size_t i = 0; i < len; ++i) {
-        if (data[i] == '\n') {
-            // The next line starts at the byte after this newline
-            size_t nextLineOffset = baseOffset + i + 1;
-            // Only add if there's more data (or will be more data)
-            if (nextLineOffset < m_bytesWritten + len || !m_complete) {
-                m_lineOffsets.push_back(nextLineOffset);
-            }
-        }
-    }
+    return totalWritten;
 }
 
 size_t StreamingFilePreview::lineCount() const {
     std::lock_guard<std::mutex> lock(m_mutex);
-    return m_lineOffsets.size();
+    return m_lineIndex->lineCount();
 }
 
 size_t StreamingFilePreview::bytesDownloaded() const {
@@ -390,33 +801,35 @@ bool StreamingFilePreview::isComplete() const {
     return m_complete;
 }
 
+std::string StreamingFilePreview::error() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_error;
+}
+
 size_t StreamingFilePreview::nextByteNeeded() const {
     std::lock_guard<std::mutex> lock(m_mutex);
     return m_bytesDownloaded;
 }
 
-std::string StreamingFilePreview::getLine(size_t lineIndex) const {
+uint64_t StreamingFilePreview::firstLineNumber() const {
     std::lock_guard<std::mutex> lock(m_mutex);
+    return m_firstLineNumber;
+}
 
-    if (m_fd < 0) return "";
-    if (lineIndex >= m_lineOffsets.size()) return "";
+uint64_t StreamingFilePreview::firstByteOffset() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_firstByteOffset;
+}
 
-    size_t startOffset = m_lineOffsets[lineIndex];
+std::string StreamingFilePreview::getLine(size_t lineIndex) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
 
-    // Determine end offset
-    size_t endOffset;
-    if (lineIndex + 1 < m_lineOffsets.size()) {
-        // End at start of next line (minus the newline character)
-        endOffset = m_lineOffsets[lineIndex + 1] - 1;
-    } else {
-        // Last line - end at current write position
-        endOffset = m_bytesWritten;
-    }
+    if (m_fd < 0) return "";
 
-    // Clamp endOffset to what's actually written
-    if (endOffset > m_bytesWritten) {
-        endOffset = m_bytesWritten;
-    }
+    // Ends at the start of the next line (or the current write position
+    // for the last line); the newline itself is trimmed below
+    uint64_t startOffset, endOffset;
+    if (!m_lineIndex->lineRange(lineIndex, m_bytesWritten, startOffset, endOffset)) return "";
 
     if (startOffset >= endOffset) return "";
 
@@ -450,12 +863,13 @@ std::string StreamingFilePreview::getLine(size_t lineIndex) const {
 bool StreamingFilePreview::isLineComplete(size_t lineIndex) const {
     std::lock_guard<std::mutex> lock(m_mutex);
 
-    if (lineIndex >= m_lineOffsets.size()) return false;
+    size_t lines = m_lineIndex->lineCount();
+    if (lineIndex >= lines) return false;
 
     // Line is complete if:
     // 1. There's a next line (meaning we found a newline after this line)
     // 2. OR the file download is complete
-    if (lineIndex + 1 < m_lineOffsets.size()) {
+    if (lineIndex + 1 < lines) {
         return true;  // There's a next line, so this one is terminated
     }
 
@@ -463,21 +877,58 @@ bool StreamingFilePreview::isLineComplete(size_t lineIndex) const {
     return m_complete;
 }
 
-std::string StreamingFilePreview::getAllContent() const {
+std::shared_ptr<const ContentView> StreamingFilePreview::content() const {
     std::lock_guard<std::mutex> lock(m_mutex);
 
     if (m_fd < 0 || m_bytesWritten == 0) {
-        return "";
+        return std::make_shared<ContentView>(std::string());
     }
+    if (!m_content || m_contentGeneration != m_generation) {
+        m_content = std::make_shared<ContentView>(m_fd, m_bytesWritten);
+        m_contentGeneration = m_generation;
+    }
+    return m_content;
+}
+
+uint64_t StreamingFilePreview::generation() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_generation;
+}
 
-    std::string content(m_bytesWritten, '\0');
+// ============================================================================
+// ContentView
+// ============================================================================
+
+ContentView::ContentView(std::string bytes)
+    : m_bytes(std::move(bytes)), m_data(m_bytes.data()), m_size(m_bytes.size()) {}
 
-    ssize_t bytesRead = pread(m_fd, content.data(), m_bytesWritten, 0);
+ContentView::ContentView(int fd, size_t size) {
+    if (size == 0) {
+        m_data = m_bytes.data();
+        return;
+    }
+    void* map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map != MAP_FAILED) {
+        m_map = map;
+        m_data = static_cast<const char*>(map);
+        m_size = size;
+        return;
+    }
+
+    LOG_F(WARNING, "ContentView: mmap failed (%s), copying instead", strerror(errno));
+    m_bytes.resize(size);
+    ssize_t bytesRead = pread(fd, m_bytes.data(), size, 0);
     if (bytesRead < 0) {
-        LOG_F(ERROR, "StreamingFilePreview::getAllContent: pread failed: %s", strerror(errno));
-        return "";
+        LOG_F(ERROR, "ContentView: pread failed: %s", strerror(errno));
+        bytesRead = 0;
     }
+    m_bytes.resize(static_cast<size_t>(bytesRead));
+    m_data = m_bytes.data();
+    m_size = m_bytes.size();
+}
 
-    content.resize(static_cast<size_t>(bytesRead));
-    return content;
+ContentView::~ContentView() {
+    if (m_map) {
+        munmap(m_map, m_size);
+    }
 }
@@ -1,9 +1,17 @@
 #pragma once
 
+#include "stream_sink.h"
+#include "seek_index.h"
+#include "thread_pool.h"
+#include "line_index.h"
 #include <string>
 #include <vector>
+#include <deque>
 #include <memory>
 #include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <future>
 #include <zlib.h>
 #include <zstd.h>
 
@@ -19,6 +27,9 @@ public:
 
     // Flush any remaining buffered data (call when stream is complete)
     virtual std::string flush() = 0;
+
+    // True once the input turned out to be corrupt; nothing more comes out
+    virtual bool hasError() const { return false; }
 };
 
 // Pass-through transform (no transformation)
@@ -31,11 +42,22 @@ public:
 };
 
 // Gzip decompression transform
+// Given a SeekIndex, records a checkpoint about every CHECKPOINT_SPAN bytes of
+// output so a later read can resume mid-stream instead of inflating from byte 0
 class GzipTransform : public IStreamTransform {
 public:
     GzipTransform();
+    explicit GzipTransform(std::shared_ptr<SeekIndex> index);
+
+    // Resume inflating at a checkpoint; input must start at resumeOffset(from)
+    GzipTransform(const SeekCheckpoint& from, std::shared_ptr<SeekIndex> index);
     ~GzipTransform();
 
+    // Source byte a resumed stream starts at (the checkpoint's partial byte, if any)
+    static uint64_t resumeOffset(const SeekCheckpoint& from) {
+        return from.compressedOffset - (from.bits ? 1 : 0);
+    }
+
     // Non-copyable
     GzipTransform(const GzipTransform&) = delete;
     GzipTransform& operator=(const GzipTransform&) = delete;
@@ -43,18 +65,40 @@ public:
     std::string transform(const char* data, size_t len) override;
     std::string flush() override;
 
-    bool hasError() const { return m_error; }
+    bool hasError() const override { return m_error; }
 
 private:
+    void recordCheckpoint();
+
     z_stream m_zstream;
     bool m_initialized = false;
     bool m_error = false;
+
+    // Checkpoint recording
+    std::shared_ptr<SeekIndex> m_index;
+    uint64_t m_inOffset = 0;        // Source offset of the next input byte
+    uint64_t m_outOffset = 0;       // Output produced so far
+    uint64_t m_lines = 0;           // Newlines in the output so far, or UNKNOWN_LINE
+    uint64_t m_nextCheckpoint = SeekIndex::CHECKPOINT_SPAN;
+
+    // Resuming: applied before the first inflate call
+    bool m_resumePending = false;
+    int m_resumeBits = 0;
+    std::string m_resumeWindow;
 };
 
 // Zstd decompression transform
+// The first frame streams through a ZSTD_DStream. If another frame follows
+// (multi-frame or seekable zstd), the rest of the input is split into frames
+// that are decompressed in parallel on the shared ThreadPool and output in
+// order. Given a SeekIndex, records frame starts as checkpoints.
 class ZstdTransform : public IStreamTransform {
 public:
     ZstdTransform();
+    explicit ZstdTransform(std::shared_ptr<SeekIndex> index);
+
+    // Resume at a frame start; input must start at from.compressedOffset
+    ZstdTransform(const SeekCheckpoint& from, std::shared_ptr<SeekIndex> index);
     ~ZstdTransform();
 
     // Non-copyable
@@ -64,14 +108,76 @@ public:
     std::string transform(const char* data, size_t len) override;
     std::string flush() override;
 
-    bool hasError() const { return m_error; }
+    bool hasError() const override { return m_error; }
+
+    // Frames with more input than this are streamed instead
+    static constexpr size_t MAX_FRAME_BYTES = 64 * 1024 * 1024;
 
 private:
+    struct FrameResult {
+        std::string data;
+        std::string error;
+    };
+
+    struct FrameJob {
+        uint64_t compressedOffset;
+        std::future<FrameResult> result;
+    };
+
+    static FrameResult decompressFrame(const std::string& frame);
+    void decodeSerial(const char* data, size_t len, std::string& output);
+    void splitFrames();
+    void collectFrames(std::string& output, bool wait);
+    void appendOutput(std::string& output, const char* data, size_t len);
+    void recordFrameStart(uint64_t compressedOffset);
+
     ZSTD_DStream* m_dstream = nullptr;
     bool m_error = false;
+    bool m_frameDone = false;       // The DStream just finished a frame
+    bool m_serialOnly = false;      // Gave up on parallel decoding (frames too large)
+
+    // Parallel mode: input not yet split into frames, and frames in flight
+    bool m_parallel = false;
+    std::string m_input;
+    uint64_t m_inputOffset = 0;     // Source offset of m_input[0]
+    std::deque<FrameJob> m_jobs;
+
+    // Checkpoint recording
+    std::shared_ptr<SeekIndex> m_index;
+    uint64_t m_inOffset = 0;        // Source offset of the next byte for the DStream
+    uint64_t m_outOffset = 0;       // Output produced so far
+    uint64_t m_lines = 0;           // Newlines in the output so far, or UNKNOWN_LINE
+    bool m_lineStart = true;        // Output so far ends with a newline
 };
 
-// Manages streaming download of a file to a temp file with newline indexing
+// Preview bytes handed out without copying: a read-only mapping of a temp
+// file prefix, or an owned copy of a small in-memory response. Stays valid
+// for as long as it's held, even after the preview that made it is gone.
+class ContentView {
+public:
+    explicit ContentView(std::string bytes);
+    // Map the first size bytes of fd (copies them if mapping fails)
+    ContentView(int fd, size_t size);
+    ~ContentView();
+
+    ContentView(const ContentView&) = delete;
+    ContentView& operator=(const ContentView&) = delete;
+
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    std::string m_bytes;
+    void* m_map = nullptr;
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+};
+
+// Manages streaming download of a file to a temp file with newline indexing.
+// Downloaded chunks are queued and decoded, written and indexed by a worker
+// thread owned by the preview, so readers only ever see finished work.
+// The backend is handed sink(), never the preview, so the preview (which
+// joins its worker) is only ever destroyed by its owners.
 class StreamingFilePreview {
 public:
     // Initialize with the first chunk (typically 64KB preview)
@@ -90,12 +196,20 @@ public:
     // Must be called before any chunks are appended
     void setTransform(std::unique_ptr<IStreamTransform> transform);
 
-    // Append a new chunk from streaming download
+    // Start partway into the source instead of at byte 0 (e.g. at a SeekCheckpoint)
+    // Must be called before any chunks are appended. sourceOffset is the first
+    // source byte that will arrive; uncompressedOffset and lineNumber locate the
+    // transform's first output byte in the whole file (lineNumber may be
+    // SeekCheckpoint::UNKNOWN_LINE). Unless atLineStart, the
+    // partial line there is dropped so the preview starts on a full line.
+    void seekTo(size_t sourceOffset, uint64_t uncompressedOffset, uint64_t lineNumber, bool atLineStart);
+
+    // Queue a new chunk from streaming download for the decode worker (never blocks)
     // offset is the byte offset in the source (S3) file
     void appendChunk(const std::string& data, size_t offset);
 
-    // Mark the stream as complete (triggers flush of any buffered transform data)
-    void finishStream();
+    // Where the backend delivers streamed chunks for the decode worker
+    std::shared_ptr<IStreamSink> sink() const { return m_queue; }
 
     // Query methods (all thread-safe)
     size_t lineCount() const;              // Lines found so far
@@ -103,7 +217,10 @@ public:
     size_t bytesWritten() const;           // Bytes written to temp file (after transform)
     size_t totalSourceBytes() const;       // Total file size on S3
     bool isComplete() const;               // Fully downloaded?
+    std::string error() const;             // Why decoding stopped early (e.g. corrupt data), or ""
     size_t nextByteNeeded() const;         // For next range request
+    uint64_t firstLineNumber() const;      // Line number of line 0 within the whole file (may be UNKNOWN_LINE)
+    uint64_t firstByteOffset() const;      // Uncompressed offset of temp file byte 0
 
     // Get a specific line (0-indexed) - reads from temp file
     // Returns empty string if line doesn't exist yet
@@ -112,8 +229,17 @@ public:
     // Get the raw content of a line (before any JSON formatting)
     std::string getRawLine(size_t lineIndex) const { return getLine(lineIndex); }
 
-    // Get all content written so far (for non-line-based viewers)
-    std::string getAllContent() const;
+    // All content written so far (for non-line-based viewers), mapped rather
+    // than copied; the same view is returned until more is written
+    std::shared_ptr<const ContentView> content() const;
+
+    // Bumped whenever more content is written or the stream completes, so
+    // readers can skip re-reading content that hasn't changed
+    uint64_t generation() const;
+
+    // Line starts in the temp file, shared with viewers that map it directly.
+    // Lines past bytesWritten() may already be indexed.
+    std::shared_ptr<const LineIndex> lineIndex() const { return m_lineIndex; }
 
     // Check if a line is complete (has a terminating newline or is at end of completed file)
     bool isLineComplete(size_t lineIndex) const;
@@ -123,9 +249,45 @@ public:
     const std::string& key() const { return m_key; }
     const std::string& tempFilePath() const { return m_tempFilePath; }
 
+    // Bytes queued for the decode worker but not processed yet
+    static constexpr size_t MAX_QUEUED_BYTES = 32 * 1024 * 1024;
+
 private:
-    void writeToTempFile(const char* data, size_t len);
-    void indexNewlines(const char* data, size_t len, size_t baseOffset);
+    struct PendingChunk {
+        std::string data;
+        size_t offset;
+    };
+
+    // Chunks waiting for the decode worker. The backend's I/O thread offers
+    // them through IStreamSink, which refuses a chunk while MAX_QUEUED_BYTES
+    // are already waiting, making the backend hold off. Once closed (the
+    // preview is going away or the stream failed) chunks are dropped.
+    class ChunkQueue : public IStreamSink {
+    public:
+        bool offerChunk(std::string& data, size_t offset) override;
+        size_t queueLimit() const override { return MAX_QUEUED_BYTES; }
+
+        void push(std::string data, size_t offset);
+        // Blocks for the next chunk; false once closed
+        bool pop(PendingChunk& chunk);
+        void close();
+
+    private:
+        std::deque<PendingChunk> m_chunks;
+        size_t m_bytes = 0;
+        bool m_closed = false;
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+    };
+
+    void workerLoop();
+
+    // Decode worker (and constructor) only
+    void processChunk(const char* data, size_t len, size_t offset);
+    void finishStream();
+    void failStream(const std::string& error);
+    size_t skipPartialLine(const std::string& data);
+    size_t writeToTempFile(const char* data, size_t len);
 
     std::string m_bucket;
     std::string m_key;
@@ -136,14 +298,26 @@ private:
     size_t m_bytesDownloaded = 0;       // Bytes received from S3
     size_t m_bytesWritten = 0;          // Bytes written to temp (after transform)
     bool m_complete = false;
+    std::string m_error;                // See error()
+    uint64_t m_generation = 0;          // See generation()
+    uint64_t m_firstLineNumber = 0;     // Where the temp file starts within the
+    uint64_t m_firstByteOffset = 0;     // whole (uncompressed) file, see seekTo
 
     // Newline index: byte offset where each line starts in temp file
-    // m_lineOffsets[0] = 0 (first line starts at byte 0)
-    // m_lineOffsets[n] = byte offset where line n starts
-    std::vector<size_t> m_lineOffsets;
+    // (appended under m_mutex so it stays in step with m_bytesWritten)
+    std::shared_ptr<LineIndex> m_lineIndex;
 
-    // Transform for data stream (default: pass-through)
+    // Transform for data stream (default: pass-through). Only used by the decode worker.
     std::unique_ptr<IStreamTransform> m_transform;
+    size_t m_nextSourceOffset = 0;      // Decode worker's position in the source file
+    size_t m_bytesWrittenUnlocked = 0;  // Decode worker's copy of m_bytesWritten
+    bool m_skipPartialLine = false;     // Dropping output up to the first newline
+    bool m_failed = false;              // Decode worker's copy of !m_error.empty()
+
+    mutable std::mutex m_mutex;  // Protects the counters and line index above
+    mutable std::shared_ptr<const ContentView> m_content;  // Last content(), under m_mutex
+    mutable uint64_t m_contentGeneration = 0;
 
-    mutable std::mutex m_mutex;  // Protects all mutable state
+    std::shared_ptr<ChunkQueue> m_queue = std::make_shared<ChunkQueue>();
+    std::thread m_worker;  // Started by the constructor unless the stream is already complete
 };
@@ -0,0 +1,56 @@
+#include "thread_pool.h"
+#include "loguru.hpp"
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t threadCount, const char* name)
+    : m_name(name)
+{
+    threadCount = std::max<size_t>(threadCount, 1);
+    for (size_t i = 0; i < threadCount; ++i) {
+        m_threads.emplace_back(&ThreadPool::workerLoop, this);
+    }
+    LOG_F(INFO, "ThreadPool: started %zu %s threads", threadCount, name);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+        m_jobs.clear();
+    }
+    m_cv.notify_all();
+    for (auto& t : m_threads) {
+        t.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool(std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 1,
+                           "Pool");
+    return pool;
+}
+
+void ThreadPool::enqueue(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(std::move(job));
+    }
+    m_cv.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+    loguru::set_thread_name(m_name.c_str());
+
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+            if (m_stop) break;
+
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+        job();
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+
+// Fixed-size pool of worker threads for CPU-bound work (decompression,
+// scanning). Jobs must own or share everything they touch: a submitter may
+// drop its future and go away before the job runs.
+class ThreadPool {
+public:
+    // name is used for the worker threads in the log
+    ThreadPool(size_t threadCount, const char* name);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Process-wide pool with one thread per core (minus one for the UI)
+    static ThreadPool& shared();
+
+    template <typename F>
+    auto submit(F&& job) -> std::future<decltype(job())> {
+        using Result = decltype(job());
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(job));
+        std::future<Result> future = task->get_future();
+        enqueue([task] { (*task)(); });
+        return future;
+    }
+
+    size_t threadCount() const { return m_threads.size(); }
+
+private:
+    void enqueue(std::function<void()> job);
+    void workerLoop();
+
+    std::string m_name;
+    std::vector<std::thread> m_threads;
+    std::deque<std::function<void()>> m_jobs;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stop = false;
+};
@@ -0,0 +1,164 @@
+// Micro-benchmark for the newline scanner behind LineIndex, and for the
+// size and lookup speed of the index itself
+// Usage: ./bench_line_index [--size <MB>] [--passes <n>] [filepath]
+// Without a file, generates <size> MB of text in memory (default 4096)
+
+#include "line_index.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using ScanFn = void (*)(const char*, size_t, std::vector<uint64_t>&);
+
+// What StreamingFilePreview used to do while writing
+static void scanBytewise(const char* data, size_t len, std::vector<uint64_t>& out) {
+    for (size_t i = 0; i < len; ++i) {
+        if (data[i] == '\n') out.push_back(i + 1);
+    }
+}
+
+// What MmapTextViewer used to do on every open/refresh
+static void scanMemchr(const char* data, size_t len, std::vector<uint64_t>& out) {
+    size_t pos = 0;
+    while (pos < len) {
+        const void* found = memchr(data + pos, '\n', len - pos);
+        if (!found) break;
+        pos = static_cast<size_t>(static_cast<const char*>(found) - data) + 1;
+        out.push_back(pos);
+    }
+}
+
+static void scanIndex(const char* data, size_t len, std::vector<uint64_t>& out) {
+    findNewlines(data, len, 0, out);
+}
+
+static char* generateText(size_t bytes) {
+    fprintf(stderr, "Generating %zu MB of text ...\n", bytes >> 20);
+    char* buf = static_cast<char*>(malloc(bytes));
+    if (!buf) return nullptr;
+
+    // Mostly JSONL-sized lines, with the occasional very long one
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> lineLenDist(20, 400);
+    size_t pos = 0;
+    uint64_t lineNum = 0;
+    while (pos < bytes) {
+        size_t lineLen = (++lineNum % 10000 == 0) ? 256 * 1024 : static_cast<size_t>(lineLenDist(rng));
+        size_t end = std::min(bytes, pos + lineLen);
+        for (; pos < end; ++pos) buf[pos] = static_cast<char>('a' + (pos % 26));
+        if (pos < bytes) buf[pos++] = '\n';
+    }
+    return buf;
+}
+
+static void run(const char* name, ScanFn fn, const char* data, size_t len, int passes,
+                size_t& lines) {
+    double best = 1e30;
+    std::vector<uint64_t> out;
+    for (int p = 0; p < passes; ++p) {
+        out.clear();
+        auto start = std::chrono::steady_clock::now();
+        fn(data, len, out);
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (secs < best) best = secs;
+    }
+    if (lines != 0 && out.size() != lines) {
+        fprintf(stderr, "%s: found %zu newlines, expected %zu\n", name, out.size(), lines);
+        exit(1);
+    }
+    lines = out.size();
+    printf("%-12s %8.1f ms  %7.2f GB/s\n", name, best * 1000.0,
+           static_cast<double>(len) / best / 1e9);
+}
+
+int main(int argc, char** argv) {
+    size_t sizeMB = 4096;
+    int passes = 3;
+    const char* path = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            sizeMB = static_cast<size_t>(atol(argv[++i]));
+        } else if (strcmp(argv[i], "--passes") == 0 && i + 1 < argc) {
+            passes = std::max(1, atoi(argv[++i]));
+        } else {
+            path = argv[i];
+        }
+    }
+
+    const char* data = nullptr;
+    size_t len = 0;
+    if (path) {
+        int fd = open(path, O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0) {
+            fprintf(stderr, "Can't open %s\n", path);
+            return 1;
+        }
+        len = static_cast<size_t>(st.st_size);
+        void* map = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            fprintf(stderr, "Can't map %s\n", path);
+            return 1;
+        }
+        madvise(map, len, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(map);
+    } else {
+        len = sizeMB << 20;
+        data = generateText(len);
+        if (!data) {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+    }
+
+    // First pass warms the page cache so every scanner sees the same memory
+    size_t lines = 0;
+    printf("%zu MB, best of %d, findNewlines uses %s\n", len >> 20, passes, newlineScannerName());
+    run("bytewise", scanBytewise, data, len, passes, lines);
+    run("memchr", scanMemchr, data, len, passes, lines);
+    run("findNewlines", scanIndex, data, len, passes, lines);
+    printf("%zu newlines\n", lines);
+
+    // Build the index the way StreamingFilePreview does, a chunk at a time
+    constexpr size_t CHUNK = 1024 * 1024;
+    LineIndex index;
+    std::vector<uint64_t> starts;
+    auto buildStart = std::chrono::steady_clock::now();
+    for (size_t pos = 0; pos < len; pos += CHUNK) {
+        starts.clear();
+        findNewlines(data + pos, std::min(CHUNK, len - pos), pos, starts);
+        index.append(starts);
+    }
+    double buildSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - buildStart).count();
+    size_t indexBytes = index.memoryBytes() + index.spilledBytes();
+    printf("LineIndex    %8.1f ms  %zu lines, %.2f bytes/line (%zu MB in memory, %zu MB spilled; vector: %zu MB)\n",
+           buildSecs * 1000.0, index.lineCount(),
+           static_cast<double>(indexBytes) / static_cast<double>(index.lineCount()),
+           index.memoryBytes() >> 20, index.spilledBytes() >> 20,
+           (index.lineCount() * sizeof(uint64_t)) >> 20);
+
+    // Random lookups, as when jumping around a large file
+    constexpr size_t LOOKUPS = 10 * 1000 * 1000;
+    std::mt19937_64 rng(7);
+    uint64_t checksum = 0;
+    auto lookupStart = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < LOOKUPS; ++i) {
+        checksum += index.lineStart(static_cast<size_t>(rng() % index.lineCount()));
+    }
+    double lookupSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - lookupStart).count();
+    printf("lineStart    %8.1f ns/lookup (checksum %llu)\n", lookupSecs * 1e9 / LOOKUPS,
+           static_cast<unsigned long long>(checksum));
+    return 0;
+}
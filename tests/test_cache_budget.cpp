@@ -0,0 +1,125 @@
+// Checks of CacheBudget: entries evicted least recently used first, touch
+// and resize moving them to the front, pinned entries kept, and the stats
+// Usage: ./test_cache_budget (exits non-zero on failure)
+
+#include "cache_budget.h"
+
+#include <cstdio>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+static int s_failures = 0;
+
+#define CHECK(cond)                                                          \
+    do {                                                                     \
+        if (!(cond)) {                                                       \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,      \
+                         __LINE__, #cond);                                   \
+            s_failures++;                                                    \
+        }                                                                    \
+    } while (0)
+
+using Evicted = std::vector<std::pair<CacheBudget::Kind, std::string>>;
+
+static Evicted evictUnpinned(CacheBudget& cache, const std::set<std::string>& pinned = {}) {
+    return cache.evict([&](CacheBudget::Kind, const std::string& key) { return pinned.count(key) != 0; });
+}
+
+static void testLruOrder() {
+    CacheBudget cache(100);
+    cache.record(CacheBudget::Folder, "a", 30);
+    cache.record(CacheBudget::Folder, "b", 30);
+    cache.record(CacheBudget::Preview, "c", 30);
+    CHECK(cache.usedBytes() == 90);
+    CHECK(evictUnpinned(cache).empty());  // Within budget
+
+    // Over by 20: only the oldest goes
+    cache.record(CacheBudget::Preview, "d", 30);
+    CHECK((evictUnpinned(cache) == Evicted{{CacheBudget::Folder, "a"}}));
+    CHECK(cache.usedBytes() == 90);
+
+    // Touching b makes c the oldest; touching an unknown key does nothing
+    cache.touch(CacheBudget::Folder, "b");
+    cache.touch(CacheBudget::Folder, "a");
+    cache.record(CacheBudget::Folder, "e", 30);
+    CHECK((evictUnpinned(cache) == Evicted{{CacheBudget::Preview, "c"}}));
+
+    // Growing an entry moves it to the front too; several go at once
+    cache.record(CacheBudget::Preview, "d", 80);
+    CHECK((evictUnpinned(cache) == Evicted{{CacheBudget::Folder, "b"}, {CacheBudget::Folder, "e"}}));
+    CHECK(cache.usedBytes() == 80);
+
+    // The same key under another kind is a separate entry
+    cache.record(CacheBudget::Folder, "d", 10);
+    CHECK(cache.usedBytes() == 90);
+    cache.forget(CacheBudget::Preview, "d");
+    CHECK(cache.usedBytes() == 10);
+    cache.forget(CacheBudget::Preview, "d");
+    CHECK(cache.usedBytes() == 10);
+}
+
+static void testPinning() {
+    CacheBudget cache(50);
+    for (const char* key : {"old", "current", "loading", "new"}) {
+        cache.record(CacheBudget::Folder, key, 20);
+    }
+
+    // Pinned entries are skipped, not counted as evicted, and stay in place
+    Evicted evicted = evictUnpinned(cache, {"old", "current"});
+    CHECK((evicted == Evicted{{CacheBudget::Folder, "loading"}, {CacheBudget::Folder, "new"}}));
+    CHECK(cache.usedBytes() == 40);
+
+    // With everything pinned, nothing goes and the total stays over budget
+    cache.record(CacheBudget::Preview, "selected", 30);
+    CHECK(evictUnpinned(cache, {"old", "current", "selected"}).empty());
+    CHECK(cache.usedBytes() == 70);
+
+    // Unpinned, the oldest pinned one is next
+    CHECK((evictUnpinned(cache, {"current", "selected"}) == Evicted{{CacheBudget::Folder, "old"}}));
+
+    // A lower budget takes more
+    cache.setBudget(0);
+    CHECK(evictUnpinned(cache).size() == 2);
+    CHECK(cache.usedBytes() == 0);
+}
+
+static void testStats() {
+    CacheBudget cache(100);
+    cache.record(CacheBudget::Folder, "a", 40);
+    cache.record(CacheBudget::Folder, "b", 40);
+    cache.record(CacheBudget::Preview, "p", 10);
+    cache.record(CacheBudget::Folder, "a", 60);
+    cache.countLookup(CacheBudget::Folder, true);
+    cache.countLookup(CacheBudget::Folder, false);
+    cache.countLookup(CacheBudget::Preview, true);
+
+    const CacheBudget::Stats& folders = cache.stats(CacheBudget::Folder);
+    CHECK(folders.entries == 2 && folders.bytes == 100);
+    CHECK(folders.hits == 1 && folders.misses == 1);
+    CHECK(cache.stats(CacheBudget::Preview).hits == 1);
+
+    CHECK((evictUnpinned(cache) == Evicted{{CacheBudget::Folder, "b"}}));
+    CHECK(folders.entries == 1 && folders.bytes == 60 && folders.evictions == 1);
+
+    // Clearing one kind leaves the other
+    cache.clear(CacheBudget::Folder);
+    CHECK(folders.entries == 0 && folders.bytes == 0);
+    CHECK(cache.usedBytes() == 10);
+    cache.record(CacheBudget::Folder, "a", 5);
+    CHECK(folders.entries == 1 && cache.usedBytes() == 15);
+}
+
+int main() {
+    testLruOrder();
+    testPinning();
+    testStats();
+
+    if (s_failures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", s_failures);
+        return 1;
+    }
+    std::printf("All cache budget checks passed\n");
+    return 0;
+}
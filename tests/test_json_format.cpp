@@ -0,0 +1,138 @@
+// Checks of formatJson and validateJson: layout, escapes written back the
+// way nlohmann::json does, nested empty containers, invalid UTF-8 passed
+// through, and records cut off at every byte
+// Usage: ./test_json_format (exits non-zero on failure)
+
+#include "preview/json_format.h"
+
+#include <cstdio>
+#include <string>
+
+static int s_failures = 0;
+
+#define CHECK(cond)                                                          \
+    do {                                                                     \
+        if (!(cond)) {                                                       \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,      \
+                         __LINE__, #cond);                                   \
+            s_failures++;                                                    \
+        }                                                                    \
+    } while (0)
+
+static std::string format(const std::string& json, const char* field = nullptr) {
+    JsonFormatResult result;
+    if (!formatJson(json, field, result)) {
+        std::fprintf(stderr, "%s: %s\n", json.c_str(), result.error.c_str());
+        return "<invalid>";
+    }
+    return result.formatted;
+}
+
+static std::string errorOf(const std::string& json) {
+    JsonFormatResult result;
+    if (formatJson(json, nullptr, result)) return "";
+    return result.error;
+}
+
+static void testLayout() {
+    CHECK(format(R"({"a":1,"b":[true,null]})") == "{\n  \"a\": 1,\n  \"b\": [\n    true,\n    null\n  ]\n}");
+    // Keys in document order, numbers as written
+    CHECK(format(R"({"z": 1.50, "a": -0e+3})") == "{\n  \"z\": 1.50,\n  \"a\": -0e+3\n}");
+    CHECK(format("  42  ") == "42");
+    CHECK(format(R"("top")") == "\"top\"");
+}
+
+static void testEmptyContainers() {
+    CHECK(format("{}") == "{}");
+    CHECK(format("[ ]") == "[]");
+    CHECK(format("{ \n }") == "{}");
+    CHECK(format(R"({"a":{},"b":[]})") == "{\n  \"a\": {},\n  \"b\": []\n}");
+    CHECK(format(R"([[],{},[[]],{"x":{}}])") ==
+          "[\n  [],\n  {},\n  [\n    []\n  ],\n  {\n    \"x\": {}\n  }\n]");
+    CHECK(format(R"({"a":[{}],"b":1})") == "{\n  \"a\": [\n    {}\n  ],\n  \"b\": 1\n}");
+}
+
+static void testEscapes() {
+    // Short escapes stay as written; \/ and \u come out decoded, except
+    // control characters, which get \u00XX like nlohmann::json
+    const std::string json = R"({"text": "a\"b\\c\n\t\/Aé😀\u0001\u001F"})";
+    JsonFormatResult result;
+    CHECK(formatJson(json, "text", result));
+    CHECK(result.formatted == "{\n  \"text\": \"a\\\"b\\\\c\\n\\t/A\xc3\xa9\xf0\x9f\x98\x80\\u0001\\u001f\"\n}");
+    CHECK(result.hasField);
+    CHECK(result.fieldValue == "a\"b\\c\n\t/A\xc3\xa9\xf0\x9f\x98\x80\x01\x1f");
+
+    // The field only counts at the top level and as a string
+    CHECK(formatJson(R"({"meta": {"text": "inner"}, "other": 1})", "text", result));
+    CHECK(!result.hasField);
+    CHECK(formatJson(R"({"text": 5})", "text", result));
+    CHECK(!result.hasField);
+    CHECK(formatJson(R"({"text": "x", "key ": "y"})", "key ", result));
+    CHECK(result.hasField && result.fieldValue == "y");
+
+    CHECK(errorOf(R"("\x")").find("invalid escape") == 0);
+    CHECK(errorOf(R"("\u12g4")").find("invalid \\u escape") == 0);
+    CHECK(errorOf(R"("\ud83d")").find("unpaired surrogate") == 0);
+    CHECK(errorOf(R"("\ud83dA")").find("unpaired surrogate") == 0);
+    CHECK(errorOf(R"("\ude00")").find("unpaired surrogate") == 0);
+    CHECK(errorOf("\"tab\there\"").find("control character") == 0);
+}
+
+static void testInvalidUtf8() {
+    // Bytes that aren't valid UTF-8 are copied through, not rejected
+    const std::string bad = "\xff\xfe \xc3 \xe2\x82 \xc0\xaf \xed\xa0\x80";
+    const std::string json = "{\"text\": \"" + bad + "\", \"k\xff\": 1}";
+    JsonFormatResult result;
+    CHECK(formatJson(json, "text", result));
+    CHECK(result.formatted == "{\n  \"text\": \"" + bad + "\",\n  \"k\xff\": 1\n}");
+    CHECK(result.hasField && result.fieldValue == bad);
+    CHECK(validateJson(json));
+
+    // Past the vector block, too
+    const std::string longer = std::string(40, 'a') + bad + std::string(40, 'b');
+    CHECK(format("\"" + longer + "\"") == "\"" + longer + "\"");
+}
+
+static void testTruncated() {
+    // Every cut of a record before its last byte is invalid, and both entry
+    // points agree on why
+    const std::string record =
+        R"({"id": "x1", "n": -12.5e+3, "ok": true, "none": null, "no": false, "e": {}, "a": [1, [], {"k": "é😀"}], "s": "q\"\\"})";
+    CHECK(format(record) != "<invalid>");
+    for (size_t len = 0; len < record.size(); ++len) {
+        std::string cut = record.substr(0, len);
+        JsonFormatResult result;
+        std::string error;
+        bool formatted = formatJson(cut, "id", result);
+        bool valid = validateJson(cut, &error);
+        if (formatted || valid || result.error.empty() || result.error != error) {
+            std::fprintf(stderr, "cut at %zu: formatted %d, valid %d, \"%s\" vs \"%s\"\n", len, formatted, valid,
+                         result.error.c_str(), error.c_str());
+            s_failures++;
+            return;
+        }
+    }
+
+    CHECK(errorOf(R"({"a": [1, 2)") == "unexpected end of input at byte 11");
+    CHECK(errorOf(R"({"a": "abc)") == "unterminated string at byte 10");
+    CHECK(errorOf(R"({"a": tru)") == "invalid literal at byte 6");
+    CHECK(errorOf(R"({"a": 1.)") == "invalid number at byte 8");
+    CHECK(errorOf(R"({"a")") == "expected ':' at byte 4");
+    CHECK(errorOf(R"({"a": 1} x)") == "unexpected characters after the document at byte 9");
+    CHECK(errorOf("") == "unexpected end of input at byte 0");
+}
+
+int main() {
+    testLayout();
+    testEmptyContainers();
+    testEscapes();
+    testInvalidUtf8();
+    testTruncated();
+
+    if (s_failures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", s_failures);
+        return 1;
+    }
+    std::printf("All JSON format checks passed\n");
+    return 0;
+}
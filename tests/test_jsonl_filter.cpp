@@ -0,0 +1,154 @@
+// Checks of JsonFilter: precedence, not, missing versus null, contains,
+// number literals and the substring prefilter on records with escapes
+// Usage: ./test_jsonl_filter (exits non-zero on failure)
+
+#include "preview/jsonl_filter.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static int s_failures = 0;
+
+#define CHECK(cond)                                                          \
+    do {                                                                     \
+        if (!(cond)) {                                                       \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,      \
+                         __LINE__, #cond);                                   \
+            s_failures++;                                                    \
+        }                                                                    \
+    } while (0)
+
+static bool matches(const char* expression, const char* record) {
+    JsonFilter filter(expression);
+    if (!filter.isValid()) {
+        std::fprintf(stderr, "filter %s: %s\n", expression, filter.error().c_str());
+        return false;
+    }
+    std::vector<JsonProjection::Value> scratch;
+    return filter.matches(record, scratch);
+}
+
+static bool compiles(const char* expression) {
+    return JsonFilter(expression).isValid();
+}
+
+static void testPrecedence() {
+    const char* record = R"({"a": true, "b": false, "c": false})";
+    // and binds tighter than or
+    CHECK(matches(".a or .b and .c", record));
+    CHECK(!matches("(.a or .b) and .c", record));
+    CHECK(matches(".c and .b or .a", record));
+    CHECK(matches(".a || .b && .c", record));
+
+    // not binds tighter than and
+    CHECK(!matches("not .a and .c", record));
+    CHECK(matches("not (.a and .c)", record));
+    CHECK(matches("not .b and not .c", record));
+    CHECK(matches("!!.a", record));
+}
+
+static void testMissingAndNull() {
+    const char* record = R"({"present": 0, "empty": "", "nothing": null, "no": false, "obj": {}})";
+    // A bare path is true unless missing, null or false
+    CHECK(matches(".present", record));
+    CHECK(matches(".empty", record));
+    CHECK(matches(".obj", record));
+    CHECK(!matches(".nothing", record));
+    CHECK(!matches(".no", record));
+    CHECK(!matches(".missing", record));
+    CHECK(matches("not .missing", record));
+
+    // Missing compares equal to null, and to nothing else
+    CHECK(matches(".missing == null", record));
+    CHECK(matches(".nothing == null", record));
+    CHECK(!matches(".present == null", record));
+    CHECK(matches(".present != null", record));
+    CHECK(!matches(".missing == 0", record));
+    CHECK(!matches(".missing < 1", record));
+    CHECK(matches(".missing != 0", record));
+
+    // Invalid JSON never passes, even a negated test
+    CHECK(!matches("not .missing", "{\"a\": "));
+}
+
+static void testComparisons() {
+    const char* record = R"({"n": 12.5, "s": "beta", "t": true, "meta": {"lang": "de"}, "text": "hello"})";
+    CHECK(matches(".n > 12", record));
+    CHECK(matches(".n <= 12.5", record));
+    CHECK(matches(".n == 1.25e1", record));
+    CHECK(matches(".n > -1", record));
+    CHECK(!matches(".n < 12.5", record));
+    CHECK(matches(".s > \"alpha\"", record));
+    CHECK(!matches(".s == 12", record));  // Types must agree
+    CHECK(matches(".t == true", record));
+    CHECK(matches(".meta.lang == 'de'", record));
+    CHECK(matches("len(.text) == 5", record));
+    CHECK(matches("len(.text) > 4 and .meta.lang == \"de\"", record));
+}
+
+static void testContains() {
+    const char* record = R"({"url": "https://en.wikipedia.org/wiki/Zstd", "n": 5, "tags": ["wiki"]})";
+    CHECK(matches(".url contains \"wiki\"", record));
+    CHECK(!matches(".url contains \"WIKI\"", record));
+    CHECK(!matches(".n contains \"5\"", record));      // Only strings contain
+    CHECK(!matches(".tags contains \"wiki\"", record));  // Not into arrays
+    CHECK(!matches(".missing contains \"\"", record));
+    CHECK(!compiles(".url contains 5"));
+}
+
+static void testNumberLiterals() {
+    CHECK(compiles(".x == 0"));
+    CHECK(compiles(".x == -0.5"));
+    CHECK(compiles(".x < 1e9"));
+    CHECK(compiles(".x < 1E+9"));
+    CHECK(compiles(".x > 2.5e-3"));
+
+    // strtod accepts these, JSON doesn't
+    CHECK(!compiles(".x == inf"));
+    CHECK(!compiles(".x == nan"));
+    CHECK(!compiles(".x == -infinity"));
+    CHECK(!compiles(".x == 0x10"));
+    CHECK(!compiles(".x == +1"));
+    CHECK(!compiles(".x == 01"));
+    CHECK(!compiles(".x == 1."));
+    CHECK(!compiles(".x == .5"));
+    CHECK(!compiles(".x == 1e"));
+    CHECK(!compiles(".x == 12abc"));
+}
+
+static void testPrefilterWithEscapes() {
+    // The literal is plain text, so records are byte-searched for it first;
+    // one that spells it with \u escapes must still be parsed and pass
+    CHECK(matches(".name == \"ABC\"", R"({"name": "ABC"})"));
+    CHECK(matches(".name == \"ABC\"", R"({"name": "\u0041BC"})"));
+    CHECK(matches(".name contains \"BC\"", R"({"name": "A\u0042C"})"));
+    CHECK(!matches(".name == \"ABC\"", R"({"name": "ABD"})"));
+    CHECK(!matches(".name == \"ABC\"", R"({"name": "\u0041BD"})"));
+
+    // Text JSON may escape isn't searched for at all
+    CHECK(matches(".url contains \"a/b\"", R"({"url": "a\/b"})"));
+    CHECK(matches(".q == \"say \\\"hi\\\"\"", R"({"q": "say \"hi\""})"));
+    CHECK(matches(".s contains \"\\n\"", R"({"s": "two\nlines"})"));
+
+    // Under or, neither side's text is required
+    CHECK(matches(".a == \"xyz\" or .b == 1", R"({"a": "nope", "b": 1})"));
+    // Under not, the inner text isn't required
+    CHECK(matches("not .a == \"xyz\"", R"({"a": "nope"})"));
+}
+
+int main() {
+    testPrecedence();
+    testMissingAndNull();
+    testComparisons();
+    testContains();
+    testNumberLiterals();
+    testPrefilterWithEscapes();
+
+    if (s_failures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", s_failures);
+        return 1;
+    }
+    std::printf("All JSONL filter checks passed\n");
+    return 0;
+}
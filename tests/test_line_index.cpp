@@ -0,0 +1,131 @@
+// Checks of LineIndex: Elias-Fano blocks round-trip every line start, across
+// block, segment and spill boundaries, and lookups agree with a plain array
+// Usage: ./test_line_index (exits non-zero on failure)
+
+#include "line_index.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+static int s_failures = 0;
+
+#define CHECK(cond)                                                          \
+    do {                                                                     \
+        if (!(cond)) {                                                       \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,      \
+                         __LINE__, #cond);                                   \
+            s_failures++;                                                    \
+        }                                                                    \
+    } while (0)
+
+// Line starts with gaps of up to maxGap bytes, appended in batches of
+// random size so blocks are sealed from the tail at every alignment
+static std::vector<uint64_t> fill(LineIndex& index, size_t lines, uint64_t maxGap, uint32_t seed) {
+    std::mt19937_64 rng(seed);
+    std::vector<uint64_t> starts{0};
+    std::vector<uint64_t> batch;
+    while (starts.size() < lines) {
+        batch.clear();
+        size_t count = std::min<size_t>(rng() % 1000 + 1, lines - starts.size());
+        for (size_t i = 0; i < count; ++i) {
+            // Mostly short lines, now and then an empty or a huge one
+            uint64_t gap = rng() % 16 == 0 ? rng() % maxGap + 1 : rng() % 200 + 1;
+            starts.push_back(starts.back() + gap);
+            batch.push_back(starts.back());
+        }
+        index.append(batch);
+    }
+    return starts;
+}
+
+static bool allStartsMatch(const LineIndex& index, const std::vector<uint64_t>& starts) {
+    for (size_t line = 0; line < starts.size(); ++line) {
+        if (index.lineStart(line) != starts[line]) {
+            std::fprintf(stderr, "line %zu: %llu, expected %llu\n", line,
+                         static_cast<unsigned long long>(index.lineStart(line)),
+                         static_cast<unsigned long long>(starts[line]));
+            return false;
+        }
+    }
+    return true;
+}
+
+static void testSmall() {
+    LineIndex index;
+    CHECK(index.lineCount() == 1);
+    CHECK(index.lineStart(0) == 0);
+    CHECK(index.lineStart(1) == 0);  // Not seen yet
+    CHECK(index.linesBefore(0) == 1);
+
+    // Fewer lines than a block stay in the tail
+    std::vector<uint64_t> starts = fill(index, 100, 1 << 20, 1);
+    CHECK(index.lineCount() == starts.size());
+    CHECK(allStartsMatch(index, starts));
+
+    uint64_t start = 0, end = 0;
+    CHECK(index.lineRange(5, starts.back() + 10, start, end));
+    CHECK(start == starts[5] && end == starts[6]);
+    CHECK(index.lineRange(starts.size() - 1, starts.back() + 10, start, end));
+    CHECK(start == starts.back() && end == starts.back() + 10);
+    CHECK(!index.lineRange(starts.size(), starts.back() + 10, start, end));
+}
+
+static void testAcrossSegmentsAndSpill() {
+    // Gaps of up to 2^40 bytes make wide blocks, so a few million lines fill
+    // several segments; a tiny budget spills all but the last to disk
+    LineIndex index(1);
+    std::vector<uint64_t> starts = fill(index, 6 * 1000 * 1000, uint64_t(1) << 40, 2);
+    CHECK(index.lineCount() == starts.size());
+    CHECK(index.spilledBytes() > 0);
+    CHECK(allStartsMatch(index, starts));
+
+    // linesBefore agrees with a search of the plain array, at line starts,
+    // just past them and just before them
+    std::mt19937_64 rng(3);
+    for (int i = 0; i < 200000; ++i) {
+        size_t line = static_cast<size_t>(rng() % starts.size());
+        for (uint64_t offset : {starts[line], starts[line] + 1, starts[line] > 0 ? starts[line] - 1 : 0}) {
+            size_t expected = static_cast<size_t>(
+                std::lower_bound(starts.begin(), starts.end(), offset) - starts.begin());
+            expected = std::max<size_t>(expected, 1);
+            if (index.linesBefore(offset) != expected) {
+                std::fprintf(stderr, "linesBefore(%llu): %zu, expected %zu\n",
+                             static_cast<unsigned long long>(offset), index.linesBefore(offset), expected);
+                s_failures++;
+                return;
+            }
+        }
+    }
+    CHECK(index.linesBefore(starts.back() + 1) == starts.size());
+}
+
+static void testDenseLines() {
+    // Newline after newline: blocks with no low bits at all
+    LineIndex index;
+    std::vector<uint64_t> starts{0};
+    std::vector<uint64_t> batch;
+    for (uint64_t i = 1; i <= 100000; ++i) {
+        starts.push_back(i);
+        batch.push_back(i);
+    }
+    index.append(batch);
+    CHECK(index.lineCount() == starts.size());
+    CHECK(allStartsMatch(index, starts));
+    CHECK(index.linesBefore(50000) == 50000);
+}
+
+int main() {
+    testSmall();
+    testAcrossSegmentsAndSpill();
+    testDenseLines();
+
+    if (s_failures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", s_failures);
+        return 1;
+    }
+    std::printf("All line index checks passed\n");
+    return 0;
+}
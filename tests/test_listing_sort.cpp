@@ -0,0 +1,177 @@
+// Checks of ListingSorter: orders by each column, pages merged into an
+// earlier order, and resets while sorts are running (build with
+// -fsanitize=thread to check the pool handoff)
+// Usage: ./test_listing_sort (exits non-zero on failure)
+
+#include "listing_sort.h"
+#include "object_store.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int s_failures = 0;
+
+#define CHECK(cond)                                                          \
+    do {                                                                     \
+        if (!(cond)) {                                                       \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,      \
+                         __LINE__, #cond);                                   \
+            s_failures++;                                                    \
+        }                                                                    \
+    } while (0)
+
+// Files named f<i>.<ext> with sizes and times out of name order
+static void appendFiles(ObjectStore& store, std::vector<size_t>& arrival, size_t count) {
+    static const char* extensions[] = {"txt", "json", "gz", "csv"};
+    for (size_t i = arrival.size(), end = arrival.size() + count; i < end; ++i) {
+        char key[64];
+        std::snprintf(key, sizeof(key), "data/f%07zu.%s", i, extensions[i % 4]);
+        store.append(key, false, static_cast<int64_t>((i * 7919) % 1000),
+                     static_cast<int64_t>(1700000000 + (i * 104729) % 5000), "", false);
+        arrival.push_back(store.size() - 1);
+    }
+}
+
+static bool sortAll(ListingSorter& sorter, const ObjectStore& store, const std::vector<size_t>& arrival,
+                    const ListingSort& sort) {
+    for (int i = 0; i < 10000; ++i) {
+        sorter.update(store, arrival, sort);
+        if (!sorter.busy() && sorter.sortedCount() == arrival.size()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+// Every row in order, and each arrival position exactly once
+static bool isSorted(const ListingSorter& sorter, const ObjectStore& store, const std::vector<size_t>& arrival,
+                     const ListingSort& sort) {
+    std::vector<bool> seen(arrival.size(), false);
+    for (size_t row = 0; row < arrival.size(); ++row) {
+        size_t position = sorter.positionAt(row);
+        if (position >= arrival.size() || seen[position]) return false;
+        seen[position] = true;
+        if (row == 0) continue;
+
+        const auto& a = store[arrival[sorter.positionAt(row - 1)]];
+        const auto& b = store[arrival[position]];
+        int64_t va = sort.column == ListingSort::Modified ? a.lastModified() : a.size();
+        int64_t vb = sort.column == ListingSort::Modified ? b.lastModified() : b.size();
+        if (sort.column == ListingSort::Size || sort.column == ListingSort::Modified) {
+            if (sort.descending ? va < vb : va > vb) return false;
+            if (va == vb && a.displayName() > b.displayName()) return false;
+        } else if (sort.column == ListingSort::Name) {
+            if (sort.descending ? a.displayName() < b.displayName() : a.displayName() > b.displayName()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void testColumns() {
+    ObjectStore store;
+    std::vector<size_t> arrival;
+    appendFiles(store, arrival, 100000);
+
+    for (auto column : {ListingSort::Size, ListingSort::Modified, ListingSort::Extension, ListingSort::Name}) {
+        for (bool descending : {false, true}) {
+            ListingSort sort;
+            sort.column = column;
+            sort.descending = descending;
+            if (sort.isKeyOrder()) continue;  // Arrival order, nothing to sort
+
+            ListingSorter sorter;
+            CHECK(sortAll(sorter, store, arrival, sort));
+            CHECK(isSorted(sorter, store, arrival, sort));
+        }
+    }
+}
+
+static void testExtensionOrder() {
+    ObjectStore store;
+    std::vector<size_t> arrival;
+    for (const char* key : {"b.txt", "a.txt", "c.csv", "noext", "d.json"}) {
+        store.append(key, false, 1, 0, "", false);
+        arrival.push_back(store.size() - 1);
+    }
+    ListingSort sort;
+    sort.column = ListingSort::Extension;
+    ListingSorter sorter;
+    CHECK(sortAll(sorter, store, arrival, sort));
+
+    // No extension sorts first (an empty suffix), then by extension and name
+    std::vector<std::string> names;
+    for (size_t row = 0; row < arrival.size(); ++row) {
+        names.emplace_back(store[arrival[sorter.positionAt(row)]].displayName());
+    }
+    CHECK((names == std::vector<std::string>{"noext", "c.csv", "d.json", "a.txt", "b.txt"}));
+}
+
+static void testPagesMergedIn() {
+    ObjectStore store;
+    std::vector<size_t> arrival;
+    ListingSort sort;
+    sort.column = ListingSort::Size;
+    ListingSorter sorter;
+
+    // Pages arrive while earlier ones are still sorting
+    for (int page = 0; page < 20; ++page) {
+        appendFiles(store, arrival, 5000);
+        sorter.update(store, arrival, sort);
+    }
+    CHECK(sortAll(sorter, store, arrival, sort));
+    CHECK(sorter.sortedCount() == arrival.size());
+    CHECK(isSorted(sorter, store, arrival, sort));
+
+    // Rows past the sorted ones show in arrival order
+    appendFiles(store, arrival, 10);
+    CHECK(sorter.positionAt(arrival.size() - 1) == arrival.size() - 1);
+}
+
+static void testResetWhileSorting() {
+    ObjectStore store;
+    std::vector<size_t> arrival;
+    appendFiles(store, arrival, 200000);
+    ListingSort sort;
+    sort.column = ListingSort::Modified;
+    sort.descending = true;
+
+    // Runs cancelled mid-sort must drop their results, and the store may
+    // be cleared while they still hold its arena
+    for (int i = 0; i < 20; ++i) {
+        ListingSorter sorter;
+        sorter.update(store, arrival, sort);
+        sorter.reset();
+        CHECK(sorter.sortedCount() == 0);
+        CHECK(!sorter.busy());
+        sorter.update(store, arrival, sort);
+    }
+
+    ListingSorter sorter;
+    sorter.update(store, arrival, sort);
+    ObjectStore replaced = std::move(store);
+    replaced.clear();
+    sorter.reset();
+
+    arrival.clear();
+    appendFiles(store, arrival, 1000);
+    CHECK(sortAll(sorter, store, arrival, sort));
+    CHECK(isSorted(sorter, store, arrival, sort));
+}
+
+int main() {
+    testColumns();
+    testExtensionOrder();
+    testPagesMergedIn();
+    testResetWhileSorting();
+
+    if (s_failures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", s_failures);
+        return 1;
+    }
+    std::printf("All listing sort checks passed\n");
+    return 0;
+}
@@ -0,0 +1,189 @@
+// Checks of ObjectStore: packing, stats, moves, in-place updates and
+// repeated listing pages
+// Usage: ./test_object_store (exits non-zero on failure)
+
+#include "object_store.h"
+#include "aws/s3_backend.h"
+
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+static int s_failures = 0;
+
+#define CHECK(cond)                                                          \
+    do {                                                                     \
+        if (!(cond)) {                                                       \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,      \
+                         __LINE__, #cond);                                   \
+            s_failures++;                                                    \
+        }                                                                    \
+    } while (0)
+
+static void appendFiles(ObjectStore& store, const std::string& prefix, int count) {
+    for (int i = 0; i < count; ++i) {
+        std::string key = prefix + std::to_string(i) + ".txt";
+        store.append(key, false, 100 + i, 1700000000 + i, "etag-" + std::to_string(i), false);
+    }
+}
+
+static void testAppend() {
+    ObjectStore store;
+    store.append("data/sub/", true, 0, 0, "", false);
+    appendFiles(store, "data/f", 3);
+
+    CHECK(store.size() == 4);
+    CHECK(store[0].isFolder());
+    CHECK(store[0].displayName() == "sub");
+    CHECK(store[1].key() == "data/f0.txt");
+    CHECK(store[1].displayName() == "f0.txt");
+    CHECK(store[1].etag() == "etag-0");
+    CHECK(store.stats().folders == 1);
+    CHECK(store.stats().files == 3);
+    CHECK(store.stats().totalBytes == 303);
+    CHECK(store.maxKey() == "data/sub/");
+}
+
+static void testMoveThenAppendToSource() {
+    ObjectStore source;
+    appendFiles(source, "a/", 10);
+
+    ObjectStore moved(std::move(source));
+    CHECK(moved.size() == 10);
+    CHECK(moved.stats().files == 10);
+    CHECK(moved[9].key() == "a/9.txt");
+
+    // The source is empty and usable; its appends must not touch the moved arena
+    CHECK(source.empty());
+    CHECK(source.stats().files == 0);
+    CHECK(source.maxKey().empty());
+    CHECK(source.memoryBytes() == 0);
+    appendFiles(source, "b/", 10);
+    CHECK(source.size() == 10);
+    CHECK(source.stats().files == 10);
+    CHECK(source.maxKey() == "b/9.txt");
+    CHECK(source.arena() != moved.arena());
+
+    for (size_t i = 0; i < moved.size(); ++i) {
+        CHECK(moved[i].key() == "a/" + std::to_string(i) + ".txt");
+        CHECK(moved[i].etag() == "etag-" + std::to_string(i));
+    }
+
+    // Same through move assignment, onto a store that already holds objects
+    ObjectStore target;
+    appendFiles(target, "c/", 3);
+    target = std::move(source);
+    CHECK(target.size() == 10);
+    CHECK(target.maxKey() == "b/9.txt");
+    CHECK(source.empty());
+    appendFiles(source, "d/", 2);
+    CHECK(source.size() == 2);
+    CHECK(source.stats().totalBytes == 201);
+    CHECK(target[0].key() == "b/0.txt");
+    CHECK(target[9].key() == "b/9.txt");
+}
+
+static void testAssignAndErase() {
+    ObjectStore store;
+    appendFiles(store, "a/", 5);
+    ObjectStore fresh;
+    fresh.append("a/2.txt", false, 5000, 1800000000, "a-much-longer-etag-than-before", false);
+
+    // New size, time and ETag; the key stays
+    store.assign({{2, &fresh[0]}});
+    CHECK(store[2].key() == "a/2.txt");
+    CHECK(store[2].size() == 5000);
+    CHECK(store[2].lastModified() == 1800000000);
+    CHECK(store[2].etag() == "a-much-longer-etag-than-before");
+    CHECK(store[3].etag() == "etag-3");
+    CHECK(store.stats().totalBytes == 100 + 101 + 5000 + 103 + 104);
+    CHECK(store.stats().largestFile == 5000);
+    CHECK(store.stats().newest == 1800000000);
+
+    // Dropping the largest and the last recounts the extremes and max key
+    store.erase({false, false, true, false, true});
+    CHECK(store.size() == 3);
+    CHECK(store[0].key() == "a/0.txt");
+    CHECK(store[2].key() == "a/3.txt");
+    CHECK(store.stats().files == 3);
+    CHECK(store.stats().largestFile == 103);
+    CHECK(store.stats().newest == 1700000003);
+    CHECK(store.maxKey() == "a/3.txt");
+}
+
+// Keys ending in '/' are folders
+static std::vector<S3Object> makePage(const std::vector<std::string>& keys) {
+    std::vector<S3Object> page;
+    for (const std::string& key : keys) {
+        S3Object obj;
+        obj.key = key;
+        obj.is_folder = key.back() == '/';
+        obj.size = obj.is_folder ? 0 : 10;
+        page.push_back(obj);
+    }
+    return page;
+}
+
+static std::vector<std::string> keysOf(const ObjectStore& store) {
+    std::vector<std::string> keys;
+    for (const auto& entry : store) keys.emplace_back(entry.key());
+    return keys;
+}
+
+static void testAppendPage() {
+    // Within a page folders come first, so keys aren't in order
+    const auto first = makePage({"d/a/", "d/m/", "d/b.txt", "d/c.txt"});
+    const auto second = makePage({"d/z/", "d/n.txt", "d/x.txt"});
+
+    ObjectStore store;
+    CHECK(store.appendPage(first, true) == 0);  // Nothing to repeat yet
+    CHECK(store.size() == 4);
+    CHECK(store.maxKey() == "d/m/");
+
+    // The same page again, from a second request in flight
+    CHECK(store.appendPage(first, true) == 4);
+    CHECK(store.size() == 4);
+
+    // The next page: files before its own folder still count, since the
+    // mark is the greatest key from earlier pages
+    CHECK(store.appendPage(second, true) == 0);
+    CHECK(store.size() == 7);
+    CHECK(store.maxKey() == "d/z/");
+
+    // A continuation overlapping what's held keeps only what's new
+    CHECK(store.appendPage(makePage({"d/z/", "d/x.txt", "d/zz.txt", "d/zzz.txt"}), true) == 2);
+    CHECK((keysOf(store) ==
+           std::vector<std::string>{"d/a/", "d/m/", "d/b.txt", "d/c.txt", "d/z/", "d/n.txt", "d/x.txt",
+                                    "d/zz.txt", "d/zzz.txt"}));
+    CHECK(store.stats().folders == 3 && store.stats().files == 6);
+
+    // A listing restarted after revalidation starts from a cleared store:
+    // its first page is taken whole and later pages checked against it
+    store.clear();
+    CHECK(store.appendPage(first, false) == 0);
+    CHECK(store.size() == 4);
+    CHECK(store.appendPage(second, true) == 0);
+    CHECK(store.appendPage(second, true) == 3);
+    CHECK(store.size() == 7);
+
+    // A first page is never checked, even into a store with entries
+    ObjectStore fresh;
+    appendFiles(fresh, "d/", 2);
+    CHECK(fresh.appendPage(makePage({"d/0.txt"}), false) == 0);
+    CHECK(fresh.size() == 3);
+}
+
+int main() {
+    testAppend();
+    testMoveThenAppendToSource();
+    testAssignAndErase();
+    testAppendPage();
+
+    if (s_failures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", s_failures);
+        return 1;
+    }
+    std::printf("All object store checks passed\n");
+    return 0;
+}
@@ -0,0 +1,191 @@
+// Checks of the line numbers SeekIndex records while zstd objects are decoded,
+// in particular after resuming at a seek-table frame whose line is unknown
+// Usage: ./test_seek_index (exits non-zero on failure)
+
+#include "seek_index.h"
+#include "streaming_preview.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+static int s_failures = 0;
+
+#define CHECK(cond)                                                          \
+    do {                                                                     \
+        if (!(cond)) {                                                       \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,      \
+                         __LINE__, #cond);                                   \
+            s_failures++;                                                    \
+        }                                                                    \
+    } while (0)
+
+static constexpr uint64_t UNKNOWN = SeekCheckpoint::UNKNOWN_LINE;
+
+// A zstd frame holding content in raw (uncompressed) blocks, so the test needs
+// no encoder
+static std::string rawZstdFrame(const std::string& content) {
+    constexpr size_t MAX_BLOCK = 128 * 1024;
+    std::string frame;
+    auto put = [&frame](uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; ++i) frame.push_back(static_cast<char>(value >> (8 * i)));
+    };
+    put(0xFD2FB528, 4);      // Magic
+    frame.push_back('\xA0');  // Single segment, 4-byte content size
+    put(content.size(), 4);
+    for (size_t pos = 0; pos == 0 || pos < content.size(); pos += MAX_BLOCK) {
+        size_t size = std::min(MAX_BLOCK, content.size() - pos);
+        bool last = pos + size >= content.size();
+        put((size << 3) | (last ? 1 : 0), 3);  // Raw block
+        frame.append(content, pos, size);
+    }
+    return frame;
+}
+
+struct Object {
+    std::string data;                   // Compressed
+    std::vector<SeekCheckpoint> frames;  // Start of each frame, lines known
+    uint64_t size = 0;                   // Uncompressed
+};
+
+// frameCount frames of frameBytes each, every line 64 bytes
+static Object makeObject(size_t frameCount, size_t frameBytes) {
+    std::string line(63, 'x');
+    line.push_back('\n');
+
+    Object object;
+    uint64_t uncompressed = 0;
+    for (size_t i = 0; i < frameCount; ++i) {
+        SeekCheckpoint start;
+        start.compressedOffset = object.data.size();
+        start.uncompressedOffset = uncompressed;
+        start.lineNumber = uncompressed / line.size();
+        start.lineStart = true;
+        object.frames.push_back(start);
+
+        std::string content;
+        while (content.size() < frameBytes) content += line;
+        object.data += rawZstdFrame(content);
+        uncompressed += content.size();
+    }
+    object.size = uncompressed;
+    return object;
+}
+
+// An index as read from the object's seek table: every frame, no line numbers
+// except those listed in known
+static std::shared_ptr<SeekIndex> seekTableIndex(const Object& object, const std::vector<size_t>& known) {
+    auto index = std::make_shared<SeekIndex>("", object.data.size());
+    for (size_t i = 0; i < object.frames.size(); ++i) {
+        SeekCheckpoint frame = object.frames[i];
+        if (std::find(known.begin(), known.end(), i) == known.end()) {
+            frame.lineNumber = UNKNOWN;
+        }
+        index->add(frame);
+    }
+    return index;
+}
+
+static uint64_t lineAt(const SeekIndex& index, uint64_t uncompressedOffset) {
+    SeekCheckpoint found;
+    if (!index.findByOffset(uncompressedOffset, found) || found.uncompressedOffset != uncompressedOffset) {
+        return UNKNOWN - 1;  // Matches nothing a test expects
+    }
+    return found.lineNumber;
+}
+
+// Decode the object from frame `from` to the end, in pieces as a download would
+static void decodeFrom(const Object& object, size_t from, const SeekCheckpoint& checkpoint,
+                       std::shared_ptr<SeekIndex> index) {
+    ZstdTransform transform(checkpoint, std::move(index));
+    constexpr size_t PIECE = 1024 * 1024;
+    size_t begin = object.frames[from].compressedOffset;
+    size_t produced = 0;
+    for (size_t pos = begin; pos < object.data.size(); pos += PIECE) {
+        size_t len = std::min(PIECE, object.data.size() - pos);
+        produced += transform.transform(object.data.data() + pos, len).size();
+    }
+    produced += transform.flush().size();
+    CHECK(!transform.hasError());
+    CHECK(produced == object.size - object.frames[from].uncompressedOffset);
+}
+
+static void testResumeFromUnknownLine() {
+    // Frames 1 and 2 have no known line; frame 3 does
+    Object object = makeObject(4, 3 * 1024 * 1024);
+    auto index = seekTableIndex(object, {0, 3});
+
+    SeekCheckpoint from = object.frames[1];
+    from.lineNumber = UNKNOWN;
+    decodeFrom(object, 1, from, index);
+
+    // Counting on from an unknown line can't learn any line numbers
+    CHECK(lineAt(*index, object.frames[2].uncompressedOffset) == UNKNOWN);
+    CHECK(lineAt(*index, object.frames[3].uncompressedOffset) == object.frames[3].lineNumber);
+    CHECK(lineAt(*index, object.frames[0].uncompressedOffset) == 0);
+
+    SeekCheckpoint byLine;
+    CHECK(index->findByLine(object.frames[3].lineNumber, byLine));
+    CHECK(byLine.uncompressedOffset == object.frames[3].uncompressedOffset);
+}
+
+static void testResumeFromKnownLine() {
+    Object object = makeObject(4, 3 * 1024 * 1024);
+    auto index = seekTableIndex(object, {0, 1});
+
+    decodeFrom(object, 1, object.frames[1], index);
+
+    // Frames after a known line learn theirs
+    CHECK(lineAt(*index, object.frames[2].uncompressedOffset) == object.frames[2].lineNumber);
+    CHECK(lineAt(*index, object.frames[3].uncompressedOffset) == object.frames[3].lineNumber);
+}
+
+static void testAddKeepsLinesInOrder() {
+    Object object = makeObject(4, 3 * 1024 * 1024);
+    auto index = seekTableIndex(object, {0, 3});
+
+    // A known line is never replaced
+    SeekCheckpoint frame = object.frames[3];
+    frame.lineNumber += 5;
+    index->add(frame);
+    CHECK(lineAt(*index, frame.uncompressedOffset) == object.frames[3].lineNumber);
+
+    // An unknown one isn't filled with a number out of order with its neighbours
+    frame = object.frames[2];
+    frame.lineNumber = object.frames[3].lineNumber + 1;
+    index->add(frame);
+    CHECK(lineAt(*index, frame.uncompressedOffset) == UNKNOWN);
+
+    frame.lineNumber = object.frames[2].lineNumber;
+    index->add(frame);
+    CHECK(lineAt(*index, frame.uncompressedOffset) == object.frames[2].lineNumber);
+}
+
+static void testFindAfter() {
+    Object object = makeObject(4, 3 * 1024 * 1024);
+    auto index = seekTableIndex(object, {0});
+
+    // A seek's download window ends on the frame after its target
+    SeekCheckpoint found;
+    CHECK(index->findAfter(object.frames[1].uncompressedOffset + 1, found));
+    CHECK(found.compressedOffset == object.frames[2].compressedOffset);
+    CHECK(index->findAfter(object.frames[2].uncompressedOffset, found));
+    CHECK(found.compressedOffset == object.frames[2].compressedOffset);
+    CHECK(!index->findAfter(object.frames[3].uncompressedOffset + 1, found));
+}
+
+int main() {
+    testResumeFromUnknownLine();
+    testResumeFromKnownLine();
+    testAddKeepsLinesInOrder();
+    testFindAfter();
+
+    if (s_failures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", s_failures);
+        return 1;
+    }
+    std::printf("All seek index checks passed\n");
+    return 0;
+}
@@ -0,0 +1,206 @@
+// Checks of findAllLiteral and TextSearch: matches at every position around
+// the vector block edges, chunks split across the 4 MB boundary, case
+// folding, and the regex line limit
+// Usage: ./test_text_search (exits non-zero on failure)
+
+#include "preview/text_search.h"
+#include "preview/text_buffer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int s_failures = 0;
+
+#define CHECK(cond)                                                          \
+    do {                                                                     \
+        if (!(cond)) {                                                       \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,      \
+                         __LINE__, #cond);                                   \
+            s_failures++;                                                    \
+        }                                                                    \
+    } while (0)
+
+// Non-overlapping occurrences, the slow way
+static std::vector<uint64_t> findAllSlow(const std::string& data, const std::string& needle) {
+    std::vector<uint64_t> starts;
+    for (size_t pos = data.find(needle); pos != std::string::npos; pos = data.find(needle, pos + needle.size())) {
+        starts.push_back(pos);
+    }
+    return starts;
+}
+
+static std::vector<uint64_t> findAllFast(const std::string& data, const std::string& needle, uint64_t base = 0) {
+    std::vector<SearchMatch> matches;
+    findAllLiteral(data.data(), data.size(), needle, base, matches);
+    std::vector<uint64_t> starts;
+    for (const auto& m : matches) {
+        if (m.length != needle.size()) return {};
+        starts.push_back(m.offset - base);
+    }
+    return starts;
+}
+
+static void testBlockEdges() {
+    // Every needle length up to past a block, at every position of buffers
+    // a little either side of one, two and three blocks
+    for (size_t m = 1; m <= 20; ++m) {
+        std::string needle(m, 'n');
+        needle.front() = 'F';
+        needle.back() = 'L';
+        for (size_t len = m; len <= 52; ++len) {
+            for (size_t pos = 0; pos + m <= len; ++pos) {
+                std::string data(len, 'x');
+                data.replace(pos, m, needle);
+                if (findAllFast(data, needle) != std::vector<uint64_t>{pos}) {
+                    std::fprintf(stderr, "needle of %zu at %zu in %zu bytes missed\n", m, pos, len);
+                    s_failures++;
+                    return;
+                }
+            }
+        }
+    }
+
+    // First and last bytes match but the middle doesn't
+    std::string data(64, 'x');
+    data.replace(10, 5, "FxxxL");
+    CHECK(findAllFast(data, "FnnnL").empty());
+
+    // Needle at the very end, and the base offset carried through
+    data.replace(59, 5, "FnnnL");
+    CHECK(findAllFast(data, "FnnnL", 1000) == std::vector<uint64_t>{59});
+    CHECK(findAllFast("", "a").empty());
+    CHECK(findAllFast("ab", "abc").empty());
+}
+
+static void testNonOverlapping() {
+    CHECK((findAllFast("aaaaaaa", "aaa") == std::vector<uint64_t>{0, 3}));
+    CHECK((findAllFast(std::string(40, 'a'), "aa").size() == 20));
+    CHECK((findAllFast("abababab", "aba") == std::vector<uint64_t>{0, 4}));
+
+    // Random text over a small alphabet agrees with the slow search
+    std::mt19937 rng(1);
+    for (int i = 0; i < 2000; ++i) {
+        std::string data(rng() % 300, ' ');
+        for (char& c : data) c = static_cast<char>('a' + rng() % 3);
+        std::string needle(rng() % 6 + 1, ' ');
+        for (char& c : needle) c = static_cast<char>('a' + rng() % 3);
+        if (findAllFast(data, needle) != findAllSlow(data, needle)) {
+            std::fprintf(stderr, "\"%s\" in \"%s\" differs\n", needle.c_str(), data.c_str());
+            s_failures++;
+            return;
+        }
+    }
+}
+
+static std::vector<uint64_t> searchAll(const std::shared_ptr<const TextBuffer>& buffer, const SearchQuery& query) {
+    TextSearch search;
+    search.setSource(buffer);
+    search.setQuery(query);
+    search.setExtent(buffer->lineIndex()->lineCount(), buffer->size(), true);
+    for (int i = 0; i < 10000 && search.isSearching(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(!search.isSearching());
+    CHECK(search.error().empty());
+
+    std::vector<SearchMatch> matches;
+    search.matchesIn(0, buffer->size(), matches);
+    CHECK(matches.size() == search.matchCount());
+    std::vector<uint64_t> starts;
+    for (const auto& m : matches) starts.push_back(m.offset);
+    return starts;
+}
+
+// Lines of filler with the needle now and then, in mixed case
+static std::string makeText(size_t bytes, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::string text;
+    while (text.size() < bytes) {
+        size_t words = rng() % 30;
+        for (size_t w = 0; w < words; ++w) {
+            if (rng() % 50 == 0) {
+                text += rng() % 2 ? "Needle" : "nEEDLE";
+            } else {
+                text.append(rng() % 8 + 1, static_cast<char>('a' + rng() % 26));
+            }
+            text += ' ';
+        }
+        text += '\n';
+    }
+    return text;
+}
+
+static std::string lowered(std::string text) {
+    for (char& c : text) {
+        if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+    }
+    return text;
+}
+
+static void testChunkBoundaries() {
+    // Three chunks and a bit, with a needle either side of each 4 MB mark
+    std::string text = makeText(3 * TextSearch::CHUNK_BYTES + 12345, 2);
+    for (uint64_t mark = TextSearch::CHUNK_BYTES; mark < text.size(); mark += TextSearch::CHUNK_BYTES) {
+        text.replace(mark - 6, 6, "Needle");
+        text.replace(mark + 1, 6, "Needle");
+    }
+
+    SearchQuery query;
+    query.pattern = "Needle";
+    query.caseSensitive = true;
+    auto buffer = std::make_shared<const TextBuffer>(text);
+    std::vector<uint64_t> expected = findAllSlow(text, "Needle");
+    CHECK(expected.size() > 1000);
+    CHECK(searchAll(buffer, query) == expected);
+
+    // Case-insensitive: the needle folded too, matching either spelling
+    query.pattern = "NeEdLe";
+    query.caseSensitive = false;
+    expected = findAllSlow(lowered(text), "needle");
+    CHECK(searchAll(buffer, query) == expected);
+
+    // Only ASCII letters fold
+    auto accented = std::make_shared<const TextBuffer>(std::string("\xc3\x89t\xc3\xa9 \xc3\xa9T\xc3\xa9\n"));
+    query.pattern = "\xc3\xa9t\xc3\xa9";
+    CHECK(searchAll(accented, query) == std::vector<uint64_t>{6});
+}
+
+static void testRegexLineLimit() {
+    // A line longer than the regex limit is only searched up to it
+    std::string text = "x match\n";
+    text += std::string(100 * 1024, 'y') + " match\n";
+    text += "match\n";
+    auto buffer = std::make_shared<const TextBuffer>(text);
+
+    SearchQuery query;
+    query.pattern = "m[a-z]+h";
+    query.regex = true;
+    uint64_t third = text.size() - 6;
+    CHECK((searchAll(buffer, query) == std::vector<uint64_t>{2, third}));
+
+    query.pattern = "MATCH";
+    CHECK((searchAll(buffer, query) == std::vector<uint64_t>{2, third}));
+
+    // Literal search has no such limit
+    query.regex = false;
+    CHECK(searchAll(buffer, query).size() == 3);
+}
+
+int main() {
+    testBlockEdges();
+    testNonOverlapping();
+    testChunkBoundaries();
+    testRegexLineLimit();
+
+    if (s_failures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", s_failures);
+        return 1;
+    }
+    std::printf("All text search checks passed\n");
+    return 0;
+}
@@ -199,6 +199,11 @@ int main(int argc, char* argv[]) {
 
             ImGui::SameLine();
             ImGui::Text("| %llu lines", static_cast<unsigned long long>(viewer.lineCount()));
+            if (viewer.isIndexing()) {
+                ImGui::SameLine();
+                ImGui::TextColored(ImVec4(0.6f, 0.6f, 0.6f, 1.0f), "(indexing %.0f%%)",
+                                   viewer.indexProgress() * 100.0f);
+            }
 
             ImGui::SameLine();
             if (ImGui::Checkbox("Word Wrap", &wordWrap)) {
@@ -231,7 +236,8 @@ int main(int argc, char* argv[]) {
                           io.MouseClicked[0] || io.MouseReleased[0] ||
                           io.MouseWheel != 0.0f ||
                           ImGui::IsKeyDown(ImGuiKey_UpArrow) || ImGui::IsKeyDown(ImGuiKey_DownArrow) ||
-                          ImGui::IsKeyDown(ImGuiKey_PageUp) || ImGui::IsKeyDown(ImGuiKey_PageDown);
+                          ImGui::IsKeyDown(ImGuiKey_PageUp) || ImGui::IsKeyDown(ImGuiKey_PageDown) ||
+                          viewer.isIndexing();
         }
     }
 
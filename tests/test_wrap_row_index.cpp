@@ -0,0 +1,207 @@
+// Checks of WrapRowIndex: wrapLine, the Fenwick prefix sums behind
+// rowsBefore, mapping rows back to lines, counting a growing file, and
+// dropping batches counted at a width that has since changed
+// Usage: ./test_wrap_row_index (exits non-zero on failure)
+
+#include "preview/wrap_row_index.h"
+#include "line_index.h"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int s_failures = 0;
+
+#define CHECK(cond)                                                          \
+    do {                                                                     \
+        if (!(cond)) {                                                       \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,      \
+                         __LINE__, #cond);                                   \
+            s_failures++;                                                    \
+        }                                                                    \
+    } while (0)
+
+// Every byte one unit wide
+static CharAdvances unitAdvances() {
+    CharAdvances advances;
+    advances.fill(1.0f);
+    return advances;
+}
+
+struct Text {
+    std::string bytes;
+    std::shared_ptr<LineIndex> index;
+    std::vector<uint64_t> starts;  // Line starts, as the index holds them
+};
+
+// Lines of random words with now and then an empty line or a \r\n ending
+static Text makeText(size_t lines, uint32_t seed) {
+    std::mt19937 rng(seed);
+    Text text;
+    for (size_t line = 0; line < lines; ++line) {
+        size_t words = rng() % 8 == 0 ? 0 : rng() % 40;
+        for (size_t w = 0; w < words; ++w) {
+            text.bytes.append(rng() % 12 + 1, static_cast<char>('a' + rng() % 26));
+            if (w + 1 < words) text.bytes += rng() % 5 == 0 ? "," : " ";
+        }
+        text.bytes += rng() % 10 == 0 ? "\r\n" : "\n";
+    }
+    text.index = std::make_shared<LineIndex>();
+    text.starts.push_back(0);
+    findNewlines(text.bytes.data(), text.bytes.size(), 0, text.starts);
+    std::vector<uint64_t> added(text.starts.begin() + 1, text.starts.end());
+    text.index->append(added);
+    return text;
+}
+
+// Rows of each line at a width, counted directly
+static std::vector<uint32_t> expectedRows(const Text& text, size_t lines, float width) {
+    CharAdvances advances = unitAdvances();
+    std::vector<uint32_t> rows;
+    for (size_t line = 0; line < lines; ++line) {
+        uint64_t start = text.starts[line];
+        uint64_t end = line + 1 < text.starts.size() ? text.starts[line + 1] : text.bytes.size();
+        while (end > start && (text.bytes[end - 1] == '\n' || text.bytes[end - 1] == '\r')) --end;
+        uint32_t len = static_cast<uint32_t>(end - start);
+        rows.push_back(len ? wrapLine(text.bytes.data() + start, len, width, advances, nullptr) : 1);
+    }
+    return rows;
+}
+
+static bool waitForLines(const WrapRowIndex& index, uint64_t lines) {
+    for (int i = 0; i < 5000; ++i) {
+        uint64_t counted = 0, rows = 0;
+        index.counted(counted, rows);
+        if (counted == lines) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+// rowsBefore matches the prefix sums and findRow inverts it for every row
+static bool rowsMatch(const WrapRowIndex& index, const std::vector<uint32_t>& expected) {
+    uint64_t before = 0;
+    for (uint64_t line = 0; line <= expected.size(); ++line) {
+        uint64_t rows = 0;
+        if (!index.rowsBefore(line, rows) || rows != before) {
+            std::fprintf(stderr, "rowsBefore(%llu) = %llu, expected %llu\n", static_cast<unsigned long long>(line),
+                         static_cast<unsigned long long>(rows), static_cast<unsigned long long>(before));
+            return false;
+        }
+        if (line == expected.size()) break;
+        for (uint32_t sub = 0; sub < expected[line]; ++sub) {
+            uint64_t foundLine = 0;
+            uint32_t foundSub = 0;
+            if (!index.findRow(before + sub, foundLine, foundSub) || foundLine != line || foundSub != sub) {
+                std::fprintf(stderr, "findRow(%llu) = %llu+%u, expected %llu+%u\n",
+                             static_cast<unsigned long long>(before + sub), static_cast<unsigned long long>(foundLine),
+                             foundSub, static_cast<unsigned long long>(line), sub);
+                return false;
+            }
+        }
+        before += expected[line];
+    }
+    uint64_t line = 0;
+    uint32_t sub = 0;
+    return !index.findRow(before, line, sub) && !index.rowsBefore(expected.size() + 1, before);
+}
+
+static void testWrapLine() {
+    CharAdvances advances = unitAdvances();
+    std::vector<uint32_t> starts;
+
+    // No break opportunity: cut at the width
+    std::string word(25, 'a');
+    CHECK(wrapLine(word.data(), 25, 10.0f, advances, &starts) == 3);
+    CHECK((starts == std::vector<uint32_t>{0, 10, 20}));
+
+    // Breaks after the last space that fits; a row may end exactly at the width
+    std::string words = "aaaa bbbb cccc";
+    CHECK(wrapLine(words.data(), static_cast<uint32_t>(words.size()), 10.0f, advances, &starts) == 2);
+    CHECK((starts == std::vector<uint32_t>{0, 10}));
+
+    // Fits on one row
+    CHECK(wrapLine(words.data(), static_cast<uint32_t>(words.size()), 100.0f, advances, nullptr) == 1);
+
+    // A character wider than the row still takes a row of its own
+    CharAdvances wide = advances;
+    wide['W'] = 30.0f;
+    std::string mixed = "aWa";
+    CHECK(wrapLine(mixed.data(), 3, 10.0f, wide, &starts) == 3);
+}
+
+static void testPrefixSumsAndLookup() {
+    Text text = makeText(20000, 1);
+    size_t lines = text.starts.size() - 1;  // The empty "line" after the last newline is left out
+    WrapRowIndex index;
+    index.setSource(text.bytes.data(), text.index);
+    index.setWidth(40.0f, unitAdvances());
+    index.setExtent(lines, text.bytes.size(), true);
+    CHECK(waitForLines(index, lines));
+    CHECK(rowsMatch(index, expectedRows(text, lines, 40.0f)));
+    index.stop();
+}
+
+static void testGrowingFile() {
+    Text text = makeText(5000, 2);
+    WrapRowIndex index;
+    index.setSource(text.bytes.data(), text.index);
+    index.setWidth(25.0f, unitAdvances());
+
+    // Until the file is complete its last line may still grow, so it isn't counted
+    index.setExtent(3000, text.starts[3000], false);
+    CHECK(waitForLines(index, 2999));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    uint64_t counted = 0, rows = 0;
+    index.counted(counted, rows);
+    CHECK(counted == 2999);
+
+    size_t lines = text.starts.size() - 1;
+    index.setExtent(lines, text.bytes.size(), true);
+    CHECK(waitForLines(index, lines));
+    CHECK(rowsMatch(index, expectedRows(text, lines, 25.0f)));
+}
+
+static void testStaleBatchesDropped() {
+    Text text = makeText(50000, 3);
+    size_t lines = text.starts.size() - 1;
+    WrapRowIndex index;
+    index.setSource(text.bytes.data(), text.index);
+    index.setExtent(lines, text.bytes.size(), true);
+
+    // Change width while batches are being counted; a batch counted at the
+    // old width must never be merged into the new count
+    std::mt19937 rng(4);
+    float width = 0.0f;
+    for (int i = 0; i < 200; ++i) {
+        width = static_cast<float>(10 + rng() % 60);
+        index.setWidth(width, unitAdvances());
+        std::this_thread::sleep_for(std::chrono::microseconds(rng() % 500));
+    }
+    CHECK(waitForLines(index, lines));
+    CHECK(rowsMatch(index, expectedRows(text, lines, width)));
+
+    // Word wrap off stops counting; turning it on again starts over
+    index.setWidth(0.0f, unitAdvances());
+    index.setWidth(33.0f, unitAdvances());
+    CHECK(waitForLines(index, lines));
+    CHECK(rowsMatch(index, expectedRows(text, lines, 33.0f)));
+}
+
+int main() {
+    testWrapLine();
+    testPrefixSumsAndLookup();
+    testGrowingFile();
+    testStaleBatchesDropped();
+
+    if (s_failures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", s_failures);
+        return 1;
+    }
+    std::printf("All wrap row index checks passed\n");
+    return 0;
+}